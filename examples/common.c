@@ -479,11 +479,30 @@ cleanup:
 }
 
 static dc_status_t
-dctool_bluetooth_open (dc_iostream_t **out, dc_context_t *context, dc_descriptor_t *descriptor, const char *devname)
+dctool_bluetooth_open (dc_iostream_t **out, dc_context_t *context, dc_descriptor_t *descriptor, const char *devname, const char *cachedir)
 {
 	dc_status_t status = DC_STATUS_SUCCESS;
 	dc_iostream_t *iostream = NULL;
 	dc_bluetooth_address_t address = 0;
+	dc_bluetooth_cache_t *cache = NULL;
+	char filename[1024] = {0};
+
+	// Load the known devices.
+	if (cachedir) {
+		snprintf (filename, sizeof (filename), "%s/bluetooth.txt", cachedir);
+
+		status = dc_bluetooth_cache_new (&cache, context);
+		if (status != DC_STATUS_SUCCESS) {
+			ERROR ("Failed to create the bluetooth cache.");
+			goto cleanup;
+		}
+
+		dc_buffer_t *buffer = dctool_file_read (filename);
+		if (buffer) {
+			dc_bluetooth_cache_load (cache, dc_buffer_get_data (buffer), dc_buffer_get_size (buffer));
+			dc_buffer_free (buffer);
+		}
+	}
 
 	if (devname) {
 		// Use the address.
@@ -492,7 +511,11 @@ dctool_bluetooth_open (dc_iostream_t **out, dc_context_t *context, dc_descriptor
 		// Discover the device address.
 		dc_iterator_t *iterator = NULL;
 		dc_bluetooth_device_t *device = NULL;
-		dc_bluetooth_iterator_new (&iterator, context, descriptor);
+		if (cache) {
+			dc_bluetooth_cache_iterator_new (&iterator, context, cache, descriptor);
+		} else {
+			dc_bluetooth_iterator_new (&iterator, context, descriptor);
+		}
 		while (dc_iterator_next (iterator, &device) == DC_STATUS_SUCCESS) {
 			address = dc_bluetooth_device_get_address (device);
 			dc_bluetooth_device_free (device);
@@ -512,7 +535,11 @@ dctool_bluetooth_open (dc_iostream_t **out, dc_context_t *context, dc_descriptor
 	}
 
 	// Open the bluetooth socket.
-	status = dc_bluetooth_open (&iostream, context, address, 0);
+	if (cache) {
+		status = dc_bluetooth_cache_open (&iostream, context, cache, address);
+	} else {
+		status = dc_bluetooth_open (&iostream, context, address, 0);
+	}
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR ("Failed to open the bluetooth socket.");
 		goto cleanup;
@@ -521,11 +548,21 @@ dctool_bluetooth_open (dc_iostream_t **out, dc_context_t *context, dc_descriptor
 	*out = iostream;
 
 cleanup:
+	// Store the known devices. A device that could not be reached has
+	// been removed from the cache, and is discovered again next time.
+	if (cache) {
+		dc_buffer_t *buffer = dc_buffer_new (0);
+		if (buffer && dc_bluetooth_cache_save (cache, buffer) == DC_STATUS_SUCCESS) {
+			dctool_file_write (filename, buffer);
+		}
+		dc_buffer_free (buffer);
+	}
+	dc_bluetooth_cache_free (cache);
 	return status;
 }
 
 dc_status_t
-dctool_iostream_open (dc_iostream_t **iostream, dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t transport, const char *devname)
+dctool_iostream_open (dc_iostream_t **iostream, dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t transport, const char *devname, const char *cachedir)
 {
 	switch (transport) {
 	case DC_TRANSPORT_SERIAL:
@@ -537,7 +574,7 @@ dctool_iostream_open (dc_iostream_t **iostream, dc_context_t *context, dc_descri
 	case DC_TRANSPORT_IRDA:
 		return dctool_irda_open (iostream, context, descriptor, devname);
 	case DC_TRANSPORT_BLUETOOTH:
-		return dctool_bluetooth_open (iostream, context, descriptor, devname);
+		return dctool_bluetooth_open (iostream, context, descriptor, devname, cachedir);
 	default:
 		return DC_STATUS_UNSUPPORTED;
 	}
@@ -68,7 +68,7 @@ dc_buffer_t *
 dctool_file_read (const char *filename);
 
 dc_status_t
-dctool_iostream_open (dc_iostream_t **iostream, dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t transport, const char *devname);
+dctool_iostream_open (dc_iostream_t **iostream, dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t transport, const char *devname, const char *cachedir);
 
 #ifdef __cplusplus
 }
@@ -35,19 +35,33 @@
 #include <libdivecomputer/descriptor.h>
 #include <libdivecomputer/device.h>
 #include <libdivecomputer/parser.h>
+#include <libdivecomputer/oceanic_atom2.h>
 
 #include "dctool.h"
 #include "common.h"
+#include "trace.h"
+#include "emulator.h"
 #include "output.h"
 #include "utils.h"
 
 typedef struct event_data_t {
 	const char *cachedir;
+	const char *pacingdir;
+	const char *checkpointdir;
+	char checkpoint[1024];
+	dc_buffer_t *state;
+	const char *imagedir;
+	char imagefile[1024];
+	dc_buffer_t *image;
 	dc_event_devinfo_t devinfo;
+	dc_event_clock_t clock;
 } event_data_t;
 
 typedef struct dive_data_t {
-	dc_device_t *device;
+	dc_context_t *context;
+	dc_descriptor_t *descriptor;
+	dc_descriptor_t *model;
+	const event_data_t *eventdata;
 	dc_buffer_t **fingerprint;
 	unsigned int number;
 	dctool_output_t *output;
@@ -76,9 +90,27 @@ dive_cb (const unsigned char *data, unsigned int size, const unsigned char *fing
 		*divedata->fingerprint = fp;
 	}
 
-	// Create the parser.
+	// Look up the descriptor of the actual model, which can be different
+	// from the selected one. Without an exact match, the selected
+	// descriptor is used.
+	if (divedata->number == 1) {
+		dc_family_t family = dc_descriptor_get_type (divedata->descriptor);
+		unsigned int model = divedata->eventdata->devinfo.model;
+		dctool_descriptor_search (&divedata->model, NULL, family, model);
+		if (divedata->model && dc_descriptor_get_model (divedata->model) != model) {
+			dc_descriptor_free (divedata->model);
+			divedata->model = NULL;
+		}
+	}
+
+	// Create the parser. The dives are parsed while the download is still
+	// in progress, so the parser can't be created from the device itself.
+	// The device info and clock are taken from the copies of the event
+	// handler instead, which are received before the first dive.
 	message ("Creating the parser.\n");
-	rc = dc_parser_new (&parser, divedata->device);
+	rc = dc_parser_new2 (&parser, divedata->context,
+		divedata->model ? divedata->model : divedata->descriptor,
+		divedata->eventdata->clock.devtime, divedata->eventdata->clock.systime);
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR ("Error creating the parser.");
 		goto cleanup;
@@ -142,33 +174,122 @@ event_cb (dc_device_t *device, dc_event_type_t event, const void *data, void *us
 			dc_buffer_free (fingerprint);
 		}
 
+		// Restore the inter packet delay that was learned during a
+		// previous session with the same device.
+		if (eventdata->pacingdir) {
+			char filename[1024] = {0};
+			dc_family_t family = DC_FAMILY_NULL;
+			dc_buffer_t *pacing = NULL;
+
+			// Generate the pacing filename.
+			family = dc_device_get_type (device);
+			snprintf (filename, sizeof (filename), "%s/%s-%08X.pacing",
+				eventdata->pacingdir, dctool_family_name (family), devinfo->serial);
+
+			// Read the pacing file.
+			pacing = dctool_file_read (filename);
+			if (pacing && dc_buffer_append (pacing, (const unsigned char *) "", 1)) {
+				const char *text = (const char *) dc_buffer_get_data (pacing);
+				dc_device_set_pacing (device, strtoul (text, NULL, 10));
+			}
+
+			// Free the buffer again.
+			dc_buffer_free (pacing);
+		}
+
+		// Resume an interrupted memory dump of the same device.
+		if (eventdata->checkpointdir && eventdata->state == NULL) {
+			dc_family_t family = DC_FAMILY_NULL;
+
+			// Generate the checkpoint filename.
+			family = dc_device_get_type (device);
+			snprintf (eventdata->checkpoint, sizeof (eventdata->checkpoint), "%s/%s-%08X.checkpoint",
+				eventdata->checkpointdir, dctool_family_name (family), devinfo->serial);
+
+			// Read the checkpoint file.
+			eventdata->state = dctool_file_read (eventdata->checkpoint);
+			if (eventdata->state == NULL)
+				eventdata->state = dc_buffer_new (0);
+
+			// Register the checkpoint data.
+			dc_device_set_checkpoint (device, eventdata->state);
+		}
+
+		// Load the memory image of the previous session with the same
+		// device into the registered buffer.
+		if (eventdata->imagedir && eventdata->image) {
+			dc_family_t family = DC_FAMILY_NULL;
+		
+			// Generate the image filename.
+			family = dc_device_get_type (device);
+			snprintf (eventdata->imagefile, sizeof (eventdata->imagefile), "%s/%s-%08X.img",
+				eventdata->imagedir, dctool_family_name (family), devinfo->serial);
+
+			// Read the image file.
+			image = dctool_file_read (eventdata->imagefile);
+			dc_buffer_clear (eventdata->image);
+			dc_buffer_append (eventdata->image,
+				dc_buffer_get_data (image),
+				dc_buffer_get_size (image));
+
+			// Free the buffer again.
+			dc_buffer_free (eventdata.image);
+		}
+
 		// Keep a copy of the event data. It will be used for generating
 		// the fingerprint filename again after a (successful) download.
 		eventdata->devinfo = *devinfo;
 		break;
+	case DC_EVENT_CLOCK:
+		// Keep a copy of the event data. It will be used for creating
+		// the parsers.
+		eventdata->clock = *(const dc_event_clock_t *) data;
+		break;
 	default:
 		break;
 	}
 }
 
 static dc_status_t
-download (dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t transport, const char *devname, const char *cachedir, dc_buffer_t *fingerprint, dctool_output_t *output)
+download (dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t transport, const char *devname, const char *emulate, const char *record, const char *replay, unsigned int realtime, unsigned int pipeline, const char *cachedir, dc_buffer_t *fingerprint, dctool_output_t *output)
 {
 	dc_status_t rc = DC_STATUS_SUCCESS;
 	dc_iostream_t *iostream = NULL;
 	dc_device_t *device = NULL;
 	dc_buffer_t *ofingerprint = NULL;
+	dc_buffer_t *image = NULL;
+	event_data_t eventdata = {0};
 
 	// Open the I/O stream.
-	message ("Opening the I/O stream (%s, %s).\n",
-		dctool_transport_name (transport),
-		devname ? devname : "null");
-	rc = dctool_iostream_open (&iostream, context, descriptor, transport, devname);
+	if (replay) {
+		message ("Opening the I/O stream (replay, %s).\n", replay);
+		rc = dctool_replay_open (&iostream, context, replay, realtime);
+	} else if (emulate) {
+		message ("Opening the I/O stream (emulator, %s dives).\n", emulate);
+		rc = dctool_emulator_open (&iostream, context, descriptor, strtoul (emulate, NULL, 10));
+	} else {
+		message ("Opening the I/O stream (%s, %s).\n",
+			dctool_transport_name (transport),
+			devname ? devname : "null");
+		rc = dctool_iostream_open (&iostream, context, descriptor, transport, devname, cachedir);
+	}
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR ("Error opening the I/O stream.");
 		goto cleanup;
 	}
 
+	// Record the I/O stream.
+	if (record) {
+		dc_iostream_t *recorder = NULL;
+		message ("Recording the I/O stream (%s).\n", record);
+		rc = dctool_record_open (&recorder, context, iostream, record);
+		if (rc != DC_STATUS_SUCCESS) {
+			ERROR ("Error recording the I/O stream.");
+			goto cleanup;
+		}
+		iostream = recorder;
+	}
+
 	// Open the device.
 	message ("Opening the device (%s %s).\n",
 		dc_descriptor_get_vendor (descriptor),
@@ -180,12 +301,14 @@ download (dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t tra
 	}
 
 	// Initialize the event data.
-	event_data_t eventdata = {0};
 	if (fingerprint) {
 		eventdata.cachedir = NULL;
 	} else {
 		eventdata.cachedir = cachedir;
 	}
+	eventdata.pacingdir = cachedir;
+	eventdata.checkpointdir = cachedir;
+	eventdata.imagedir = cachedir;
 
 	// Register the event handler.
 	message ("Registering the event handler.\n");
@@ -214,16 +337,44 @@ download (dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t tra
 		}
 	}
 
+	// Enable the pipelined reads.
+	if (pipeline) {
+		message ("Enabling the pipelined reads.\n");
+		dc_family_t family = dc_device_get_type (device);
+		if (family == DC_FAMILY_OCEANIC_ATOM2) {
+			rc = oceanic_atom2_device_set_pipeline (device, 1);
+		} else {
+			rc = DC_STATUS_UNSUPPORTED;
+		}
+		if (rc != DC_STATUS_SUCCESS) {
+			message ("Pipelined reads are not supported by this device.\n");
+			rc = DC_STATUS_SUCCESS;
+		}
+	}
+
+	// Register a buffer for the memory image of the previous session,
+	// such that only the changes need to be downloaded. The image itself
+	// is loaded once the identity of the device is known.
+	if (cachedir) {
+		eventdata.image = dc_buffer_new (0);
+		dc_device_set_image (device, eventdata.image);
+	}
+
 	// Initialize the dive data.
 	dive_data_t divedata = {0};
-	divedata.device = device;
+	divedata.context = context;
+	divedata.descriptor = descriptor;
+	divedata.model = NULL;
+	divedata.eventdata = &eventdata;
 	divedata.fingerprint = &ofingerprint;
 	divedata.number = 0;
 	divedata.output = output;
 
-	// Download the dives.
+	// Download the dives. The dives are parsed and written on a
+	// separate thread, while the download continues.
 	message ("Downloading the dives.\n");
-	rc = dc_device_foreach (device, dive_cb, &divedata);
+	rc = dc_device_foreach_pipelined (device, 4, dive_cb, &divedata);
+	dc_descriptor_free (divedata.model);
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR ("Error downloading the dives.");
 		goto cleanup;
@@ -243,7 +394,45 @@ download (dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t tra
 		dctool_file_write (filename, ofingerprint);
 	}
 
+	// Store the memory image.
+	if (eventdata.image && eventdata.imagefile[0] && dc_buffer_get_size (eventdata.image)) {
+		dctool_file_write (eventdata.imagefile, eventdata.image);
+	}
+
+	// Store the inter packet delay.
+	unsigned int pacing = 0;
+	if (cachedir && dc_device_get_pacing (device, &pacing) == DC_STATUS_SUCCESS) {
+		char filename[1024] = {0};
+		char text[16] = {0};
+		dc_family_t family = DC_FAMILY_NULL;
+		dc_buffer_t *buffer = NULL;
+
+		// Generate the pacing filename.
+		family = dc_device_get_type (device);
+		snprintf (filename, sizeof (filename), "%s/%s-%08X.pacing",
+			cachedir, dctool_family_name (family), eventdata.devinfo.serial);
+
+		// Write the pacing file.
+		int n = snprintf (text, sizeof (text), "%u\n", pacing);
+		buffer = dc_buffer_new (n);
+		if (buffer && dc_buffer_append (buffer, (const unsigned char *) text, n)) {
+			dctool_file_write (filename, buffer);
+		}
+		dc_buffer_free (buffer);
+	}
+
 cleanup:
+	// Keep the checkpoint for the next attempt, or remove it once it
+	// is no longer needed.
+	if (eventdata.state) {
+		if (rc != DC_STATUS_SUCCESS && dc_buffer_get_size (eventdata.state)) {
+			dctool_file_write (eventdata.checkpoint, eventdata.state);
+		} else {
+			remove (eventdata.checkpoint);
+		}
+	}
+	dc_buffer_free (image);
+	dc_buffer_free (eventdata.state);
 	dc_buffer_free (ofingerprint);
 	dc_device_close (device);
 	dc_iostream_close (iostream);
@@ -263,19 +452,29 @@ dctool_download_run (int argc, char *argv[], dc_context_t *context, dc_descripto
 	// Default option values.
 	unsigned int help = 0;
 	const char *fphex = NULL;
+	const char *emulate = NULL;
+	const char *record = NULL;
+	const char *replay = NULL;
+	unsigned int realtime = 0;
+	unsigned int pipeline = 0;
 	const char *filename = NULL;
 	const char *cachedir = NULL;
 	const char *format = "xml";
 
 	// Parse the command-line options.
 	int opt = 0;
-	const char *optstring = "ht:o:p:c:f:u:";
+	const char *optstring = "ht:o:p:c:f:u:E:r:R:TP";
 #ifdef HAVE_GETOPT_LONG
 	struct option options[] = {
 		{"help",        no_argument,       0, 'h'},
 		{"transport",   required_argument, 0, 't'},
 		{"output",      required_argument, 0, 'o'},
 		{"fingerprint", required_argument, 0, 'p'},
+		{"emulator",    required_argument, 0, 'E'},
+		{"record",      required_argument, 0, 'r'},
+		{"replay",      required_argument, 0, 'R'},
+		{"realtime",    no_argument,       0, 'T'},
+		{"pipeline",    no_argument,       0, 'P'},
 		{"cache",       required_argument, 0, 'c'},
 		{"format",      required_argument, 0, 'f'},
 		{"units",       required_argument, 0, 'u'},
@@ -298,6 +497,21 @@ dctool_download_run (int argc, char *argv[], dc_context_t *context, dc_descripto
 		case 'p':
 			fphex = optarg;
 			break;
+		case 'E':
+			emulate = optarg;
+			break;
+		case 'r':
+			record = optarg;
+			break;
+		case 'R':
+			replay = optarg;
+			break;
+		case 'T':
+			realtime = 1;
+			break;
+		case 'P':
+			pipeline = 1;
+			break;
 		case 'c':
 			cachedir = optarg;
 			break;
@@ -351,7 +565,7 @@ dctool_download_run (int argc, char *argv[], dc_context_t *context, dc_descripto
 	}
 
 	// Download the dives.
-	status = download (context, descriptor, transport, argv[0], cachedir, fingerprint, output);
+	status = download (context, descriptor, transport, argv[0], emulate, record, replay, realtime, pipeline, cachedir, fingerprint, output);
 	if (status != DC_STATUS_SUCCESS) {
 		message ("ERROR: %s\n", dctool_errmsg (status));
 		exitcode = EXIT_FAILURE;
@@ -378,6 +592,11 @@ const dctool_command_t dctool_download = {
 	"   -t, --transport <name>     Transport type\n"
 	"   -o, --output <filename>    Output filename\n"
 	"   -p, --fingerprint <data>   Fingerprint data (hexadecimal)\n"
+	"   -E, --emulator <ndives>    Emulate the device with a number of dives\n"
+	"   -r, --record <filename>    Record the I/O stream to a trace file\n"
+	"   -R, --replay <filename>    Replay a trace file instead of the device\n"
+	"   -T, --realtime             Replay with the original timing\n"
+	"   -P, --pipeline             Send several read commands at once\n"
 	"   -c, --cache <directory>    Cache directory\n"
 	"   -f, --format <format>      Output format\n"
 	"   -u, --units <units>        Set units (metric or imperial)\n"
@@ -386,6 +605,11 @@ const dctool_command_t dctool_download = {
 	"   -t <transport>     Transport type\n"
 	"   -o <filename>      Output filename\n"
 	"   -p <fingerprint>   Fingerprint data (hexadecimal)\n"
+	"   -E <ndives>        Emulate the device with a number of dives\n"
+	"   -r <filename>      Record the I/O stream to a trace file\n"
+	"   -R <filename>      Replay a trace file instead of the device\n"
+	"   -T                 Replay with the original timing\n"
+	"   -P                 Send several read commands at once\n"
 	"   -c <directory>     Cache directory\n"
 	"   -f <format>        Output format\n"
 	"   -u <units>         Set units (metric or imperial)\n"
@@ -37,25 +37,48 @@
 
 #include "dctool.h"
 #include "common.h"
+#include "trace.h"
+#include "emulator.h"
 #include "utils.h"
 
 static dc_status_t
-dump (dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t transport, const char *devname, dc_buffer_t *fingerprint, dc_buffer_t *buffer)
+dump (dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t transport, const char *devname, const char *emulate, const char *record, const char *replay, unsigned int realtime, const char *checkpoint, dc_buffer_t *fingerprint, dc_buffer_t *buffer)
 {
 	dc_status_t rc = DC_STATUS_SUCCESS;
 	dc_iostream_t *iostream = NULL;
 	dc_device_t *device = NULL;
+	dc_buffer_t *state = NULL;
 
 	// Open the I/O stream.
-	message ("Opening the I/O stream (%s, %s).\n",
-		dctool_transport_name (transport),
-		devname ? devname : "null");
-	rc = dctool_iostream_open (&iostream, context, descriptor, transport, devname);
+	if (replay) {
+		message ("Opening the I/O stream (replay, %s).\n", replay);
+		rc = dctool_replay_open (&iostream, context, replay, realtime);
+	} else if (emulate) {
+		message ("Opening the I/O stream (emulator, %s dives).\n", emulate);
+		rc = dctool_emulator_open (&iostream, context, descriptor, strtoul (emulate, NULL, 10));
+	} else {
+		message ("Opening the I/O stream (%s, %s).\n",
+			dctool_transport_name (transport),
+			devname ? devname : "null");
+		rc = dctool_iostream_open (&iostream, context, descriptor, transport, devname, NULL);
+	}
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR ("Error opening the I/O stream.");
 		goto cleanup;
 	}
 
+	// Record the I/O stream.
+	if (record) {
+		dc_iostream_t *recorder = NULL;
+		message ("Recording the I/O stream (%s).\n", record);
+		rc = dctool_record_open (&recorder, context, iostream, record);
+		if (rc != DC_STATUS_SUCCESS) {
+			ERROR ("Error recording the I/O stream.");
+			goto cleanup;
+		}
+		iostream = recorder;
+	}
+
 	// Open the device.
 	message ("Opening the device (%s %s).\n",
 		dc_descriptor_get_vendor (descriptor),
@@ -93,6 +116,19 @@ dump (dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t transpo
 		}
 	}
 
+	// Register the checkpoint of an interrupted memory dump.
+	if (checkpoint) {
+		message ("Registering the checkpoint (%s).\n", checkpoint);
+		state = dctool_file_read (checkpoint);
+		if (state == NULL)
+			state = dc_buffer_new (0);
+		rc = dc_device_set_checkpoint (device, state);
+		if (rc != DC_STATUS_SUCCESS) {
+			ERROR ("Error registering the checkpoint.");
+			goto cleanup;
+		}
+	}
+
 	// Download the memory dump.
 	message ("Downloading the memory dump.\n");
 	rc = dc_device_dump (device, buffer);
@@ -102,6 +138,16 @@ dump (dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t transpo
 	}
 
 cleanup:
+	// Keep the checkpoint for the next attempt, or remove it once it
+	// is no longer needed.
+	if (state) {
+		if (rc != DC_STATUS_SUCCESS && dc_buffer_get_size (state)) {
+			dctool_file_write (checkpoint, state);
+		} else {
+			remove (checkpoint);
+		}
+	}
+	dc_buffer_free (state);
 	dc_device_close (device);
 	dc_iostream_close (iostream);
 	return rc;
@@ -119,17 +165,27 @@ dctool_dump_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 	// Default option values.
 	unsigned int help = 0;
 	const char *fphex = NULL;
+	const char *emulate = NULL;
+	const char *record = NULL;
+	const char *replay = NULL;
+	unsigned int realtime = 0;
 	const char *filename = NULL;
+	const char *checkpoint = NULL;
 
 	// Parse the command-line options.
 	int opt = 0;
-	const char *optstring = "ht:o:p:";
+	const char *optstring = "ht:o:p:k:E:r:R:T";
 #ifdef HAVE_GETOPT_LONG
 	struct option options[] = {
 		{"help",        no_argument,       0, 'h'},
 		{"transport",   required_argument, 0, 't'},
 		{"output",      required_argument, 0, 'o'},
 		{"fingerprint", required_argument, 0, 'p'},
+		{"checkpoint",  required_argument, 0, 'k'},
+		{"emulator",    required_argument, 0, 'E'},
+		{"record",      required_argument, 0, 'r'},
+		{"replay",      required_argument, 0, 'R'},
+		{"realtime",    no_argument,       0, 'T'},
 		{0,             0,                 0,  0 }
 	};
 	while ((opt = getopt_long (argc, argv, optstring, options, NULL)) != -1) {
@@ -149,6 +205,21 @@ dctool_dump_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 		case 'p':
 			fphex = optarg;
 			break;
+		case 'k':
+			checkpoint = optarg;
+			break;
+		case 'E':
+			emulate = optarg;
+			break;
+		case 'r':
+			record = optarg;
+			break;
+		case 'R':
+			replay = optarg;
+			break;
+		case 'T':
+			realtime = 1;
+			break;
 		default:
 			return EXIT_FAILURE;
 		}
@@ -177,7 +248,7 @@ dctool_dump_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 	buffer = dc_buffer_new (0);
 
 	// Download the memory dump.
-	status = dump (context, descriptor, transport, argv[0], fingerprint, buffer);
+	status = dump (context, descriptor, transport, argv[0], emulate, record, replay, realtime, checkpoint, fingerprint, buffer);
 	if (status != DC_STATUS_SUCCESS) {
 		message ("ERROR: %s\n", dctool_errmsg (status));
 		exitcode = EXIT_FAILURE;
@@ -207,10 +278,20 @@ const dctool_command_t dctool_dump = {
 	"   -t, --transport <name>     Transport type\n"
 	"   -o, --output <filename>    Output filename\n"
 	"   -p, --fingerprint <data>   Fingerprint data (hexadecimal)\n"
+	"   -k, --checkpoint <file>    Resume an interrupted dump from a checkpoint\n"
+	"   -E, --emulator <ndives>    Emulate the device with a number of dives\n"
+	"   -r, --record <filename>    Record the I/O stream to a trace file\n"
+	"   -R, --replay <filename>    Replay a trace file instead of the device\n"
+	"   -T, --realtime             Replay with the original timing\n"
 #else
 	"   -h                 Show help message\n"
 	"   -t <transport>     Transport type\n"
 	"   -o <filename>      Output filename\n"
 	"   -p <fingerprint>   Fingerprint data (hexadecimal)\n"
+	"   -k <filename>      Resume an interrupted dump from a checkpoint\n"
+	"   -E <ndives>        Emulate the device with a number of dives\n"
+	"   -r <filename>      Record the I/O stream to a trace file\n"
+	"   -R <filename>      Replay a trace file instead of the device\n"
+	"   -T                 Replay with the original timing\n"
 #endif
 };
@@ -40,6 +40,8 @@
 #include "common.h"
 #include "utils.h"
 
+#define C_ARRAY_SIZE(array) (sizeof (array) / sizeof *(array))
+
 #define REACTPROWHITE 0x4354
 
 static dc_status_t
@@ -79,6 +81,81 @@ cleanup:
 	return rc;
 }
 
+static dc_status_t
+benchmark_probe (dc_parser_t *parser, const dc_parse_job_t *job, void *userdata)
+{
+	dc_probe_t probe;
+
+	return dc_parser_probe (parser, &probe);
+}
+
+static dc_status_t
+benchmark_summary (dc_parser_t *parser, const dc_parse_job_t *job, void *userdata)
+{
+	dc_summary_t summary;
+
+	memset (&summary, 0, sizeof (summary));
+
+	return dc_parser_get_summary (parser, &summary);
+}
+
+static const struct {
+	const char *name;
+	dc_parse_func_t func;
+} g_benchmarks[] = {
+	{"probe",   benchmark_probe},
+	{"summary", benchmark_summary},
+	{"full",    NULL},
+};
+
+static dc_status_t
+benchmark (dc_buffer_t *buffer, dc_context_t *context, dc_descriptor_t *descriptor, unsigned int devtime, dc_ticks_t systime, unsigned int count)
+{
+	dc_status_t rc = DC_STATUS_SUCCESS;
+	dc_parse_job_t *jobs = NULL;
+
+	// Parse the same dive repeatedly, on the calling thread.
+	jobs = (dc_parse_job_t *) malloc (count * sizeof (dc_parse_job_t));
+	if (jobs == NULL) {
+		ERROR ("Failed to allocate memory.");
+		rc = DC_STATUS_NOMEMORY;
+		goto cleanup;
+	}
+
+	for (unsigned int i = 0; i < count; ++i) {
+		jobs[i].descriptor = descriptor;
+		jobs[i].devtime = devtime;
+		jobs[i].systime = systime;
+		jobs[i].data = dc_buffer_get_data (buffer);
+		jobs[i].size = dc_buffer_get_size (buffer);
+		jobs[i].userdata = NULL;
+	}
+
+	for (unsigned int i = 0; i < C_ARRAY_SIZE (g_benchmarks); ++i) {
+		dc_parse_stats_t stats;
+		unsigned int nstats = 1;
+
+		message ("Running the %s benchmark.\n", g_benchmarks[i].name);
+		rc = dc_parse_batch (context, jobs, count, 0, g_benchmarks[i].func, NULL, NULL, &stats, &nstats);
+		if (rc != DC_STATUS_SUCCESS) {
+			ERROR ("Error running the benchmark.");
+			goto cleanup;
+		}
+
+		if (nstats == 0 || stats.count == 0)
+			continue;
+
+		printf ("%-8s %10.3f us/dive (%u errors)\n",
+			g_benchmarks[i].name,
+			(double) stats.usecs / stats.count,
+			stats.errors);
+	}
+
+cleanup:
+	free (jobs);
+	return rc;
+}
+
 static int
 dctool_parse_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t *descriptor)
 {
@@ -94,10 +171,11 @@ dctool_parse_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 	const char *filename = NULL;
 	unsigned int devtime = 0;
 	dc_ticks_t systime = 0;
+	unsigned int count = 0;
 
 	// Parse the command-line options.
 	int opt = 0;
-	const char *optstring = "ho:d:s:u:";
+	const char *optstring = "ho:d:s:u:b:";
 #ifdef HAVE_GETOPT_LONG
 	struct option options[] = {
 		{"help",        no_argument,       0, 'h'},
@@ -105,6 +183,7 @@ dctool_parse_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 		{"devtime",     required_argument, 0, 'd'},
 		{"systime",     required_argument, 0, 's'},
 		{"units",       required_argument, 0, 'u'},
+		{"benchmark",   required_argument, 0, 'b'},
 		{0,             0,                 0,  0 }
 	};
 	while ((opt = getopt_long (argc, argv, optstring, options, NULL)) != -1) {
@@ -130,6 +209,9 @@ dctool_parse_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 			if (strcmp (optarg, "imperial") == 0)
 				units = DCTOOL_UNITS_IMPERIAL;
 			break;
+		case 'b':
+			count = strtoul (optarg, NULL, 0);
+			break;
 		default:
 			return EXIT_FAILURE;
 		}
@@ -144,12 +226,14 @@ dctool_parse_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 		return EXIT_SUCCESS;
 	}
 
-	// Create the output.
-	output = dctool_xml_output_new (filename, units);
-	if (output == NULL) {
-		message ("Failed to create the output.\n");
-		exitcode = EXIT_FAILURE;
-		goto cleanup;
+	// Create the output, unless only the benchmark is run.
+	if (count == 0) {
+		output = dctool_xml_output_new (filename, units);
+		if (output == NULL) {
+			message ("Failed to create the output.\n");
+			exitcode = EXIT_FAILURE;
+			goto cleanup;
+		}
 	}
 
 	for (unsigned int i = 0; i < argc; ++i) {
@@ -162,7 +246,10 @@ dctool_parse_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 		}
 
 		// Parse the dive.
-		status = parse (buffer, context, descriptor, devtime, systime, output);
+		if (count)
+			status = benchmark (buffer, context, descriptor, devtime, systime, count);
+		else
+			status = parse (buffer, context, descriptor, devtime, systime, output);
 		if (status != DC_STATUS_SUCCESS) {
 			message ("ERROR: %s\n", dctool_errmsg (status));
 			exitcode = EXIT_FAILURE;
@@ -195,11 +282,13 @@ const dctool_command_t dctool_parse = {
 	"   -d, --devtime <timestamp>  Device time\n"
 	"   -s, --systime <timestamp>  System time\n"
 	"   -u, --units <units>        Set units (metric or imperial)\n"
+	"   -b, --benchmark <count>    Measure the parse time per dive\n"
 #else
 	"   -h              Show help message\n"
 	"   -o <filename>   Output filename\n"
 	"   -d <devtime>    Device time\n"
 	"   -s <systime>    System time\n"
 	"   -u <units>      Set units (metric or imperial)\n"
+	"   -b <count>      Measure the parse time per dive\n"
 #endif
 };
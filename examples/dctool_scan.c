@@ -110,6 +110,43 @@ cleanup:
 	return status;
 }
 
+static void
+watch_cb (dc_usbhid_device_t *device, unsigned int arrived, void *userdata)
+{
+	printf ("%c%04x:%04x\n", arrived ? '+' : '-',
+		dc_usbhid_device_get_vid (device), dc_usbhid_device_get_pid (device));
+	fflush (stdout);
+}
+
+static dc_status_t
+watch (dc_context_t *context, dc_descriptor_t *descriptor)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_usbhid_watcher_t *watcher = NULL;
+
+	// Create the hotplug watcher.
+	status = dc_usbhid_watcher_new (&watcher, context, descriptor, watch_cb, NULL);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR ("Failed to create the hotplug watcher.");
+		goto cleanup;
+	}
+
+	// Report the devices being plugged in or removed, until cancelled.
+	while (!dctool_cancel_cb (NULL)) {
+		status = dc_usbhid_watcher_poll (watcher, 100);
+		if (status != DC_STATUS_SUCCESS && status != DC_STATUS_TIMEOUT) {
+			ERROR ("Failed to wait for the hotplug events.");
+			goto cleanup;
+		}
+	}
+
+	status = DC_STATUS_SUCCESS;
+
+cleanup:
+	dc_usbhid_watcher_free (watcher);
+	return status;
+}
+
 static int
 dctool_scan_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t *descriptor)
 {
@@ -118,15 +155,17 @@ dctool_scan_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 
 	// Default option values.
 	unsigned int help = 0;
+	unsigned int follow = 0;
 	dc_transport_t transport = dctool_transport_default (descriptor);
 
 	// Parse the command-line options.
 	int opt = 0;
-	const char *optstring = "ht:";
+	const char *optstring = "ht:w";
 #ifdef HAVE_GETOPT_LONG
 	struct option options[] = {
 		{"help",        no_argument,       0, 'h'},
 		{"transport",   required_argument, 0, 't'},
+		{"watch",       no_argument,       0, 'w'},
 		{0,             0,                 0,  0 }
 	};
 	while ((opt = getopt_long (argc, argv, optstring, options, NULL)) != -1) {
@@ -140,6 +179,9 @@ dctool_scan_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 		case 't':
 			transport = dctool_transport_type (optarg);
 			break;
+		case 'w':
+			follow = 1;
+			break;
 		default:
 			return EXIT_FAILURE;
 		}
@@ -161,6 +203,22 @@ dctool_scan_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 		goto cleanup;
 	}
 
+	// Watch for devices being plugged in or removed.
+	if (follow) {
+		if (transport != DC_TRANSPORT_USBHID) {
+			message ("Watching is only supported for USB HID devices.\n");
+			exitcode = EXIT_FAILURE;
+			goto cleanup;
+		}
+
+		status = watch (context, descriptor);
+		if (status != DC_STATUS_SUCCESS) {
+			message ("ERROR: %s\n", dctool_errmsg (status));
+			exitcode = EXIT_FAILURE;
+		}
+		goto cleanup;
+	}
+
 	// Scan for supported devices.
 	status = scan (context, descriptor, transport);
 	if (status != DC_STATUS_SUCCESS) {
@@ -185,8 +243,10 @@ const dctool_command_t dctool_scan = {
 #ifdef HAVE_GETOPT_LONG
 	"   -h, --help               Show help message\n"
 	"   -t, --transport <name>   Transport type\n"
+	"   -w, --watch              Watch for USB HID devices being plugged in\n"
 #else
 	"   -h               Show help message\n"
 	"   -t <transport>   Transport type\n"
+	"   -w               Watch for USB HID devices being plugged in\n"
 #endif
 };
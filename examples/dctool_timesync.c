@@ -49,7 +49,7 @@ do_timesync (dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t
 	message ("Opening the I/O stream (%s, %s).\n",
 		dctool_transport_name (transport),
 		devname ? devname : "null");
-	rc = dctool_iostream_open (&iostream, context, descriptor, transport, devname);
+	rc = dctool_iostream_open (&iostream, context, descriptor, transport, devname, NULL);
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR ("Error opening the I/O stream.");
 		goto cleanup;
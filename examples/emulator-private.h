@@ -0,0 +1,92 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+
+#ifndef DCTOOL_EMULATOR_PRIVATE_H
+#define DCTOOL_EMULATOR_PRIVATE_H
+
+#include <libdivecomputer/common.h>
+#include <libdivecomputer/buffer.h>
+#include <libdivecomputer/datetime.h>
+
+#include "emulator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct dctool_emulator_t dctool_emulator_t;
+typedef struct dctool_emulator_vtable_t dctool_emulator_vtable_t;
+
+struct dctool_emulator_t {
+	const dctool_emulator_vtable_t *vtable;
+	unsigned int model;
+	unsigned int ndives;
+	dc_buffer_t *input;
+	dc_buffer_t *output;
+	size_t offset;
+};
+
+struct dctool_emulator_vtable_t {
+	size_t size;
+
+	// Build the memory image.
+	dc_status_t (*init) (dctool_emulator_t *emulator);
+
+	// Handle the bytes received from the host. The number of bytes
+	// consumed is zero as long as the command is still incomplete.
+	dc_status_t (*process) (dctool_emulator_t *emulator, const unsigned char data[], size_t size, size_t *consumed);
+
+	void (*free) (dctool_emulator_t *emulator);
+};
+
+extern const dctool_emulator_vtable_t dctool_suunto_d9_emulator_vtable;
+extern const dctool_emulator_vtable_t dctool_oceanic_atom2_emulator_vtable;
+extern const dctool_emulator_vtable_t dctool_shearwater_petrel_emulator_vtable;
+extern const dctool_emulator_vtable_t dctool_hw_ostc3_emulator_vtable;
+
+/*
+ * Queue data to be sent to the host.
+ */
+dc_status_t
+dctool_emulator_reply (dctool_emulator_t *emulator, const unsigned char data[], size_t size);
+
+/*
+ * Helpers to generate the synthetic dives. Dive number zero is the
+ * oldest dive. Every dive starts one day after the previous one, and
+ * has a simple square profile.
+ */
+dc_ticks_t
+dctool_emulator_dive_ticks (unsigned int dive);
+
+unsigned int
+dctool_emulator_dive_nsamples (unsigned int dive);
+
+unsigned int
+dctool_emulator_dive_maxdepth (unsigned int dive);
+
+unsigned int
+dctool_emulator_dive_depth (unsigned int dive, unsigned int sample);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DCTOOL_EMULATOR_PRIVATE_H */
@@ -0,0 +1,276 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <libdivecomputer/custom.h>
+
+#include "emulator-private.h"
+#include "utils.h"
+
+// Timestamp of the oldest dive (2026-01-01 09:00:00 UTC).
+#define EPOCH  1767258000
+#define DAY    86400
+
+static dc_status_t
+dctool_emulator_get_available (void *userdata, size_t *value)
+{
+	dctool_emulator_t *emulator = (dctool_emulator_t *) userdata;
+
+	*value = dc_buffer_get_size (emulator->output) - emulator->offset;
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+dctool_emulator_poll (void *userdata, int timeout)
+{
+	dctool_emulator_t *emulator = (dctool_emulator_t *) userdata;
+
+	if (dc_buffer_get_size (emulator->output) == emulator->offset)
+		return DC_STATUS_TIMEOUT;
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+dctool_emulator_read (void *userdata, void *data, size_t size, size_t *actual)
+{
+	dctool_emulator_t *emulator = (dctool_emulator_t *) userdata;
+	size_t available = dc_buffer_get_size (emulator->output) - emulator->offset;
+
+	// Return the queued data. A real device never answers faster than
+	// the host can ask, so a short read is reported as a timeout.
+	size_t nbytes = size < available ? size : available;
+	memcpy (data, dc_buffer_get_data (emulator->output) + emulator->offset, nbytes);
+	emulator->offset += nbytes;
+
+	if (emulator->offset == dc_buffer_get_size (emulator->output)) {
+		dc_buffer_clear (emulator->output);
+		emulator->offset = 0;
+	}
+
+	if (actual)
+		*actual = nbytes;
+
+	return nbytes == size ? DC_STATUS_SUCCESS : DC_STATUS_TIMEOUT;
+}
+
+static dc_status_t
+dctool_emulator_write (void *userdata, const void *data, size_t size, size_t *actual)
+{
+	dctool_emulator_t *emulator = (dctool_emulator_t *) userdata;
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (!dc_buffer_append (emulator->input, (const unsigned char *) data, size)) {
+		message ("Failed to allocate memory.\n");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	if (actual)
+		*actual = size;
+
+	// Process all complete commands.
+	while (dc_buffer_get_size (emulator->input)) {
+		const unsigned char *input = dc_buffer_get_data (emulator->input);
+		size_t length = dc_buffer_get_size (emulator->input);
+
+		size_t consumed = 0;
+		status = emulator->vtable->process (emulator, input, length, &consumed);
+		if (status != DC_STATUS_SUCCESS)
+			return status;
+
+		if (consumed == 0)
+			break;
+
+		dc_buffer_slice (emulator->input, consumed, length - consumed);
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+dctool_emulator_purge (void *userdata, dc_direction_t direction)
+{
+	dctool_emulator_t *emulator = (dctool_emulator_t *) userdata;
+
+	if (direction & DC_DIRECTION_INPUT) {
+		dc_buffer_clear (emulator->output);
+		emulator->offset = 0;
+	}
+
+	if (direction & DC_DIRECTION_OUTPUT) {
+		dc_buffer_clear (emulator->input);
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+dctool_emulator_close (void *userdata)
+{
+	dctool_emulator_t *emulator = (dctool_emulator_t *) userdata;
+
+	if (emulator->vtable->free)
+		emulator->vtable->free (emulator);
+
+	dc_buffer_free (emulator->input);
+	dc_buffer_free (emulator->output);
+	free (emulator);
+
+	return DC_STATUS_SUCCESS;
+}
+
+static const dc_custom_cbs_t callbacks = {
+	NULL, /* set_timeout */
+	NULL, /* set_break */
+	NULL, /* set_dtr */
+	NULL, /* set_rts */
+	NULL, /* get_lines */
+	dctool_emulator_get_available, /* get_available */
+	NULL, /* configure */
+	dctool_emulator_poll, /* poll */
+	dctool_emulator_read, /* read */
+	dctool_emulator_write, /* write */
+	NULL, /* ioctl */
+	NULL, /* flush */
+	dctool_emulator_purge, /* purge */
+	NULL, /* sleep */
+	dctool_emulator_close, /* close */
+};
+
+dc_status_t
+dctool_emulator_open (dc_iostream_t **iostream, dc_context_t *context, dc_descriptor_t *descriptor, unsigned int ndives)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dctool_emulator_t *emulator = NULL;
+	const dctool_emulator_vtable_t *vtable = NULL;
+
+	switch (dc_descriptor_get_type (descriptor)) {
+	case DC_FAMILY_SUUNTO_D9:
+		vtable = &dctool_suunto_d9_emulator_vtable;
+		break;
+	case DC_FAMILY_OCEANIC_ATOM2:
+		vtable = &dctool_oceanic_atom2_emulator_vtable;
+		break;
+	case DC_FAMILY_SHEARWATER_PETREL:
+		vtable = &dctool_shearwater_petrel_emulator_vtable;
+		break;
+	case DC_FAMILY_HW_OSTC3:
+		vtable = &dctool_hw_ostc3_emulator_vtable;
+		break;
+	default:
+		message ("No emulator available for this device.\n");
+		return DC_STATUS_UNSUPPORTED;
+	}
+
+	assert (vtable->size >= sizeof (dctool_emulator_t));
+
+	// Allocate memory.
+	emulator = (dctool_emulator_t *) calloc (1, vtable->size);
+	if (emulator == NULL) {
+		message ("Failed to allocate memory.\n");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	emulator->vtable = vtable;
+	emulator->model = dc_descriptor_get_model (descriptor);
+	emulator->ndives = ndives;
+	emulator->offset = 0;
+	emulator->input = dc_buffer_new (0);
+	emulator->output = dc_buffer_new (0);
+	if (emulator->input == NULL || emulator->output == NULL) {
+		message ("Failed to allocate memory.\n");
+		status = DC_STATUS_NOMEMORY;
+		goto error_free;
+	}
+
+	// Build the memory image.
+	status = vtable->init (emulator);
+	if (status != DC_STATUS_SUCCESS) {
+		goto error_close;
+	}
+
+	status = dc_custom_open (iostream, context, DC_TRANSPORT_SERIAL, &callbacks, emulator);
+	if (status != DC_STATUS_SUCCESS) {
+		goto error_close;
+	}
+
+	return DC_STATUS_SUCCESS;
+
+error_close:
+	if (vtable->free)
+		vtable->free (emulator);
+error_free:
+	dc_buffer_free (emulator->input);
+	dc_buffer_free (emulator->output);
+	free (emulator);
+	return status;
+}
+
+dc_status_t
+dctool_emulator_reply (dctool_emulator_t *emulator, const unsigned char data[], size_t size)
+{
+	if (!dc_buffer_append (emulator->output, data, size)) {
+		message ("Failed to allocate memory.\n");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_ticks_t
+dctool_emulator_dive_ticks (unsigned int dive)
+{
+	return EPOCH + (dc_ticks_t) dive * DAY;
+}
+
+unsigned int
+dctool_emulator_dive_nsamples (unsigned int dive)
+{
+	// Between 10 and 30 minutes, with a 10 second interval.
+	return 60 + (dive * 37) % 120;
+}
+
+unsigned int
+dctool_emulator_dive_maxdepth (unsigned int dive)
+{
+	// Between 10 and 40 meters, in centimeters.
+	return 1000 + (dive * 373) % 3000;
+}
+
+unsigned int
+dctool_emulator_dive_depth (unsigned int dive, unsigned int sample)
+{
+	unsigned int nsamples = dctool_emulator_dive_nsamples (dive);
+	unsigned int maxdepth = dctool_emulator_dive_maxdepth (dive);
+	unsigned int ramp = nsamples / 6;
+
+	if (sample < ramp)
+		return maxdepth * (sample + 1) / ramp;
+	if (sample >= nsamples - ramp)
+		return maxdepth * (nsamples - sample) / (ramp + 1);
+
+	return maxdepth;
+}
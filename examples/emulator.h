@@ -0,0 +1,46 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+
+#ifndef DCTOOL_EMULATOR_H
+#define DCTOOL_EMULATOR_H
+
+#include <libdivecomputer/context.h>
+#include <libdivecomputer/descriptor.h>
+#include <libdivecomputer/iostream.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Open an I/O stream connected to an emulated dive computer. The
+ * emulator speaks the wire protocol of the device family selected by
+ * the descriptor, and answers from a synthetic memory image containing
+ * the requested number of dives.
+ */
+dc_status_t
+dctool_emulator_open (dc_iostream_t **iostream, dc_context_t *context, dc_descriptor_t *descriptor, unsigned int ndives);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DCTOOL_EMULATOR_H */
@@ -0,0 +1,383 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "emulator-private.h"
+#include "utils.h"
+
+#define SZ_VERSION    64
+#define SZ_HARDWARE2  5
+#define SZ_CUSTOMTEXT 60
+#define SZ_DISPLAY    16
+#define SZ_CLOCK      6
+
+#define RB_LOGBOOK_SIZE_COMPACT  16
+#define RB_LOGBOOK_SIZE_FULL     256
+#define RB_LOGBOOK_COUNT 256
+
+#define SZ_MEMORY  0x400000
+
+#define S_BLOCK_READ 0x20
+#define S_READY    0x4C
+#define READY      0x4D
+#define HARDWARE2  0x60
+#define HEADER     0x61
+#define CLOCK      0x62
+#define CUSTOMTEXT 0x63
+#define DIVE       0x66
+#define IDENTITY   0x69
+#define HARDWARE   0x6A
+#define DISPLAY    0x6E
+#define COMPACT    0x6D
+#define S_INIT     0xAA
+#define INIT       0xBB
+#define EXIT       0xFF
+
+#define OSTC4      0x3B
+
+#define SZ_SAMPLE  3
+#define INTERVAL   10
+
+typedef struct hw_ostc3_emulator_t {
+	dctool_emulator_t base;
+	unsigned char *dives[RB_LOGBOOK_COUNT];
+	unsigned int sizes[RB_LOGBOOK_COUNT];
+	unsigned char command;
+	unsigned int handshake;
+	unsigned int service;
+} hw_ostc3_emulator_t;
+
+static const unsigned char hw_ostc3_emulator_service[] = {S_INIT, 0xAB, 0xCD, 0xEF};
+
+static void
+put_u16_le (unsigned char data[], unsigned int value)
+{
+	data[0] = value & 0xFF;
+	data[1] = (value >> 8) & 0xFF;
+}
+
+static void
+put_u24_le (unsigned char data[], unsigned int value)
+{
+	data[0] = value & 0xFF;
+	data[1] = (value >> 8) & 0xFF;
+	data[2] = (value >> 16) & 0xFF;
+}
+
+static dc_status_t
+hw_ostc3_emulator_init (dctool_emulator_t *abstract)
+{
+	hw_ostc3_emulator_t *emulator = (hw_ostc3_emulator_t *) abstract;
+
+	// The logbook holds at most 256 dives. Older dives are overwritten,
+	// and the slot of a dive is its number modulo the logbook size.
+	unsigned int first = 0;
+	if (abstract->ndives > RB_LOGBOOK_COUNT)
+		first = abstract->ndives - RB_LOGBOOK_COUNT;
+
+	for (unsigned int i = first; i < abstract->ndives; ++i) {
+		unsigned int idx = i % RB_LOGBOOK_COUNT;
+		unsigned int nsamples = dctool_emulator_dive_nsamples (i);
+		unsigned int maxdepth = dctool_emulator_dive_maxdepth (i);
+		unsigned int divetime = nsamples * INTERVAL;
+
+		// The profile consists of a small header, the samples and an
+		// end marker. Its length includes the three length bytes.
+		unsigned int length = 5 + nsamples * SZ_SAMPLE + 2;
+		unsigned int size = RB_LOGBOOK_SIZE_FULL + length;
+
+		unsigned char *data = (unsigned char *) calloc (size, 1);
+		if (data == NULL) {
+			message ("Failed to allocate memory.\n");
+			return DC_STATUS_NOMEMORY;
+		}
+
+		dc_datetime_t dt;
+		dc_datetime_gmtime (&dt, dctool_emulator_dive_ticks (i));
+
+		// Dive header.
+		data[0] = data[1] = 0xFA;
+		data[8] = 0x23;
+		put_u24_le (data + 9, length + 3);
+		data[12] = dt.year - 2000;
+		data[13] = dt.month;
+		data[14] = dt.day;
+		data[15] = dt.hour;
+		data[16] = dt.minute;
+		put_u16_le (data + 17, maxdepth);
+		put_u16_le (data + 19, divetime / 60);
+		data[21] = divetime % 60;
+		put_u16_le (data + 22, 200);
+		put_u16_le (data + 24, 1013);
+		data[48] = 10; // Firmware version
+		data[49] = 30;
+		data[28] = 21;
+		data[31] = 1;
+		data[70] = 100;
+		put_u16_le (data + 73, maxdepth * 2 / 3);
+		put_u16_le (data + 75, divetime);
+		put_u16_le (data + 80, i + 1);
+		data[RB_LOGBOOK_SIZE_FULL - 2] = data[RB_LOGBOOK_SIZE_FULL - 1] = 0xFB;
+
+		// Profile header without any extra sample data.
+		unsigned char *profile = data + RB_LOGBOOK_SIZE_FULL;
+		unsigned int delta = abstract->model == OSTC4 ? 3 : 0;
+		put_u24_le (profile, length + 3 - delta);
+		profile[3] = INTERVAL;
+		profile[4] = 0;
+		for (unsigned int j = 0; j < nsamples; ++j) {
+			put_u16_le (profile + 5 + j * SZ_SAMPLE, dctool_emulator_dive_depth (i, j));
+		}
+		profile[length - 2] = profile[length - 1] = 0xFD;
+
+		emulator->dives[idx] = data;
+		emulator->sizes[idx] = size;
+	}
+
+	emulator->command = 0;
+	emulator->handshake = 0;
+	emulator->service = 0;
+
+	return DC_STATUS_SUCCESS;
+}
+
+/*
+ * The flash memory of the service mode is not modelled. Every byte is
+ * derived from its address, which is enough to verify a memory dump.
+ */
+static dc_status_t
+hw_ostc3_emulator_memory (hw_ostc3_emulator_t *emulator, unsigned int address, unsigned int size)
+{
+	dctool_emulator_t *abstract = (dctool_emulator_t *) emulator;
+	unsigned char block[256];
+
+	if (address > SZ_MEMORY || size > SZ_MEMORY - address)
+		return DC_STATUS_SUCCESS;
+
+	while (size) {
+		unsigned int len = size < sizeof (block) ? size : sizeof (block);
+		for (unsigned int i = 0; i < len; ++i) {
+			unsigned int a = address + i;
+			block[i] = (a ^ (a >> 8) ^ (a >> 16)) & 0xFF;
+		}
+
+		dc_status_t status = dctool_emulator_reply (abstract, block, len);
+		if (status != DC_STATUS_SUCCESS)
+			return status;
+
+		address += len;
+		size -= len;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+hw_ostc3_emulator_logbook (hw_ostc3_emulator_t *emulator, unsigned int compact)
+{
+	dctool_emulator_t *abstract = (dctool_emulator_t *) emulator;
+	unsigned int size = compact ? RB_LOGBOOK_SIZE_COMPACT : RB_LOGBOOK_SIZE_FULL;
+	unsigned char entry[RB_LOGBOOK_SIZE_FULL];
+
+	for (unsigned int i = 0; i < RB_LOGBOOK_COUNT; ++i) {
+		const unsigned char *data = emulator->dives[i];
+		if (data == NULL) {
+			memset (entry, 0xFF, size);
+		} else if (compact) {
+			memcpy (entry + 0, data + 9, 3);  // Profile length
+			memcpy (entry + 3, data + 12, 5); // Date and time
+			memcpy (entry + 8, data + 17, 2); // Maximum depth
+			memcpy (entry + 10, data + 19, 3); // Dive time
+			memcpy (entry + 13, data + 80, 2); // Dive number
+			entry[15] = data[8];
+		} else {
+			memcpy (entry, data, size);
+		}
+
+		dc_status_t status = dctool_emulator_reply (abstract, entry, size);
+		if (status != DC_STATUS_SUCCESS)
+			return status;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+hw_ostc3_emulator_process (dctool_emulator_t *abstract, const unsigned char data[], size_t size, size_t *consumed)
+{
+	hw_ostc3_emulator_t *emulator = (hw_ostc3_emulator_t *) abstract;
+	dc_status_t status = DC_STATUS_SUCCESS;
+	const unsigned char ready[] = {emulator->service ? S_READY : READY};
+
+	// The service mode is entered with a handshake sequence. The first
+	// byte is answered with a fixed value, the others are echoed.
+	if (emulator->command == 0 && !emulator->service &&
+		(emulator->handshake || data[0] == S_INIT)) {
+		*consumed = 1;
+		if (data[0] != hw_ostc3_emulator_service[emulator->handshake]) {
+			emulator->handshake = 0;
+			return dctool_emulator_reply (abstract, ready, sizeof (ready));
+		}
+
+		const unsigned char answer[] = {emulator->handshake ? data[0] : 0x4B};
+		status = dctool_emulator_reply (abstract, answer, sizeof (answer));
+		if (status != DC_STATUS_SUCCESS)
+			return status;
+
+		if (++emulator->handshake < sizeof (hw_ostc3_emulator_service))
+			return DC_STATUS_SUCCESS;
+
+		emulator->handshake = 0;
+		emulator->service = 1;
+
+		const unsigned char s_ready[] = {S_READY};
+		return dctool_emulator_reply (abstract, s_ready, sizeof (s_ready));
+	}
+
+	// A new command is echoed immediately, before the host sends the
+	// input data (if any).
+	unsigned int offset = 0;
+	if (emulator->command == 0) {
+		*consumed = offset = 1;
+		if (data[0] == S_BLOCK_READ && !emulator->service) {
+			// Service commands are not available in download mode.
+			return dctool_emulator_reply (abstract, ready, sizeof (ready));
+		}
+		switch (data[0]) {
+		case S_BLOCK_READ:
+		case INIT:
+		case HARDWARE2:
+		case HARDWARE:
+		case IDENTITY:
+		case COMPACT:
+		case HEADER:
+		case DIVE:
+		case CLOCK:
+		case CUSTOMTEXT:
+		case DISPLAY:
+			emulator->command = data[0];
+			status = dctool_emulator_reply (abstract, data, 1);
+			if (status != DC_STATUS_SUCCESS)
+				return status;
+			break;
+		case EXIT:
+			// The exit command has no ready byte.
+			return dctool_emulator_reply (abstract, data, 1);
+		default:
+			// Unsupported commands are answered with the ready byte.
+			return dctool_emulator_reply (abstract, ready, sizeof (ready));
+		}
+	}
+
+	// Wait for the input data.
+	unsigned int isize = 0;
+	switch (emulator->command) {
+	case S_BLOCK_READ:
+		isize = 6;
+		break;
+	case DIVE:
+		isize = 1;
+		break;
+	case CLOCK:
+		isize = SZ_CLOCK;
+		break;
+	case CUSTOMTEXT:
+		isize = SZ_CUSTOMTEXT;
+		break;
+	case DISPLAY:
+		isize = SZ_DISPLAY;
+		break;
+	default:
+		break;
+	}
+
+	if (size < offset + isize)
+		return DC_STATUS_SUCCESS;
+
+	*consumed = offset + isize;
+
+	const unsigned char *input = data + offset;
+	unsigned char answer[SZ_VERSION] = {0};
+	switch (emulator->command) {
+	case HARDWARE2:
+		answer[0] = (abstract->model >> 8) & 0xFF;
+		answer[1] = abstract->model & 0xFF;
+		answer[4] = abstract->model & 0xFF;
+		status = dctool_emulator_reply (abstract, answer, SZ_HARDWARE2);
+		break;
+	case HARDWARE:
+		answer[0] = abstract->model & 0xFF;
+		status = dctool_emulator_reply (abstract, answer, 1);
+		break;
+	case IDENTITY:
+		// Serial number and firmware version.
+		put_u16_le (answer, 12345);
+		answer[2] = 10;
+		answer[3] = 30;
+		memset (answer + 4, ' ', SZ_CUSTOMTEXT);
+		memcpy (answer + 4, "libdivecomputer emulator", 24);
+		status = dctool_emulator_reply (abstract, answer, SZ_VERSION);
+		break;
+	case COMPACT:
+	case HEADER:
+		status = hw_ostc3_emulator_logbook (emulator, emulator->command == COMPACT);
+		break;
+	case S_BLOCK_READ:
+		status = hw_ostc3_emulator_memory (emulator,
+			(input[0] << 16) | (input[1] << 8) | input[2],
+			(input[3] << 16) | (input[4] << 8) | input[5]);
+		break;
+	case DIVE:
+		if (emulator->dives[input[0]]) {
+			status = dctool_emulator_reply (abstract, emulator->dives[input[0]], emulator->sizes[input[0]]);
+		}
+		break;
+	default:
+		break;
+	}
+
+	emulator->command = 0;
+
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
+	return dctool_emulator_reply (abstract, ready, sizeof (ready));
+}
+
+static void
+hw_ostc3_emulator_free (dctool_emulator_t *abstract)
+{
+	hw_ostc3_emulator_t *emulator = (hw_ostc3_emulator_t *) abstract;
+
+	for (unsigned int i = 0; i < RB_LOGBOOK_COUNT; ++i) {
+		free (emulator->dives[i]);
+	}
+}
+
+const dctool_emulator_vtable_t dctool_hw_ostc3_emulator_vtable = {
+	sizeof (hw_ostc3_emulator_t),
+	hw_ostc3_emulator_init, /* init */
+	hw_ostc3_emulator_process, /* process */
+	hw_ostc3_emulator_free, /* free */
+};
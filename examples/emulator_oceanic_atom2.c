@@ -0,0 +1,339 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "emulator-private.h"
+#include "utils.h"
+
+#define F11A     0x4549
+#define F11B     0x4554
+#define A300CS   0x454C
+#define VTX      0x4557
+#define I750TC   0x455A
+
+#define CMD_VERSION   0x84
+#define CMD_READ1     0xB1
+#define CMD_READ8     0xB4
+#define CMD_READ16    0xB8
+#define CMD_WRITE     0xB2
+#define CMD_KEEPALIVE 0x91
+#define CMD_QUIT      0x6A
+
+#define ACK 0x5A
+#define NAK 0xA5
+
+#define PAGESIZE 0x10
+#define INVALID  0xFFFFFFFF
+
+typedef struct oceanic_atom2_layout_t {
+	unsigned char version[PAGESIZE + 1];
+	unsigned int memsize;
+	unsigned int cf_devinfo;
+	unsigned int cf_pointers;
+	unsigned int rb_logbook_begin;
+	unsigned int rb_logbook_end;
+	unsigned int rb_logbook_entry_size;
+	unsigned int rb_profile_begin;
+	unsigned int rb_profile_end;
+	unsigned int pt_mode_logbook;
+} oceanic_atom2_layout_t;
+
+typedef struct oceanic_atom2_emulator_t {
+	dctool_emulator_t base;
+	const oceanic_atom2_layout_t *layout;
+	unsigned char *memory;
+	unsigned int write;
+} oceanic_atom2_emulator_t;
+
+// The version strings select the memory layout, and with it the
+// read command, on the host side: single pages for the default
+// layout, 8 and 16 page reads for the larger models.
+static const oceanic_atom2_layout_t oceanic_default_layout = {
+	"OCE VT3 R10 512K",
+	0x10000, 0x0000, 0x0040,
+	0x0240, 0x0A40, 8,
+	0x0A40, 0x10000,
+	0
+};
+
+static const oceanic_atom2_layout_t aeris_f11_layout = {
+	"AERISF11 10 1024",
+	0x20000, 0x0000, 0x0040,
+	0x0100, 0x0D80, 32,
+	0x0D80, 0x20000,
+	3
+};
+
+static const oceanic_atom2_layout_t aeris_a300cs_layout = {
+	"AER300CS 10 2048",
+	0x40000, 0x0000, 0x0040,
+	0x0900, 0x1000, 16,
+	0x1000, 0x3FE00,
+	1
+};
+
+static unsigned char
+bcd (unsigned int value)
+{
+	return ((value / 10) << 4) | (value % 10);
+}
+
+static void
+oceanic_atom2_emulator_pointers (const oceanic_atom2_layout_t *layout, unsigned char entry[], unsigned int first, unsigned int last)
+{
+	// The profile pointers are page numbers.
+	first /= PAGESIZE;
+	last /= PAGESIZE;
+
+	switch (layout->pt_mode_logbook) {
+	case 0:
+		entry[5] = first & 0xFF;
+		entry[6] = ((first >> 8) & 0x0F) | ((last & 0x0F) << 4);
+		entry[7] = (last >> 4) & 0xFF;
+		break;
+	case 1:
+		entry[4] = first & 0xFF;
+		entry[5] = (first >> 8) & 0xFF;
+		entry[6] = last & 0xFF;
+		entry[7] = (last >> 8) & 0xFF;
+		break;
+	default:
+		entry[16] = first & 0xFF;
+		entry[17] = (first >> 8) & 0xFF;
+		entry[18] = last & 0xFF;
+		entry[19] = (last >> 8) & 0xFF;
+		break;
+	}
+}
+
+static unsigned int
+oceanic_atom2_emulator_profile_size (unsigned int dive)
+{
+	// One header page, followed by the depth samples.
+	unsigned int nsamples = dctool_emulator_dive_nsamples (dive);
+	return PAGESIZE + (2 * nsamples + PAGESIZE - 1) / PAGESIZE * PAGESIZE;
+}
+
+static dc_status_t
+oceanic_atom2_emulator_init (dctool_emulator_t *abstract)
+{
+	oceanic_atom2_emulator_t *emulator = (oceanic_atom2_emulator_t *) abstract;
+	unsigned int model = abstract->model;
+
+	if (model == F11A || model == F11B)
+		emulator->layout = &aeris_f11_layout;
+	else if (model == A300CS || model == VTX || model == I750TC)
+		emulator->layout = &aeris_a300cs_layout;
+	else
+		emulator->layout = &oceanic_default_layout;
+
+	const oceanic_atom2_layout_t *layout = emulator->layout;
+
+	emulator->write = INVALID;
+	emulator->memory = (unsigned char *) malloc (layout->memsize);
+	if (emulator->memory == NULL) {
+		message ("Failed to allocate memory.\n");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	memset (emulator->memory, 0xFF, layout->memsize);
+
+	// Device info with the model and serial number.
+	unsigned char *id = emulator->memory + layout->cf_devinfo;
+	memset (id, 0, PAGESIZE);
+	id[8] = (model >> 8) & 0xFF;
+	id[9] = model & 0xFF;
+	id[10] = bcd (12);
+	id[11] = bcd (34);
+	id[12] = bcd (56);
+
+	// Only the most recent dives that fit in both ringbuffers are kept.
+	unsigned int capacity = (layout->rb_logbook_end - layout->rb_logbook_begin) / layout->rb_logbook_entry_size;
+	unsigned int first = 0, total = 0;
+	for (unsigned int i = abstract->ndives; i > 0; --i) {
+		unsigned int size = oceanic_atom2_emulator_profile_size (i - 1);
+		if (abstract->ndives - i >= capacity ||
+			total + size > layout->rb_profile_end - layout->rb_profile_begin) {
+			first = i;
+			break;
+		}
+		total += size;
+	}
+
+	// Fill both ringbuffers, without wrapping around. Apart from the
+	// ringbuffer pointers, the logbook entries contain only a unique
+	// timestamp and the profiles a simple depth profile.
+	unsigned int logbook = layout->rb_logbook_begin;
+	unsigned int profile = layout->rb_profile_begin;
+	for (unsigned int i = first; i < abstract->ndives; ++i) {
+		unsigned int size = oceanic_atom2_emulator_profile_size (i);
+		unsigned int nsamples = dctool_emulator_dive_nsamples (i);
+
+		dc_datetime_t dt;
+		dc_datetime_gmtime (&dt, dctool_emulator_dive_ticks (i));
+
+		unsigned char *entry = emulator->memory + logbook;
+		memset (entry, 0, layout->rb_logbook_entry_size);
+		entry[0] = bcd (dt.minute);
+		entry[1] = bcd (dt.hour);
+		entry[2] = bcd (dt.day);
+		entry[3] = bcd (dt.month);
+		oceanic_atom2_emulator_pointers (layout, entry, profile, profile + size - PAGESIZE);
+
+		unsigned char *data = emulator->memory + profile;
+		memset (data, 0, size);
+		memcpy (data, entry, 4);
+		for (unsigned int j = 0; j < nsamples; ++j) {
+			unsigned int depth = dctool_emulator_dive_depth (i, j);
+			data[PAGESIZE + 2 * j + 0] = depth & 0xFF;
+			data[PAGESIZE + 2 * j + 1] = (depth >> 8) & 0xFF;
+		}
+
+		logbook += layout->rb_logbook_entry_size;
+		profile += size;
+	}
+
+	// The pointers to the first and last logbook entry.
+	unsigned int count = abstract->ndives - first;
+	unsigned int last = layout->rb_logbook_begin;
+	if (count)
+		last += (count - 1) * layout->rb_logbook_entry_size;
+	unsigned char *pointers = emulator->memory + layout->cf_pointers;
+	memset (pointers, 0, PAGESIZE);
+	pointers[4] = layout->rb_logbook_begin & 0xFF;
+	pointers[5] = (layout->rb_logbook_begin >> 8) & 0xFF;
+	pointers[6] = last & 0xFF;
+	pointers[7] = (last >> 8) & 0xFF;
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+oceanic_atom2_emulator_answer (dctool_emulator_t *abstract, const unsigned char data[], unsigned int size, unsigned int crc_size)
+{
+	unsigned char packet[1 + 16 * PAGESIZE + 2] = {ACK};
+	unsigned int crc = 0;
+
+	memcpy (packet + 1, data, size);
+	for (unsigned int i = 0; i < size; ++i)
+		crc += data[i];
+
+	packet[1 + size] = crc & 0xFF;
+	if (crc_size == 2)
+		packet[2 + size] = (crc >> 8) & 0xFF;
+
+	return dctool_emulator_reply (abstract, packet, 1 + size + crc_size);
+}
+
+static dc_status_t
+oceanic_atom2_emulator_process (dctool_emulator_t *abstract, const unsigned char data[], size_t size, size_t *consumed)
+{
+	oceanic_atom2_emulator_t *emulator = (oceanic_atom2_emulator_t *) abstract;
+	const oceanic_atom2_layout_t *layout = emulator->layout;
+	const unsigned char ack[] = {ACK}, nak[] = {NAK};
+
+	// The data packet following a write command.
+	if (emulator->write != INVALID) {
+		if (size < PAGESIZE + 1)
+			return DC_STATUS_SUCCESS;
+
+		*consumed = PAGESIZE + 1;
+
+		unsigned char crc = 0;
+		for (unsigned int i = 0; i < PAGESIZE; ++i)
+			crc += data[i];
+
+		unsigned int address = emulator->write;
+		emulator->write = INVALID;
+		if (crc != data[PAGESIZE])
+			return dctool_emulator_reply (abstract, nak, sizeof (nak));
+
+		memcpy (emulator->memory + address, data, PAGESIZE);
+		return dctool_emulator_reply (abstract, ack, sizeof (ack));
+	}
+
+	unsigned int pages = 0, crc_size = 1;
+	switch (data[0]) {
+	case CMD_VERSION:
+		*consumed = 1;
+		return oceanic_atom2_emulator_answer (abstract, layout->version, PAGESIZE, 1);
+	case CMD_READ1:
+	case CMD_READ8:
+	case CMD_READ16:
+		if (size < 3)
+			return DC_STATUS_SUCCESS;
+		*consumed = 3;
+		if (data[0] == CMD_READ1) {
+			pages = 1;
+		} else if (data[0] == CMD_READ8) {
+			pages = 8;
+		} else {
+			pages = 16;
+			crc_size = 2;
+		}
+		unsigned int address = ((data[1] << 8) | data[2]) * PAGESIZE;
+		if (address + pages * PAGESIZE > layout->memsize)
+			return dctool_emulator_reply (abstract, nak, sizeof (nak));
+		return oceanic_atom2_emulator_answer (abstract, emulator->memory + address, pages * PAGESIZE, crc_size);
+	case CMD_WRITE:
+		if (size < 3)
+			return DC_STATUS_SUCCESS;
+		*consumed = 3;
+		emulator->write = ((data[1] << 8) | data[2]) * PAGESIZE;
+		if (emulator->write + PAGESIZE > layout->memsize) {
+			emulator->write = INVALID;
+			return dctool_emulator_reply (abstract, nak, sizeof (nak));
+		}
+		return dctool_emulator_reply (abstract, ack, sizeof (ack));
+	case CMD_KEEPALIVE:
+		if (size < 3)
+			return DC_STATUS_SUCCESS;
+		*consumed = 3;
+		return dctool_emulator_reply (abstract, ack, sizeof (ack));
+	case CMD_QUIT:
+		// The quit command is acknowledged with a NAK byte.
+		if (size < 4)
+			return DC_STATUS_SUCCESS;
+		*consumed = 4;
+		return dctool_emulator_reply (abstract, nak, sizeof (nak));
+	default:
+		*consumed = 1;
+		return dctool_emulator_reply (abstract, nak, sizeof (nak));
+	}
+}
+
+static void
+oceanic_atom2_emulator_free (dctool_emulator_t *abstract)
+{
+	oceanic_atom2_emulator_t *emulator = (oceanic_atom2_emulator_t *) abstract;
+
+	free (emulator->memory);
+}
+
+const dctool_emulator_vtable_t dctool_oceanic_atom2_emulator_vtable = {
+	sizeof (oceanic_atom2_emulator_t),
+	oceanic_atom2_emulator_init, /* init */
+	oceanic_atom2_emulator_process, /* process */
+	oceanic_atom2_emulator_free, /* free */
+};
@@ -0,0 +1,432 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "emulator-private.h"
+#include "utils.h"
+
+#define PETREL   3
+#define NERD     4
+#define PERDIX   5
+#define PERDIXAI 6
+#define NERD2    7
+#define TERIC    8
+
+#define ID_SERIAL    0x8010
+#define ID_FIRMWARE  0x8011
+#define ID_LOGUPLOAD 0x8021
+#define ID_HARDWARE  0x8050
+
+#define MANIFEST_ADDR 0xE0000000
+#define RECORD_SIZE   0x20
+#define RECORD_COUNT  48
+#define BASE_ADDR     0xC0000000
+
+#define SZ_PACKET 254
+#define SZ_BLOCK  (SZ_PACKET - 2)
+#define SZ_HEADER 0x80
+#define SZ_SAMPLE 0x20
+#define SZ_FOOTER 0x100
+
+#define OC 0x10
+
+// SLIP special character codes
+#define END       0xC0
+#define ESC       0xDB
+#define ESC_END   0xDC
+#define ESC_ESC   0xDD
+
+typedef struct shearwater_petrel_emulator_t {
+	dctool_emulator_t base;
+	dc_buffer_t *memory;
+	unsigned int *offsets;
+	unsigned int manifest;
+	dc_buffer_t *stream;
+	unsigned int position;
+} shearwater_petrel_emulator_t;
+
+static void
+put_u16_be (unsigned char data[], unsigned int value)
+{
+	data[0] = (value >> 8) & 0xFF;
+	data[1] = value & 0xFF;
+}
+
+static void
+put_u32_be (unsigned char data[], unsigned int value)
+{
+	data[0] = (value >> 24) & 0xFF;
+	data[1] = (value >> 16) & 0xFF;
+	data[2] = (value >> 8) & 0xFF;
+	data[3] = value & 0xFF;
+}
+
+static dc_status_t
+shearwater_petrel_emulator_init (dctool_emulator_t *abstract)
+{
+	shearwater_petrel_emulator_t *emulator = (shearwater_petrel_emulator_t *) abstract;
+	unsigned int ndives = abstract->ndives;
+
+	emulator->manifest = 0;
+	emulator->position = 0;
+	emulator->stream = dc_buffer_new (0);
+	emulator->memory = dc_buffer_new (0);
+	emulator->offsets = (unsigned int *) malloc ((ndives + 1) * sizeof (unsigned int));
+	if (emulator->stream == NULL || emulator->memory == NULL || emulator->offsets == NULL) {
+		message ("Failed to allocate memory.\n");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	// Store the dives in the Predator-like log format: a header block,
+	// the samples, a closing block and a final block.
+	emulator->offsets[0] = 0;
+	for (unsigned int i = 0; i < ndives; ++i) {
+		unsigned int nsamples = dctool_emulator_dive_nsamples (i);
+		unsigned int maxdepth = dctool_emulator_dive_maxdepth (i);
+		unsigned int size = SZ_HEADER + nsamples * SZ_SAMPLE + SZ_FOOTER;
+		unsigned int offset = emulator->offsets[i];
+
+		if (!dc_buffer_resize (emulator->memory, offset + size)) {
+			message ("Failed to allocate memory.\n");
+			return DC_STATUS_NOMEMORY;
+		}
+
+		unsigned char *data = dc_buffer_get_data (emulator->memory) + offset;
+		memset (data, 0, size);
+
+		// Header block.
+		put_u16_be (data, 0xFFFF);
+		put_u32_be (data + 12, (unsigned int) dctool_emulator_dive_ticks (i));
+		put_u16_be (data + 47, 1013);
+		put_u16_be (data + 83, 1025);
+
+		// Samples (1/10 m, 21% O2).
+		for (unsigned int j = 0; j < nsamples; ++j) {
+			unsigned char *sample = data + SZ_HEADER + j * SZ_SAMPLE;
+			put_u16_be (sample, dctool_emulator_dive_depth (i, j) / 10);
+			sample[7] = 21;
+			sample[11] = OC;
+			sample[13] = 20;
+		}
+
+		// Closing and final block.
+		unsigned char *closing = data + size - SZ_FOOTER;
+		put_u16_be (closing + 4, maxdepth / 100);
+		put_u16_be (closing + 6, nsamples * 10 / 60);
+		put_u16_be (closing + SZ_FOOTER / 2, 0xFFFD);
+
+		emulator->offsets[i + 1] = offset + size;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+shearwater_petrel_emulator_send (dctool_emulator_t *abstract, const unsigned char data[], unsigned int size)
+{
+	unsigned char packet[2 * (SZ_PACKET + 4) + 1];
+	unsigned char header[4] = {0x01, 0xFF, size + 1, 0x00};
+	unsigned int n = 0;
+
+	for (unsigned int i = 0; i < sizeof (header) + size; ++i) {
+		unsigned char c = i < sizeof (header) ? header[i] : data[i - sizeof (header)];
+		if (c == END) {
+			packet[n++] = ESC;
+			packet[n++] = ESC_END;
+		} else if (c == ESC) {
+			packet[n++] = ESC;
+			packet[n++] = ESC_ESC;
+		} else {
+			packet[n++] = c;
+		}
+	}
+	packet[n++] = END;
+
+	return dctool_emulator_reply (abstract, packet, n);
+}
+
+static dc_status_t
+shearwater_petrel_emulator_compress (dc_buffer_t *buffer, const unsigned char data[], unsigned int size)
+{
+	unsigned int value = 0, nbits = 0, nvalues = 0;
+	unsigned int offset = 0, done = 0;
+
+	dc_buffer_clear (buffer);
+
+	// Each block of 32 bytes is XOR'ed with the previous block, and the
+	// result is encoded as a stream of 9 bit values, where runs of zero
+	// bytes are replaced with their length. A zero value marks the end
+	// of the stream, which is padded to a multiple of 9 bytes.
+	while (!done || nvalues % 8 != 0) {
+		unsigned int code = 0;
+		if (offset < size) {
+			unsigned int run = 0;
+			while (offset + run < size && run < 0xFF &&
+				(data[offset + run] ^ (offset + run >= 32 ? data[offset + run - 32] : 0)) == 0)
+				run++;
+			if (run) {
+				code = run;
+				offset += run;
+			} else {
+				code = 0x100 | (data[offset] ^ (offset >= 32 ? data[offset - 32] : 0));
+				offset++;
+			}
+		} else {
+			done = 1;
+		}
+
+		value = (value << 9) | code;
+		nbits += 9;
+		nvalues++;
+
+		while (nbits >= 8) {
+			unsigned char c = (value >> (nbits - 8)) & 0xFF;
+			if (!dc_buffer_append (buffer, &c, 1))
+				return DC_STATUS_NOMEMORY;
+			nbits -= 8;
+		}
+		value &= (1 << nbits) - 1;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+shearwater_petrel_emulator_download (shearwater_petrel_emulator_t *emulator, unsigned int address, unsigned int size, unsigned int compression)
+{
+	dctool_emulator_t *abstract = (dctool_emulator_t *) emulator;
+	const unsigned char *data = NULL;
+	unsigned int length = 0;
+	unsigned char manifest[RECORD_SIZE * RECORD_COUNT];
+
+	if (address == MANIFEST_ADDR) {
+		// Every download returns the next page of the manifest, with the
+		// most recent dives first.
+		unsigned int page = emulator->manifest++;
+		memset (manifest, 0xFF, sizeof (manifest));
+		for (unsigned int i = 0; i < RECORD_COUNT; ++i) {
+			unsigned int n = page * RECORD_COUNT + i;
+			if (n >= abstract->ndives)
+				break;
+
+			unsigned int dive = abstract->ndives - 1 - n;
+			unsigned char *record = manifest + i * RECORD_SIZE;
+			memset (record, 0, RECORD_SIZE);
+			put_u16_be (record, 0xA5C4);
+			put_u32_be (record + 4, (unsigned int) dctool_emulator_dive_ticks (dive));
+			put_u32_be (record + 20, emulator->offsets[dive]);
+		}
+		data = manifest;
+		length = sizeof (manifest);
+	} else if (address >= BASE_ADDR) {
+		emulator->manifest = 0;
+		for (unsigned int i = 0; i < abstract->ndives; ++i) {
+			if (emulator->offsets[i] == address - BASE_ADDR) {
+				data = dc_buffer_get_data (emulator->memory) + emulator->offsets[i];
+				length = emulator->offsets[i + 1] - emulator->offsets[i];
+				break;
+			}
+		}
+	}
+
+	if (data == NULL) {
+		message ("Emulator: download of unknown address 0x%08x.\n", address);
+		const unsigned char response[] = {0x7F, 0x35, 0x31};
+		return shearwater_petrel_emulator_send (abstract, response, sizeof (response));
+	}
+
+	if (length > size)
+		length = size;
+
+	emulator->position = 0;
+	if (compression) {
+		dc_status_t status = shearwater_petrel_emulator_compress (emulator->stream, data, length);
+		if (status != DC_STATUS_SUCCESS) {
+			message ("Failed to allocate memory.\n");
+			return status;
+		}
+	} else {
+		dc_buffer_clear (emulator->stream);
+		if (!dc_buffer_append (emulator->stream, data, length)) {
+			message ("Failed to allocate memory.\n");
+			return DC_STATUS_NOMEMORY;
+		}
+	}
+
+	const unsigned char response[] = {0x75, 0x10, SZ_BLOCK};
+	return shearwater_petrel_emulator_send (abstract, response, sizeof (response));
+}
+
+static dc_status_t
+shearwater_petrel_emulator_identifier (shearwater_petrel_emulator_t *emulator, unsigned int id)
+{
+	dctool_emulator_t *abstract = (dctool_emulator_t *) emulator;
+	unsigned char response[3 + 16] = {0x62, (id >> 8) & 0xFF, id & 0xFF};
+	unsigned int n = 3;
+
+	switch (id) {
+	case ID_SERIAL:
+		memcpy (response + n, "12345678", 8);
+		n += 8;
+		break;
+	case ID_FIRMWARE:
+		memcpy (response + n, "V71", 3);
+		n += 3;
+		break;
+	case ID_HARDWARE:
+		switch (abstract->model) {
+		case NERD:
+			put_u16_be (response + n, 0x0A0A);
+			break;
+		case PERDIX:
+			put_u16_be (response + n, 0x0707);
+			break;
+		case PERDIXAI:
+			put_u16_be (response + n, 0x0C0D);
+			break;
+		case NERD2:
+			put_u16_be (response + n, 0x0E0D);
+			break;
+		case TERIC:
+			put_u16_be (response + n, 0x0F0F);
+			break;
+		default:
+			put_u16_be (response + n, 0x0808);
+			break;
+		}
+		n += 2;
+		break;
+	case ID_LOGUPLOAD:
+		memset (response + n, 0, 9);
+		put_u32_be (response + n + 1, BASE_ADDR);
+		n += 9;
+		break;
+	default:
+		response[0] = 0x7F;
+		response[1] = 0x22;
+		response[2] = 0x31;
+		break;
+	}
+
+	return shearwater_petrel_emulator_send (abstract, response, n);
+}
+
+static dc_status_t
+shearwater_petrel_emulator_block (shearwater_petrel_emulator_t *emulator, unsigned int block)
+{
+	dctool_emulator_t *abstract = (dctool_emulator_t *) emulator;
+	unsigned char response[SZ_PACKET] = {0x76, block};
+
+	unsigned int available = dc_buffer_get_size (emulator->stream) - emulator->position;
+	unsigned int length = available < SZ_BLOCK ? available : SZ_BLOCK;
+	memcpy (response + 2, dc_buffer_get_data (emulator->stream) + emulator->position, length);
+	emulator->position += length;
+
+	return shearwater_petrel_emulator_send (abstract, response, length + 2);
+}
+
+static dc_status_t
+shearwater_petrel_emulator_request (shearwater_petrel_emulator_t *emulator, const unsigned char data[], unsigned int size)
+{
+	dctool_emulator_t *abstract = (dctool_emulator_t *) emulator;
+	const unsigned char quit[] = {0x77, 0x00};
+
+	if (size == 0)
+		return DC_STATUS_SUCCESS;
+
+	if (data[0] == 0x22 && size == 3) {
+		return shearwater_petrel_emulator_identifier (emulator, (data[1] << 8) | data[2]);
+	} else if (data[0] == 0x35 && size == 10) {
+		return shearwater_petrel_emulator_download (emulator,
+			((unsigned int) data[3] << 24) | (data[4] << 16) | (data[5] << 8) | data[6],
+			(data[7] << 16) | (data[8] << 8) | data[9],
+			data[1] & 0x10);
+	} else if (data[0] == 0x36 && size == 2) {
+		return shearwater_petrel_emulator_block (emulator, data[1]);
+	} else if (data[0] == 0x37 && size == 1) {
+		return shearwater_petrel_emulator_send (abstract, quit, sizeof (quit));
+	} else if (data[0] == 0x2E) {
+		// The shutdown request is not answered.
+		return DC_STATUS_SUCCESS;
+	}
+
+	const unsigned char response[] = {0x7F, data[0], 0x12};
+	return shearwater_petrel_emulator_send (abstract, response, sizeof (response));
+}
+
+static dc_status_t
+shearwater_petrel_emulator_process (dctool_emulator_t *abstract, const unsigned char data[], size_t size, size_t *consumed)
+{
+	shearwater_petrel_emulator_t *emulator = (shearwater_petrel_emulator_t *) abstract;
+
+	// Wait for the end of the SLIP frame.
+	const unsigned char *end = (const unsigned char *) memchr (data, END, size);
+	if (end == NULL)
+		return DC_STATUS_SUCCESS;
+
+	*consumed = end - data + 1;
+
+	unsigned char packet[SZ_PACKET + 4];
+	unsigned int n = 0;
+	for (const unsigned char *p = data; p < end; ++p) {
+		unsigned char c = *p;
+		if (c == ESC && p + 1 < end) {
+			c = *++p == ESC_END ? END : ESC;
+		}
+		if (n >= sizeof (packet)) {
+			message ("Emulator: ignored an oversized packet.\n");
+			return DC_STATUS_SUCCESS;
+		}
+		packet[n++] = c;
+	}
+
+	// Empty frames are ignored.
+	if (n == 0)
+		return DC_STATUS_SUCCESS;
+
+	if (n < 4 || packet[0] != 0xFF || packet[1] != 0x01 ||
+		packet[2] != n - 3 || packet[3] != 0x00) {
+		message ("Emulator: ignored an invalid packet.\n");
+		return DC_STATUS_SUCCESS;
+	}
+
+	return shearwater_petrel_emulator_request (emulator, packet + 4, n - 4);
+}
+
+static void
+shearwater_petrel_emulator_free (dctool_emulator_t *abstract)
+{
+	shearwater_petrel_emulator_t *emulator = (shearwater_petrel_emulator_t *) abstract;
+
+	dc_buffer_free (emulator->stream);
+	dc_buffer_free (emulator->memory);
+	free (emulator->offsets);
+}
+
+const dctool_emulator_vtable_t dctool_shearwater_petrel_emulator_vtable = {
+	sizeof (shearwater_petrel_emulator_t),
+	shearwater_petrel_emulator_init, /* init */
+	shearwater_petrel_emulator_process, /* process */
+	shearwater_petrel_emulator_free, /* free */
+};
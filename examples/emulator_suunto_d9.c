@@ -0,0 +1,369 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "emulator-private.h"
+#include "utils.h"
+
+#define D4        0x12
+#define HELO2     0x15
+#define D4i       0x19
+#define D6i       0x1A
+#define D9tx      0x1B
+#define DX        0x1C
+#define VYPERNOVO 0x1D
+#define ZOOPNOVO  0x1E
+#define D4F       0x20
+
+#define CMD_VERSION  0x0F
+#define CMD_READ     0x05
+#define CMD_WRITE    0x06
+#define CMD_RESET    0x20
+
+#define SZ_HEADER 0x0190
+
+#define AIR       0
+#define DEPTH     0x64
+#define DIVISOR   0x18 // 1/100
+
+typedef struct suunto_d9_layout_t {
+	unsigned int memsize;
+	unsigned int fingerprint;
+	unsigned int serial;
+	unsigned int rb_profile_begin;
+	unsigned int rb_profile_end;
+} suunto_d9_layout_t;
+
+typedef struct suunto_d9_emulator_t {
+	dctool_emulator_t base;
+	const suunto_d9_layout_t *layout;
+	unsigned char *memory;
+} suunto_d9_emulator_t;
+
+static const suunto_d9_layout_t suunto_d9_layout = {
+	0x8000, 0x0011, 0x0023, 0x019A, 0x7FFE
+};
+
+static const suunto_d9_layout_t suunto_d9tx_layout = {
+	0x10000, 0x0013, 0x0024, 0x019A, 0xEBF0
+};
+
+static const suunto_d9_layout_t suunto_dx_layout = {
+	0x10000, 0x0017, 0x0024, 0x019A, 0xEBF0
+};
+
+static unsigned int
+suunto_d9_emulator_isnewer (unsigned int model)
+{
+	return model == D4i || model == D6i || model == D9tx || model == DX ||
+		model == VYPERNOVO || model == ZOOPNOVO || model == D4F;
+}
+
+/*
+ * Offset to the sample configuration, which is located right after the
+ * gas mixes. The parser uses the same model dependent offsets.
+ */
+static unsigned int
+suunto_d9_emulator_config (unsigned int model)
+{
+	switch (model) {
+	case D4:
+		return 0x3B;
+	case HELO2:
+		return 0x54 + 8 * 6;
+	case D4i:
+	case ZOOPNOVO:
+	case D4F:
+		return 0x5F + 1 * 6;
+	case D6i:
+	case VYPERNOVO:
+		return 0x5F + 2 * 6;
+	case D9tx:
+		return 0x87 + 8 * 6;
+	case DX:
+		return 0xC1 + 11 * 6;
+	default:
+		return 0x3A;
+	}
+}
+
+static void
+suunto_d9_emulator_dive (suunto_d9_emulator_t *emulator, unsigned char data[], unsigned int dive)
+{
+	unsigned int model = emulator->base.model;
+	unsigned int nsamples = dctool_emulator_dive_nsamples (dive);
+	unsigned int maxdepth = dctool_emulator_dive_maxdepth (dive);
+	unsigned int divetime = nsamples * 10;
+	unsigned int config = suunto_d9_emulator_config (model);
+
+	// Dive time and maximum depth.
+	unsigned int offset = 0x0B;
+	if (suunto_d9_emulator_isnewer (model) || model == HELO2)
+		offset = 0x0D;
+	if (suunto_d9_emulator_isnewer (model) || model == D4) {
+		data[offset + 0] = divetime & 0xFF;
+		data[offset + 1] = (divetime >> 8) & 0xFF;
+	} else {
+		data[offset + 0] = (divetime / 60) & 0xFF;
+		data[offset + 1] = ((divetime / 60) >> 8) & 0xFF;
+	}
+	data[0x09] = maxdepth & 0xFF;
+	data[0x0A] = (maxdepth >> 8) & 0xFF;
+
+	// The date and time are used as the fingerprint. The HelO2 stores
+	// them at a different location, and uses the dive number instead.
+	dc_datetime_t dt;
+	dc_datetime_gmtime (&dt, dctool_emulator_dive_ticks (dive));
+	unsigned char *p = data + emulator->layout->fingerprint;
+	if (model == HELO2) {
+		p[0] = dive & 0xFF;
+		p[1] = (dive >> 8) & 0xFF;
+		p = data + 0x17;
+	}
+	if (suunto_d9_emulator_isnewer (model)) {
+		p[0] = dt.year & 0xFF;
+		p[1] = (dt.year >> 8) & 0xFF;
+		p[2] = dt.month;
+		p[3] = dt.day;
+		p[4] = dt.hour;
+		p[5] = dt.minute;
+		p[6] = dt.second;
+	} else {
+		p[0] = dt.hour;
+		p[1] = dt.minute;
+		p[2] = dt.second;
+		p[3] = dt.year & 0xFF;
+		p[4] = (dt.year >> 8) & 0xFF;
+		p[5] = dt.month;
+		p[6] = dt.day;
+	}
+
+	// Sample interval (seconds) and dive mode.
+	if (model == DX) {
+		data[0x21] = AIR;
+		data[0x22] = 10;
+	} else if (suunto_d9_emulator_isnewer (model)) {
+		data[0x1D] = AIR;
+		data[0x1E] = 10;
+	} else if (model == HELO2) {
+		data[0x1F] = AIR;
+		data[0x1E] = 10;
+	} else {
+		data[0x18] = 10;
+		data[0x19] = AIR;
+	}
+
+	// A single depth parameter, recorded with every sample.
+	data[config + 0] = 1;
+	data[config + 2] = DEPTH;
+	data[config + 3] = 1;
+	data[config + 4] = DIVISOR;
+
+	// The profile starts without any event markers.
+	unsigned char *profile = data + config + 5;
+	profile[0] = 0x01;
+	profile[1] = 0x00;
+	profile[2] = 0x00;
+	profile[3] = 0x00;
+	profile[4] = 0x00;
+
+	unsigned char *samples = profile + 5;
+	for (unsigned int i = 0; i < nsamples; ++i) {
+		unsigned int depth = dctool_emulator_dive_depth (dive, i);
+		samples[2 * i + 0] = depth & 0xFF;
+		samples[2 * i + 1] = (depth >> 8) & 0xFF;
+	}
+}
+
+static dc_status_t
+suunto_d9_emulator_init (dctool_emulator_t *abstract)
+{
+	suunto_d9_emulator_t *emulator = (suunto_d9_emulator_t *) abstract;
+	unsigned int model = abstract->model;
+
+	if (model == D4i || model == D6i || model == D9tx ||
+		model == VYPERNOVO || model == ZOOPNOVO || model == D4F)
+		emulator->layout = &suunto_d9tx_layout;
+	else if (model == DX)
+		emulator->layout = &suunto_dx_layout;
+	else
+		emulator->layout = &suunto_d9_layout;
+
+	const suunto_d9_layout_t *layout = emulator->layout;
+	unsigned int rb_size = layout->rb_profile_end - layout->rb_profile_begin;
+	// The sample configuration and the profile header have five bytes each.
+	unsigned int header = suunto_d9_emulator_config (model) + 5 + 5;
+
+	emulator->memory = (unsigned char *) malloc (layout->memsize);
+	if (emulator->memory == NULL) {
+		message ("Failed to allocate memory.\n");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	memset (emulator->memory, 0xFF, layout->memsize);
+
+	// Serial number (decimal digit pairs).
+	const unsigned char serial[] = {12, 34, 56, 78};
+	memcpy (emulator->memory + layout->serial, serial, sizeof (serial));
+
+	// Only the most recent dives that fit in the ringbuffer are kept.
+	unsigned int first = 0, total = 0;
+	for (unsigned int i = abstract->ndives; i > 0; --i) {
+		unsigned int size = 4 + header + 2 * dctool_emulator_dive_nsamples (i - 1);
+		if (total + size >= rb_size) {
+			first = i;
+			break;
+		}
+		total += size;
+	}
+
+	// Fill the profile ringbuffer. Each dive is preceded by a pointer to
+	// the previous and the next dive. The dives never wrap around. The
+	// dives contain a header in air mode, with only the fields the parser
+	// needs, followed by a depth profile without any events.
+	unsigned int begin = layout->rb_profile_begin, last = begin, address = begin;
+	unsigned int previous = begin;
+	for (unsigned int i = first; i < abstract->ndives; ++i) {
+		unsigned int nsamples = dctool_emulator_dive_nsamples (i);
+		unsigned int size = 4 + header + 2 * nsamples;
+		unsigned int next = address + size;
+
+		unsigned char *dive = emulator->memory + address;
+		memset (dive, 0, size);
+		dive[0] = previous & 0xFF;
+		dive[1] = (previous >> 8) & 0xFF;
+		dive[2] = next & 0xFF;
+		dive[3] = (next >> 8) & 0xFF;
+		suunto_d9_emulator_dive (emulator, dive + 4, i);
+
+		previous = last = address;
+		address = next;
+	}
+
+	// The header with the ringbuffer pointers.
+	unsigned int count = abstract->ndives - first;
+	unsigned char *pointers = emulator->memory + SZ_HEADER;
+	pointers[0] = last & 0xFF;
+	pointers[1] = (last >> 8) & 0xFF;
+	pointers[2] = count & 0xFF;
+	pointers[3] = (count >> 8) & 0xFF;
+	pointers[4] = address & 0xFF;
+	pointers[5] = (address >> 8) & 0xFF;
+	pointers[6] = begin & 0xFF;
+	pointers[7] = (begin >> 8) & 0xFF;
+
+	return DC_STATUS_SUCCESS;
+}
+
+static unsigned char
+suunto_d9_emulator_checksum (const unsigned char data[], unsigned int size)
+{
+	unsigned char crc = 0x00;
+	for (unsigned int i = 0; i < size; ++i)
+		crc ^= data[i];
+	return crc;
+}
+
+static dc_status_t
+suunto_d9_emulator_process (dctool_emulator_t *abstract, const unsigned char data[], size_t size, size_t *consumed)
+{
+	suunto_d9_emulator_t *emulator = (suunto_d9_emulator_t *) abstract;
+	dc_status_t status = DC_STATUS_SUCCESS;
+	const suunto_d9_layout_t *layout = emulator->layout;
+
+	// Every command is followed by a big endian length, the
+	// parameters and an xor checksum.
+	if (size < 3)
+		return DC_STATUS_SUCCESS;
+
+	unsigned int length = (data[1] << 8) | data[2];
+	if (size < length + 4)
+		return DC_STATUS_SUCCESS;
+
+	*consumed = length + 4;
+
+	if (suunto_d9_emulator_checksum (data, length + 3) != data[length + 3]) {
+		message ("Emulator: ignored a command with a bad checksum.\n");
+		return DC_STATUS_SUCCESS;
+	}
+
+	// The interface echoes the command.
+	status = dctool_emulator_reply (abstract, data, length + 4);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
+	unsigned char answer[3 + 3 + 0xFF + 1] = {data[0], 0x00, 0x00};
+	unsigned int n = 3;
+	switch (data[0]) {
+	case CMD_VERSION:
+		answer[n++] = abstract->model;
+		answer[n++] = 0x01;
+		answer[n++] = 0x02;
+		answer[n++] = 0x03;
+		break;
+	case CMD_READ:
+	case CMD_WRITE:
+		if (length < 3)
+			return DC_STATUS_SUCCESS;
+		unsigned int address = (data[3] << 8) | data[4];
+		unsigned int count = data[5];
+		memcpy (answer + n, data + 3, 3);
+		n += 3;
+		if (address + count > layout->memsize)
+			return DC_STATUS_SUCCESS;
+		if (data[0] == CMD_READ) {
+			memcpy (answer + n, emulator->memory + address, count);
+			n += count;
+		} else if (length == count + 3) {
+			memcpy (emulator->memory + address, data + 6, count);
+		}
+		break;
+	case CMD_RESET:
+		break;
+	default:
+		// Unknown commands are not answered.
+		return DC_STATUS_SUCCESS;
+	}
+
+	answer[1] = ((n - 3) >> 8) & 0xFF;
+	answer[2] = (n - 3) & 0xFF;
+	answer[n] = suunto_d9_emulator_checksum (answer, n);
+
+	return dctool_emulator_reply (abstract, answer, n + 1);
+}
+
+static void
+suunto_d9_emulator_free (dctool_emulator_t *abstract)
+{
+	suunto_d9_emulator_t *emulator = (suunto_d9_emulator_t *) abstract;
+
+	free (emulator->memory);
+}
+
+const dctool_emulator_vtable_t dctool_suunto_d9_emulator_vtable = {
+	sizeof (suunto_d9_emulator_t),
+	suunto_d9_emulator_init, /* init */
+	suunto_d9_emulator_process, /* process */
+	suunto_d9_emulator_free, /* free */
+};
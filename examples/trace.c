@@ -0,0 +1,802 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#define NOGDI
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <libdivecomputer/custom.h>
+
+#include "trace.h"
+#include "common.h"
+#include "utils.h"
+
+/*
+ * The trace file starts with a header:
+ *
+ *   magic[8], version[4], transport[4]
+ *
+ * followed by one record for every operation:
+ *
+ *   operation[1], status[1], delay[4], duration[4], arguments
+ *
+ * The delay is the time between the start of the previous and the
+ * current operation, and the duration is the time the operation
+ * took, both in microseconds. All numbers are little endian.
+ */
+
+#define MAGIC   "DCTRACE"
+#define VERSION 1
+
+#define SZ_HEADER 16
+#define SZ_RECORD 10
+
+typedef enum trace_op_t {
+	OP_SET_TIMEOUT = 1, // timeout[4]
+	OP_SET_BREAK,       // value[4]
+	OP_SET_DTR,         // value[4]
+	OP_SET_RTS,         // value[4]
+	OP_GET_LINES,       // value[4]
+	OP_GET_AVAILABLE,   // value[4]
+	OP_CONFIGURE,       // baudrate[4], databits[1], parity[1], stopbits[1], flowcontrol[1]
+	OP_POLL,            // timeout[4]
+	OP_READ,            // size[4], actual[4], data[actual]
+	OP_WRITE,           // size[4], actual[4], data[size]
+	OP_IOCTL,           // request[4], size[4], data[size]
+	OP_FLUSH,           //
+	OP_PURGE,           // direction[4]
+	OP_SLEEP,           // milliseconds[4]
+} trace_op_t;
+
+typedef struct record_t {
+	dc_iostream_t *iostream;
+	FILE *fp;
+	unsigned long long previous;
+} record_t;
+
+typedef struct replay_t {
+	dc_buffer_t *buffer;
+	const unsigned char *data;
+	size_t size;
+	size_t offset;
+	unsigned int realtime;
+	unsigned long long start;
+	unsigned long long timestamp;
+} replay_t;
+
+static unsigned long long
+trace_now (void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency (&frequency);
+	QueryPerformanceCounter (&counter);
+	return counter.QuadPart * 1000000ULL / frequency.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (unsigned long long) ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+#endif
+}
+
+static void
+trace_wait (unsigned long long until)
+{
+	unsigned long long now = trace_now ();
+	if (now >= until)
+		return;
+
+	unsigned long long us = until - now;
+#ifdef _WIN32
+	Sleep ((DWORD) ((us + 999) / 1000));
+#else
+	struct timespec ts;
+	ts.tv_sec  = us / 1000000;
+	ts.tv_nsec = (us % 1000000) * 1000;
+	while (nanosleep (&ts, &ts) != 0) {}
+#endif
+}
+
+static void
+put_u32 (unsigned char data[], unsigned int value)
+{
+	data[0] = value & 0xFF;
+	data[1] = (value >> 8) & 0xFF;
+	data[2] = (value >> 16) & 0xFF;
+	data[3] = (value >> 24) & 0xFF;
+}
+
+static unsigned int
+get_u32 (const unsigned char data[])
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int) data[3] << 24);
+}
+
+/*
+ * Recording.
+ */
+
+static void
+record_write (record_t *record, trace_op_t op, dc_status_t status, unsigned long long start, const unsigned char args[], size_t nargs, const void *data, size_t size)
+{
+	unsigned long long now = trace_now ();
+	unsigned char header[SZ_RECORD];
+
+	header[0] = op;
+	header[1] = (unsigned char) (signed char) status;
+	put_u32 (header + 2, (unsigned int) (start - record->previous));
+	put_u32 (header + 6, (unsigned int) (now - start));
+	record->previous = start;
+
+	fwrite (header, 1, sizeof (header), record->fp);
+	if (nargs)
+		fwrite (args, 1, nargs, record->fp);
+	if (size)
+		fwrite (data, 1, size, record->fp);
+}
+
+static void
+record_value (record_t *record, trace_op_t op, dc_status_t status, unsigned long long start, unsigned int value)
+{
+	unsigned char args[4];
+
+	put_u32 (args, value);
+	record_write (record, op, status, start, args, sizeof (args), NULL, 0);
+}
+
+static dc_status_t
+record_set_timeout (void *userdata, int timeout)
+{
+	record_t *record = (record_t *) userdata;
+	unsigned long long start = trace_now ();
+
+	dc_status_t status = dc_iostream_set_timeout (record->iostream, timeout);
+	record_value (record, OP_SET_TIMEOUT, status, start, (unsigned int) timeout);
+
+	return status;
+}
+
+static dc_status_t
+record_set_break (void *userdata, unsigned int value)
+{
+	record_t *record = (record_t *) userdata;
+	unsigned long long start = trace_now ();
+
+	dc_status_t status = dc_iostream_set_break (record->iostream, value);
+	record_value (record, OP_SET_BREAK, status, start, value);
+
+	return status;
+}
+
+static dc_status_t
+record_set_dtr (void *userdata, unsigned int value)
+{
+	record_t *record = (record_t *) userdata;
+	unsigned long long start = trace_now ();
+
+	dc_status_t status = dc_iostream_set_dtr (record->iostream, value);
+	record_value (record, OP_SET_DTR, status, start, value);
+
+	return status;
+}
+
+static dc_status_t
+record_set_rts (void *userdata, unsigned int value)
+{
+	record_t *record = (record_t *) userdata;
+	unsigned long long start = trace_now ();
+
+	dc_status_t status = dc_iostream_set_rts (record->iostream, value);
+	record_value (record, OP_SET_RTS, status, start, value);
+
+	return status;
+}
+
+static dc_status_t
+record_get_lines (void *userdata, unsigned int *value)
+{
+	record_t *record = (record_t *) userdata;
+	unsigned long long start = trace_now ();
+	unsigned int lines = 0;
+
+	dc_status_t status = dc_iostream_get_lines (record->iostream, &lines);
+	record_value (record, OP_GET_LINES, status, start, lines);
+
+	if (value)
+		*value = lines;
+
+	return status;
+}
+
+static dc_status_t
+record_get_available (void *userdata, size_t *value)
+{
+	record_t *record = (record_t *) userdata;
+	unsigned long long start = trace_now ();
+	size_t available = 0;
+
+	dc_status_t status = dc_iostream_get_available (record->iostream, &available);
+	record_value (record, OP_GET_AVAILABLE, status, start, (unsigned int) available);
+
+	if (value)
+		*value = available;
+
+	return status;
+}
+
+static dc_status_t
+record_configure (void *userdata, unsigned int baudrate, unsigned int databits, dc_parity_t parity, dc_stopbits_t stopbits, dc_flowcontrol_t flowcontrol)
+{
+	record_t *record = (record_t *) userdata;
+	unsigned long long start = trace_now ();
+	unsigned char args[8];
+
+	dc_status_t status = dc_iostream_configure (record->iostream, baudrate, databits, parity, stopbits, flowcontrol);
+
+	put_u32 (args, baudrate);
+	args[4] = databits;
+	args[5] = parity;
+	args[6] = stopbits;
+	args[7] = flowcontrol;
+	record_write (record, OP_CONFIGURE, status, start, args, sizeof (args), NULL, 0);
+
+	return status;
+}
+
+static dc_status_t
+record_poll (void *userdata, int timeout)
+{
+	record_t *record = (record_t *) userdata;
+	unsigned long long start = trace_now ();
+
+	dc_status_t status = dc_iostream_poll (record->iostream, timeout);
+	record_value (record, OP_POLL, status, start, (unsigned int) timeout);
+
+	return status;
+}
+
+static dc_status_t
+record_read (void *userdata, void *data, size_t size, size_t *actual)
+{
+	record_t *record = (record_t *) userdata;
+	unsigned long long start = trace_now ();
+	unsigned char args[8];
+	size_t nbytes = 0;
+
+	dc_status_t status = dc_iostream_read (record->iostream, data, size, &nbytes);
+
+	put_u32 (args, (unsigned int) size);
+	put_u32 (args + 4, (unsigned int) nbytes);
+	record_write (record, OP_READ, status, start, args, sizeof (args), data, nbytes);
+
+	if (actual)
+		*actual = nbytes;
+
+	return status;
+}
+
+static dc_status_t
+record_write_data (void *userdata, const void *data, size_t size, size_t *actual)
+{
+	record_t *record = (record_t *) userdata;
+	unsigned long long start = trace_now ();
+	unsigned char args[8];
+	size_t nbytes = 0;
+
+	dc_status_t status = dc_iostream_write (record->iostream, data, size, &nbytes);
+
+	put_u32 (args, (unsigned int) size);
+	put_u32 (args + 4, (unsigned int) nbytes);
+	record_write (record, OP_WRITE, status, start, args, sizeof (args), data, size);
+
+	if (actual)
+		*actual = nbytes;
+
+	return status;
+}
+
+static dc_status_t
+record_ioctl (void *userdata, unsigned int request, void *data, size_t size)
+{
+	record_t *record = (record_t *) userdata;
+	unsigned long long start = trace_now ();
+	unsigned char args[8];
+
+	dc_status_t status = dc_iostream_ioctl (record->iostream, request, data, size);
+
+	put_u32 (args, request);
+	put_u32 (args + 4, (unsigned int) size);
+	record_write (record, OP_IOCTL, status, start, args, sizeof (args), data, size);
+
+	return status;
+}
+
+static dc_status_t
+record_flush (void *userdata)
+{
+	record_t *record = (record_t *) userdata;
+	unsigned long long start = trace_now ();
+
+	dc_status_t status = dc_iostream_flush (record->iostream);
+	record_write (record, OP_FLUSH, status, start, NULL, 0, NULL, 0);
+
+	return status;
+}
+
+static dc_status_t
+record_purge (void *userdata, dc_direction_t direction)
+{
+	record_t *record = (record_t *) userdata;
+	unsigned long long start = trace_now ();
+
+	dc_status_t status = dc_iostream_purge (record->iostream, direction);
+	record_value (record, OP_PURGE, status, start, direction);
+
+	return status;
+}
+
+static dc_status_t
+record_sleep (void *userdata, unsigned int milliseconds)
+{
+	record_t *record = (record_t *) userdata;
+	unsigned long long start = trace_now ();
+
+	dc_status_t status = dc_iostream_sleep (record->iostream, milliseconds);
+	record_value (record, OP_SLEEP, status, start, milliseconds);
+
+	return status;
+}
+
+static dc_status_t
+record_close (void *userdata)
+{
+	record_t *record = (record_t *) userdata;
+
+	dc_status_t status = dc_iostream_close (record->iostream);
+
+	if (fclose (record->fp) != 0) {
+		message ("Failed to write the trace file.\n");
+		if (status == DC_STATUS_SUCCESS)
+			status = DC_STATUS_IO;
+	}
+
+	free (record);
+
+	return status;
+}
+
+static const dc_custom_cbs_t g_record = {
+	record_set_timeout, /* set_timeout */
+	record_set_break, /* set_break */
+	record_set_dtr, /* set_dtr */
+	record_set_rts, /* set_rts */
+	record_get_lines, /* get_lines */
+	record_get_available, /* get_available */
+	record_configure, /* configure */
+	record_poll, /* poll */
+	record_read, /* read */
+	record_write_data, /* write */
+	record_ioctl, /* ioctl */
+	record_flush, /* flush */
+	record_purge, /* purge */
+	record_sleep, /* sleep */
+	record_close, /* close */
+};
+
+dc_status_t
+dctool_record_open (dc_iostream_t **out, dc_context_t *context, dc_iostream_t *base, const char *filename)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	record_t *record = NULL;
+	unsigned char header[SZ_HEADER] = {0};
+
+	if (out == NULL || filename == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	if (base == NULL) {
+		message ("Recording requires an I/O stream.\n");
+		return DC_STATUS_UNSUPPORTED;
+	}
+
+	record = (record_t *) malloc (sizeof (record_t));
+	if (record == NULL) {
+		return DC_STATUS_NOMEMORY;
+	}
+
+	record->iostream = base;
+	record->previous = trace_now ();
+	record->fp = fopen (filename, "wb");
+	if (record->fp == NULL) {
+		message ("Failed to open the trace file '%s'.\n", filename);
+		status = DC_STATUS_IO;
+		goto error_free;
+	}
+
+	memcpy (header, MAGIC, sizeof (MAGIC));
+	put_u32 (header + 8, VERSION);
+	put_u32 (header + 12, dc_iostream_get_transport (base));
+	fwrite (header, 1, sizeof (header), record->fp);
+
+	status = dc_custom_open (out, context, dc_iostream_get_transport (base), &g_record, record);
+	if (status != DC_STATUS_SUCCESS) {
+		goto error_close;
+	}
+
+	return DC_STATUS_SUCCESS;
+
+error_close:
+	fclose (record->fp);
+error_free:
+	free (record);
+	return status;
+}
+
+/*
+ * Replaying.
+ */
+
+static const char *
+replay_opname (unsigned int op)
+{
+	static const char *names[] = {
+		"none", "set_timeout", "set_break", "set_dtr", "set_rts",
+		"get_lines", "get_available", "configure", "poll", "read",
+		"write", "ioctl", "flush", "purge", "sleep"};
+
+	if (op >= sizeof (names) / sizeof (*names))
+		return "unknown";
+
+	return names[op];
+}
+
+/*
+ * Fetch the next record, which should be of the expected type, and
+ * make sure its fixed size arguments are present.
+ */
+static const unsigned char *
+replay_next (replay_t *replay, trace_op_t op, size_t nargs, dc_status_t *status)
+{
+	if (replay->offset + SZ_RECORD + nargs > replay->size) {
+		message ("Trace mismatch: unexpected %s at the end of the trace.\n",
+			replay_opname (op));
+		*status = DC_STATUS_IO;
+		return NULL;
+	}
+
+	const unsigned char *p = replay->data + replay->offset;
+	if (p[0] != op) {
+		message ("Trace mismatch: expected %s, found %s at offset %lu.\n",
+			replay_opname (op), replay_opname (p[0]), (unsigned long) replay->offset);
+		*status = DC_STATUS_IO;
+		return NULL;
+	}
+
+	*status = (dc_status_t) (signed char) p[1];
+	replay->timestamp += get_u32 (p + 2);
+
+	return p + SZ_RECORD;
+}
+
+/*
+ * Consume the current record, and in realtime mode, wait until the
+ * operation took as long as the original one.
+ */
+static void
+replay_done (replay_t *replay, size_t length)
+{
+	const unsigned char *p = replay->data + replay->offset;
+
+	replay->offset += SZ_RECORD + length;
+
+	if (replay->realtime)
+		trace_wait (replay->start + replay->timestamp + get_u32 (p + 6));
+}
+
+static dc_status_t
+replay_value (replay_t *replay, trace_op_t op, unsigned int *value)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	const unsigned char *args = replay_next (replay, op, 4, &status);
+	if (args == NULL)
+		return status;
+
+	if (value)
+		*value = get_u32 (args);
+
+	replay_done (replay, 4);
+
+	return status;
+}
+
+static dc_status_t
+replay_set_timeout (void *userdata, int timeout)
+{
+	return replay_value ((replay_t *) userdata, OP_SET_TIMEOUT, NULL);
+}
+
+static dc_status_t
+replay_set_break (void *userdata, unsigned int value)
+{
+	return replay_value ((replay_t *) userdata, OP_SET_BREAK, NULL);
+}
+
+static dc_status_t
+replay_set_dtr (void *userdata, unsigned int value)
+{
+	return replay_value ((replay_t *) userdata, OP_SET_DTR, NULL);
+}
+
+static dc_status_t
+replay_set_rts (void *userdata, unsigned int value)
+{
+	return replay_value ((replay_t *) userdata, OP_SET_RTS, NULL);
+}
+
+static dc_status_t
+replay_get_lines (void *userdata, unsigned int *value)
+{
+	return replay_value ((replay_t *) userdata, OP_GET_LINES, value);
+}
+
+static dc_status_t
+replay_get_available (void *userdata, size_t *value)
+{
+	unsigned int available = 0;
+
+	dc_status_t status = replay_value ((replay_t *) userdata, OP_GET_AVAILABLE, &available);
+
+	if (value)
+		*value = available;
+
+	return status;
+}
+
+static dc_status_t
+replay_configure (void *userdata, unsigned int baudrate, unsigned int databits, dc_parity_t parity, dc_stopbits_t stopbits, dc_flowcontrol_t flowcontrol)
+{
+	replay_t *replay = (replay_t *) userdata;
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	const unsigned char *args = replay_next (replay, OP_CONFIGURE, 8, &status);
+	if (args == NULL)
+		return status;
+
+	replay_done (replay, 8);
+
+	return status;
+}
+
+static dc_status_t
+replay_poll (void *userdata, int timeout)
+{
+	return replay_value ((replay_t *) userdata, OP_POLL, NULL);
+}
+
+static dc_status_t
+replay_read (void *userdata, void *data, size_t size, size_t *actual)
+{
+	replay_t *replay = (replay_t *) userdata;
+	dc_status_t status = DC_STATUS_SUCCESS;
+	size_t nbytes = 0;
+
+	const unsigned char *args = replay_next (replay, OP_READ, 8, &status);
+	if (args == NULL)
+		goto out;
+
+	nbytes = get_u32 (args + 4);
+	if (get_u32 (args) != size || nbytes > size ||
+		replay->offset + SZ_RECORD + 8 + nbytes > replay->size) {
+		message ("Trace mismatch: read of %lu bytes, recorded %u bytes.\n",
+			(unsigned long) size, get_u32 (args));
+		status = DC_STATUS_IO;
+		nbytes = 0;
+		goto out;
+	}
+
+	memcpy (data, args + 8, nbytes);
+
+	replay_done (replay, 8 + nbytes);
+
+out:
+	if (actual)
+		*actual = nbytes;
+
+	return status;
+}
+
+static dc_status_t
+replay_write (void *userdata, const void *data, size_t size, size_t *actual)
+{
+	replay_t *replay = (replay_t *) userdata;
+	dc_status_t status = DC_STATUS_SUCCESS;
+	size_t nbytes = 0;
+
+	const unsigned char *args = replay_next (replay, OP_WRITE, 8, &status);
+	if (args == NULL)
+		goto out;
+
+	size_t length = get_u32 (args);
+	if (replay->offset + SZ_RECORD + 8 + length > replay->size) {
+		message ("Trace mismatch: truncated write record.\n");
+		status = DC_STATUS_IO;
+		goto out;
+	}
+
+	// The data may legitimately differ (e.g. a clock), so only warn.
+	if (length != size || memcmp (args + 8, data, size) != 0) {
+		message ("WARNING: Trace mismatch: write data differs at offset %lu.\n",
+			(unsigned long) replay->offset);
+	}
+
+	nbytes = get_u32 (args + 4);
+
+	replay_done (replay, 8 + length);
+
+out:
+	if (actual)
+		*actual = nbytes;
+
+	return status;
+}
+
+static dc_status_t
+replay_ioctl (void *userdata, unsigned int request, void *data, size_t size)
+{
+	replay_t *replay = (replay_t *) userdata;
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	const unsigned char *args = replay_next (replay, OP_IOCTL, 8, &status);
+	if (args == NULL)
+		return status;
+
+	size_t length = get_u32 (args + 4);
+	if (get_u32 (args) != request || length != size ||
+		replay->offset + SZ_RECORD + 8 + length > replay->size) {
+		message ("Trace mismatch: ioctl %08x, recorded %08x.\n", request, get_u32 (args));
+		return DC_STATUS_IO;
+	}
+
+	memcpy (data, args + 8, length);
+
+	replay_done (replay, 8 + length);
+
+	return status;
+}
+
+static dc_status_t
+replay_flush (void *userdata)
+{
+	replay_t *replay = (replay_t *) userdata;
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	const unsigned char *args = replay_next (replay, OP_FLUSH, 0, &status);
+	if (args == NULL)
+		return status;
+
+	replay_done (replay, 0);
+
+	return status;
+}
+
+static dc_status_t
+replay_purge (void *userdata, dc_direction_t direction)
+{
+	return replay_value ((replay_t *) userdata, OP_PURGE, NULL);
+}
+
+static dc_status_t
+replay_sleep (void *userdata, unsigned int milliseconds)
+{
+	return replay_value ((replay_t *) userdata, OP_SLEEP, NULL);
+}
+
+static dc_status_t
+replay_close (void *userdata)
+{
+	replay_t *replay = (replay_t *) userdata;
+
+	if (replay->offset != replay->size) {
+		message ("WARNING: %lu bytes of the trace were not replayed.\n",
+			(unsigned long) (replay->size - replay->offset));
+	}
+
+	dc_buffer_free (replay->buffer);
+	free (replay);
+
+	return DC_STATUS_SUCCESS;
+}
+
+static const dc_custom_cbs_t g_replay = {
+	replay_set_timeout, /* set_timeout */
+	replay_set_break, /* set_break */
+	replay_set_dtr, /* set_dtr */
+	replay_set_rts, /* set_rts */
+	replay_get_lines, /* get_lines */
+	replay_get_available, /* get_available */
+	replay_configure, /* configure */
+	replay_poll, /* poll */
+	replay_read, /* read */
+	replay_write, /* write */
+	replay_ioctl, /* ioctl */
+	replay_flush, /* flush */
+	replay_purge, /* purge */
+	replay_sleep, /* sleep */
+	replay_close, /* close */
+};
+
+dc_status_t
+dctool_replay_open (dc_iostream_t **out, dc_context_t *context, const char *filename, unsigned int realtime)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	replay_t *replay = NULL;
+
+	if (out == NULL || filename == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	replay = (replay_t *) malloc (sizeof (replay_t));
+	if (replay == NULL) {
+		return DC_STATUS_NOMEMORY;
+	}
+
+	replay->buffer = dctool_file_read (filename);
+	if (replay->buffer == NULL) {
+		message ("Failed to read the trace file '%s'.\n", filename);
+		status = DC_STATUS_IO;
+		goto error_free;
+	}
+
+	replay->data = dc_buffer_get_data (replay->buffer);
+	replay->size = dc_buffer_get_size (replay->buffer);
+	replay->offset = SZ_HEADER;
+	replay->realtime = realtime;
+	replay->timestamp = 0;
+
+	if (replay->size < SZ_HEADER ||
+		memcmp (replay->data, MAGIC, sizeof (MAGIC)) != 0 ||
+		get_u32 (replay->data + 8) != VERSION) {
+		message ("Invalid trace file '%s'.\n", filename);
+		status = DC_STATUS_DATAFORMAT;
+		goto error_buffer_free;
+	}
+
+	status = dc_custom_open (out, context, get_u32 (replay->data + 12), &g_replay, replay);
+	if (status != DC_STATUS_SUCCESS) {
+		goto error_buffer_free;
+	}
+
+	replay->start = trace_now ();
+
+	return DC_STATUS_SUCCESS;
+
+error_buffer_free:
+	dc_buffer_free (replay->buffer);
+error_free:
+	free (replay);
+	return status;
+}
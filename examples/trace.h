@@ -0,0 +1,50 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifndef DCTOOL_TRACE_H
+#define DCTOOL_TRACE_H
+
+#include <libdivecomputer/context.h>
+#include <libdivecomputer/iostream.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Record all operations on an I/O stream into a trace file. On success,
+ * the new I/O stream takes ownership of the underlying I/O stream, and
+ * closes it when it is closed itself.
+ */
+dc_status_t
+dctool_record_open (dc_iostream_t **iostream, dc_context_t *context, dc_iostream_t *base, const char *filename);
+
+/*
+ * Replay a trace file recorded with dctool_record_open. The operations
+ * are answered as fast as possible, or with the original timing.
+ */
+dc_status_t
+dctool_replay_open (dc_iostream_t **iostream, dc_context_t *context, const char *filename, unsigned int realtime);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DCTOOL_TRACE_H */
@@ -27,6 +27,7 @@
 #include "iostream.h"
 #include "iterator.h"
 #include "descriptor.h"
+#include "buffer.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -129,6 +130,101 @@ dc_bluetooth_iterator_new (dc_iterator_t **iterator, dc_context_t *context, dc_d
 dc_status_t
 dc_bluetooth_open (dc_iostream_t **iostream, dc_context_t *context, dc_bluetooth_address_t address, unsigned int port);
 
+/**
+ * Opaque object representing a cache of known bluetooth devices.
+ *
+ * Both the device discovery and the lookup of the port number (with
+ * SDP) take several seconds. The cache remembers the address, name and
+ * port number of the devices, such that reconnecting to a known device
+ * can skip both. The application is responsible for storing the cache
+ * between sessions, with #dc_bluetooth_cache_save and
+ * #dc_bluetooth_cache_load.
+ */
+typedef struct dc_bluetooth_cache_t dc_bluetooth_cache_t;
+
+/**
+ * Create a new (empty) bluetooth cache.
+ *
+ * @param[out] cache    A location to store the bluetooth cache.
+ * @param[in]  context  A valid context object.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_bluetooth_cache_new (dc_bluetooth_cache_t **cache, dc_context_t *context);
+
+/**
+ * Destroy the bluetooth cache and free all resources.
+ *
+ * @param[in]  cache  A valid bluetooth cache.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_bluetooth_cache_free (dc_bluetooth_cache_t *cache);
+
+/**
+ * Load the entries previously saved with #dc_bluetooth_cache_save into
+ * the bluetooth cache. Invalid entries are ignored.
+ *
+ * @param[in]  cache  A valid bluetooth cache.
+ * @param[in]  data   The serialized cache entries.
+ * @param[in]  size   The size of the data in bytes.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_bluetooth_cache_load (dc_bluetooth_cache_t *cache, const unsigned char data[], size_t size);
+
+/**
+ * Save the entries of the bluetooth cache into a buffer. The format is
+ * plain text, with one device per line.
+ *
+ * @param[in]  cache   A valid bluetooth cache.
+ * @param[in]  buffer  The buffer to store the serialized cache entries.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_bluetooth_cache_save (dc_bluetooth_cache_t *cache, dc_buffer_t *buffer);
+
+/**
+ * Create an iterator to enumerate the bluetooth devices, using the
+ * cache.
+ *
+ * The devices in the cache that match the descriptor are returned
+ * first. Only when the application asks for more devices, a device
+ * discovery is performed. The devices that are found are added to the
+ * cache, and those already returned from the cache are skipped.
+ *
+ * @param[out] iterator    A location to store the iterator.
+ * @param[in]  context     A valid context object.
+ * @param[in]  cache       A valid bluetooth cache.
+ * @param[in]  descriptor  A valid device descriptor or NULL.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_bluetooth_cache_iterator_new (dc_iterator_t **iterator, dc_context_t *context, dc_bluetooth_cache_t *cache, dc_descriptor_t *descriptor);
+
+/**
+ * Open a bluetooth connection, using the cache.
+ *
+ * If the port number of the device is known, the SDP lookup is
+ * skipped. If connecting to the cached port fails, the port number is
+ * looked up again. If that fails too, the device is removed from the
+ * cache.
+ *
+ * @param[out]  iostream   A location to store the bluetooth connection.
+ * @param[in]   context    A valid context object.
+ * @param[in]   cache      A valid bluetooth cache.
+ * @param[in]   address    The bluetooth device address.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_bluetooth_cache_open (dc_iostream_t **iostream, dc_context_t *context, dc_bluetooth_cache_t *cache, dc_bluetooth_address_t address);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
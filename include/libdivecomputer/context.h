@@ -28,6 +28,22 @@
 extern "C" {
 #endif /* __cplusplus */
 
+/*
+ * Thread safety
+ *
+ * A context can be shared between threads. Logging does not modify the
+ * context, but the log function is called from the thread that logs
+ * the message, and must therefore be thread-safe itself. The log level
+ * and log function should be configured before the context is shared,
+ * because changing them is not synchronized with the other threads.
+ *
+ * Descriptors are immutable, and can be shared between threads too.
+ * Parser and device objects are not thread-safe. Each of them can be
+ * used from only one thread at a time, but different objects can be
+ * used in parallel from different threads, even if they share the same
+ * context.
+ */
+
 typedef struct dc_context_t dc_context_t;
 
 typedef enum dc_loglevel_t {
@@ -38,7 +38,8 @@ typedef enum dc_event_type_t {
 	DC_EVENT_PROGRESS = (1 << 1),
 	DC_EVENT_DEVINFO = (1 << 2),
 	DC_EVENT_CLOCK = (1 << 3),
-	DC_EVENT_VENDOR = (1 << 4)
+	DC_EVENT_VENDOR = (1 << 4),
+	DC_EVENT_DIVEDATA = (1 << 5)
 } dc_event_type_t;
 
 typedef struct dc_device_t dc_device_t;
@@ -64,6 +65,20 @@ typedef struct dc_event_vendor_t {
 	unsigned int size;
 } dc_event_vendor_t;
 
+/*
+ * The divedata event reports the raw dive data while it is being
+ * downloaded, such that it can be passed to dc_parser_feed. A chunk with
+ * a zero offset starts a new dive. The dive callback remains the
+ * authoritative source of the dive data.
+ */
+
+typedef struct dc_event_divedata_t {
+	const unsigned char *data;
+	unsigned int size;
+	unsigned int offset;  /* Offset of the data within the dive */
+	unsigned int total;   /* Expected size of the dive, or zero if unknown */
+} dc_event_divedata_t;
+
 typedef int (*dc_cancel_callback_t) (void *userdata);
 
 typedef void (*dc_event_callback_t) (dc_device_t *device, dc_event_type_t event, const void *data, void *userdata);
@@ -85,6 +100,50 @@ dc_device_set_events (dc_device_t *device, unsigned int events, dc_event_callbac
 dc_status_t
 dc_device_set_fingerprint (dc_device_t *device, const unsigned char data[], unsigned int size);
 
+/*
+ * The inter packet delay (in milliseconds) is adjusted automatically by
+ * some backends. The fastest known-good value can be retrieved after a
+ * download, and restored in the next session (typically from the
+ * DC_EVENT_DEVINFO callback, just like the fingerprint).
+ */
+dc_status_t
+dc_device_set_pacing (dc_device_t *device, unsigned int delay);
+
+dc_status_t
+dc_device_get_pacing (dc_device_t *device, unsigned int *delay);
+
+/*
+ * A checkpoint buffer allows to resume an interrupted memory dump. The
+ * buffer is kept up to date with the data received so far, and can be
+ * saved when the download fails. When the same buffer is registered
+ * again in the next session, the memory dump continues where it was
+ * interrupted. The first and the last block are read again, to verify
+ * that the memory of the device did not change in the meantime. The
+ * model, firmware and serial number are verified too. A dump is only
+ * resumed for the backends that report them before the memory dump,
+ * thus the checkpoint is best registered from the devinfo event. After
+ * a successful memory dump, the buffer is empty again. The buffer
+ * remains owned by the caller.
+ */
+dc_status_t
+dc_device_set_checkpoint (dc_device_t *device, dc_buffer_t *checkpoint);
+
+/*
+ * Some backends can bring the memory image of a previous session up to
+ * date, by reading only the parts of the memory that changed since,
+ * instead of the entire memory. The result is the same as a full memory
+ * dump. When the image does not belong to the device, or the changes
+ * can't be determined reliably, the entire memory is read anyway. After
+ * every successful memory dump (including the one performed internally
+ * by dc_device_foreach), the buffer contains the new memory image. The
+ * devinfo event is emitted before the image is used, such that the
+ * buffer can still be filled with the image of that particular device
+ * from the event callback. The buffer remains owned by the caller, and
+ * is left untouched by backends without support.
+ */
+dc_status_t
+dc_device_set_image (dc_device_t *device, dc_buffer_t *image);
+
 dc_status_t
 dc_device_read (dc_device_t *device, unsigned int address, unsigned char data[], unsigned int size);
 
@@ -97,12 +156,88 @@ dc_device_dump (dc_device_t *device, dc_buffer_t *buffer);
 dc_status_t
 dc_device_foreach (dc_device_t *device, dc_dive_callback_t callback, void *userdata);
 
+/*
+ * Download the dives like dc_device_foreach, but call the dive callback
+ * on a separate consumer thread, such that the communication with the
+ * device continues while the previous dives are being processed. Each
+ * dive is copied into one of depth buffers. When all buffers are in use,
+ * the download waits until the consumer has caught up.
+ *
+ * Returning zero from the callback stops the download, and the dives
+ * that are still queued are discarded. The event and cancel callbacks
+ * are still called on the calling thread. With a zero depth, or when
+ * threads are not supported, this is equivalent to dc_device_foreach.
+ */
+dc_status_t
+dc_device_foreach_pipelined (dc_device_t *device, unsigned int depth, dc_dive_callback_t callback, void *userdata);
+
 dc_status_t
 dc_device_timesync (dc_device_t *device, const dc_datetime_t *datetime);
 
 dc_status_t
 dc_device_close (dc_device_t *device);
 
+/*
+ * Concurrent downloads
+ *
+ * The dc_download_batch function downloads several dive computers at
+ * once. Each job is a dive computer on its own, already opened, I/O
+ * stream. The device is opened, downloaded and closed on a worker thread
+ * of its own. The I/O streams remain owned by the caller.
+ *
+ * The number of simultaneous downloads can be limited per transport
+ * type, for example to one for all dive computers sharing a single
+ * bluetooth adapter. Jobs beyond the limit wait until another job on
+ * the same transport has finished. Transports without a limit are not
+ * restricted.
+ *
+ * The dive function is called from the worker thread, for every dive of
+ * the job, and must therefore be reentrant. Returning zero stops the
+ * download of that job only.
+ *
+ * The progress, devinfo and clock events of all jobs are collected in a
+ * state per job. The monitor function is called on the calling thread
+ * with a snapshot of all states, whenever any of them has changed, and
+ * once more after all jobs have finished. Returning zero from the
+ * monitor cancels all downloads. When threads are not supported, the
+ * jobs are downloaded one after the other on the calling thread.
+ *
+ * On return, the states array (if not NULL) contains the final state of
+ * every job. The status field of a job that was cancelled before it
+ * could start is set to DC_STATUS_CANCELLED.
+ */
+
+typedef struct dc_download_job_t {
+	dc_descriptor_t *descriptor;
+	dc_iostream_t *iostream;
+	const unsigned char *fingerprint;
+	unsigned int fsize;
+	void *userdata;
+} dc_download_job_t;
+
+typedef struct dc_download_limit_t {
+	dc_transport_t transport;
+	unsigned int maximum;      /* Simultaneous downloads (zero is unlimited) */
+} dc_download_limit_t;
+
+typedef struct dc_download_state_t {
+	unsigned int started;      /* The device is being downloaded */
+	unsigned int finished;     /* The status field is valid */
+	dc_status_t status;
+	unsigned int events;       /* Events received so far (DC_EVENT_*) */
+	dc_event_progress_t progress;
+	dc_event_devinfo_t devinfo;
+	dc_event_clock_t clock;
+	unsigned int ndives;
+} dc_download_state_t;
+
+typedef int (*dc_download_dive_t) (dc_device_t *device, const dc_download_job_t *job, const unsigned char *data, unsigned int size, const unsigned char *fingerprint, unsigned int fsize);
+
+typedef int (*dc_download_monitor_t) (const dc_download_job_t jobs[], const dc_download_state_t states[], unsigned int njobs, void *userdata);
+
+dc_status_t
+dc_download_batch (dc_context_t *context, const dc_download_job_t jobs[], unsigned int njobs, const dc_download_limit_t limits[], unsigned int nlimits, dc_download_dive_t dive, dc_download_monitor_t monitor, void *userdata, dc_download_state_t states[]);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -225,6 +225,32 @@ dc_iostream_configure (dc_iostream_t *iostream, unsigned int baudrate, unsigned
 dc_status_t
 dc_iostream_poll (dc_iostream_t *iostream, int timeout);
 
+/**
+ * Get the file descriptor of the I/O stream.
+ *
+ * The file descriptor can be added to an external event loop (e.g.
+ * select, poll or epoll) to get notified when the I/O stream is ready
+ * for reading or writing, instead of blocking a thread inside the
+ * library. The descriptor remains owned by the I/O stream, and must
+ * only be used to wait for readiness. All data should still be
+ * transferred with #dc_iostream_read_nonblock and
+ * #dc_iostream_write_nonblock.
+ *
+ * Because an I/O stream may already have data buffered internally, the
+ * application should only wait for readiness after a non-blocking
+ * operation has returned #DC_STATUS_TIMEOUT.
+ *
+ * This is only supported by I/O streams that are backed by a single
+ * file descriptor on a POSIX system, such as serial ports and sockets.
+ *
+ * @param[in]  iostream  A valid I/O stream.
+ * @param[out] fd        A location to store the file descriptor.
+ * @returns #DC_STATUS_SUCCESS on success, #DC_STATUS_UNSUPPORTED if
+ * there is no file descriptor, or another #dc_status_t code on failure.
+ */
+dc_status_t
+dc_iostream_get_fd (dc_iostream_t *iostream, int *fd);
+
 /**
  * Read data from the I/O stream.
  *
@@ -253,6 +279,46 @@ dc_iostream_read (dc_iostream_t *iostream, void *data, size_t size, size_t *actu
 dc_status_t
 dc_iostream_write (dc_iostream_t *iostream, const void *data, size_t size, size_t *actual);
 
+/**
+ * Read data from the I/O stream without blocking.
+ *
+ * Only the data that is already available is returned, regardless of
+ * the timeout configured with #dc_iostream_set_timeout. If less data
+ * is available than requested, the operation returns immediately with
+ * #DC_STATUS_TIMEOUT and the number of bytes that have been read.
+ *
+ * @param[in]  iostream  A valid I/O stream.
+ * @param[out] data      The memory buffer to read the data into.
+ * @param[in]  size      The number of bytes to read.
+ * @param[out] actual    An (optional) location to store the actual
+ *                       number of bytes transferred.
+ * @returns #DC_STATUS_SUCCESS on success, #DC_STATUS_TIMEOUT if not all
+ * data was available, #DC_STATUS_UNSUPPORTED if the I/O stream has no
+ * non-blocking mode, or another #dc_status_t code on failure.
+ */
+dc_status_t
+dc_iostream_read_nonblock (dc_iostream_t *iostream, void *data, size_t size, size_t *actual);
+
+/**
+ * Write data to the I/O stream without blocking.
+ *
+ * Only the data that fits in the output buffer is written, and the
+ * operation does not wait until it has been transmitted. If not all
+ * data could be written, the operation returns immediately with
+ * #DC_STATUS_TIMEOUT and the number of bytes that have been written.
+ *
+ * @param[in]  iostream  A valid I/O stream.
+ * @param[in]  data      The memory buffer to write the data from.
+ * @param[in]  size      The number of bytes to write.
+ * @param[out] actual    An (optional) location to store the actual
+ *                       number of bytes transferred.
+ * @returns #DC_STATUS_SUCCESS on success, #DC_STATUS_TIMEOUT if not all
+ * data could be written, #DC_STATUS_UNSUPPORTED if the I/O stream has
+ * no non-blocking mode, or another #dc_status_t code on failure.
+ */
+dc_status_t
+dc_iostream_write_nonblock (dc_iostream_t *iostream, const void *data, size_t size, size_t *actual);
+
 /**
  * Perform an I/O stream specific request.
  *
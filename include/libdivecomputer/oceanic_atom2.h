@@ -35,6 +35,17 @@ oceanic_atom2_device_version (dc_device_t *device, unsigned char data[], unsigne
 dc_status_t
 oceanic_atom2_device_keepalive (dc_device_t *device);
 
+/**
+ * Enable or disable the pipelined reads.
+ *
+ * When enabled (non-zero), several read commands are sent at once, and
+ * the answers are received back to back. If the device does not keep up,
+ * the download falls back to a single command at a time. This is only
+ * supported for a few models on the serial cable.
+ */
+dc_status_t
+oceanic_atom2_device_set_pipeline (dc_device_t *device, unsigned int value);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -220,9 +220,108 @@ typedef union dc_sample_value_t {
 } dc_sample_value_t;
 
 typedef struct dc_parser_t dc_parser_t;
+typedef struct dc_parser_pool_t dc_parser_pool_t;
 
 typedef void (*dc_sample_callback_t) (dc_sample_type_t type, dc_sample_value_t value, void *userdata);
 
+/*
+ * Columnar sample extraction
+ *
+ * The time, depth, temperature and pressure samples are stored in
+ * caller provided arrays, with one element per sample (row). The
+ * pressure array contains ntanks columns of capacity elements each,
+ * and the value for tank t of row i is stored at index t * capacity + i.
+ * Values that are not present in a row are set to NAN. Any of the
+ * arrays can be NULL to skip that column.
+ *
+ * All other sample types, and pressure samples for tanks beyond the
+ * ntanks columns, are stored in the sparse events array, with the index
+ * of the row they belong to.
+ *
+ * Each call to dc_parser_samples_batch returns the next chunk of rows,
+ * until a count of zero indicates the end of the profile. A chunk never
+ * splits a row, so it also ends early when the events of the next row do
+ * not fit anymore. Setting new data rewinds to the first row.
+ */
+
+typedef struct dc_sample_batch_event_t {
+	unsigned int index;        /* Row index within the chunk */
+	dc_sample_type_t type;     /* Sample type */
+	dc_sample_value_t value;   /* Sample value */
+} dc_sample_batch_event_t;
+
+typedef struct dc_sample_batch_t {
+	/* Input */
+	unsigned int capacity;     /* Number of rows in each column */
+	unsigned int ntanks;       /* Number of pressure columns */
+	unsigned int *time;        /* Time (seconds) */
+	double *depth;             /* Depth (meter) */
+	double *temperature;       /* Temperature (celsius) */
+	double *pressure;          /* Pressure (bar) */
+	unsigned int maxevents;    /* Number of elements in the events array */
+	dc_sample_batch_event_t *events;
+	/* Output */
+	unsigned int count;        /* Number of rows returned */
+	unsigned int nevents;      /* Number of events returned */
+} dc_sample_batch_t;
+
+/*
+ * Dive summary
+ *
+ * The dc_parser_get_summary function retrieves all header fields at
+ * once. On return, the fields member contains a bitmask with a bit
+ * (1 << type) set for each dc_field_type_t that is available. The gas
+ * mixes and tanks are stored in caller provided arrays. The count
+ * members always contain the actual number of gas mixes and tanks,
+ * but no more than maxgasmixes and maxtanks elements are filled in.
+ * The arrays can be NULL to retrieve only the counts.
+ */
+
+typedef struct dc_summary_t {
+	/* Input */
+	unsigned int maxgasmixes;  /* Number of elements in the gasmixes array */
+	dc_gasmix_t *gasmixes;
+	unsigned int maxtanks;     /* Number of elements in the tanks array */
+	dc_tank_t *tanks;
+	/* Output */
+	unsigned int fields;       /* Bitmask of available fields */
+	unsigned int divetime;
+	double maxdepth;
+	double avgdepth;
+	unsigned int gasmix_count;
+	dc_salinity_t salinity;
+	double atmospheric;
+	double temperature_surface;
+	double temperature_minimum;
+	double temperature_maximum;
+	unsigned int tank_count;
+	dc_divemode_t divemode;
+} dc_summary_t;
+
+#define DC_SUMMARY_HAS(summary,type) (((summary)->fields & (1u << (type))) != 0)
+
+/*
+ * Header-only probe
+ *
+ * The dc_parser_probe function retrieves the minimal set of fields
+ * needed to identify a dive (e.g. to detect duplicates), without ever
+ * decoding the profile. Fields that are only available by walking the
+ * samples on a particular model are reported as absent, instead of
+ * paying the cost of the full traversal. On return, the fields member
+ * contains a bitmask of the DC_PROBE_* flags that are available.
+ */
+
+#define DC_PROBE_DATETIME (1 << 0)
+#define DC_PROBE_DIVETIME (1 << 1)
+#define DC_PROBE_MAXDEPTH (1 << 2)
+
+typedef struct dc_probe_t {
+	unsigned int fields;       /* Bitmask of available fields */
+	dc_datetime_t datetime;
+	unsigned int divetime;
+	double maxdepth;
+} dc_probe_t;
+
 dc_status_t
 dc_parser_new (dc_parser_t **parser, dc_device_t *device);
 
@@ -232,6 +331,9 @@ dc_parser_new2 (dc_parser_t **parser, dc_context_t *context, dc_descriptor_t *de
 dc_family_t
 dc_parser_get_type (dc_parser_t *parser);
 
+dc_status_t
+dc_parser_reset (dc_parser_t *parser, unsigned int devtime, dc_ticks_t systime);
+
 dc_status_t
 dc_parser_set_data (dc_parser_t *parser, const unsigned char *data, unsigned int size);
 
@@ -241,12 +343,127 @@ dc_parser_get_datetime (dc_parser_t *parser, dc_datetime_t *datetime);
 dc_status_t
 dc_parser_get_field (dc_parser_t *parser, dc_field_type_t type, unsigned int flags, void *value);
 
+dc_status_t
+dc_parser_get_summary (dc_parser_t *parser, dc_summary_t *summary);
+
+dc_status_t
+dc_parser_probe (dc_parser_t *parser, dc_probe_t *probe);
+
 dc_status_t
 dc_parser_samples_foreach (dc_parser_t *parser, dc_sample_callback_t callback, void *userdata);
 
+dc_status_t
+dc_parser_samples_batch (dc_parser_t *parser, dc_sample_batch_t *batch);
+
 dc_status_t
 dc_parser_destroy (dc_parser_t *parser);
 
+/*
+ * Time range access
+ *
+ * The dc_parser_samples_range function reports only the samples with a
+ * time between begin and end (both inclusive, in seconds). Samples
+ * reported before the first time sample belong to time zero. Backends
+ * that support it build an index on the first walk over the profile,
+ * and decode only the part of the profile that covers the range on
+ * subsequent calls. State changes before the start of the range, such
+ * as the active gas mix, are not repeated.
+ */
+
+dc_status_t
+dc_parser_samples_range (dc_parser_t *parser, unsigned int begin, unsigned int end, dc_sample_callback_t callback, void *userdata);
+
+/*
+ * Push mode parsing
+ *
+ * Instead of passing the complete dive with dc_parser_set_data, the dive
+ * data can also be passed in chunks while it is being downloaded (see the
+ * DC_EVENT_DIVEDATA event). After dc_parser_feed_begin, each call to
+ * dc_parser_feed appends the next chunk, and reports the samples that are
+ * complete. The dc_parser_feed_end function reports the remaining samples,
+ * and does the final consistency checks. Afterwards, the parser can be
+ * used as if the entire dive was passed to dc_parser_set_data. Backends
+ * without support for incremental decoding report all samples at the end.
+ */
+
+dc_status_t
+dc_parser_feed_begin (dc_parser_t *parser, dc_sample_callback_t callback, void *userdata);
+
+dc_status_t
+dc_parser_feed (dc_parser_t *parser, const unsigned char data[], unsigned int size);
+
+dc_status_t
+dc_parser_feed_end (dc_parser_t *parser);
+
+/*
+ * Parser pool
+ *
+ * A pool keeps one parser for each (family, model) combination, such
+ * that dives from the same device can be parsed with the same parser
+ * object. The parser returned by dc_parser_pool_get is reset to the new
+ * clock values, but keeps any per-device decoding state. It remains
+ * owned by the pool, and is only valid until the next call to
+ * dc_parser_pool_get for the same family and model.
+ */
+
+dc_status_t
+dc_parser_pool_new (dc_parser_pool_t **pool, dc_context_t *context);
+
+dc_status_t
+dc_parser_pool_get (dc_parser_pool_t *pool, dc_parser_t **parser, dc_descriptor_t *descriptor, unsigned int devtime, dc_ticks_t systime);
+
+dc_status_t
+dc_parser_pool_free (dc_parser_pool_t *pool);
+
+/*
+ * Batch parsing
+ *
+ * The dc_parse_batch function parses a list of independent dives on a
+ * pool of nthreads worker threads. Each worker takes jobs from its own
+ * range of the list, and steals from the other workers once its range
+ * is exhausted. Parsers are reused per worker with a parser pool.
+ *
+ * For each job, the worker calls the parse function with a parser that
+ * has the job data already set. Without a parse function, the date/time
+ * and the sample profile are decoded and the results are discarded. The
+ * parse function is called from a worker thread, and must therefore be
+ * reentrant.
+ *
+ * The sink function is called on the calling thread, exactly once per
+ * job and strictly in input order, with the status of the job. Returning
+ * zero from the sink stops the batch. With zero threads, or when threads
+ * are not supported, all jobs are parsed on the calling thread.
+ *
+ * On input, nstats is the number of elements in the stats array. On
+ * output, it is the number of families for which statistics are
+ * returned. The usecs field is the total time spent parsing, summed over
+ * all workers.
+ */
+
+typedef struct dc_parse_job_t {
+	dc_descriptor_t *descriptor;
+	unsigned int devtime;
+	dc_ticks_t systime;
+	const unsigned char *data;
+	unsigned int size;
+	void *userdata;
+} dc_parse_job_t;
+
+typedef struct dc_parse_stats_t {
+	dc_family_t family;
+	unsigned int count;        /* Number of jobs */
+	unsigned int errors;       /* Number of failed jobs */
+	unsigned long long bytes;  /* Number of bytes parsed */
+	unsigned long long usecs;  /* Parse time (microseconds) */
+} dc_parse_stats_t;
+
+typedef dc_status_t (*dc_parse_func_t) (dc_parser_t *parser, const dc_parse_job_t *job, void *userdata);
+
+typedef int (*dc_parse_sink_t) (const dc_parse_job_t *job, dc_status_t status, void *userdata);
+
+dc_status_t
+dc_parse_batch (dc_context_t *context, const dc_parse_job_t jobs[], unsigned int njobs, unsigned int nthreads, dc_parse_func_t func, dc_parse_sink_t sink, void *userdata, dc_parse_stats_t stats[], unsigned int *nstats);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
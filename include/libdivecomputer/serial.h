@@ -88,6 +88,17 @@ dc_serial_open (dc_iostream_t **iostream, dc_context_t *context, const char *nam
  */
 #define DC_IOCTL_SERIAL_SET_LATENCY DC_IOCTL_IOW('s', 0, sizeof(unsigned int))
 
+/**
+ * Enable or disable the deferred draining of the output.
+ *
+ * By default, a write waits until all data has been transmitted. When
+ * enabled (non-zero), that wait is postponed until the next flush,
+ * sleep, modem line, break or configuration change instead, which
+ * reduces the round-trip time of small request/response packets. This
+ * is only supported on POSIX systems.
+ */
+#define DC_IOCTL_SERIAL_SET_DEFERRED_DRAIN DC_IOCTL_IOW('s', 1, sizeof(unsigned int))
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
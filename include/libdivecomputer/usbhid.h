@@ -27,11 +27,29 @@
 #include "iostream.h"
 #include "iterator.h"
 #include "descriptor.h"
+#include "ioctl.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
+/**
+ * Set the number of input transfers that are kept in flight.
+ *
+ * By default, every read submits a single synchronous transfer. With
+ * the libusb backend, a non-zero value (at most 16) switches to reading
+ * the input endpoint asynchronously: that many transfers are queued on
+ * the interrupt endpoint at all times, and the received reports are
+ * buffered until they are read. This ensures no polling interval is
+ * missed between two reads. A value of zero switches back to the
+ * synchronous reads. Reports that are still buffered at that point are
+ * discarded.
+ *
+ * The hidapi backend already buffers the incoming reports internally,
+ * and does not support this setting.
+ */
+#define DC_IOCTL_USBHID_SET_ASYNC DC_IOCTL_IOW('u', 0, sizeof(unsigned int))
+
 /**
  * Opaque object representing a USB HID device.
  */
@@ -85,6 +103,75 @@ dc_usbhid_iterator_new (dc_iterator_t **iterator, dc_context_t *context, dc_desc
 dc_status_t
 dc_usbhid_open (dc_iostream_t **iostream, dc_context_t *context, dc_usbhid_device_t *device);
 
+/**
+ * Opaque object representing a USB HID hotplug watcher.
+ */
+typedef struct dc_usbhid_watcher_t dc_usbhid_watcher_t;
+
+/**
+ * USB HID hotplug callback.
+ *
+ * The device is owned by the watcher, and remains valid until the
+ * callback reporting its removal returns. It can be opened with
+ * #dc_usbhid_open in the meantime.
+ *
+ * @param[in]  device    The USB HID device.
+ * @param[in]  arrived   Non-zero if the device was plugged in, zero if
+ *                       it was removed.
+ * @param[in]  userdata  The user data passed to #dc_usbhid_watcher_new.
+ */
+typedef void (*dc_usbhid_watcher_callback_t) (dc_usbhid_device_t *device, unsigned int arrived, void *userdata);
+
+/**
+ * Create a watcher for USB HID devices being plugged in or removed.
+ *
+ * Instead of enumerating the entire bus on every scan, the watcher
+ * maintains the set of matching devices from the hotplug notifications
+ * of the operating system. The devices that are already plugged in are
+ * reported as arrived on the first call to #dc_usbhid_watcher_poll.
+ * Hotplug notifications require the libusb backend, and are not
+ * available on all platforms.
+ *
+ * @param[out] watcher     A location to store the watcher.
+ * @param[in]  context     A valid context object.
+ * @param[in]  descriptor  A valid device descriptor or NULL.
+ * @param[in]  callback    The function to call for every device that
+ *                         arrives or is removed.
+ * @param[in]  userdata    User data passed to the callback.
+ * @returns #DC_STATUS_SUCCESS on success, #DC_STATUS_UNSUPPORTED if
+ * hotplug notifications are not available, or another #dc_status_t
+ * code on failure.
+ */
+dc_status_t
+dc_usbhid_watcher_new (dc_usbhid_watcher_t **watcher, dc_context_t *context, dc_descriptor_t *descriptor, dc_usbhid_watcher_callback_t callback, void *userdata);
+
+/**
+ * Wait for hotplug notifications, and deliver them to the callback.
+ *
+ * The callback is only ever called from this function, and thus from
+ * the thread calling it.
+ *
+ * @param[in]  watcher  A valid watcher.
+ * @param[in]  timeout  The maximum time to wait in milliseconds, or a
+ *                      negative value to wait forever.
+ * @returns #DC_STATUS_SUCCESS if at least one device arrived or was
+ * removed, #DC_STATUS_TIMEOUT if not, or another #dc_status_t code on
+ * failure.
+ */
+dc_status_t
+dc_usbhid_watcher_poll (dc_usbhid_watcher_t *watcher, int timeout);
+
+/**
+ * Destroy the watcher and free all resources. The devices that are
+ * still plugged in are freed without calling the callback.
+ *
+ * @param[in]  watcher  A valid watcher.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_usbhid_watcher_free (dc_usbhid_watcher_t *watcher);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -53,9 +53,13 @@ static const dc_parser_vtable_t atomics_cobalt_parser_vtable = {
 	sizeof(atomics_cobalt_parser_t),
 	DC_FAMILY_ATOMICS_COBALT,
 	atomics_cobalt_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	atomics_cobalt_parser_get_datetime, /* datetime */
 	atomics_cobalt_parser_get_field, /* fields */
 	atomics_cobalt_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -24,6 +24,7 @@
 #endif
 
 #include <stdlib.h> // malloc, free
+#include <string.h>
 #include <stdio.h>
 
 #include "socket.h"
@@ -65,18 +66,37 @@
 
 #define MAX_DEVICES 255
 #define MAX_PERIODS 8
+#define MAX_NAME    248
+
+/* Cache entry: address, port and name, separated with a tab. */
+#define MAX_LINE (DC_BLUETOOTH_SIZE + 12 + MAX_NAME)
 
 #define ISINSTANCE(device) dc_iostream_isinstance((device), &dc_bluetooth_vtable)
 
 struct dc_bluetooth_device_t {
 	dc_bluetooth_address_t address;
-	char name[248];
+	char name[MAX_NAME];
+};
+
+typedef struct dc_bluetooth_entry_t {
+	dc_bluetooth_device_t device;
+	unsigned int port;
+} dc_bluetooth_entry_t;
+
+struct dc_bluetooth_cache_t {
+	dc_context_t *context;
+	dc_bluetooth_entry_t *entries;
+	size_t count;
+	size_t capacity;
 };
 
 #ifdef BLUETOOTH
 static dc_status_t dc_bluetooth_iterator_next (dc_iterator_t *iterator, void *item);
 static dc_status_t dc_bluetooth_iterator_free (dc_iterator_t *iterator);
 
+static dc_status_t dc_bluetooth_cache_iterator_next (dc_iterator_t *iterator, void *item);
+static dc_status_t dc_bluetooth_cache_iterator_free (dc_iterator_t *iterator);
+
 typedef struct dc_bluetooth_iterator_t {
 	dc_iterator_t base;
 	dc_filter_t filter;
@@ -90,12 +110,28 @@ typedef struct dc_bluetooth_iterator_t {
 #endif
 } dc_bluetooth_iterator_t;
 
+typedef struct dc_bluetooth_cache_iterator_t {
+	dc_iterator_t base;
+	dc_filter_t filter;
+	dc_bluetooth_cache_t *cache;
+	dc_bluetooth_device_t *devices;
+	size_t count;
+	size_t current;
+	dc_iterator_t *inquiry;
+} dc_bluetooth_cache_iterator_t;
+
 static const dc_iterator_vtable_t dc_bluetooth_iterator_vtable = {
 	sizeof(dc_bluetooth_iterator_t),
 	dc_bluetooth_iterator_next,
 	dc_bluetooth_iterator_free,
 };
 
+static const dc_iterator_vtable_t dc_bluetooth_cache_iterator_vtable = {
+	sizeof(dc_bluetooth_cache_iterator_t),
+	dc_bluetooth_cache_iterator_next,
+	dc_bluetooth_cache_iterator_free,
+};
+
 static const dc_iostream_vtable_t dc_bluetooth_vtable = {
 	sizeof(dc_socket_t),
 	dc_socket_set_timeout, /* set_timeout */
@@ -106,8 +142,11 @@ static const dc_iostream_vtable_t dc_bluetooth_vtable = {
 	dc_socket_get_available, /* get_available */
 	NULL, /* configure */
 	dc_socket_poll, /* poll */
+	dc_socket_get_fd, /* get_fd */
 	dc_socket_read, /* read */
 	dc_socket_write, /* write */
+	dc_socket_read_nonblock, /* read_nonblock */
+	dc_socket_write_nonblock, /* write_nonblock */
 	dc_socket_ioctl, /* ioctl */
 	NULL, /* flush */
 	NULL, /* purge */
@@ -501,10 +540,15 @@ dc_bluetooth_iterator_free (dc_iterator_t *abstract)
 }
 #endif
 
-dc_status_t
-dc_bluetooth_open (dc_iostream_t **out, dc_context_t *context, dc_bluetooth_address_t address, unsigned int port)
-{
 #ifdef BLUETOOTH
+/*
+ * Open a bluetooth connection. If no port is specified, the port number
+ * is looked up with SDP. The port that was actually used is returned,
+ * or zero if it isn't known.
+ */
+static dc_status_t
+dc_bluetooth_connect (dc_iostream_t **out, dc_context_t *context, dc_bluetooth_address_t address, unsigned int port, unsigned int *actual)
+{
 	dc_status_t status = DC_STATUS_SUCCESS;
 	dc_socket_t *device = NULL;
 
@@ -559,6 +603,16 @@ dc_bluetooth_open (dc_iostream_t **out, dc_context_t *context, dc_bluetooth_addr
 		goto error_close;
 	}
 
+	if (actual) {
+#ifdef _WIN32
+		// The service lookup is done by the operating system, and the
+		// port number it found is not reported back.
+		*actual = port;
+#else
+		*actual = sa.rc_channel;
+#endif
+	}
+
 	*out = (dc_iostream_t *) device;
 
 	return DC_STATUS_SUCCESS;
@@ -568,6 +622,359 @@ error_close:
 error_free:
 	dc_iostream_deallocate ((dc_iostream_t *) device);
 	return status;
+}
+#endif
+
+dc_status_t
+dc_bluetooth_open (dc_iostream_t **out, dc_context_t *context, dc_bluetooth_address_t address, unsigned int port)
+{
+#ifdef BLUETOOTH
+	return dc_bluetooth_connect (out, context, address, port, NULL);
+#else
+	return DC_STATUS_UNSUPPORTED;
+#endif
+}
+
+static dc_bluetooth_entry_t *
+dc_bluetooth_cache_lookup (dc_bluetooth_cache_t *cache, dc_bluetooth_address_t address)
+{
+	for (size_t i = 0; i < cache->count; ++i) {
+		if (cache->entries[i].device.address == address)
+			return cache->entries + i;
+	}
+
+	return NULL;
+}
+
+static dc_bluetooth_entry_t *
+dc_bluetooth_cache_insert (dc_bluetooth_cache_t *cache, dc_bluetooth_address_t address)
+{
+	dc_bluetooth_entry_t *entry = dc_bluetooth_cache_lookup (cache, address);
+	if (entry)
+		return entry;
+
+	if (cache->count == cache->capacity) {
+		size_t capacity = cache->capacity ? cache->capacity * 2 : 8;
+		dc_bluetooth_entry_t *entries = (dc_bluetooth_entry_t *) realloc (cache->entries, capacity * sizeof (dc_bluetooth_entry_t));
+		if (entries == NULL) {
+			SYSERROR (cache->context, S_ENOMEM);
+			return NULL;
+		}
+
+		cache->entries = entries;
+		cache->capacity = capacity;
+	}
+
+	entry = cache->entries + cache->count++;
+	memset (entry, 0, sizeof (dc_bluetooth_entry_t));
+	entry->device.address = address;
+
+	return entry;
+}
+
+dc_status_t
+dc_bluetooth_cache_new (dc_bluetooth_cache_t **out, dc_context_t *context)
+{
+	dc_bluetooth_cache_t *cache = NULL;
+
+	if (out == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	cache = (dc_bluetooth_cache_t *) malloc (sizeof (dc_bluetooth_cache_t));
+	if (cache == NULL) {
+		SYSERROR (context, S_ENOMEM);
+		return DC_STATUS_NOMEMORY;
+	}
+
+	cache->context = context;
+	cache->entries = NULL;
+	cache->count = 0;
+	cache->capacity = 0;
+
+	*out = cache;
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_bluetooth_cache_free (dc_bluetooth_cache_t *cache)
+{
+	if (cache == NULL)
+		return DC_STATUS_SUCCESS;
+
+	free (cache->entries);
+	free (cache);
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_bluetooth_cache_load (dc_bluetooth_cache_t *cache, const unsigned char data[], size_t size)
+{
+	if (cache == NULL || (data == NULL && size))
+		return DC_STATUS_INVALIDARGS;
+
+	size_t offset = 0;
+	while (offset < size) {
+		// Find the end of the line.
+		size_t length = 0;
+		while (offset + length < size && data[offset + length] != '\n')
+			length++;
+
+		// Ignore the carriage return of a CRLF line ending.
+		size_t n = length;
+		if (n && data[offset + n - 1] == '\r')
+			n--;
+
+		// Split the line into the address, port and name fields.
+		char line[MAX_LINE];
+		if (n < sizeof (line)) {
+			memcpy (line, data + offset, n);
+			line[n] = '\0';
+
+			char *port = strchr (line, '\t');
+			char *name = port ? strchr (port + 1, '\t') : NULL;
+			if (name) {
+				*port++ = '\0';
+				*name++ = '\0';
+			}
+
+			dc_bluetooth_address_t address = name ? dc_bluetooth_str2addr (line) : 0;
+			if (address) {
+				dc_bluetooth_entry_t *entry = dc_bluetooth_cache_insert (cache, address);
+				if (entry == NULL)
+					return DC_STATUS_NOMEMORY;
+
+				entry->port = strtoul (port, NULL, 10);
+				strncpy (entry->device.name, name, sizeof (entry->device.name) - 1);
+			} else {
+				WARNING (cache->context, "Ignoring an invalid bluetooth cache entry.");
+			}
+		} else {
+			WARNING (cache->context, "Ignoring an invalid bluetooth cache entry.");
+		}
+
+		offset += length + 1;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_bluetooth_cache_save (dc_bluetooth_cache_t *cache, dc_buffer_t *buffer)
+{
+	if (cache == NULL || buffer == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_buffer_clear (buffer);
+
+	for (size_t i = 0; i < cache->count; ++i) {
+		const dc_bluetooth_entry_t *entry = cache->entries + i;
+		char address[DC_BLUETOOTH_SIZE];
+		char line[MAX_LINE];
+
+		// Tabs and newlines would corrupt the file format.
+		char name[MAX_NAME];
+		for (size_t j = 0; j < sizeof (name); ++j) {
+			char c = entry->device.name[j];
+			name[j] = (c == '\t' || c == '\n' || c == '\r') ? ' ' : c;
+		}
+		name[sizeof (name) - 1] = '\0';
+
+		int n = snprintf (line, sizeof (line), "%s\t%u\t%s\n",
+			dc_bluetooth_addr2str (entry->device.address, address, sizeof (address)),
+			entry->port, name);
+		if (n < 0 || (size_t) n >= sizeof (line) ||
+			!dc_buffer_append (buffer, (const unsigned char *) line, n)) {
+			ERROR (cache->context, "Failed to serialize the bluetooth cache.");
+			return DC_STATUS_NOMEMORY;
+		}
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_bluetooth_cache_iterator_new (dc_iterator_t **out, dc_context_t *context, dc_bluetooth_cache_t *cache, dc_descriptor_t *descriptor)
+{
+#ifdef BLUETOOTH
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_bluetooth_cache_iterator_t *iterator = NULL;
+
+	if (out == NULL || cache == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	iterator = (dc_bluetooth_cache_iterator_t *) dc_iterator_allocate (context, &dc_bluetooth_cache_iterator_vtable);
+	if (iterator == NULL) {
+		SYSERROR (context, S_ENOMEM);
+		return DC_STATUS_NOMEMORY;
+	}
+
+	iterator->filter = dc_descriptor_get_filter (descriptor);
+	iterator->cache = cache;
+	iterator->devices = NULL;
+	iterator->count = 0;
+	iterator->current = 0;
+	iterator->inquiry = NULL;
+
+	// Take a copy of the known devices that match. The discovered devices
+	// are added to the cache while iterating.
+	if (cache->count) {
+		iterator->devices = (dc_bluetooth_device_t *) malloc (cache->count * sizeof (dc_bluetooth_device_t));
+		if (iterator->devices == NULL) {
+			SYSERROR (context, S_ENOMEM);
+			status = DC_STATUS_NOMEMORY;
+			goto error_free;
+		}
+	}
+
+	for (size_t i = 0; i < cache->count; ++i) {
+		const dc_bluetooth_device_t *device = &cache->entries[i].device;
+		if (iterator->filter == NULL || iterator->filter (DC_TRANSPORT_BLUETOOTH, device->name)) {
+			iterator->devices[iterator->count++] = *device;
+		}
+	}
+
+	*out = (dc_iterator_t *) iterator;
+
+	return DC_STATUS_SUCCESS;
+
+error_free:
+	dc_iterator_deallocate ((dc_iterator_t *) iterator);
+	return status;
+#else
+	return DC_STATUS_UNSUPPORTED;
+#endif
+}
+
+#ifdef BLUETOOTH
+static int
+dc_bluetooth_cache_iterator_returned (dc_bluetooth_cache_iterator_t *iterator, dc_bluetooth_address_t address)
+{
+	for (size_t i = 0; i < iterator->count; ++i) {
+		if (iterator->devices[i].address == address)
+			return 1;
+	}
+
+	return 0;
+}
+
+static dc_status_t
+dc_bluetooth_cache_iterator_next (dc_iterator_t *abstract, void *out)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_bluetooth_cache_iterator_t *iterator = (dc_bluetooth_cache_iterator_t *) abstract;
+	dc_bluetooth_device_t *device = NULL;
+
+	// Return the known devices first.
+	if (iterator->current < iterator->count) {
+		device = (dc_bluetooth_device_t *) malloc (sizeof(dc_bluetooth_device_t));
+		if (device == NULL) {
+			SYSERROR (abstract->context, S_ENOMEM);
+			return DC_STATUS_NOMEMORY;
+		}
+
+		*device = iterator->devices[iterator->current++];
+
+		*(dc_bluetooth_device_t **) out = device;
+
+		return DC_STATUS_SUCCESS;
+	}
+
+	// Only start the (slow) device discovery once the application asks
+	// for more devices than the known ones.
+	if (iterator->inquiry == NULL) {
+		status = dc_bluetooth_iterator_new (&iterator->inquiry, abstract->context, NULL);
+		if (status != DC_STATUS_SUCCESS)
+			return status;
+	}
+
+	while (1) {
+		status = dc_iterator_next (iterator->inquiry, &device);
+		if (status != DC_STATUS_SUCCESS)
+			return status;
+
+		if (iterator->filter && !iterator->filter (DC_TRANSPORT_BLUETOOTH, device->name)) {
+			dc_bluetooth_device_free (device);
+			continue;
+		}
+
+		// Remember the discovered device.
+		dc_bluetooth_entry_t *entry = dc_bluetooth_cache_insert (iterator->cache, device->address);
+		if (entry) {
+			memcpy (entry->device.name, device->name, sizeof (entry->device.name));
+		}
+
+		// Skip the devices that were already returned from the cache.
+		if (dc_bluetooth_cache_iterator_returned (iterator, device->address)) {
+			dc_bluetooth_device_free (device);
+			continue;
+		}
+
+		*(dc_bluetooth_device_t **) out = device;
+
+		return DC_STATUS_SUCCESS;
+	}
+}
+
+static dc_status_t
+dc_bluetooth_cache_iterator_free (dc_iterator_t *abstract)
+{
+	dc_bluetooth_cache_iterator_t *iterator = (dc_bluetooth_cache_iterator_t *) abstract;
+
+	free (iterator->devices);
+
+	return dc_iterator_free (iterator->inquiry);
+}
+
+static void
+dc_bluetooth_cache_remove (dc_bluetooth_cache_t *cache, dc_bluetooth_address_t address)
+{
+	dc_bluetooth_entry_t *entry = dc_bluetooth_cache_lookup (cache, address);
+	if (entry == NULL)
+		return;
+
+	size_t index = entry - cache->entries;
+	memmove (entry, entry + 1, (cache->count - index - 1) * sizeof (dc_bluetooth_entry_t));
+	cache->count--;
+}
+#endif
+
+dc_status_t
+dc_bluetooth_cache_open (dc_iostream_t **out, dc_context_t *context, dc_bluetooth_cache_t *cache, dc_bluetooth_address_t address)
+{
+#ifdef BLUETOOTH
+	dc_status_t status = DC_STATUS_SUCCESS;
+	unsigned int port = 0;
+
+	if (out == NULL || cache == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	// Try the known port number first.
+	dc_bluetooth_entry_t *entry = dc_bluetooth_cache_lookup (cache, address);
+	if (entry && entry->port) {
+		status = dc_bluetooth_connect (out, context, address, entry->port, NULL);
+		if (status == DC_STATUS_SUCCESS)
+			return DC_STATUS_SUCCESS;
+
+		WARNING (context, "Failed to connect to the cached port %u.", entry->port);
+		entry->port = 0;
+	}
+
+	// Look up the port number again.
+	status = dc_bluetooth_connect (out, context, address, 0, &port);
+	if (status != DC_STATUS_SUCCESS) {
+		// Forget the device, such that it's discovered again next time.
+		dc_bluetooth_cache_remove (cache, address);
+		return status;
+	}
+
+	entry = dc_bluetooth_cache_insert (cache, address);
+	if (entry) {
+		entry->port = port;
+	}
+
+	return DC_STATUS_SUCCESS;
 #else
 	return DC_STATUS_UNSUPPORTED;
 #endif
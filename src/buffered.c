@@ -0,0 +1,436 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#include <stdlib.h> // malloc, free
+#include <string.h> // memcpy, memmove
+
+#include "buffered.h"
+#include "iostream-private.h"
+#include "common-private.h"
+#include "context-private.h"
+#include "platform.h"
+
+#define ISINSTANCE(iostream) dc_iostream_isinstance((iostream), &dc_buffered_vtable)
+
+static dc_status_t dc_buffered_set_timeout (dc_iostream_t *abstract, int timeout);
+static dc_status_t dc_buffered_set_break (dc_iostream_t *abstract, unsigned int value);
+static dc_status_t dc_buffered_set_dtr (dc_iostream_t *abstract, unsigned int value);
+static dc_status_t dc_buffered_set_rts (dc_iostream_t *abstract, unsigned int value);
+static dc_status_t dc_buffered_get_lines (dc_iostream_t *abstract, unsigned int *value);
+static dc_status_t dc_buffered_get_available (dc_iostream_t *abstract, size_t *value);
+static dc_status_t dc_buffered_configure (dc_iostream_t *abstract, unsigned int baudrate, unsigned int databits, dc_parity_t parity, dc_stopbits_t stopbits, dc_flowcontrol_t flowcontrol);
+static dc_status_t dc_buffered_poll (dc_iostream_t *abstract, int timeout);
+static dc_status_t dc_buffered_get_fd (dc_iostream_t *abstract, int *fd);
+static dc_status_t dc_buffered_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual);
+static dc_status_t dc_buffered_write (dc_iostream_t *abstract, const void *data, size_t size, size_t *actual);
+static dc_status_t dc_buffered_read_nonblock (dc_iostream_t *abstract, void *data, size_t size, size_t *actual);
+static dc_status_t dc_buffered_write_nonblock (dc_iostream_t *abstract, const void *data, size_t size, size_t *actual);
+static dc_status_t dc_buffered_ioctl (dc_iostream_t *abstract, unsigned int request, void *data, size_t size);
+static dc_status_t dc_buffered_flush (dc_iostream_t *abstract);
+static dc_status_t dc_buffered_purge (dc_iostream_t *abstract, dc_direction_t direction);
+static dc_status_t dc_buffered_sleep (dc_iostream_t *abstract, unsigned int milliseconds);
+static dc_status_t dc_buffered_close (dc_iostream_t *abstract);
+
+typedef struct dc_buffered_t {
+	/* Base class. */
+	dc_iostream_t base;
+	/* Internal state. */
+	dc_context_t *context;
+	dc_iostream_t *iostream;
+	unsigned char *buffer;
+	size_t capacity;
+	size_t offset;
+	size_t length;
+} dc_buffered_t;
+
+static const dc_iostream_vtable_t dc_buffered_vtable = {
+	sizeof(dc_buffered_t),
+	dc_buffered_set_timeout, /* set_timeout */
+	dc_buffered_set_break, /* set_break */
+	dc_buffered_set_dtr, /* set_dtr */
+	dc_buffered_set_rts, /* set_rts */
+	dc_buffered_get_lines, /* get_lines */
+	dc_buffered_get_available, /* get_available */
+	dc_buffered_configure, /* configure */
+	dc_buffered_poll, /* poll */
+	dc_buffered_get_fd, /* get_fd */
+	dc_buffered_read, /* read */
+	dc_buffered_write, /* write */
+	dc_buffered_read_nonblock, /* read_nonblock */
+	dc_buffered_write_nonblock, /* write_nonblock */
+	dc_buffered_ioctl, /* ioctl */
+	dc_buffered_flush, /* flush */
+	dc_buffered_purge, /* purge */
+	dc_buffered_sleep, /* sleep */
+	dc_buffered_close, /* close */
+};
+
+dc_status_t
+dc_buffered_open (dc_iostream_t **out, dc_context_t *context, dc_iostream_t *base, size_t size)
+{
+	dc_buffered_t *buffered = NULL;
+
+	if (out == NULL || base == NULL || size == 0)
+		return DC_STATUS_INVALIDARGS;
+
+	// Allocate memory. All data already gets logged by the underlying
+	// stream, so the buffered stream has no context of its own.
+	buffered = (dc_buffered_t *) dc_iostream_allocate (NULL, &dc_buffered_vtable, dc_iostream_get_transport (base));
+	if (buffered == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	buffered->buffer = (unsigned char *) malloc (size);
+	if (buffered->buffer == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		dc_iostream_deallocate ((dc_iostream_t *) buffered);
+		return DC_STATUS_NOMEMORY;
+	}
+
+	buffered->context = context;
+	buffered->iostream = base;
+	buffered->capacity = size;
+	buffered->offset = 0;
+	buffered->length = 0;
+
+	*out = (dc_iostream_t *) buffered;
+
+	return DC_STATUS_SUCCESS;
+}
+
+/*
+ * Make sure the buffer contains at least the requested number of
+ * bytes. Only the missing bytes are waited for, but anything that
+ * has already arrived is read along, as far as there is room.
+ */
+static dc_status_t
+dc_buffered_fill (dc_buffered_t *buffered, size_t size)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (buffered->length >= size)
+		return DC_STATUS_SUCCESS;
+
+	// Move the remaining data to the start of the buffer.
+	if (buffered->offset) {
+		memmove (buffered->buffer, buffered->buffer + buffered->offset, buffered->length);
+		buffered->offset = 0;
+	}
+
+	size_t missing = size - buffered->length;
+	size_t space = buffered->capacity - buffered->length;
+
+	size_t available = 0;
+	status = dc_iostream_get_available (buffered->iostream, &available);
+	if (status != DC_STATUS_SUCCESS)
+		available = 0;
+
+	size_t len = available > missing ? available : missing;
+	if (len > space)
+		len = space;
+
+	size_t nbytes = 0;
+	status = dc_iostream_read (buffered->iostream, buffered->buffer + buffered->length, len, &nbytes);
+	buffered->length += nbytes;
+
+	return status;
+}
+
+dc_status_t
+dc_buffered_peek (dc_iostream_t *abstract, void *data, size_t size, size_t *actual)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+	size_t nbytes = 0;
+
+	if (!ISINSTANCE (abstract)) {
+		status = DC_STATUS_INVALIDARGS;
+		goto out;
+	}
+
+	if (size > buffered->capacity) {
+		ERROR (buffered->context, "Peek size exceeds the buffer size (" DC_PRINTF_SIZE ").", buffered->capacity);
+		status = DC_STATUS_INVALIDARGS;
+		goto out;
+	}
+
+	status = dc_buffered_fill (buffered, size);
+
+	nbytes = buffered->length < size ? buffered->length : size;
+	memcpy (data, buffered->buffer + buffered->offset, nbytes);
+
+out:
+	if (actual)
+		*actual = nbytes;
+
+	return status;
+}
+
+dc_status_t
+dc_buffered_unread (dc_iostream_t *abstract, const void *data, size_t size)
+{
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+
+	if (!ISINSTANCE (abstract))
+		return DC_STATUS_INVALIDARGS;
+
+	if (size == 0)
+		return DC_STATUS_SUCCESS;
+
+	if (size > buffered->offset) {
+		// Grow the buffer if necessary.
+		if (buffered->length + size > buffered->capacity) {
+			size_t capacity = buffered->length + size;
+			unsigned char *buffer = (unsigned char *) realloc (buffered->buffer, capacity);
+			if (buffer == NULL) {
+				ERROR (buffered->context, "Failed to allocate memory.");
+				return DC_STATUS_NOMEMORY;
+			}
+			buffered->buffer = buffer;
+			buffered->capacity = capacity;
+		}
+
+		// Make room in front of the buffered data.
+		memmove (buffered->buffer + size, buffered->buffer + buffered->offset, buffered->length);
+		buffered->offset = size;
+	}
+
+	buffered->offset -= size;
+	buffered->length += size;
+	memcpy (buffered->buffer + buffered->offset, data, size);
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+dc_buffered_set_timeout (dc_iostream_t *abstract, int timeout)
+{
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+
+	return dc_iostream_set_timeout (buffered->iostream, timeout);
+}
+
+static dc_status_t
+dc_buffered_set_break (dc_iostream_t *abstract, unsigned int value)
+{
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+
+	return dc_iostream_set_break (buffered->iostream, value);
+}
+
+static dc_status_t
+dc_buffered_set_dtr (dc_iostream_t *abstract, unsigned int value)
+{
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+
+	return dc_iostream_set_dtr (buffered->iostream, value);
+}
+
+static dc_status_t
+dc_buffered_set_rts (dc_iostream_t *abstract, unsigned int value)
+{
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+
+	return dc_iostream_set_rts (buffered->iostream, value);
+}
+
+static dc_status_t
+dc_buffered_get_lines (dc_iostream_t *abstract, unsigned int *value)
+{
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+
+	return dc_iostream_get_lines (buffered->iostream, value);
+}
+
+static dc_status_t
+dc_buffered_get_available (dc_iostream_t *abstract, size_t *value)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+	size_t available = 0;
+
+	status = dc_iostream_get_available (buffered->iostream, &available);
+	if (status != DC_STATUS_SUCCESS && buffered->length == 0)
+		return status;
+
+	if (value)
+		*value = buffered->length + available;
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+dc_buffered_configure (dc_iostream_t *abstract, unsigned int baudrate, unsigned int databits, dc_parity_t parity, dc_stopbits_t stopbits, dc_flowcontrol_t flowcontrol)
+{
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+
+	return dc_iostream_configure (buffered->iostream, baudrate, databits, parity, stopbits, flowcontrol);
+}
+
+static dc_status_t
+dc_buffered_poll (dc_iostream_t *abstract, int timeout)
+{
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+
+	if (buffered->length)
+		return DC_STATUS_SUCCESS;
+
+	return dc_iostream_poll (buffered->iostream, timeout);
+}
+
+static dc_status_t
+dc_buffered_get_fd (dc_iostream_t *abstract, int *fd)
+{
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+
+	return dc_iostream_get_fd (buffered->iostream, fd);
+}
+
+static size_t
+dc_buffered_take (dc_buffered_t *buffered, unsigned char data[], size_t size)
+{
+	size_t len = size < buffered->length ? size : buffered->length;
+
+	memcpy (data, buffered->buffer + buffered->offset, len);
+	buffered->offset += len;
+	buffered->length -= len;
+
+	return len;
+}
+
+static dc_status_t
+dc_buffered_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+	unsigned char *p = (unsigned char *) data;
+	size_t nbytes = 0;
+
+	// Return the buffered data first.
+	nbytes = dc_buffered_take (buffered, p, size);
+
+	if (nbytes < size) {
+		if (size - nbytes >= buffered->capacity) {
+			// Large reads bypass the buffer.
+			size_t len = 0;
+			status = dc_iostream_read (buffered->iostream, p + nbytes, size - nbytes, &len);
+			nbytes += len;
+		} else {
+			status = dc_buffered_fill (buffered, size - nbytes);
+			nbytes += dc_buffered_take (buffered, p + nbytes, size - nbytes);
+		}
+	}
+
+	if (actual)
+		*actual = nbytes;
+
+	return status;
+}
+
+static dc_status_t
+dc_buffered_write (dc_iostream_t *abstract, const void *data, size_t size, size_t *actual)
+{
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+
+	return dc_iostream_write (buffered->iostream, data, size, actual);
+}
+
+static dc_status_t
+dc_buffered_read_nonblock (dc_iostream_t *abstract, void *data, size_t size, size_t *actual)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+	unsigned char *p = (unsigned char *) data;
+	size_t nbytes = 0;
+
+	// Return the buffered data first. The underlying file descriptor
+	// does not signal readiness for this data, so it must be drained
+	// before the caller goes back to waiting.
+	nbytes = dc_buffered_take (buffered, p, size);
+
+	if (nbytes < size) {
+		size_t len = 0;
+		status = dc_iostream_read_nonblock (buffered->iostream, p + nbytes, size - nbytes, &len);
+		nbytes += len;
+	}
+
+	if (actual)
+		*actual = nbytes;
+
+	return status;
+}
+
+static dc_status_t
+dc_buffered_write_nonblock (dc_iostream_t *abstract, const void *data, size_t size, size_t *actual)
+{
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+
+	return dc_iostream_write_nonblock (buffered->iostream, data, size, actual);
+}
+
+static dc_status_t
+dc_buffered_ioctl (dc_iostream_t *abstract, unsigned int request, void *data, size_t size)
+{
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+
+	return dc_iostream_ioctl (buffered->iostream, request, data, size);
+}
+
+static dc_status_t
+dc_buffered_flush (dc_iostream_t *abstract)
+{
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+
+	return dc_iostream_flush (buffered->iostream);
+}
+
+static dc_status_t
+dc_buffered_purge (dc_iostream_t *abstract, dc_direction_t direction)
+{
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+
+	if (direction & DC_DIRECTION_INPUT) {
+		buffered->offset = 0;
+		buffered->length = 0;
+	}
+
+	return dc_iostream_purge (buffered->iostream, direction);
+}
+
+static dc_status_t
+dc_buffered_sleep (dc_iostream_t *abstract, unsigned int milliseconds)
+{
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+
+	return dc_iostream_sleep (buffered->iostream, milliseconds);
+}
+
+static dc_status_t
+dc_buffered_close (dc_iostream_t *abstract)
+{
+	dc_buffered_t *buffered = (dc_buffered_t *) abstract;
+
+	// The underlying stream is owned by the caller.
+	free (buffered->buffer);
+
+	return DC_STATUS_SUCCESS;
+}
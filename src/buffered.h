@@ -0,0 +1,87 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifndef DC_BUFFERED_H
+#define DC_BUFFERED_H
+
+#include <libdivecomputer/common.h>
+#include <libdivecomputer/context.h>
+#include <libdivecomputer/iostream.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Create a buffered I/O stream on top of another I/O stream.
+ *
+ * Data that is already waiting in the underlying I/O stream is read
+ * ahead into the buffer, such that drivers reading one byte at a time
+ * no longer need a system call for every byte. A read never waits for
+ * more data than requested, so the timeout behaves exactly as for the
+ * underlying I/O stream. All other operations are passed through.
+ *
+ * The underlying I/O stream remains owned by the caller, and is not
+ * closed when the buffered I/O stream is closed.
+ *
+ * @param[out]  iostream  A location to store the buffered I/O stream.
+ * @param[in]   context   A valid context object.
+ * @param[in]   base      The underlying I/O stream.
+ * @param[in]   size      The size of the read-ahead buffer in bytes.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_buffered_open (dc_iostream_t **iostream, dc_context_t *context, dc_iostream_t *base, size_t size);
+
+/**
+ * Look at the next bytes of a buffered I/O stream without consuming
+ * them. A subsequent read returns the same bytes again.
+ *
+ * @param[in]   iostream  A valid buffered I/O stream.
+ * @param[out]  data      The memory buffer to read the data into.
+ * @param[in]   size      The number of bytes to peek (at most the size
+ *                        of the read-ahead buffer).
+ * @param[out]  actual    An (optional) location to store the number of
+ *                        bytes available.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_buffered_peek (dc_iostream_t *iostream, void *data, size_t size, size_t *actual);
+
+/**
+ * Push bytes back into a buffered I/O stream. The next read returns
+ * these bytes first, followed by the data that was already buffered.
+ *
+ * @param[in]   iostream  A valid buffered I/O stream.
+ * @param[in]   data      The data to push back.
+ * @param[in]   size      The number of bytes to push back.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_buffered_unread (dc_iostream_t *iostream, const void *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DC_BUFFERED_H */
@@ -110,9 +110,13 @@ static const dc_parser_vtable_t cochran_commander_parser_vtable = {
 	sizeof(cochran_commander_parser_t),
 	DC_FAMILY_COCHRAN_COMMANDER,
 	cochran_commander_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	cochran_commander_parser_get_datetime, /* datetime */
 	cochran_commander_parser_get_field, /* fields */
 	cochran_commander_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -36,12 +36,20 @@
 #include "context-private.h"
 #include "timer.h"
 
+/*
+ * The log messages are formatted in a buffer on the stack of the calling
+ * thread, and only the larger messages (e.g. hexdumps) are formatted in
+ * a temporary buffer on the heap. The context itself is never modified
+ * while logging, so a single context can be shared between threads.
+ */
+#define MSGSIZE_STACK 256
+#define MSGSIZE_MAX   (16384 + 32)
+
 struct dc_context_t {
 	dc_loglevel_t loglevel;
 	dc_logfunc_t logfunc;
 	void *userdata;
 #ifdef ENABLE_LOGGING
-	char msg[16384 + 32];
 	dc_timer_t *timer;
 #endif
 };
@@ -173,7 +181,6 @@ dc_context_new (dc_context_t **out)
 	context->userdata = NULL;
 
 #ifdef ENABLE_LOGGING
-	memset (context->msg, 0, sizeof (context->msg));
 	context->timer = NULL;
 	dc_timer_new (&context->timer);
 #endif
@@ -229,6 +236,9 @@ dc_context_log (dc_context_t *context, dc_loglevel_t loglevel, const char *file,
 {
 #ifdef ENABLE_LOGGING
 	va_list ap;
+	char buffer[MSGSIZE_STACK];
+	char *msg = buffer;
+	int n;
 #endif
 
 	if (context == NULL)
@@ -242,10 +252,27 @@ dc_context_log (dc_context_t *context, dc_loglevel_t loglevel, const char *file,
 		return DC_STATUS_SUCCESS;
 
 	va_start (ap, format);
-	l_vsnprintf (context->msg, sizeof (context->msg), format, ap);
+	n = l_vsnprintf (buffer, sizeof (buffer), format, ap);
 	va_end (ap);
 
-	context->logfunc (context, loglevel, file, line, function, context->msg, context->userdata);
+	/*
+	 * Retry with a larger buffer if the message was truncated. If the
+	 * allocation fails, the truncated message is logged instead.
+	 */
+	if (n < 0) {
+		char *large = (char *) malloc (MSGSIZE_MAX);
+		if (large) {
+			va_start (ap, format);
+			l_vsnprintf (large, MSGSIZE_MAX, format, ap);
+			va_end (ap);
+			msg = large;
+		}
+	}
+
+	context->logfunc (context, loglevel, file, line, function, msg, context->userdata);
+
+	if (msg != buffer)
+		free (msg);
 #endif
 
 	return DC_STATUS_SUCCESS;
@@ -295,6 +322,9 @@ dc_status_t
 dc_context_hexdump (dc_context_t *context, dc_loglevel_t loglevel, const char *file, unsigned int line, const char *function, const char *prefix, const unsigned char data[], unsigned int size)
 {
 #ifdef ENABLE_LOGGING
+	char buffer[MSGSIZE_STACK];
+	char *msg = buffer;
+	size_t length = sizeof (buffer);
 	int n;
 #endif
 
@@ -308,13 +338,27 @@ dc_context_hexdump (dc_context_t *context, dc_loglevel_t loglevel, const char *f
 	if (context->logfunc == NULL)
 		return DC_STATUS_SUCCESS;
 
-	n = l_snprintf (context->msg, sizeof (context->msg), "%s: size=%u, data=", prefix, size);
+	/* Use a heap buffer if the hexdump doesn't fit on the stack. */
+	size_t required = strlen (prefix) + 32 + 2 * (size_t) size + 1;
+	if (required > sizeof (buffer)) {
+		length = (required < MSGSIZE_MAX ? required : MSGSIZE_MAX);
+		msg = (char *) malloc (length);
+		if (msg == NULL) {
+			msg = buffer;
+			length = sizeof (buffer);
+		}
+	}
+
+	n = l_snprintf (msg, length, "%s: size=%u, data=", prefix, size);
 
 	if (n >= 0) {
-		n = l_hexdump (context->msg + n, sizeof (context->msg) - n, data, size);
+		n = l_hexdump (msg + n, length - n, data, size);
 	}
 
-	context->logfunc (context, loglevel, file, line, function, context->msg, context->userdata);
+	context->logfunc (context, loglevel, file, line, function, msg, context->userdata);
+
+	if (msg != buffer)
+		free (msg);
 #endif
 
 	return DC_STATUS_SUCCESS;
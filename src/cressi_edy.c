@@ -30,6 +30,7 @@
 #include "array.h"
 #include "ringbuffer.h"
 #include "rbstream.h"
+#include "buffered.h"
 
 #define ISINSTANCE(device) dc_device_isinstance((device), &cressi_edy_device_vtable)
 
@@ -233,37 +234,44 @@ cressi_edy_device_open (dc_device_t **out, dc_context_t *context, dc_iostream_t
 	}
 
 	// Set the default values.
-	device->iostream = iostream;
 	device->layout = NULL;
 	device->model = 0;
 	memset (device->fingerprint, 0, sizeof (device->fingerprint));
 
+	// Read ahead, because the answer follows the echo of the last
+	// command byte immediately, and is picked up along with it.
+	status = dc_buffered_open (&device->iostream, context, iostream, 1024);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (context, "Failed to create the buffered stream.");
+		goto error_free;
+	}
+
 	// Set the serial communication protocol (1200 8N1).
 	status = dc_iostream_configure (device->iostream, 1200, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the terminal attributes.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Set the timeout for receiving data (1000 ms).
 	status = dc_iostream_set_timeout (device->iostream, 1000);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the timeout.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Set the DTR line.
 	status = dc_iostream_set_dtr (device->iostream, 1);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the DTR line.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Clear the RTS line.
 	status = dc_iostream_set_rts (device->iostream, 0);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to clear the RTS line.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Make sure everything is in a sane state.
@@ -285,7 +293,7 @@ cressi_edy_device_open (dc_device_t **out, dc_context_t *context, dc_iostream_t
 	status = dc_iostream_configure (device->iostream, 4800, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the terminal attributes.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Make sure everything is in a sane state.
@@ -296,6 +304,8 @@ cressi_edy_device_open (dc_device_t **out, dc_context_t *context, dc_iostream_t
 
 	return DC_STATUS_SUCCESS;
 
+error_close:
+	dc_iostream_close (device->iostream);
 error_free:
 	dc_device_deallocate ((dc_device_t *) device);
 	return status;
@@ -315,6 +325,12 @@ cressi_edy_device_close (dc_device_t *abstract)
 		dc_status_set_error(&status, rc);
 	}
 
+	// Close the buffered stream.
+	rc = dc_iostream_close (device->iostream);
+	if (rc != DC_STATUS_SUCCESS) {
+		dc_status_set_error(&status, rc);
+	}
+
 	return status;
 }
 
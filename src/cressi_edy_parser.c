@@ -47,9 +47,13 @@ static const dc_parser_vtable_t cressi_edy_parser_vtable = {
 	sizeof(cressi_edy_parser_t),
 	DC_FAMILY_CRESSI_EDY,
 	cressi_edy_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	cressi_edy_parser_get_datetime, /* datetime */
 	cressi_edy_parser_get_field, /* fields */
 	cressi_edy_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -52,9 +52,13 @@ static const dc_parser_vtable_t cressi_goa_parser_vtable = {
 	sizeof(cressi_goa_parser_t),
 	DC_FAMILY_CRESSI_GOA,
 	cressi_goa_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	cressi_goa_parser_get_datetime, /* datetime */
 	cressi_goa_parser_get_field, /* fields */
 	cressi_goa_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -124,7 +128,7 @@ cressi_goa_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsign
 
 	const unsigned char *data = abstract->data;
 
-	if (!parser->cached) {
+	if (!parser->cached && !abstract->headeronly) {
 		sample_statistics_t statistics = SAMPLE_STATISTICS_INITIALIZER;
 		dc_status_t rc = cressi_goa_parser_samples_foreach (
 			abstract, sample_statistics_cb, &statistics);
@@ -143,6 +147,8 @@ cressi_goa_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsign
 			*((unsigned int *) value) = array_uint16_le (data + 0x14);
 			break;
 		case DC_FIELD_MAXDEPTH:
+			if (!parser->cached)
+				return DC_STATUS_UNSUPPORTED;
 			*((double *) value) = parser->maxdepth;
 			break;
 		case DC_FIELD_GASMIX_COUNT:
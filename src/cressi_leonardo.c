@@ -287,18 +287,180 @@ cressi_leonardo_device_read (dc_device_t *abstract, unsigned int address, unsign
 	return rc;
 }
 
+static void
+cressi_leonardo_device_devinfo (dc_device_t *abstract, const unsigned char data[])
+{
+	// Emit a device info event.
+	dc_event_devinfo_t devinfo;
+	devinfo.model = data[0];
+	devinfo.firmware = 0;
+	devinfo.serial = array_uint24_le (data + 1);
+	device_event_emit (abstract, DC_EVENT_DEVINFO, &devinfo);
+}
+
 static dc_status_t
-cressi_leonardo_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
+cressi_leonardo_device_update (dc_device_t *abstract, unsigned char data[])
 {
 	dc_status_t status = DC_STATUS_SUCCESS;
-	cressi_leonardo_device_t *device = (cressi_leonardo_device_t *) abstract;
 
-	// Allocate the required amount of memory.
-	if (!dc_buffer_resize (buffer, SZ_MEMORY)) {
-		ERROR (abstract->context, "Insufficient buffer space available.");
-		return DC_STATUS_NOMEMORY;
+	const unsigned char *image = dc_buffer_get_data (abstract->image);
+	if (dc_buffer_get_size (abstract->image) != SZ_MEMORY)
+		return DC_STATUS_UNSUPPORTED;
+
+	// Check the model and serial number.
+	if (memcmp (data, image, 4) != 0) {
+		INFO (abstract->context, "The memory image belongs to another device.");
+		return DC_STATUS_UNSUPPORTED;
+	}
+
+	// Get the old and new ringbuffer pointers.
+	unsigned int olast = array_uint16_le (image + 0x64);
+	unsigned int nlast = array_uint16_le (data + 0x64);
+	unsigned int oeop = array_uint16_le (image + 0x66);
+	unsigned int neop = array_uint16_le (data + 0x66);
+	if (olast < RB_LOGBOOK_BEGIN || olast >= RB_LOGBOOK_END ||
+		((olast - RB_LOGBOOK_BEGIN) % RB_LOGBOOK_SIZE) != 0 ||
+		nlast < RB_LOGBOOK_BEGIN || nlast >= RB_LOGBOOK_END ||
+		((nlast - RB_LOGBOOK_BEGIN) % RB_LOGBOOK_SIZE) != 0 ||
+		oeop < RB_PROFILE_BEGIN || oeop > RB_PROFILE_END ||
+		neop < RB_PROFILE_BEGIN || neop > RB_PROFILE_END) {
+		INFO (abstract->context, "Unexpected ringbuffer pointers (0x%04x 0x%04x 0x%04x 0x%04x).",
+			olast, oeop, nlast, neop);
+		return DC_STATUS_UNSUPPORTED;
+	}
+
+	// The end of profile pointer points past the footer of the last dive,
+	// which can be the end of the ringbuffer.
+	if (oeop == RB_PROFILE_END)
+		oeop = RB_PROFILE_BEGIN;
+	if (neop == RB_PROFILE_END)
+		neop = RB_PROFILE_BEGIN;
+
+	// Start from the previous memory image.
+	memcpy (data + RB_LOGBOOK_BEGIN, image + RB_LOGBOOK_BEGIN, SZ_MEMORY - RB_LOGBOOK_BEGIN);
+
+	// Enable progress notifications.
+	dc_event_progress_t progress = EVENT_PROGRESS_INITIALIZER;
+	progress.maximum = RB_LOGBOOK_SIZE;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	// The logbook pointer wraps around after RB_LOGBOOK_COUNT dives, so
+	// with exactly that many new dives it's unchanged, and with more the
+	// count is wrong. The previous last logbook entry is overwritten in
+	// both cases.
+	status = cressi_leonardo_device_read (abstract, olast, data + olast, RB_LOGBOOK_SIZE);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (abstract->context, "Failed to read the logbook.");
+		return status;
+	}
+
+	progress.current += RB_LOGBOOK_SIZE;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	if (memcmp (data + olast, image + olast, RB_LOGBOOK_SIZE) != 0) {
+		INFO (abstract->context, "The logbook wrapped around since the previous memory image.");
+		return DC_STATUS_UNSUPPORTED;
+	}
+
+	if (olast == nlast) {
+		if (oeop != neop) {
+			INFO (abstract->context, "Profile data changed without a new logbook entry.");
+			return DC_STATUS_UNSUPPORTED;
+		}
+		return DC_STATUS_SUCCESS;
+	}
+
+	// Read the new logbook entries, in at most two contiguous parts.
+	unsigned int first = (olast - RB_LOGBOOK_BEGIN) / RB_LOGBOOK_SIZE + 1;
+	unsigned int latest = (nlast - RB_LOGBOOK_BEGIN) / RB_LOGBOOK_SIZE;
+	unsigned int count = (latest + RB_LOGBOOK_COUNT - first + 1) % RB_LOGBOOK_COUNT;
+
+	progress.maximum += count * RB_LOGBOOK_SIZE;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	unsigned int idx = first % RB_LOGBOOK_COUNT;
+	unsigned int remaining = count;
+	while (remaining) {
+		unsigned int n = RB_LOGBOOK_COUNT - idx;
+		if (n > remaining)
+			n = remaining;
+
+		unsigned int offset = RB_LOGBOOK_BEGIN + idx * RB_LOGBOOK_SIZE;
+		status = cressi_leonardo_device_read (abstract, offset, data + offset, n * RB_LOGBOOK_SIZE);
+		if (status != DC_STATUS_SUCCESS) {
+			ERROR (abstract->context, "Failed to read the logbook.");
+			return status;
+		}
+
+		progress.current += n * RB_LOGBOOK_SIZE;
+		device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+		remaining -= n;
+		idx = 0;
+	}
+
+	// The profiles of the new dives are stored back to back, starting at
+	// the previous end of profile pointer. Anything else means the
+	// changes can't be determined from the pointers alone.
+	unsigned int eop = oeop;
+	for (unsigned int i = 0; i < count; ++i) {
+		unsigned int offset = RB_LOGBOOK_BEGIN + ((first + i) % RB_LOGBOOK_COUNT) * RB_LOGBOOK_SIZE;
+		unsigned int header = array_uint16_le (data + offset + 2);
+		unsigned int footer = array_uint16_le (data + offset + 4);
+		if (header != eop ||
+			footer < RB_PROFILE_BEGIN || footer + 2 > RB_PROFILE_END) {
+			INFO (abstract->context, "Unexpected profile pointers (0x%04x 0x%04x 0x%04x).",
+				header, footer, eop);
+			return DC_STATUS_UNSUPPORTED;
+		}
+
+		eop = footer + 2;
+		if (eop == RB_PROFILE_END)
+			eop = RB_PROFILE_BEGIN;
+	}
+
+	if (eop != neop) {
+		INFO (abstract->context, "Unexpected end of profile pointer (0x%04x 0x%04x).", eop, neop);
+		return DC_STATUS_UNSUPPORTED;
+	}
+
+	// Read the new profile data, and one extra packet in case the device
+	// marks the end of the profile data.
+	unsigned int length = RB_PROFILE_DISTANCE (oeop, neop) + PACKETSIZE;
+	if (length > RB_PROFILE_END - RB_PROFILE_BEGIN)
+		length = RB_PROFILE_END - RB_PROFILE_BEGIN;
+
+	progress.maximum += length;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	unsigned int address = oeop;
+	while (length) {
+		unsigned int len = RB_PROFILE_END - address;
+		if (len > length)
+			len = length;
+
+		status = cressi_leonardo_device_read (abstract, address, data + address, len);
+		if (status != DC_STATUS_SUCCESS) {
+			ERROR (abstract->context, "Failed to read the profile.");
+			return status;
+		}
+
+		progress.current += len;
+		device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+		length -= len;
+		address = RB_PROFILE_BEGIN;
 	}
 
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+cressi_leonardo_device_download (dc_device_t *abstract, unsigned char data[])
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	cressi_leonardo_device_t *device = (cressi_leonardo_device_t *) abstract;
+
 	// Enable progress notifications.
 	dc_event_progress_t progress = EVENT_PROGRESS_INITIALIZER;
 	progress.maximum = SZ_MEMORY;
@@ -327,8 +489,6 @@ cressi_leonardo_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 		return DC_STATUS_PROTOCOL;
 	}
 
-	unsigned char *data = dc_buffer_get_data (buffer);
-
 	unsigned int nbytes = 0;
 	while (nbytes < SZ_MEMORY) {
 		// Set the minimum packet size.
@@ -381,6 +541,59 @@ cressi_leonardo_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 	return DC_STATUS_SUCCESS;
 }
 
+static dc_status_t
+cressi_leonardo_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
+{
+	dc_status_t status = DC_STATUS_UNSUPPORTED;
+
+	// Allocate the required amount of memory.
+	if (!dc_buffer_resize (buffer, SZ_MEMORY)) {
+		ERROR (abstract->context, "Insufficient buffer space available.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	unsigned char *data = dc_buffer_get_data (buffer);
+	int emitted = 0;
+
+	// Read only the changes since the previous memory image, and fall
+	// back to a full memory dump if that's not possible. The header is
+	// read first, such that the application can provide the memory image
+	// of this particular device from the devinfo event.
+	if (abstract->image) {
+		status = cressi_leonardo_device_read (abstract, 0, data, RB_LOGBOOK_BEGIN);
+		if (status != DC_STATUS_SUCCESS) {
+			ERROR (abstract->context, "Failed to read the header.");
+			return status;
+		}
+
+		cressi_leonardo_device_devinfo (abstract, data);
+		emitted = 1;
+
+		status = cressi_leonardo_device_update (abstract, data);
+	}
+	if (status == DC_STATUS_UNSUPPORTED) {
+		status = cressi_leonardo_device_download (abstract, data);
+	}
+	if (status != DC_STATUS_SUCCESS) {
+		return status;
+	}
+
+	if (!emitted) {
+		cressi_leonardo_device_devinfo (abstract, data);
+	}
+
+	// Keep the new memory image for the next session.
+	if (abstract->image) {
+		dc_buffer_clear (abstract->image);
+		if (!dc_buffer_append (abstract->image, data, SZ_MEMORY)) {
+			WARNING (abstract->context, "Failed to store the memory image.");
+			dc_buffer_clear (abstract->image);
+		}
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
 static dc_status_t
 cressi_leonardo_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
 {
@@ -394,13 +607,6 @@ cressi_leonardo_device_foreach (dc_device_t *abstract, dc_dive_callback_t callba
 		return rc;
 	}
 
-	unsigned char *data = dc_buffer_get_data (buffer);
-	dc_event_devinfo_t devinfo;
-	devinfo.model = data[0];
-	devinfo.firmware = 0;
-	devinfo.serial = array_uint24_le (data + 1);
-	device_event_emit (abstract, DC_EVENT_DEVINFO, &devinfo);
-
 	rc = cressi_leonardo_extract_dives (abstract, dc_buffer_get_data (buffer),
 		dc_buffer_get_size (buffer), callback, userdata);
 
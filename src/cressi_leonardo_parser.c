@@ -48,9 +48,13 @@ static const dc_parser_vtable_t cressi_leonardo_parser_vtable = {
 	sizeof(cressi_leonardo_parser_t),
 	DC_FAMILY_CRESSI_LEONARDO,
 	cressi_leonardo_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	cressi_leonardo_parser_get_datetime, /* datetime */
 	cressi_leonardo_parser_get_field, /* fields */
 	cressi_leonardo_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
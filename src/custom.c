@@ -61,8 +61,11 @@ static const dc_iostream_vtable_t dc_custom_vtable = {
 	dc_custom_get_available, /* get_available */
 	dc_custom_configure, /* configure */
 	dc_custom_poll, /* poll */
+	NULL, /* get_fd */
 	dc_custom_read, /* read */
 	dc_custom_write, /* write */
+	NULL, /* read_nonblock */
+	NULL, /* write_nonblock */
 	dc_custom_ioctl, /* ioctl */
 	dc_custom_flush, /* flush */
 	dc_custom_purge, /* purge */
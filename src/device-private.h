@@ -28,6 +28,7 @@
 #include <libdivecomputer/device.h>
 
 #include "common-private.h"
+#include "pacing.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -54,6 +55,14 @@ struct dc_device_t {
 	// Cached events for the parsers.
 	dc_event_devinfo_t devinfo;
 	dc_event_clock_t clock;
+	// Adaptive inter packet delay.
+	dc_pacing_t pacing;
+	// Checkpoint of a memory dump.
+	dc_buffer_t *checkpoint;
+	unsigned int checkpoint_offset;
+	unsigned int checkpoint_resume;
+	// Previous memory image.
+	dc_buffer_t *image;
 };
 
 struct dc_device_vtable_t {
@@ -94,6 +103,28 @@ device_is_cancelled (dc_device_t *device);
 dc_status_t
 device_dump_read (dc_device_t *device, unsigned char data[], unsigned int size, unsigned int blocksize);
 
+/*
+ * Restore the part of a memory dump that is already present in the
+ * checkpoint. Reading always starts at address zero again: the first
+ * and the last block are read once more, to check whether the memory
+ * of the device is still the same, and device_checkpoint_update skips
+ * the blocks in between. The memory is assumed to be read sequentially,
+ * in blocks of the given size. The identity of the device (from the
+ * devinfo event) must match as well. When the backend has not emitted
+ * it at this point, the dump is not resumed.
+ */
+void
+device_checkpoint_resume (dc_device_t *device, unsigned char data[], unsigned int size, unsigned int blocksize);
+
+/*
+ * Add the data received so far (up to address nbytes) to the checkpoint,
+ * and return the address to continue reading from. That is normally
+ * nbytes itself, the last restored block after the first block has been
+ * verified, or zero if the restored data turned out to be stale.
+ */
+unsigned int
+device_checkpoint_update (dc_device_t *device, const unsigned char data[], unsigned int size, unsigned int nbytes);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -61,6 +61,11 @@
 
 #include "device-private.h"
 #include "context-private.h"
+#include "thread.h"
+#include "array.h"
+
+#define CHECKPOINT_MAGIC  0x50434344 /* "DCCP" */
+#define CHECKPOINT_HEADER 24
 
 dc_device_t *
 dc_device_allocate (dc_context_t *context, const dc_device_vtable_t *vtable)
@@ -91,6 +96,15 @@ dc_device_allocate (dc_context_t *context, const dc_device_vtable_t *vtable)
 	memset (&device->devinfo, 0, sizeof (device->devinfo));
 	memset (&device->clock, 0, sizeof (device->clock));
 
+	// Disabled until the backend enables it.
+	dc_pacing_init (&device->pacing, 0, 0, 0);
+
+	device->checkpoint = NULL;
+	device->checkpoint_offset = 0;
+	device->checkpoint_resume = 0;
+
+	device->image = NULL;
+
 	return device;
 }
 
@@ -285,6 +299,171 @@ dc_device_set_fingerprint (dc_device_t *device, const unsigned char data[], unsi
 }
 
 
+dc_status_t
+dc_device_set_pacing (dc_device_t *device, unsigned int delay)
+{
+	if (device == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (!dc_pacing_enabled (&device->pacing))
+		return DC_STATUS_UNSUPPORTED;
+
+	dc_pacing_set (&device->pacing, delay);
+
+	return DC_STATUS_SUCCESS;
+}
+
+
+dc_status_t
+dc_device_get_pacing (dc_device_t *device, unsigned int *delay)
+{
+	if (device == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (!dc_pacing_enabled (&device->pacing))
+		return DC_STATUS_UNSUPPORTED;
+
+	if (delay == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	*delay = dc_pacing_get (&device->pacing);
+
+	return DC_STATUS_SUCCESS;
+}
+
+
+dc_status_t
+dc_device_set_checkpoint (dc_device_t *device, dc_buffer_t *checkpoint)
+{
+	if (device == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	device->checkpoint = checkpoint;
+	device->checkpoint_offset = 0;
+	device->checkpoint_resume = 0;
+
+	return DC_STATUS_SUCCESS;
+}
+
+
+dc_status_t
+dc_device_set_image (dc_device_t *device, dc_buffer_t *image)
+{
+	if (device == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	device->image = image;
+
+	return DC_STATUS_SUCCESS;
+}
+
+
+static void
+device_checkpoint_reset (dc_device_t *device, unsigned int size)
+{
+	unsigned char header[CHECKPOINT_HEADER] = {0};
+
+	array_uint32_le_set (header +  0, CHECKPOINT_MAGIC);
+	array_uint32_le_set (header +  4, dc_device_get_type (device));
+	array_uint32_le_set (header +  8, size);
+	array_uint32_le_set (header + 12, device->devinfo.model);
+	array_uint32_le_set (header + 16, device->devinfo.firmware);
+	array_uint32_le_set (header + 20, device->devinfo.serial);
+
+	dc_buffer_clear (device->checkpoint);
+	if (!dc_buffer_append (device->checkpoint, header, sizeof (header))) {
+		WARNING (device->context, "Failed to allocate memory for the checkpoint.");
+		dc_buffer_clear (device->checkpoint);
+	}
+
+	device->checkpoint_offset = 0;
+	device->checkpoint_resume = 0;
+}
+
+
+void
+device_checkpoint_resume (dc_device_t *device, unsigned char data[], unsigned int size, unsigned int blocksize)
+{
+	if (device->checkpoint == NULL)
+		return;
+
+	const unsigned char *header = dc_buffer_get_data (device->checkpoint);
+	unsigned int length = dc_buffer_get_size (device->checkpoint);
+	unsigned int nbytes = 0;
+
+	// Check whether the checkpoint belongs to this memory dump. Without a
+	// known identity of the device, the data could belong to any other
+	// device of the same family, and the dump is never resumed.
+	if (length >= CHECKPOINT_HEADER &&
+		array_uint32_le (header + 0) == CHECKPOINT_MAGIC &&
+		array_uint32_le (header + 4) == dc_device_get_type (device) &&
+		array_uint32_le (header + 8) == size &&
+		array_uint32_le (header + 12) == device->devinfo.model &&
+		array_uint32_le (header + 16) == device->devinfo.firmware &&
+		array_uint32_le (header + 20) == device->devinfo.serial &&
+		device->devinfo.serial != 0) {
+		nbytes = length - CHECKPOINT_HEADER;
+	}
+
+	if (nbytes < blocksize || nbytes >= size) {
+		device_checkpoint_reset (device, size);
+		return;
+	}
+
+	memcpy (data, header + CHECKPOINT_HEADER, nbytes);
+
+	// Start with the first block again, and continue with the last one.
+	device->checkpoint_offset = 0;
+	device->checkpoint_resume = (nbytes - 1) / blocksize * blocksize;
+
+	INFO (device->context, "Resuming the memory dump at address 0x%08x.", device->checkpoint_resume);
+}
+
+
+unsigned int
+device_checkpoint_update (dc_device_t *device, const unsigned char data[], unsigned int size, unsigned int nbytes)
+{
+	if (device->checkpoint == NULL)
+		return nbytes;
+
+	unsigned int length = dc_buffer_get_size (device->checkpoint);
+	if (length < CHECKPOINT_HEADER)
+		return nbytes;
+
+	// Compare the data that was read again with the restored data.
+	unsigned int begin = device->checkpoint_offset;
+	unsigned int stored = length - CHECKPOINT_HEADER;
+	if (begin < stored) {
+		unsigned int end = nbytes < stored ? nbytes : stored;
+		const unsigned char *old = dc_buffer_get_data (device->checkpoint) + CHECKPOINT_HEADER;
+		if (memcmp (data + begin, old + begin, end - begin) != 0) {
+			WARNING (device->context, "The checkpoint does not match the device memory. Restarting the memory dump.");
+			device_checkpoint_reset (device, size);
+			return 0;
+		}
+	}
+
+	if (nbytes == size) {
+		// The memory dump is complete.
+		dc_buffer_clear (device->checkpoint);
+	} else if (nbytes > stored) {
+		if (!dc_buffer_append (device->checkpoint, data + stored, nbytes - stored)) {
+			WARNING (device->context, "Failed to allocate memory for the checkpoint.");
+			dc_buffer_clear (device->checkpoint);
+		}
+	}
+
+	// Skip the data that was restored from the checkpoint.
+	if (device->checkpoint_resume > nbytes)
+		nbytes = device->checkpoint_resume;
+	device->checkpoint_resume = 0;
+
+	device->checkpoint_offset = nbytes;
+
+	return nbytes;
+}
+
+
 dc_status_t
 dc_device_read (dc_device_t *device, unsigned int address, unsigned char data[], unsigned int size)
 {
@@ -343,6 +522,10 @@ device_dump_read (dc_device_t *device, unsigned char data[], unsigned int size,
 	progress.maximum = size;
 	device_event_emit (device, DC_EVENT_PROGRESS, &progress);
 
+	// Restore the part that was already downloaded in a previous session.
+	// The progress skips ahead once the first block has been verified.
+	device_checkpoint_resume (device, data, size, blocksize);
+
 	unsigned int nbytes = 0;
 	while (nbytes < size) {
 		// Calculate the packet size.
@@ -355,11 +538,11 @@ device_dump_read (dc_device_t *device, unsigned char data[], unsigned int size,
 		if (rc != DC_STATUS_SUCCESS)
 			return rc;
 
+		nbytes = device_checkpoint_update (device, data, size, nbytes + len);
+
 		// Update and emit a progress event.
-		progress.current += len;
+		progress.current = nbytes;
 		device_event_emit (device, DC_EVENT_PROGRESS, &progress);
-
-		nbytes += len;
 	}
 
 	return DC_STATUS_SUCCESS;
@@ -379,6 +562,178 @@ dc_device_foreach (dc_device_t *device, dc_dive_callback_t callback, void *userd
 }
 
 
+typedef struct dc_pipeline_item_t {
+	unsigned char *buffer;
+	unsigned int capacity;
+	unsigned int size;
+	unsigned int fsize;
+} dc_pipeline_item_t;
+
+typedef struct dc_pipeline_t {
+	dc_device_t *device;
+	dc_dive_callback_t callback;
+	void *userdata;
+	dc_mutex_t *mutex;
+	dc_cond_t *cond;
+	dc_pipeline_item_t *items;
+	unsigned int depth;
+	unsigned int head;
+	unsigned int count;
+	dc_status_t status;
+	int finished;
+	int stopped;
+} dc_pipeline_t;
+
+
+static int
+dc_pipeline_produce (const unsigned char *data, unsigned int size, const unsigned char *fingerprint, unsigned int fsize, void *userdata)
+{
+	dc_pipeline_t *pipeline = (dc_pipeline_t *) userdata;
+	dc_pipeline_item_t *item = NULL;
+
+	// Wait for a free buffer, or stop the download once the consumer
+	// is no longer interested.
+	dc_mutex_lock (pipeline->mutex);
+	while (!pipeline->stopped && pipeline->count == pipeline->depth)
+		dc_cond_wait (pipeline->cond, pipeline->mutex);
+	int stopped = pipeline->stopped;
+	if (!stopped)
+		item = pipeline->items + (pipeline->head + pipeline->count) % pipeline->depth;
+	dc_mutex_unlock (pipeline->mutex);
+
+	if (stopped)
+		return 0;
+
+	// The free buffer is not visible to the consumer until it is
+	// queued, so it can be filled without holding the lock.
+	if (item->capacity < size + fsize) {
+		unsigned char *buffer = (unsigned char *) realloc (item->buffer, size + fsize);
+		if (buffer == NULL) {
+			ERROR (pipeline->device->context, "Failed to allocate memory.");
+			pipeline->status = DC_STATUS_NOMEMORY;
+			return 0;
+		}
+		item->buffer = buffer;
+		item->capacity = size + fsize;
+	}
+
+	if (size)
+		memcpy (item->buffer, data, size);
+	if (fsize)
+		memcpy (item->buffer + size, fingerprint, fsize);
+	item->size = size;
+	item->fsize = fsize;
+
+	dc_mutex_lock (pipeline->mutex);
+	pipeline->count++;
+	dc_cond_broadcast (pipeline->cond);
+	dc_mutex_unlock (pipeline->mutex);
+
+	return 1;
+}
+
+
+static void
+dc_pipeline_consume (void *userdata)
+{
+	dc_pipeline_t *pipeline = (dc_pipeline_t *) userdata;
+
+	dc_mutex_lock (pipeline->mutex);
+	while (!pipeline->stopped) {
+		while (pipeline->count == 0 && !pipeline->finished)
+			dc_cond_wait (pipeline->cond, pipeline->mutex);
+		if (pipeline->count == 0)
+			break;
+		dc_pipeline_item_t *item = pipeline->items + pipeline->head;
+		dc_mutex_unlock (pipeline->mutex);
+
+		int proceed = pipeline->callback (item->buffer, item->size,
+			item->buffer + item->size, item->fsize, pipeline->userdata);
+
+		// Dives that are still queued after the callback asked to
+		// stop are discarded.
+		dc_mutex_lock (pipeline->mutex);
+		pipeline->head = (pipeline->head + 1) % pipeline->depth;
+		pipeline->count--;
+		if (!proceed)
+			pipeline->stopped = 1;
+		dc_cond_broadcast (pipeline->cond);
+	}
+	dc_mutex_unlock (pipeline->mutex);
+}
+
+
+dc_status_t
+dc_device_foreach_pipelined (dc_device_t *device, unsigned int depth, dc_dive_callback_t callback, void *userdata)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_pipeline_t pipeline;
+	dc_thread_t *thread = NULL;
+
+	if (device == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (depth == 0 || callback == NULL)
+		return dc_device_foreach (device, callback, userdata);
+
+	pipeline.device = device;
+	pipeline.callback = callback;
+	pipeline.userdata = userdata;
+	pipeline.mutex = NULL;
+	pipeline.cond = NULL;
+	pipeline.depth = depth;
+	pipeline.head = 0;
+	pipeline.count = 0;
+	pipeline.status = DC_STATUS_SUCCESS;
+	pipeline.finished = 0;
+	pipeline.stopped = 0;
+	pipeline.items = (dc_pipeline_item_t *) calloc (depth, sizeof (dc_pipeline_item_t));
+	if (pipeline.items == NULL) {
+		ERROR (device->context, "Failed to allocate memory.");
+		status = DC_STATUS_NOMEMORY;
+		goto error_free;
+	}
+
+	status = dc_mutex_new (&pipeline.mutex);
+	if (status == DC_STATUS_SUCCESS) {
+		status = dc_cond_new (&pipeline.cond);
+	}
+	if (status == DC_STATUS_SUCCESS) {
+		status = dc_thread_new (&thread, dc_pipeline_consume, &pipeline);
+	}
+	if (status != DC_STATUS_SUCCESS) {
+		// Without a consumer thread, process the dives synchronously.
+		if (status != DC_STATUS_UNSUPPORTED)
+			WARNING (device->context, "Failed to start the consumer thread.");
+		status = dc_device_foreach (device, callback, userdata);
+		goto error_free;
+	}
+
+	status = dc_device_foreach (device, dc_pipeline_produce, &pipeline);
+
+	// Let the consumer drain the queue.
+	dc_mutex_lock (pipeline.mutex);
+	pipeline.finished = 1;
+	dc_cond_broadcast (pipeline.cond);
+	dc_mutex_unlock (pipeline.mutex);
+
+	dc_thread_join (thread);
+
+	if (status == DC_STATUS_SUCCESS)
+		status = pipeline.status;
+
+error_free:
+	if (pipeline.items) {
+		for (unsigned int i = 0; i < depth; ++i)
+			free (pipeline.items[i].buffer);
+	}
+	dc_cond_free (pipeline.cond);
+	dc_mutex_free (pipeline.mutex);
+	free (pipeline.items);
+	return status;
+}
+
+
 dc_status_t
 dc_device_timesync (dc_device_t *device, const dc_datetime_t *datetime)
 {
@@ -435,6 +790,9 @@ device_event_emit (dc_device_t *device, dc_event_type_t event, const void *data)
 	case DC_EVENT_CLOCK:
 		assert (data != NULL);
 		break;
+	case DC_EVENT_DIVEDATA:
+		assert (data != NULL);
+		break;
 	default:
 		break;
 	}
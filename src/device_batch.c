@@ -0,0 +1,365 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libdivecomputer/device.h>
+
+#include "context-private.h"
+#include "common-private.h"
+#include "thread.h"
+
+typedef struct dc_download_engine_t dc_download_engine_t;
+
+typedef struct dc_download_worker_t {
+	dc_download_engine_t *engine;
+	const dc_download_job_t *job;
+	dc_download_state_t *state;
+	dc_thread_t *thread;
+	dc_device_t *device;
+	dc_transport_t transport;
+	unsigned int maximum;
+	unsigned int local;
+} dc_download_worker_t;
+
+struct dc_download_engine_t {
+	dc_context_t *context;
+	const dc_download_job_t *jobs;
+	unsigned int njobs;
+	dc_download_dive_t dive;
+	dc_download_monitor_t monitor;
+	void *userdata;
+	dc_download_worker_t *workers;
+	dc_download_state_t *states;
+	dc_download_state_t *snapshot;
+	dc_mutex_t *mutex;
+	dc_cond_t *cond;
+	dc_cond_t *slots;
+	unsigned int nfinished;
+	int changed;
+	int cancelled;
+};
+
+static void
+dc_download_deliver (dc_download_engine_t *engine)
+{
+	dc_mutex_lock (engine->mutex);
+	int changed = engine->changed;
+	if (changed) {
+		memcpy (engine->snapshot, engine->states, engine->njobs * sizeof (dc_download_state_t));
+		engine->changed = 0;
+	}
+	dc_mutex_unlock (engine->mutex);
+
+	if (!changed || engine->monitor == NULL)
+		return;
+
+	if (!engine->monitor (engine->jobs, engine->snapshot, engine->njobs, engine->userdata)) {
+		dc_mutex_lock (engine->mutex);
+		engine->cancelled = 1;
+		dc_cond_broadcast (engine->slots);
+		dc_mutex_unlock (engine->mutex);
+	}
+}
+
+static void
+dc_download_notify (dc_download_engine_t *engine)
+{
+	// Must be called with the engine mutex locked.
+	engine->changed = 1;
+	dc_cond_signal (engine->cond);
+}
+
+static unsigned int
+dc_download_active (dc_download_engine_t *engine, dc_transport_t transport)
+{
+	unsigned int count = 0;
+
+	for (unsigned int i = 0; i < engine->njobs; ++i) {
+		const dc_download_worker_t *worker = engine->workers + i;
+		if (worker->transport == transport &&
+			worker->state->started && !worker->state->finished)
+			count++;
+	}
+
+	return count;
+}
+
+static int
+dc_download_acquire (dc_download_worker_t *worker)
+{
+	dc_download_engine_t *engine = worker->engine;
+
+	// Wait for a free slot on the transport.
+	dc_mutex_lock (engine->mutex);
+	while (!engine->cancelled && worker->maximum &&
+		dc_download_active (engine, worker->transport) >= worker->maximum)
+		dc_cond_wait (engine->slots, engine->mutex);
+	int cancelled = engine->cancelled;
+	if (!cancelled) {
+		worker->state->started = 1;
+		dc_download_notify (engine);
+	}
+	dc_mutex_unlock (engine->mutex);
+
+	return !cancelled;
+}
+
+static int
+dc_download_cancel (void *userdata)
+{
+	dc_download_worker_t *worker = (dc_download_worker_t *) userdata;
+	dc_download_engine_t *engine = worker->engine;
+
+	dc_mutex_lock (engine->mutex);
+	int cancelled = engine->cancelled;
+	dc_mutex_unlock (engine->mutex);
+
+	return cancelled;
+}
+
+static void
+dc_download_event (dc_device_t *device, dc_event_type_t event, const void *data, void *userdata)
+{
+	dc_download_worker_t *worker = (dc_download_worker_t *) userdata;
+	dc_download_engine_t *engine = worker->engine;
+	dc_download_state_t *state = worker->state;
+
+	dc_mutex_lock (engine->mutex);
+	switch (event) {
+	case DC_EVENT_PROGRESS:
+		state->progress = *(const dc_event_progress_t *) data;
+		break;
+	case DC_EVENT_DEVINFO:
+		state->devinfo = *(const dc_event_devinfo_t *) data;
+		break;
+	case DC_EVENT_CLOCK:
+		state->clock = *(const dc_event_clock_t *) data;
+		break;
+	default:
+		break;
+	}
+	state->events |= event;
+	dc_download_notify (engine);
+	dc_mutex_unlock (engine->mutex);
+
+	// Jobs running on the calling thread report immediately.
+	if (worker->local)
+		dc_download_deliver (engine);
+}
+
+static int
+dc_download_dive (const unsigned char *data, unsigned int size, const unsigned char *fingerprint, unsigned int fsize, void *userdata)
+{
+	dc_download_worker_t *worker = (dc_download_worker_t *) userdata;
+	dc_download_engine_t *engine = worker->engine;
+
+	dc_mutex_lock (engine->mutex);
+	worker->state->ndives++;
+	dc_download_notify (engine);
+	dc_mutex_unlock (engine->mutex);
+
+	if (worker->local)
+		dc_download_deliver (engine);
+
+	if (engine->dive)
+		return engine->dive (worker->device, worker->job, data, size, fingerprint, fsize);
+
+	return 1;
+}
+
+static dc_status_t
+dc_download_worker_run (dc_download_worker_t *worker)
+{
+	dc_download_engine_t *engine = worker->engine;
+	const dc_download_job_t *job = worker->job;
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_status_t rc = DC_STATUS_SUCCESS;
+
+	status = dc_device_open (&worker->device, engine->context, job->descriptor, job->iostream);
+	if (status != DC_STATUS_SUCCESS) {
+		return status;
+	}
+
+	unsigned int events = DC_EVENT_PROGRESS | DC_EVENT_DEVINFO | DC_EVENT_CLOCK;
+	status = dc_device_set_events (worker->device, events, dc_download_event, worker);
+	if (status != DC_STATUS_SUCCESS) {
+		goto error_close;
+	}
+
+	status = dc_device_set_cancel (worker->device, dc_download_cancel, worker);
+	if (status != DC_STATUS_SUCCESS) {
+		goto error_close;
+	}
+
+	if (job->fingerprint) {
+		status = dc_device_set_fingerprint (worker->device, job->fingerprint, job->fsize);
+		if (status != DC_STATUS_SUCCESS && status != DC_STATUS_UNSUPPORTED) {
+			goto error_close;
+		}
+	}
+
+	status = dc_device_foreach (worker->device, dc_download_dive, worker);
+
+error_close:
+	rc = dc_device_close (worker->device);
+	dc_status_set_error (&status, rc);
+	worker->device = NULL;
+	return status;
+}
+
+static void
+dc_download_worker_main (void *userdata)
+{
+	dc_download_worker_t *worker = (dc_download_worker_t *) userdata;
+	dc_download_engine_t *engine = worker->engine;
+	dc_status_t status = DC_STATUS_CANCELLED;
+
+	if (dc_download_acquire (worker)) {
+		status = dc_download_worker_run (worker);
+	}
+
+	// Release the transport slot.
+	dc_mutex_lock (engine->mutex);
+	worker->state->status = status;
+	worker->state->finished = 1;
+	engine->nfinished++;
+	dc_download_notify (engine);
+	dc_cond_broadcast (engine->slots);
+	dc_mutex_unlock (engine->mutex);
+
+	if (worker->local)
+		dc_download_deliver (engine);
+}
+
+dc_status_t
+dc_download_batch (dc_context_t *context, const dc_download_job_t jobs[], unsigned int njobs, const dc_download_limit_t limits[], unsigned int nlimits, dc_download_dive_t dive, dc_download_monitor_t monitor, void *userdata, dc_download_state_t states[])
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_download_engine_t engine;
+
+	if ((jobs == NULL && njobs != 0) || (limits == NULL && nlimits != 0))
+		return DC_STATUS_INVALIDARGS;
+
+	for (unsigned int i = 0; i < njobs; ++i) {
+		if (jobs[i].descriptor == NULL || jobs[i].iostream == NULL)
+			return DC_STATUS_INVALIDARGS;
+	}
+
+	engine.context = context;
+	engine.jobs = jobs;
+	engine.njobs = njobs;
+	engine.dive = dive;
+	engine.monitor = monitor;
+	engine.userdata = userdata;
+	engine.mutex = NULL;
+	engine.cond = NULL;
+	engine.slots = NULL;
+	engine.nfinished = 0;
+	engine.changed = 0;
+	engine.cancelled = 0;
+	engine.workers = (dc_download_worker_t *) calloc (njobs ? njobs : 1, sizeof (dc_download_worker_t));
+	engine.states = (dc_download_state_t *) calloc (njobs ? njobs : 1, sizeof (dc_download_state_t));
+	engine.snapshot = (dc_download_state_t *) calloc (njobs ? njobs : 1, sizeof (dc_download_state_t));
+	if (engine.workers == NULL || engine.states == NULL || engine.snapshot == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		status = DC_STATUS_NOMEMORY;
+		goto error_free;
+	}
+
+	status = dc_mutex_new (&engine.mutex);
+	if (status == DC_STATUS_SUCCESS) {
+		status = dc_cond_new (&engine.cond);
+	}
+	if (status == DC_STATUS_SUCCESS) {
+		status = dc_cond_new (&engine.slots);
+	}
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (context, "Failed to create the synchronization objects.");
+		goto error_free;
+	}
+
+	for (unsigned int i = 0; i < njobs; ++i) {
+		dc_download_worker_t *worker = engine.workers + i;
+		worker->engine = &engine;
+		worker->job = jobs + i;
+		worker->state = engine.states + i;
+		worker->state->status = DC_STATUS_SUCCESS;
+		worker->transport = dc_iostream_get_transport (jobs[i].iostream);
+		for (unsigned int j = 0; j < nlimits; ++j) {
+			if (limits[j].transport == worker->transport)
+				worker->maximum = limits[j].maximum;
+		}
+	}
+
+	// Start one thread per job. A job without a thread is downloaded
+	// on the calling thread instead, after all threads are started.
+	for (unsigned int i = 0; i < njobs; ++i) {
+		dc_download_worker_t *worker = engine.workers + i;
+		status = dc_thread_new (&worker->thread, dc_download_worker_main, worker);
+		if (status != DC_STATUS_SUCCESS) {
+			if (status != DC_STATUS_UNSUPPORTED)
+				WARNING (context, "Failed to start the thread for job %u.", i);
+			worker->thread = NULL;
+			worker->local = 1;
+		}
+	}
+	status = DC_STATUS_SUCCESS;
+
+	for (unsigned int i = 0; i < njobs; ++i) {
+		if (engine.workers[i].local)
+			dc_download_worker_main (engine.workers + i);
+	}
+
+	// Report the changes until all jobs have finished, and the final
+	// state has been delivered.
+	dc_mutex_lock (engine.mutex);
+	while (engine.nfinished < njobs || engine.changed) {
+		while (!engine.changed)
+			dc_cond_wait (engine.cond, engine.mutex);
+		dc_mutex_unlock (engine.mutex);
+
+		dc_download_deliver (&engine);
+
+		dc_mutex_lock (engine.mutex);
+	}
+	dc_mutex_unlock (engine.mutex);
+
+	for (unsigned int i = 0; i < njobs; ++i) {
+		if (engine.workers[i].thread)
+			dc_thread_join (engine.workers[i].thread);
+	}
+
+	if (states) {
+		memcpy (states, engine.states, njobs * sizeof (dc_download_state_t));
+	}
+
+error_free:
+	dc_cond_free (engine.slots);
+	dc_cond_free (engine.cond);
+	dc_mutex_free (engine.mutex);
+	free (engine.snapshot);
+	free (engine.states);
+	free (engine.workers);
+	return status;
+}
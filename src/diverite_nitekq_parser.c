@@ -58,9 +58,13 @@ static const dc_parser_vtable_t diverite_nitekq_parser_vtable = {
 	sizeof(diverite_nitekq_parser_t),
 	DC_FAMILY_DIVERITE_NITEKQ,
 	diverite_nitekq_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	diverite_nitekq_parser_get_datetime, /* datetime */
 	diverite_nitekq_parser_get_field, /* fields */
 	diverite_nitekq_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -138,6 +142,9 @@ diverite_nitekq_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, u
 	dc_gasmix_t *gasmix = (dc_gasmix_t *) value;
 
 	if (!parser->cached) {
+		if (abstract->headeronly)
+			return DC_STATUS_UNSUPPORTED;
+
 		dc_status_t rc = diverite_nitekq_parser_samples_foreach (abstract, NULL, NULL);
 		if (rc != DC_STATUS_SUCCESS)
 			return rc;
@@ -87,9 +87,13 @@ static const dc_parser_vtable_t divesystem_idive_parser_vtable = {
 	sizeof(divesystem_idive_parser_t),
 	DC_FAMILY_DIVESYSTEM_IDIVE,
 	divesystem_idive_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	divesystem_idive_parser_get_datetime, /* datetime */
 	divesystem_idive_parser_get_field, /* fields */
 	divesystem_idive_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -274,6 +278,9 @@ divesystem_idive_parser_get_field (dc_parser_t *abstract, dc_field_type_t type,
 		return DC_STATUS_DATAFORMAT;
 
 	if (!parser->cached) {
+		if (abstract->headeronly)
+			return DC_STATUS_UNSUPPORTED;
+
 		dc_status_t rc = divesystem_idive_parser_samples_foreach (abstract, NULL, NULL);
 		if (rc != DC_STATUS_SUCCESS)
 			return rc;
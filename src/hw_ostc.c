@@ -28,6 +28,7 @@
 #include "checksum.h"
 #include "array.h"
 #include "ihex.h"
+#include "buffered.h"
 
 #define ISINSTANCE(device) dc_device_isinstance((device), &hw_ostc_device_vtable)
 
@@ -70,6 +71,7 @@ static dc_status_t hw_ostc_device_set_fingerprint (dc_device_t *abstract, const
 static dc_status_t hw_ostc_device_dump (dc_device_t *abstract, dc_buffer_t *buffer);
 static dc_status_t hw_ostc_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata);
 static dc_status_t hw_ostc_device_timesync (dc_device_t *abstract, const dc_datetime_t *datetime);
+static dc_status_t hw_ostc_device_close (dc_device_t *abstract);
 
 static const dc_device_vtable_t hw_ostc_device_vtable = {
 	sizeof(hw_ostc_device_t),
@@ -80,7 +82,7 @@ static const dc_device_vtable_t hw_ostc_device_vtable = {
 	hw_ostc_device_dump, /* dump */
 	hw_ostc_device_foreach, /* foreach */
 	hw_ostc_device_timesync, /* timesync */
-	NULL /* close */
+	hw_ostc_device_close /* close */
 };
 
 static dc_status_t
@@ -137,21 +139,28 @@ hw_ostc_device_open (dc_device_t **out, dc_context_t *context, dc_iostream_t *io
 	}
 
 	// Set the default values.
-	device->iostream = iostream;
 	memset (device->fingerprint, 0, sizeof (device->fingerprint));
 
+	// Read ahead, because the run-length encoded screenshot is decoded
+	// one byte at a time, while the device is already sending.
+	status = dc_buffered_open (&device->iostream, context, iostream, 1024);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (context, "Failed to create the buffered stream.");
+		goto error_free;
+	}
+
 	// Set the serial communication protocol (115200 8N1).
 	status = dc_iostream_configure (device->iostream, 115200, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the terminal attributes.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Set the timeout for receiving data.
 	status = dc_iostream_set_timeout (device->iostream, 4000);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the timeout.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Make sure everything is in a sane state.
@@ -162,12 +171,23 @@ hw_ostc_device_open (dc_device_t **out, dc_context_t *context, dc_iostream_t *io
 
 	return DC_STATUS_SUCCESS;
 
+error_close:
+	dc_iostream_close (device->iostream);
 error_free:
 	dc_device_deallocate ((dc_device_t *) device);
 	return status;
 }
 
 
+static dc_status_t
+hw_ostc_device_close (dc_device_t *abstract)
+{
+	hw_ostc_device_t *device = (hw_ostc_device_t *) abstract;
+
+	return dc_iostream_close (device->iostream);
+}
+
+
 static dc_status_t
 hw_ostc_device_set_fingerprint (dc_device_t *abstract, const unsigned char data[], unsigned int size)
 {
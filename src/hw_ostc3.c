@@ -184,7 +184,7 @@ hw_ostc3_strncpy (unsigned char *data, unsigned int size, const char *text)
 }
 
 static dc_status_t
-hw_ostc3_read (hw_ostc3_device_t *device, dc_event_progress_t *progress, unsigned char data[], size_t size)
+hw_ostc3_read (hw_ostc3_device_t *device, dc_event_progress_t *progress, dc_event_divedata_t *divedata, unsigned char data[], size_t size)
 {
 	dc_status_t rc = DC_STATUS_SUCCESS;
 	dc_transport_t transport = dc_iostream_get_transport(device->iostream);
@@ -229,6 +229,14 @@ hw_ostc3_read (hw_ostc3_device_t *device, dc_event_progress_t *progress, unsigne
 			device_event_emit ((dc_device_t *) device, DC_EVENT_PROGRESS, progress);
 		}
 
+		// Emit a divedata event.
+		if (divedata) {
+			divedata->data = data + nbytes;
+			divedata->size = length;
+			divedata->offset = nbytes;
+			device_event_emit ((dc_device_t *) device, DC_EVENT_DIVEDATA, divedata);
+		}
+
 		nbytes += length;
 	}
 
@@ -296,7 +304,7 @@ hw_ostc3_transfer (hw_ostc3_device_t *device,
 
 	// Read the echo.
 	unsigned char echo[1] = {0};
-	status = hw_ostc3_read (device, NULL, echo, sizeof (echo));
+	status = hw_ostc3_read (device, NULL, NULL, echo, sizeof (echo));
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (abstract->context, "Failed to receive the echo.");
 		return status;
@@ -323,8 +331,10 @@ hw_ostc3_transfer (hw_ostc3_device_t *device,
 	}
 
 	if (output) {
-		// Read the output data packet.
-		status = hw_ostc3_read (device, progress, output, osize);
+		// Read the output data packet. The dive data is also passed to
+		// the application while it arrives.
+		dc_event_divedata_t divedata = {NULL, 0, 0, osize};
+		status = hw_ostc3_read (device, progress, cmd == DIVE ? &divedata : NULL, output, osize);
 		if (status != DC_STATUS_SUCCESS) {
 			ERROR (abstract->context, "Failed to receive the answer.");
 			return status;
@@ -338,7 +348,7 @@ hw_ostc3_transfer (hw_ostc3_device_t *device,
 	if (cmd != EXIT) {
 		// Read the ready byte.
 		unsigned char answer[1] = {0};
-		status = hw_ostc3_read (device, NULL, answer, sizeof (answer));
+		status = hw_ostc3_read (device, NULL, NULL, answer, sizeof (answer));
 		if (status != DC_STATUS_SUCCESS) {
 			ERROR (abstract->context, "Failed to receive the ready byte.");
 			return status;
@@ -477,7 +487,7 @@ hw_ostc3_device_init_service (hw_ostc3_device_t *device)
 		}
 
 		// Read the answer.
-		status = hw_ostc3_read (device, NULL, answer + i, 1);
+		status = hw_ostc3_read (device, NULL, NULL, answer + i, 1);
 		if (status != DC_STATUS_SUCCESS) {
 			ERROR (abstract->context, "Failed to receive the answer.");
 			return status;
@@ -492,7 +502,7 @@ hw_ostc3_device_init_service (hw_ostc3_device_t *device)
 	}
 
 	// Read the ready byte.
-	status = hw_ostc3_read (device, NULL, answer + 4, 1);
+	status = hw_ostc3_read (device, NULL, NULL, answer + 4, 1);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (abstract->context, "Failed to receive the ready byte.");
 		return status;
@@ -1659,6 +1669,8 @@ hw_ostc3_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 
 	unsigned char *data = dc_buffer_get_data (buffer);
 
+	device_checkpoint_resume (abstract, data, SZ_MEMORY, SZ_FIRMWARE_BLOCK);
+
 	unsigned int nbytes = 0;
 	while (nbytes < SZ_MEMORY) {
 		// packet size. Can be almost arbitrary size.
@@ -1671,11 +1683,11 @@ hw_ostc3_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 			return rc;
 		}
 
+		nbytes = device_checkpoint_update (abstract, data, SZ_MEMORY, nbytes + len);
+
 		// Update and emit a progress event.
-		progress.current += len;
+		progress.current = nbytes;
 		device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
-
-		nbytes += len;
 	}
 
 	return DC_STATUS_SUCCESS;
@@ -20,6 +20,7 @@
  */
 
 #include <stdlib.h>
+#include <limits.h>
 
 #include "libdivecomputer/units.h"
 
@@ -119,20 +120,28 @@ typedef struct hw_ostc_parser_t {
 	unsigned int initial_setpoint;
 	unsigned int initial_cns;
 	hw_ostc_gasmix_t gasmix[NGASMIXES];
+	dc_sample_index_t index;
 } hw_ostc_parser_t;
 
 static dc_status_t hw_ostc_parser_set_data (dc_parser_t *abstract, const unsigned char *data, unsigned int size);
 static dc_status_t hw_ostc_parser_get_datetime (dc_parser_t *abstract, dc_datetime_t *datetime);
 static dc_status_t hw_ostc_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsigned int flags, void *value);
 static dc_status_t hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata);
+static dc_status_t hw_ostc_parser_samples_batch (dc_parser_t *abstract, dc_sample_table_t *table);
+static dc_status_t hw_ostc_parser_samples_range (dc_parser_t *abstract, unsigned int begin, unsigned int end, dc_sample_callback_t callback, void *userdata);
+static dc_status_t hw_ostc_parser_samples_feed (dc_parser_t *abstract, dc_sample_feed_t *feed);
 
 static const dc_parser_vtable_t hw_ostc_parser_vtable = {
 	sizeof(hw_ostc_parser_t),
 	DC_FAMILY_HW_OSTC,
 	hw_ostc_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	hw_ostc_parser_get_datetime, /* datetime */
 	hw_ostc_parser_get_field, /* fields */
 	hw_ostc_parser_samples_foreach, /* samples_foreach */
+	hw_ostc_parser_samples_batch, /* samples_batch */
+	hw_ostc_parser_samples_range, /* samples_range */
+	hw_ostc_parser_samples_feed, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -193,6 +202,34 @@ hw_ostc_find_gasmix (hw_ostc_parser_t *parser, unsigned int o2, unsigned int he,
 	return i;
 }
 
+static int
+hw_ostc_parser_layout (unsigned int version, const hw_ostc_layout_t **layout, unsigned int *header)
+{
+	switch (version) {
+	case 0x20:
+		*layout = &hw_ostc_layout_ostc;
+		*header = 47;
+		break;
+	case 0x21:
+		*layout = &hw_ostc_layout_ostc;
+		*header = 57;
+		break;
+	case 0x22:
+		*layout = &hw_ostc_layout_frog;
+		*header = 256;
+		break;
+	case 0x23:
+	case 0x24:
+		*layout = &hw_ostc_layout_ostc3;
+		*header = 256;
+		break;
+	default:
+		return 0;
+	}
+
+	return 1;
+}
+
 static dc_status_t
 hw_ostc_parser_cache (hw_ostc_parser_t *parser)
 {
@@ -213,25 +250,7 @@ hw_ostc_parser_cache (hw_ostc_parser_t *parser)
 	unsigned int version = data[parser->hwos ? 8 : 2];
 	const hw_ostc_layout_t *layout = NULL;
 	unsigned int header = 0;
-	switch (version) {
-	case 0x20:
-		layout = &hw_ostc_layout_ostc;
-		header = 47;
-		break;
-	case 0x21:
-		layout = &hw_ostc_layout_ostc;
-		header = 57;
-		break;
-	case 0x22:
-		layout = &hw_ostc_layout_frog;
-		header = 256;
-		break;
-	case 0x23:
-	case 0x24:
-		layout = &hw_ostc_layout_ostc3;
-		header = 256;
-		break;
-	default:
+	if (!hw_ostc_parser_layout (version, &layout, &header)) {
 		ERROR(abstract->context, "Unknown data format version.");
 		return DC_STATUS_DATAFORMAT;
 	}
@@ -342,6 +361,7 @@ hw_ostc_parser_create_internal (dc_parser_t **out, dc_context_t *context, unsign
 		parser->gasmix[i].oxygen = 0;
 		parser->gasmix[i].helium = 0;
 	}
+	dc_sample_index_reset (&parser->index);
 
 	*out = (dc_parser_t *) parser;
 
@@ -380,6 +400,7 @@ hw_ostc_parser_set_data (dc_parser_t *abstract, const unsigned char *data, unsig
 		parser->gasmix[i].oxygen = 0;
 		parser->gasmix[i].helium = 0;
 	}
+	dc_sample_index_reset (&parser->index);
 
 	return DC_STATUS_SUCCESS;
 }
@@ -458,8 +479,8 @@ hw_ostc_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsigned
 	if (rc != DC_STATUS_SUCCESS)
 		return rc;
 
-	// Cache the profile data.
-	if (parser->cached < PROFILE) {
+	// Cache the profile data, unless only the header is requested.
+	if (parser->cached < PROFILE && !abstract->headeronly) {
 		rc = hw_ostc_parser_samples_foreach (abstract, NULL, NULL);
 		if (rc != DC_STATUS_SUCCESS)
 			return rc;
@@ -488,9 +509,13 @@ hw_ostc_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsigned
 			*((double *) value) = array_uint16_le (data + layout->avgdepth) / 100.0;
 			break;
 		case DC_FIELD_GASMIX_COUNT:
+			if (parser->cached < PROFILE)
+				return DC_STATUS_UNSUPPORTED;
 			*((unsigned int *) value) = parser->ngasmixes;
 			break;
 		case DC_FIELD_GASMIX:
+			if (parser->cached < PROFILE)
+				return DC_STATUS_UNSUPPORTED;
 			gasmix->oxygen = parser->gasmix[flags].oxygen / 100.0;
 			gasmix->helium = parser->gasmix[flags].helium / 100.0;
 			gasmix->nitrogen = 1.0 - gasmix->oxygen - gasmix->helium;
@@ -580,7 +605,7 @@ hw_ostc_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsigned
 
 
 static dc_status_t
-hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata)
+hw_ostc_parser_samples (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata, dc_sample_table_t *table, unsigned int begin, unsigned int end, dc_sample_feed_t *feed)
 {
 	hw_ostc_parser_t *parser = (hw_ostc_parser_t *) abstract;
 	const unsigned char *data = abstract->data;
@@ -595,16 +620,24 @@ hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t call
 	unsigned int header = parser->header;
 	const hw_ostc_layout_t *layout = parser->layout;
 
+	// In push mode, the data can be incomplete.
+	unsigned int partial = feed && !feed->final;
+	if (partial && size <= header + 2)
+		return DC_STATUS_SUCCESS;
+
 	// Exit if no profile data available.
 	if (size == header || (size == header + 2 &&
 		data[header] == 0xFD && data[header + 1] == 0xFD)) {
 		parser->cached = PROFILE;
+		parser->index.complete = 1;
 		return DC_STATUS_SUCCESS;
 	}
 
 	// Check the header length.
 	if (version == 0x23 || version == 0x24) {
 		if (size < header + 5) {
+			if (partial)
+				return DC_STATUS_SUCCESS;
 			ERROR (abstract->context, "Buffer overflow detected!");
 			return DC_STATUS_DATAFORMAT;
 		}
@@ -631,6 +664,8 @@ hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t call
 	// Check the header length.
 	if (version == 0x23 || version == 0x24) {
 		if (size < header + 5 + 3 * nconfig) {
+			if (partial)
+				return DC_STATUS_SUCCESS;
 			ERROR (abstract->context, "Buffer overflow detected!");
 			return DC_STATUS_DATAFORMAT;
 		}
@@ -688,19 +723,58 @@ hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t call
 	unsigned int time = 0;
 	unsigned int nsamples = 0;
 	unsigned int tank = parser->initial != UNDEFINED ? parser->initial : 0;
+	unsigned int reset = 0;
 
 	unsigned int offset = header;
 	if (version == 0x23 || version == 0x24)
 		offset += 5 + 3 * nconfig;
+
+	// Resume from the last checkpoint before the start of the range, or
+	// from the first incomplete sample in push mode.
+	const dc_sample_checkpoint_t *checkpoint = NULL;
+	if (feed) {
+		if (feed->resume.offset)
+			checkpoint = &feed->resume;
+	} else {
+		checkpoint = dc_sample_index_find (&parser->index, begin);
+	}
+	if (checkpoint) {
+		time = checkpoint->time;
+		offset = checkpoint->offset;
+		nsamples = checkpoint->state[0];
+		tank = checkpoint->state[1];
+		reset = checkpoint->state[2];
+		for (unsigned int i = 0; i < nconfig; ++i) {
+			if (reset & (1 << i))
+				info[i].divisor = 0;
+		}
+	}
+
 	while (offset + 3 <= size) {
 		dc_sample_value_t sample = {0};
 
+		// Wait for the remainder of an incomplete sample.
+		if (partial && offset + 3 + (data[offset + 2] & 0x7F) > size)
+			break;
+
+		if (parser->index.complete) {
+			// Stop after the end of the range.
+			if (time + samplerate > end)
+				return DC_STATUS_SUCCESS;
+		} else {
+			dc_sample_checkpoint_t cp = {time, offset, {nsamples, tank, reset, 0}};
+			dc_sample_index_add (&parser->index, &cp);
+		}
+
 		nsamples++;
 
 		// Time (seconds).
 		time += samplerate;
 		sample.time = time;
-		if (callback) callback (DC_SAMPLE_TIME, sample, userdata);
+		if (table)
+			dc_sample_table_time (table, time);
+		else if (callback)
+			callback (DC_SAMPLE_TIME, sample, userdata);
 
 		// Initial gas mix.
 		if (time == samplerate && parser->initial != UNDEFINED) {
@@ -723,7 +797,10 @@ hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t call
 		// Depth (1/100 m).
 		unsigned int depth = array_uint16_le (data + offset);
 		sample.depth = depth / 100.0;
-		if (callback) callback (DC_SAMPLE_DEPTH, sample, userdata);
+		if (table)
+			dc_sample_table_depth (table, sample.depth);
+		else if (callback)
+			callback (DC_SAMPLE_DEPTH, sample, userdata);
 		offset += 2;
 
 		// Extended sample info.
@@ -881,6 +958,7 @@ hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t call
 						(firmware >= OSTC3FW(10,57) && firmware <= OSTC3FW(10,63)))) {
 						WARNING (abstract->context, "Reset invalid ppO2 divisor to zero.");
 						info[i].divisor = 0;
+						reset |= 1 << i;
 						continue;
 					}
 					ERROR (abstract->context, "Buffer overflow detected!");
@@ -894,7 +972,10 @@ hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t call
 				case TEMPERATURE:
 					value = array_uint16_le (data + offset);
 					sample.temperature = value / 10.0;
-					if (callback) callback (DC_SAMPLE_TEMPERATURE, sample, userdata);
+					if (table)
+						dc_sample_table_temperature (table, sample.temperature);
+					else if (callback)
+						callback (DC_SAMPLE_TEMPERATURE, sample, userdata);
 					break;
 				case DECO:
 					// Due to a firmware bug, the deco/ndl info is incorrect for
@@ -946,7 +1027,10 @@ hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t call
 							(firmware >= OSTC3FW(10,40) && firmware <= OSTC3FW(10,50))) {
 							sample.pressure.value /= 10.0;
 						}
-						if (callback) callback (DC_SAMPLE_PRESSURE, sample, userdata);
+						if (table)
+							dc_sample_table_pressure (table, sample.pressure.tank, sample.pressure.value);
+						else if (callback)
+							callback (DC_SAMPLE_PRESSURE, sample, userdata);
 					}
 					break;
 				default: // Not yet used.
@@ -1005,12 +1089,63 @@ hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t call
 		offset += length;
 	}
 
+	if (partial) {
+		feed->resume.time = time;
+		feed->resume.offset = offset;
+		feed->resume.state[0] = nsamples;
+		feed->resume.state[1] = tank;
+		feed->resume.state[2] = reset;
+		return DC_STATUS_SUCCESS;
+	}
+
 	if (offset + 2 > size || data[offset] != 0xFD || data[offset + 1] != 0xFD) {
 		ERROR (abstract->context, "Invalid end marker found!");
 		return DC_STATUS_DATAFORMAT;
 	}
 
 	parser->cached = PROFILE;
+	parser->index.complete = 1;
 
 	return DC_STATUS_SUCCESS;
 }
+
+static dc_status_t
+hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata)
+{
+	return hw_ostc_parser_samples (abstract, callback, userdata, NULL, 0, UINT_MAX, NULL);
+}
+
+static dc_status_t
+hw_ostc_parser_samples_batch (dc_parser_t *abstract, dc_sample_table_t *table)
+{
+	return hw_ostc_parser_samples (abstract, dc_sample_table_cb, table, table, 0, UINT_MAX, NULL);
+}
+
+static dc_status_t
+hw_ostc_parser_samples_range (dc_parser_t *abstract, unsigned int begin, unsigned int end, dc_sample_callback_t callback, void *userdata)
+{
+	return hw_ostc_parser_samples (abstract, callback, userdata, NULL, begin, end, NULL);
+}
+
+static dc_status_t
+hw_ostc_parser_samples_feed (dc_parser_t *abstract, dc_sample_feed_t *feed)
+{
+	hw_ostc_parser_t *parser = (hw_ostc_parser_t *) abstract;
+	const unsigned char *data = abstract->data;
+	unsigned int size = abstract->size;
+
+	// Wait until the header is complete.
+	if (!feed->final && !parser->cached) {
+		if (size < 9)
+			return DC_STATUS_SUCCESS;
+
+		// An unknown version is reported by the sample parser.
+		const hw_ostc_layout_t *layout = NULL;
+		unsigned int header = 0;
+		unsigned int version = data[parser->hwos ? 8 : 2];
+		if (hw_ostc_parser_layout (version, &layout, &header) && size < header)
+			return DC_STATUS_SUCCESS;
+	}
+
+	return hw_ostc_parser_samples (abstract, feed->callback, feed->userdata, NULL, 0, UINT_MAX, feed);
+}
@@ -57,10 +57,16 @@ struct dc_iostream_vtable_t {
 
 	dc_status_t (*poll) (dc_iostream_t *iostream, int timeout);
 
+	dc_status_t (*get_fd) (dc_iostream_t *iostream, int *fd);
+
 	dc_status_t (*read) (dc_iostream_t *iostream, void *data, size_t size, size_t *actual);
 
 	dc_status_t (*write) (dc_iostream_t *iostream, const void *data, size_t size, size_t *actual);
 
+	dc_status_t (*read_nonblock) (dc_iostream_t *iostream, void *data, size_t size, size_t *actual);
+
+	dc_status_t (*write_nonblock) (dc_iostream_t *iostream, const void *data, size_t size, size_t *actual);
+
 	dc_status_t (*ioctl) (dc_iostream_t *iostream, unsigned int request, void *data, size_t size);
 
 	dc_status_t (*flush) (dc_iostream_t *iostream);
@@ -185,6 +185,18 @@ dc_iostream_poll (dc_iostream_t *iostream, int timeout)
 	return iostream->vtable->poll (iostream, timeout);
 }
 
+dc_status_t
+dc_iostream_get_fd (dc_iostream_t *iostream, int *fd)
+{
+	if (iostream == NULL || iostream->vtable->get_fd == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (fd == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	return iostream->vtable->get_fd (iostream, fd);
+}
+
 dc_status_t
 dc_iostream_read (dc_iostream_t *iostream, void *data, size_t size, size_t *actual)
 {
@@ -227,6 +239,52 @@ out:
 	return status;
 }
 
+dc_status_t
+dc_iostream_read_nonblock (dc_iostream_t *iostream, void *data, size_t size, size_t *actual)
+{
+	dc_status_t status = DC_STATUS_UNSUPPORTED;
+	size_t nbytes = 0;
+
+	if (iostream == NULL || iostream->vtable->read_nonblock == NULL) {
+		goto out;
+	}
+
+	status = iostream->vtable->read_nonblock (iostream, data, size, &nbytes);
+
+	if (nbytes) {
+		HEXDUMP (iostream->context, DC_LOGLEVEL_INFO, "Read", (unsigned char *) data, nbytes);
+	}
+
+out:
+	if (actual)
+		*actual = nbytes;
+
+	return status;
+}
+
+dc_status_t
+dc_iostream_write_nonblock (dc_iostream_t *iostream, const void *data, size_t size, size_t *actual)
+{
+	dc_status_t status = DC_STATUS_UNSUPPORTED;
+	size_t nbytes = 0;
+
+	if (iostream == NULL || iostream->vtable->write_nonblock == NULL) {
+		goto out;
+	}
+
+	status = iostream->vtable->write_nonblock (iostream, data, size, &nbytes);
+
+	if (nbytes) {
+		HEXDUMP (iostream->context, DC_LOGLEVEL_INFO, "Write", (const unsigned char *) data, nbytes);
+	}
+
+out:
+	if (actual)
+		*actual = nbytes;
+
+	return status;
+}
+
 dc_status_t
 dc_iostream_ioctl (dc_iostream_t *iostream, unsigned int request, void *data, size_t size)
 {
@@ -98,8 +98,11 @@ static const dc_iostream_vtable_t dc_irda_vtable = {
 	dc_socket_get_available, /* get_available */
 	NULL, /* configure */
 	dc_socket_poll, /* poll */
+	dc_socket_get_fd, /* get_fd */
 	dc_socket_read, /* read */
 	dc_socket_write, /* write */
+	dc_socket_read_nonblock, /* read_nonblock */
+	dc_socket_write_nonblock, /* write_nonblock */
 	dc_socket_ioctl, /* ioctl */
 	NULL, /* flush */
 	NULL, /* purge */
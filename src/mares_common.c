@@ -54,7 +54,7 @@ mares_common_device_init (mares_common_device_t *device, dc_iostream_t *iostream
 	// Set the default values.
 	device->iostream = iostream;
 	device->echo = 0;
-	device->delay = 0;
+	dc_pacing_init (&device->base.pacing, 0, 0, MAXDELAY);
 }
 
 
@@ -87,8 +87,9 @@ mares_common_packet (mares_common_device_t *device, const unsigned char command[
 	if (device_is_cancelled (abstract))
 		return DC_STATUS_CANCELLED;
 
-	if (device->delay) {
-		dc_iostream_sleep (device->iostream, device->delay);
+	unsigned int delay = dc_pacing_delay (&abstract->pacing);
+	if (delay) {
+		dc_iostream_sleep (device->iostream, delay);
 	}
 
 	// Send the command to the device.
@@ -142,6 +143,8 @@ mares_common_packet (mares_common_device_t *device, const unsigned char command[
 static dc_status_t
 mares_common_transfer (mares_common_device_t *device, const unsigned char command[], unsigned int csize, unsigned char answer[], unsigned int asize)
 {
+	dc_device_t *abstract = (dc_device_t *) device;
+
 	unsigned int nretries = 0;
 	dc_status_t rc = DC_STATUS_SUCCESS;
 	while ((rc = mares_common_packet (device, command, csize, answer, asize)) != DC_STATUS_SUCCESS) {
@@ -150,6 +153,9 @@ mares_common_transfer (mares_common_device_t *device, const unsigned char comman
 		if (rc != DC_STATUS_PROTOCOL && rc != DC_STATUS_TIMEOUT)
 			return rc;
 
+		// Slow down the next packets.
+		dc_pacing_failure (&abstract->pacing);
+
 		// Abort if the maximum number of retries is reached.
 		if (nretries++ >= MAXRETRIES)
 			return rc;
@@ -159,6 +165,8 @@ mares_common_transfer (mares_common_device_t *device, const unsigned char comman
 		dc_iostream_purge (device->iostream, DC_DIRECTION_INPUT);
 	}
 
+	dc_pacing_success (&abstract->pacing);
+
 	return rc;
 }
 
@@ -157,7 +157,7 @@ mares_darwin_device_open (dc_device_t **out, dc_context_t *context, dc_iostream_
 
 	// Override the base class values.
 	device->base.echo = 1;
-	device->base.delay = 50;
+	dc_pacing_init (&device->base.base.pacing, 50, 50, MAXDELAY);
 
 	*out = (dc_device_t *) device;
 
@@ -150,9 +150,13 @@ static const dc_parser_vtable_t mares_iconhd_parser_vtable = {
 	sizeof(mares_iconhd_parser_t),
 	DC_FAMILY_MARES_ICONHD,
 	mares_iconhd_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	mares_iconhd_parser_get_datetime, /* datetime */
 	mares_iconhd_parser_get_field, /* fields */
 	mares_iconhd_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -637,6 +641,9 @@ mares_iconhd_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsi
 			} else if (parser->model == SMARTAPNEA) {
 				*((unsigned int *) value) = array_uint16_le (p + 0x24);
 			} else if (parser->mode == ICONHD_FREEDIVE) {
+				// The total time is the sum of all the dives in the session.
+				if (abstract->headeronly)
+					return DC_STATUS_UNSUPPORTED;
 				unsigned int divetime = 0;
 				unsigned int offset = 4;
 				for (unsigned int i = 0; i < parser->nsamples; ++i) {
@@ -28,6 +28,7 @@
 #include "device-private.h"
 #include "checksum.h"
 #include "array.h"
+#include "buffered.h"
 
 #define ISINSTANCE(device) dc_device_isinstance((device), &mares_nemo_device_vtable)
 
@@ -51,6 +52,7 @@ typedef struct mares_nemo_device_t {
 static dc_status_t mares_nemo_device_set_fingerprint (dc_device_t *abstract, const unsigned char data[], unsigned int size);
 static dc_status_t mares_nemo_device_dump (dc_device_t *abstract, dc_buffer_t *buffer);
 static dc_status_t mares_nemo_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata);
+static dc_status_t mares_nemo_device_close (dc_device_t *abstract);
 
 static const dc_device_vtable_t mares_nemo_device_vtable = {
 	sizeof(mares_nemo_device_t),
@@ -61,7 +63,7 @@ static const dc_device_vtable_t mares_nemo_device_vtable = {
 	mares_nemo_device_dump, /* dump */
 	mares_nemo_device_foreach, /* foreach */
 	NULL, /* timesync */
-	NULL /* close */
+	mares_nemo_device_close /* close */
 };
 
 static const mares_common_layout_t mares_nemo_layout = {
@@ -98,35 +100,42 @@ mares_nemo_device_open (dc_device_t **out, dc_context_t *context, dc_iostream_t
 	}
 
 	// Set the default values.
-	device->iostream = iostream;
 	memset (device->fingerprint, 0, sizeof (device->fingerprint));
 
+	// Read ahead, because the start of the data is searched for one
+	// byte at a time, while the device is already sending.
+	status = dc_buffered_open (&device->iostream, context, iostream, 1024);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (context, "Failed to create the buffered stream.");
+		goto error_free;
+	}
+
 	// Set the serial communication protocol (9600 8N1).
 	status = dc_iostream_configure (device->iostream, 9600, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the terminal attributes.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Set the timeout for receiving data (1000 ms).
 	status = dc_iostream_set_timeout (device->iostream, 1000);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the timeout.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Set the DTR line.
 	status = dc_iostream_set_dtr (device->iostream, 1);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the DTR line.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Set the RTS line.
 	status = dc_iostream_set_rts (device->iostream, 1);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the RTS line.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Make sure everything is in a sane state.
@@ -136,12 +145,23 @@ mares_nemo_device_open (dc_device_t **out, dc_context_t *context, dc_iostream_t
 
 	return DC_STATUS_SUCCESS;
 
+error_close:
+	dc_iostream_close (device->iostream);
 error_free:
 	dc_device_deallocate ((dc_device_t *) device);
 	return status;
 }
 
 
+static dc_status_t
+mares_nemo_device_close (dc_device_t *abstract)
+{
+	mares_nemo_device_t *device = (mares_nemo_device_t *) abstract;
+
+	return dc_iostream_close (device->iostream);
+}
+
+
 static dc_status_t
 mares_nemo_device_set_fingerprint (dc_device_t *abstract, const unsigned char data[], unsigned int size)
 {
@@ -68,9 +68,13 @@ static const dc_parser_vtable_t mares_nemo_parser_vtable = {
 	sizeof(mares_nemo_parser_t),
 	DC_FAMILY_MARES_NEMO,
 	mares_nemo_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	mares_nemo_parser_get_datetime, /* datetime */
 	mares_nemo_parser_get_field, /* fields */
 	mares_nemo_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -312,6 +316,8 @@ mares_nemo_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsign
 			unsigned int divetime = 0;
 			switch (type) {
 			case DC_FIELD_DIVETIME:
+				if (abstract->headeronly)
+					return DC_STATUS_UNSUPPORTED;
 				for (unsigned int i = 0; i < parser->sample_count; ++i) {
 					unsigned int idx = 2 + parser->sample_size * i;
 					divetime += data[idx + 2] + data[idx + 3] * 60;
@@ -65,9 +65,13 @@ static const dc_parser_vtable_t mclean_extreme_parser_vtable = {
 	sizeof(mclean_extreme_parser_t),
 	DC_FAMILY_MCLEAN_EXTREME,
 	mclean_extreme_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	mclean_extreme_parser_get_datetime, /* datetime */
 	mclean_extreme_parser_get_field, /* fields */
 	mclean_extreme_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -143,7 +147,7 @@ mclean_extreme_parser_get_field(dc_parser_t *abstract, dc_field_type_t type, uns
 		return DC_STATUS_DATAFORMAT;
 	}
 
-	if (!parser->cached) {
+	if (!parser->cached && !abstract->headeronly) {
 		dc_status_t rc = mclean_extreme_parser_samples_foreach (abstract, NULL, NULL);
 		if (rc != DC_STATUS_SUCCESS)
 			return rc;
@@ -213,9 +217,13 @@ mclean_extreme_parser_get_field(dc_parser_t *abstract, dc_field_type_t type, uns
 			}
 			break;
 		case DC_FIELD_GASMIX_COUNT:
+			if (!parser->cached)
+				return DC_STATUS_UNSUPPORTED;
 			*((unsigned int *)value) = parser->ngasmixes;
 			break;
 		case DC_FIELD_GASMIX:
+			if (!parser->cached)
+				return DC_STATUS_UNSUPPORTED;
 			gasmix->helium = 0.01 * abstract->data[0x0001 + 1 + 2 * parser->gasmix[flags]];
 			gasmix->oxygen = 0.01 * abstract->data[0x0001 + 0 + 2 * parser->gasmix[flags]];
 			gasmix->nitrogen = 1.0 - gasmix->oxygen - gasmix->helium;
@@ -44,6 +44,8 @@
 #define MAXPACKET  256
 #define MAXRETRIES 2
 #define MAXDELAY   16
+#define PIPELINE   4
+#define NCACHE     (2 * PIPELINE)
 #define INVALID    0xFFFFFFFF
 
 #define CMD_INIT      0xA8
@@ -60,16 +62,22 @@
 #define ACK 0x5A
 #define NAK 0xA5
 
+typedef struct oceanic_atom2_page_t {
+	unsigned int number;
+	unsigned int highmem;
+	unsigned char data[MAXPACKET];
+} oceanic_atom2_page_t;
+
 typedef struct oceanic_atom2_device_t {
 	oceanic_common_device_t base;
 	dc_iostream_t *iostream;
 	unsigned int sequence;
-	unsigned int delay;
 	unsigned int extra;
 	unsigned int bigpage;
-	unsigned char cache[256];
-	unsigned int cached_page;
-	unsigned int cached_highmem;
+	unsigned int pipeline;
+	unsigned int maxpipeline;
+	oceanic_atom2_page_t cache[NCACHE];
+	unsigned int cache_next;
 } oceanic_atom2_device_t;
 
 static dc_status_t oceanic_atom2_device_read (dc_device_t *abstract, unsigned int address, unsigned char data[], unsigned int size);
@@ -541,6 +549,44 @@ static const oceanic_common_layout_t aqualung_i450t_layout = {
 	0, /* pt_mode_serial */
 };
 
+static void
+oceanic_atom2_cache_invalidate (oceanic_atom2_device_t *device)
+{
+	for (unsigned int i = 0; i < NCACHE; ++i) {
+		device->cache[i].number = INVALID;
+		device->cache[i].highmem = INVALID;
+	}
+	device->cache_next = 0;
+}
+
+static oceanic_atom2_page_t *
+oceanic_atom2_cache_lookup (oceanic_atom2_device_t *device, unsigned int number, unsigned int highmem)
+{
+	for (unsigned int i = 0; i < NCACHE; ++i) {
+		if (device->cache[i].number == number &&
+			device->cache[i].highmem == highmem)
+			return device->cache + i;
+	}
+
+	return NULL;
+}
+
+static oceanic_atom2_page_t *
+oceanic_atom2_cache_insert (oceanic_atom2_device_t *device, unsigned int number, unsigned int highmem)
+{
+	// Replace the entries in a round-robin fashion. Because the cache is
+	// twice as large as the pipeline, the pages of the previous request
+	// survive the next one. That's what makes the partially used page at
+	// the edge of each block a cache hit.
+	oceanic_atom2_page_t *page = device->cache + device->cache_next;
+	device->cache_next = (device->cache_next + 1) % NCACHE;
+
+	page->number = number;
+	page->highmem = highmem;
+
+	return page;
+}
+
 /*
  * The BLE GATT packet size is up to 20 bytes and the format is:
  *
@@ -670,39 +716,12 @@ oceanic_atom2_ble_read (oceanic_atom2_device_t *device, unsigned char data[], un
 }
 
 static dc_status_t
-oceanic_atom2_packet (oceanic_atom2_device_t *device, const unsigned char command[], unsigned int csize, unsigned char ack, unsigned char answer[], unsigned int asize, unsigned int crc_size)
+oceanic_atom2_receive (oceanic_atom2_device_t *device, unsigned char ack, unsigned char answer[], unsigned int asize, unsigned int crc_size)
 {
 	dc_status_t status = DC_STATUS_SUCCESS;
 	dc_device_t *abstract = (dc_device_t *) device;
 	dc_transport_t transport = dc_iostream_get_transport (device->iostream);
 
-	if (asize > MAXPACKET) {
-		return DC_STATUS_INVALIDARGS;
-	}
-
-	if (crc_size > 2 || (crc_size != 0 && asize == 0)) {
-		return DC_STATUS_INVALIDARGS;
-	}
-
-	if (device_is_cancelled (abstract))
-		return DC_STATUS_CANCELLED;
-
-	if (device->delay) {
-		dc_iostream_sleep (device->iostream, device->delay);
-	}
-
-	// Send the command to the dive computer.
-	if (transport == DC_TRANSPORT_BLE) {
-		status = oceanic_atom2_ble_write (device, command, csize);
-	} else {
-		status = dc_iostream_write (device->iostream, command, csize, NULL);
-	}
-	if (status != DC_STATUS_SUCCESS) {
-		ERROR (abstract->context, "Failed to send the command.");
-		return status;
-	}
-
-	// Receive the answer of the dive computer.
 	unsigned char packet[1 + MAXPACKET + 2];
 	unsigned int nbytes = 1 + asize + crc_size;
 	if (transport == DC_TRANSPORT_BLE) {
@@ -755,6 +774,48 @@ oceanic_atom2_packet (oceanic_atom2_device_t *device, const unsigned char comman
 		WARNING (abstract->context, "Ignored %u excess byte(s).", nbytes - asize);
 	}
 
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+oceanic_atom2_packet (oceanic_atom2_device_t *device, const unsigned char command[], unsigned int csize, unsigned char ack, unsigned char answer[], unsigned int asize, unsigned int crc_size)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_device_t *abstract = (dc_device_t *) device;
+	dc_transport_t transport = dc_iostream_get_transport (device->iostream);
+
+	if (asize > MAXPACKET) {
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	if (crc_size > 2 || (crc_size != 0 && asize == 0)) {
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	if (device_is_cancelled (abstract))
+		return DC_STATUS_CANCELLED;
+
+	unsigned int delay = dc_pacing_delay (&abstract->pacing);
+	if (delay) {
+		dc_iostream_sleep (device->iostream, delay);
+	}
+
+	// Send the command to the dive computer.
+	if (transport == DC_TRANSPORT_BLE) {
+		status = oceanic_atom2_ble_write (device, command, csize);
+	} else {
+		status = dc_iostream_write (device->iostream, command, csize, NULL);
+	}
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (abstract->context, "Failed to send the command.");
+		return status;
+	}
+
+	// Receive the answer of the dive computer.
+	status = oceanic_atom2_receive (device, ack, answer, asize, crc_size);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
 	device->sequence++;
 
 	return DC_STATUS_SUCCESS;
@@ -770,25 +831,29 @@ oceanic_atom2_transfer (oceanic_atom2_device_t *device, const unsigned char comm
 	// a NAK byte, we try to resend the command a number of times before
 	// returning an error.
 
+	dc_device_t *abstract = (dc_device_t *) device;
+
 	unsigned int nretries = 0;
 	dc_status_t rc = DC_STATUS_SUCCESS;
 	while ((rc = oceanic_atom2_packet (device, command, csize, ack, answer, asize, crc_size)) != DC_STATUS_SUCCESS) {
 		if (rc != DC_STATUS_TIMEOUT && rc != DC_STATUS_PROTOCOL)
 			return rc;
 
+		// Increase the inter packet delay.
+		dc_pacing_failure (&abstract->pacing);
+
 		// Abort if the maximum number of retries is reached.
 		if (nretries++ >= MAXRETRIES)
 			return rc;
 
-		// Increase the inter packet delay.
-		if (device->delay < MAXDELAY)
-			device->delay++;
-
 		// Delay the next attempt.
 		dc_iostream_sleep (device->iostream, 100);
 		dc_iostream_purge (device->iostream, DC_DIRECTION_INPUT);
 	}
 
+	// Probe for a shorter inter packet delay.
+	dc_pacing_success (&abstract->pacing);
+
 	return DC_STATUS_SUCCESS;
 }
 
@@ -873,13 +938,13 @@ oceanic_atom2_device_open (dc_device_t **out, dc_context_t *context, dc_iostream
 
 	// Set the default values.
 	device->iostream = iostream;
-	device->delay = 0;
+	dc_pacing_init (&device->base.base.pacing, 0, 0, MAXDELAY);
 	device->extra = model == PROPLUSX || model == I770R;
 	device->sequence = 0;
 	device->bigpage = 1; // no big pages
-	device->cached_page = INVALID;
-	device->cached_highmem = INVALID;
-	memset(device->cache, 0, sizeof(device->cache));
+	device->pipeline = 1;
+	device->maxpipeline = 1;
+	oceanic_atom2_cache_invalidate (device);
 
 	// Get the correct baudrate.
 	unsigned int baudrate = 38400;
@@ -1026,6 +1091,15 @@ oceanic_atom2_device_open (dc_device_t **out, dc_context_t *context, dc_iostream
 		}
 	}
 
+	// Keeping several read commands in flight is limited to a few models,
+	// and to the serial cable for now. The other transports have their own
+	// packet framing (e.g. one USB HID report or BLE packet per command).
+	// The application has to enable it explicitly.
+	if (dc_iostream_get_transport (device->iostream) == DC_TRANSPORT_SERIAL &&
+		(model == VTX || model == I750TC)) {
+		device->maxpipeline = PIPELINE;
+	}
+
 	*out = (dc_device_t*) device;
 
 	return DC_STATUS_SUCCESS;
@@ -1092,6 +1166,90 @@ oceanic_atom2_device_version (dc_device_t *abstract, unsigned char data[], unsig
 }
 
 
+dc_status_t
+oceanic_atom2_device_set_pipeline (dc_device_t *abstract, unsigned int value)
+{
+	oceanic_atom2_device_t *device = (oceanic_atom2_device_t*) abstract;
+
+	if (!ISINSTANCE (abstract))
+		return DC_STATUS_INVALIDARGS;
+
+	if (value && device->maxpipeline == 1)
+		return DC_STATUS_UNSUPPORTED;
+
+	// Read large enough blocks to fill the pipeline.
+	device->pipeline = value ? device->maxpipeline : 1;
+	device->base.multipage = device->bigpage * device->pipeline;
+
+	return DC_STATUS_SUCCESS;
+}
+
+
+static dc_status_t
+oceanic_atom2_pipeline (oceanic_atom2_device_t *device, unsigned char read_cmd, unsigned int first, unsigned int count, unsigned int highmem, unsigned int pagesize, unsigned int crc_size)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_device_t *abstract = (dc_device_t *) device;
+
+	// Devices that needed an inter packet delay are not fast enough to
+	// accept several commands back-to-back.
+	if (dc_pacing_delay (&abstract->pacing))
+		return DC_STATUS_SUCCESS;
+
+	if (device_is_cancelled (abstract))
+		return DC_STATUS_CANCELLED;
+
+	// Send all read commands at once.
+	unsigned char commands[PIPELINE * 3];
+	for (unsigned int i = 0; i < count; ++i) {
+		unsigned int page = first + i;
+		unsigned int number = highmem ? page : page * device->bigpage;
+		commands[i * 3 + 0] = read_cmd;
+		commands[i * 3 + 1] = (number >> 8) & 0xFF;
+		commands[i * 3 + 2] = (number     ) & 0xFF;
+	}
+
+	status = dc_iostream_write (device->iostream, commands, count * 3, NULL);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (abstract->context, "Failed to send the commands.");
+		return status;
+	}
+
+	// Receive the answers in the same order.
+	unsigned int n = 0;
+	while (n < count) {
+		unsigned char answer[MAXPACKET];
+		status = oceanic_atom2_receive (device, ACK, answer, pagesize, crc_size);
+		if (status != DC_STATUS_SUCCESS)
+			break;
+
+		oceanic_atom2_page_t *cached = oceanic_atom2_cache_insert (device, first + n, highmem);
+		memcpy (cached->data, answer, pagesize);
+
+		dc_pacing_success (&abstract->pacing);
+
+		device->sequence++;
+		n++;
+	}
+
+	if (status != DC_STATUS_SUCCESS) {
+		if (status != DC_STATUS_TIMEOUT && status != DC_STATUS_PROTOCOL)
+			return status;
+
+		// The firmware did not keep up with the pipelined commands. Drop
+		// any remaining answers, and continue with a single command at a
+		// time. The pages that were received correctly remain cached.
+		WARNING (abstract->context, "Pipelined read failed after %u of %u pages. Falling back to single page reads.", n, count);
+		device->pipeline = 1;
+		device->base.multipage = device->bigpage;
+		dc_iostream_sleep (device->iostream, 100);
+		dc_iostream_purge (device->iostream, DC_DIRECTION_INPUT);
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+
 static dc_status_t
 oceanic_atom2_device_read (dc_device_t *abstract, unsigned int address, unsigned char data[], unsigned int size)
 {
@@ -1142,20 +1300,42 @@ oceanic_atom2_device_read (dc_device_t *abstract, unsigned int address, unsigned
 		// addresses back to their physical address.
 		unsigned int page = (address - highmem) / pagesize;
 
-		if (page != device->cached_page || highmem != device->cached_highmem) {
+		oceanic_atom2_page_t *cached = oceanic_atom2_cache_lookup (device, page, highmem);
+		if (cached == NULL) {
+			// Request all the missing pages of this read at once, up to
+			// the depth of the pipeline. A read never crosses into the high
+			// memory area, because that requires a different command.
+			unsigned int last = address + (size - nbytes) - 1;
+			if (layout->highmem && !highmem && last >= layout->highmem)
+				last = layout->highmem - 1;
+			unsigned int count = (last - highmem) / pagesize - page + 1;
+			if (count > device->pipeline)
+				count = device->pipeline;
+
+			if (count > 1) {
+				dc_status_t rc = oceanic_atom2_pipeline (device, read_cmd, page, count, highmem, pagesize, crc_size);
+				if (rc != DC_STATUS_SUCCESS)
+					return rc;
+
+				cached = oceanic_atom2_cache_lookup (device, page, highmem);
+			}
+		}
+
+		if (cached == NULL) {
 			// Read the package.
 			unsigned int number = highmem ? page : page * device->bigpage; // This is always PAGESIZE, even in big page mode.
 			unsigned char command[] = {read_cmd,
 					(number >> 8) & 0xFF, // high
 					(number     ) & 0xFF, // low
 				};
-			dc_status_t rc = oceanic_atom2_transfer (device, command, sizeof (command), ACK, device->cache, pagesize, crc_size);
+			unsigned char answer[MAXPACKET];
+			dc_status_t rc = oceanic_atom2_transfer (device, command, sizeof (command), ACK, answer, pagesize, crc_size);
 			if (rc != DC_STATUS_SUCCESS)
 				return rc;
 
 			// Cache the page.
-			device->cached_page = page;
-			device->cached_highmem = highmem;
+			cached = oceanic_atom2_cache_insert (device, page, highmem);
+			memcpy (cached->data, answer, pagesize);
 		}
 
 		unsigned int offset = address % pagesize;
@@ -1163,7 +1343,7 @@ oceanic_atom2_device_read (dc_device_t *abstract, unsigned int address, unsigned
 		if (nbytes + length > size)
 			length = size - nbytes;
 
-		memcpy (data, device->cache + offset, length);
+		memcpy (data, cached->data + offset, length);
 
 		nbytes += length;
 		address += length;
@@ -1184,8 +1364,7 @@ oceanic_atom2_device_write (dc_device_t *abstract, unsigned int address, const u
 		return DC_STATUS_INVALIDARGS;
 
 	// Invalidate the cache.
-	device->cached_page = INVALID;
-	device->cached_highmem = INVALID;
+	oceanic_atom2_cache_invalidate (device);
 
 	unsigned int nbytes = 0;
 	while (nbytes < size) {
@@ -134,9 +134,13 @@ static const dc_parser_vtable_t oceanic_atom2_parser_vtable = {
 	sizeof(oceanic_atom2_parser_t),
 	DC_FAMILY_OCEANIC_ATOM2,
 	oceanic_atom2_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	oceanic_atom2_parser_get_datetime, /* datetime */
 	oceanic_atom2_parser_get_field, /* fields */
 	oceanic_atom2_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -528,8 +532,8 @@ oceanic_atom2_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, uns
 	if (status != DC_STATUS_SUCCESS)
 		return status;
 
-	// Cache the profile data.
-	if (parser->cached < PROFILE) {
+	// Cache the profile data, unless only the header is requested.
+	if (parser->cached < PROFILE && !abstract->headeronly) {
 		sample_statistics_t statistics = SAMPLE_STATISTICS_INITIALIZER;
 		status = oceanic_atom2_parser_samples_foreach (
 			abstract, sample_statistics_cb, &statistics);
@@ -551,6 +555,8 @@ oceanic_atom2_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, uns
 				parser->model == F11A || parser->model == F11B ||
 				parser->model == MUNDIAL2 || parser->model == MUNDIAL3)
 				*((unsigned int *) value) = bcd2dec (data[2]) + bcd2dec (data[3]) * 60;
+			else if (parser->cached < PROFILE)
+				return DC_STATUS_UNSUPPORTED;
 			else
 				*((unsigned int *) value) = parser->divetime;
 			break;
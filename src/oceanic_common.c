@@ -40,6 +40,8 @@
 
 #define INVALID 0
 
+#define READAHEAD 4
+
 static unsigned int
 get_profile_first (const unsigned char data[], const oceanic_common_layout_t *layout, unsigned int pagesize)
 {
@@ -439,6 +441,9 @@ oceanic_common_device_profile (dc_device_t *abstract, dc_event_progress_t *progr
 		return rc;
 	}
 
+	// The profile of a single dive often spans several packets.
+	dc_rbstream_set_readahead (rbstream, READAHEAD);
+
 	// Memory buffer for the profile data.
 	unsigned char *profiles = (unsigned char *) malloc (rb_profile_size + rb_logbook_size);
 	if (profiles == NULL) {
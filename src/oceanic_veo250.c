@@ -28,6 +28,7 @@
 #include "device-private.h"
 #include "ringbuffer.h"
 #include "checksum.h"
+#include "buffered.h"
 
 #define ISINSTANCE(device) dc_device_isinstance((device), &oceanic_veo250_device_vtable.base)
 
@@ -248,28 +249,35 @@ oceanic_veo250_device_open (dc_device_t **out, dc_context_t *context, dc_iostrea
 	device->base.multipage = MULTIPAGE;
 
 	// Set the default values.
-	device->iostream = iostream;
 	device->last = 0;
 
+	// Read ahead, because the answer follows the single byte ACK
+	// immediately, and is picked up along with it.
+	status = dc_buffered_open (&device->iostream, context, iostream, 1024);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (context, "Failed to create the buffered stream.");
+		goto error_free;
+	}
+
 	// Set the serial communication protocol (9600 8N1).
 	status = dc_iostream_configure (device->iostream, 9600, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the terminal attributes.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Set the timeout for receiving data (3000 ms).
 	status = dc_iostream_set_timeout (device->iostream, 3000);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the timeout.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Set the DTR line.
 	status = dc_iostream_set_dtr (device->iostream, 1);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the DTR line.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Clear the RTS line to reset the PIC inside the data cable as it
@@ -280,7 +288,7 @@ oceanic_veo250_device_open (dc_device_t **out, dc_context_t *context, dc_iostrea
 	status = dc_iostream_set_rts (device->iostream, 0);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to clear the RTS line.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Hold RTS clear for a bit to allow PIC to reset.
@@ -290,7 +298,7 @@ oceanic_veo250_device_open (dc_device_t **out, dc_context_t *context, dc_iostrea
 	status = dc_iostream_set_rts (device->iostream, 1);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the RTS line.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Give the interface 100 ms to settle and draw power up.
@@ -302,7 +310,7 @@ oceanic_veo250_device_open (dc_device_t **out, dc_context_t *context, dc_iostrea
 	// Initialize the data cable (PPS mode).
 	status = oceanic_veo250_init (device);
 	if (status != DC_STATUS_SUCCESS) {
-		goto error_free;
+		goto error_close;
 	}
 
 	// Delay the sending of the version command.
@@ -313,7 +321,7 @@ oceanic_veo250_device_open (dc_device_t **out, dc_context_t *context, dc_iostrea
 	// the user), or already in download mode.
 	status = oceanic_veo250_device_version ((dc_device_t *) device, device->base.version, sizeof (device->base.version));
 	if (status != DC_STATUS_SUCCESS) {
-		goto error_free;
+		goto error_close;
 	}
 
 	// Override the base class values.
@@ -328,6 +336,8 @@ oceanic_veo250_device_open (dc_device_t **out, dc_context_t *context, dc_iostrea
 
 	return DC_STATUS_SUCCESS;
 
+error_close:
+	dc_iostream_close (device->iostream);
 error_free:
 	dc_device_deallocate ((dc_device_t *) device);
 	return status;
@@ -347,6 +357,12 @@ oceanic_veo250_device_close (dc_device_t *abstract)
 		dc_status_set_error(&status, rc);
 	}
 
+	// Close the buffered stream.
+	rc = dc_iostream_close (device->iostream);
+	if (rc != DC_STATUS_SUCCESS) {
+		dc_status_set_error(&status, rc);
+	}
+
 	return status;
 }
 
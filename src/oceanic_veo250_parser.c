@@ -57,9 +57,13 @@ static const dc_parser_vtable_t oceanic_veo250_parser_vtable = {
 	sizeof(oceanic_veo250_parser_t),
 	DC_FAMILY_OCEANIC_VEO250,
 	oceanic_veo250_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	oceanic_veo250_parser_get_datetime, /* datetime */
 	oceanic_veo250_parser_get_field, /* fields */
 	oceanic_veo250_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -145,7 +149,7 @@ oceanic_veo250_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, un
 	if (size < 7 * PAGESIZE / 2)
 		return DC_STATUS_DATAFORMAT;
 
-	if (!parser->cached) {
+	if (!parser->cached && !abstract->headeronly) {
 		sample_statistics_t statistics = SAMPLE_STATISTICS_INITIALIZER;
 		dc_status_t rc = oceanic_veo250_parser_samples_foreach (
 			abstract, sample_statistics_cb, &statistics);
@@ -167,6 +171,8 @@ oceanic_veo250_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, un
 			*((unsigned int *) value) = data[footer + 3] * 60 + data[footer + 4] * 3600;
 			break;
 		case DC_FIELD_MAXDEPTH:
+			if (!parser->cached)
+				return DC_STATUS_UNSUPPORTED;
 			*((double *) value) = parser->maxdepth;
 			break;
 		case DC_FIELD_GASMIX_COUNT:
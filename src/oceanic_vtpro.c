@@ -30,6 +30,7 @@
 #include "ringbuffer.h"
 #include "checksum.h"
 #include "array.h"
+#include "buffered.h"
 
 #define ISINSTANCE(device) dc_device_isinstance((device), &oceanic_vtpro_device_vtable.base)
 
@@ -413,7 +414,6 @@ oceanic_vtpro_device_open (dc_device_t **out, dc_context_t *context, dc_iostream
 	device->base.multipage = MULTIPAGE;
 
 	// Set the default values.
-	device->iostream = iostream;
 	device->model = model;
 	if (model == AERIS500AI) {
 		device->protocol = INTR;
@@ -421,25 +421,33 @@ oceanic_vtpro_device_open (dc_device_t **out, dc_context_t *context, dc_iostream
 		device->protocol = MOD;
 	}
 
+	// Read ahead, because the answer follows the single byte ACK
+	// immediately, and the logbook index pages arrive back to back.
+	status = dc_buffered_open (&device->iostream, context, iostream, 1024);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (context, "Failed to create the buffered stream.");
+		goto error_free;
+	}
+
 	// Set the serial communication protocol (9600 8N1).
 	status = dc_iostream_configure (device->iostream, 9600, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the terminal attributes.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Set the timeout for receiving data (3000 ms).
 	status = dc_iostream_set_timeout (device->iostream, 3000);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the timeout.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Set the DTR line.
 	status = dc_iostream_set_dtr (device->iostream, 1);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the DTR line.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Clear the RTS line to reset the PIC inside the data cable as it
@@ -450,7 +458,7 @@ oceanic_vtpro_device_open (dc_device_t **out, dc_context_t *context, dc_iostream
 	status = dc_iostream_set_rts (device->iostream, 0);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to clear the RTS line.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Hold RTS clear for a bit to allow PIC to reset.
@@ -460,7 +468,7 @@ oceanic_vtpro_device_open (dc_device_t **out, dc_context_t *context, dc_iostream
 	status = dc_iostream_set_rts (device->iostream, 1);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the RTS line.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Give the interface 100 ms to settle and draw power up.
@@ -472,7 +480,7 @@ oceanic_vtpro_device_open (dc_device_t **out, dc_context_t *context, dc_iostream
 	// Initialize the data cable (MOD mode).
 	status = oceanic_vtpro_init (device);
 	if (status != DC_STATUS_SUCCESS) {
-		goto error_free;
+		goto error_close;
 	}
 
 	// Switch the device from surface mode into download mode. Before sending
@@ -480,7 +488,7 @@ oceanic_vtpro_device_open (dc_device_t **out, dc_context_t *context, dc_iostream
 	// the user), or already in download mode.
 	status = oceanic_vtpro_device_version ((dc_device_t *) device, device->base.version, sizeof (device->base.version));
 	if (status != DC_STATUS_SUCCESS) {
-		goto error_free;
+		goto error_close;
 	}
 
 	// Calibrate the device. Although calibration is optional, it's highly
@@ -488,7 +496,7 @@ oceanic_vtpro_device_open (dc_device_t **out, dc_context_t *context, dc_iostream
 	// when processing the command itself is quite slow.
 	status = oceanic_vtpro_calibrate (device);
 	if (status != DC_STATUS_SUCCESS) {
-		goto error_free;
+		goto error_close;
 	}
 
 	// Override the base class values.
@@ -507,6 +515,8 @@ oceanic_vtpro_device_open (dc_device_t **out, dc_context_t *context, dc_iostream
 
 	return DC_STATUS_SUCCESS;
 
+error_close:
+	dc_iostream_close (device->iostream);
 error_free:
 	dc_device_deallocate ((dc_device_t *) device);
 	return status;
@@ -526,6 +536,12 @@ oceanic_vtpro_device_close (dc_device_t *abstract)
 		dc_status_set_error(&status, rc);
 	}
 
+	// Close the buffered stream.
+	rc = dc_iostream_close (device->iostream);
+	if (rc != DC_STATUS_SUCCESS) {
+		dc_status_set_error(&status, rc);
+	}
+
 	return status;
 }
 
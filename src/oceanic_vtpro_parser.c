@@ -53,9 +53,13 @@ static const dc_parser_vtable_t oceanic_vtpro_parser_vtable = {
 	sizeof(oceanic_vtpro_parser_t),
 	DC_FAMILY_OCEANIC_VTPRO,
 	oceanic_vtpro_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	oceanic_vtpro_parser_get_datetime, /* datetime */
 	oceanic_vtpro_parser_get_field, /* fields */
 	oceanic_vtpro_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -158,7 +162,7 @@ oceanic_vtpro_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, uns
 	if (size < 7 * PAGESIZE / 2)
 		return DC_STATUS_DATAFORMAT;
 
-	if (!parser->cached) {
+	if (!parser->cached && !abstract->headeronly) {
 		sample_statistics_t statistics = SAMPLE_STATISTICS_INITIALIZER;
 		dc_status_t rc = oceanic_vtpro_parser_samples_foreach (
 			abstract, sample_statistics_cb, &statistics);
@@ -190,6 +194,8 @@ oceanic_vtpro_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, uns
 	if (value) {
 		switch (type) {
 		case DC_FIELD_DIVETIME:
+			if (!parser->cached)
+				return DC_STATUS_UNSUPPORTED;
 			*((unsigned int *) value) = parser->divetime;
 			break;
 		case DC_FIELD_MAXDEPTH:
@@ -0,0 +1,107 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+
+#include "pacing.h"
+
+#define INTERVAL_MIN 32
+#define INTERVAL_MAX 1024
+
+void
+dc_pacing_init (dc_pacing_t *pacing, unsigned int initial, unsigned int minimum, unsigned int maximum)
+{
+	pacing->minimum = minimum;
+	pacing->maximum = maximum;
+	pacing->interval = INTERVAL_MIN;
+	dc_pacing_set (pacing, initial);
+}
+
+int
+dc_pacing_enabled (const dc_pacing_t *pacing)
+{
+	return pacing->maximum != 0;
+}
+
+unsigned int
+dc_pacing_delay (const dc_pacing_t *pacing)
+{
+	return pacing->delay;
+}
+
+unsigned int
+dc_pacing_get (const dc_pacing_t *pacing)
+{
+	return pacing->good;
+}
+
+void
+dc_pacing_set (dc_pacing_t *pacing, unsigned int delay)
+{
+	if (delay < pacing->minimum)
+		delay = pacing->minimum;
+	if (delay > pacing->maximum)
+		delay = pacing->maximum;
+
+	pacing->delay = delay;
+	pacing->good = delay;
+	pacing->count = 0;
+}
+
+void
+dc_pacing_success (dc_pacing_t *pacing)
+{
+	// A delay above the known-good one (e.g. after backing off) is known
+	// to work as soon as a single packet succeeds.
+	if (pacing->delay > pacing->good)
+		pacing->good = pacing->delay;
+
+	if (++pacing->count < pacing->interval)
+		return;
+
+	// The current delay is known to work. Try the next lower one.
+	pacing->good = pacing->delay;
+	if (pacing->delay > pacing->minimum)
+		pacing->delay--;
+	pacing->count = 0;
+}
+
+void
+dc_pacing_failure (dc_pacing_t *pacing)
+{
+	pacing->count = 0;
+
+	if (pacing->delay < pacing->good) {
+		// The probe failed. Return to the last known-good delay, and
+		// wait longer before probing again.
+		pacing->delay = pacing->good;
+		if (pacing->interval < INTERVAL_MAX)
+			pacing->interval *= 2;
+	} else {
+		// Back off, faster for larger delays. The new delay only becomes
+		// the known-good one once a packet succeeds.
+		unsigned int step = pacing->delay / 2;
+		if (step == 0)
+			step = 1;
+		pacing->delay += step;
+		if (pacing->delay > pacing->maximum)
+			pacing->delay = pacing->maximum;
+	}
+}
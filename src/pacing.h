@@ -0,0 +1,71 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+
+#ifndef DC_PACING_H
+#define DC_PACING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Adaptive inter packet delay.
+ *
+ * The delay is increased when a packet fails, and after a long enough
+ * run of successful packets, the next lower delay is probed. If a probe
+ * fails, the delay returns to the last known-good value, and probing
+ * becomes less frequent.
+ */
+typedef struct dc_pacing_t {
+	unsigned int delay;
+	unsigned int good;
+	unsigned int minimum;
+	unsigned int maximum;
+	unsigned int count;
+	unsigned int interval;
+} dc_pacing_t;
+
+void
+dc_pacing_init (dc_pacing_t *pacing, unsigned int initial, unsigned int minimum, unsigned int maximum);
+
+int
+dc_pacing_enabled (const dc_pacing_t *pacing);
+
+unsigned int
+dc_pacing_delay (const dc_pacing_t *pacing);
+
+unsigned int
+dc_pacing_get (const dc_pacing_t *pacing);
+
+void
+dc_pacing_set (dc_pacing_t *pacing, unsigned int delay);
+
+void
+dc_pacing_success (dc_pacing_t *pacing);
+
+void
+dc_pacing_failure (dc_pacing_t *pacing);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DC_PACING_H */
@@ -22,6 +22,7 @@
 #ifndef PARSER_PRIVATE_H
 #define PARSER_PRIVATE_H
 
+#include <libdivecomputer/buffer.h>
 #include <libdivecomputer/context.h>
 #include <libdivecomputer/parser.h>
 
@@ -31,14 +32,21 @@ extern "C" {
 
 struct dc_parser_t;
 struct dc_parser_vtable_t;
+struct dc_sample_table_t;
+struct dc_sample_feed_t;
 
 typedef struct dc_parser_vtable_t dc_parser_vtable_t;
+typedef struct dc_sample_table_t dc_sample_table_t;
+typedef struct dc_sample_feed_t dc_sample_feed_t;
 
 struct dc_parser_t {
 	const dc_parser_vtable_t *vtable;
 	dc_context_t *context;
 	const unsigned char *data;
 	unsigned int size;
+	dc_sample_table_t *table;
+	dc_sample_feed_t *feed;
+	unsigned int headeronly;
 };
 
 struct dc_parser_vtable_t {
@@ -48,12 +56,20 @@ struct dc_parser_vtable_t {
 
 	dc_status_t (*set_data) (dc_parser_t *parser, const unsigned char *data, unsigned int size);
 
+	dc_status_t (*set_clock) (dc_parser_t *parser, unsigned int devtime, dc_ticks_t systime);
+
 	dc_status_t (*datetime) (dc_parser_t *parser, dc_datetime_t *datetime);
 
 	dc_status_t (*field) (dc_parser_t *parser, dc_field_type_t type, unsigned int flags, void *value);
 
 	dc_status_t (*samples_foreach) (dc_parser_t *parser, dc_sample_callback_t callback, void *userdata);
 
+	dc_status_t (*samples_batch) (dc_parser_t *parser, dc_sample_table_t *table);
+
+	dc_status_t (*samples_range) (dc_parser_t *parser, unsigned int begin, unsigned int end, dc_sample_callback_t callback, void *userdata);
+
+	dc_status_t (*samples_feed) (dc_parser_t *parser, dc_sample_feed_t *feed);
+
 	dc_status_t (*destroy) (dc_parser_t *parser);
 };
 
@@ -76,6 +92,93 @@ typedef struct sample_statistics_t {
 void
 sample_statistics_cb (dc_sample_type_t type, dc_sample_value_t value, void *userdata);
 
+/*
+ * Columnar sample storage, used by dc_parser_samples_batch.
+ *
+ * Backends with a native samples_batch implementation store the time,
+ * depth, temperature and pressure values directly in the table, and pass
+ * all other sample types through dc_sample_table_cb. Backends without a
+ * native implementation are adapted by passing dc_sample_table_cb to
+ * their samples_foreach function. A new row is started by each time
+ * sample.
+ */
+
+void
+dc_sample_table_time (dc_sample_table_t *table, unsigned int time);
+
+void
+dc_sample_table_depth (dc_sample_table_t *table, double depth);
+
+void
+dc_sample_table_temperature (dc_sample_table_t *table, double temperature);
+
+void
+dc_sample_table_pressure (dc_sample_table_t *table, unsigned int tank, double value);
+
+void
+dc_sample_table_cb (dc_sample_type_t type, dc_sample_value_t value, void *userdata);
+
+/*
+ * Sample index, used by dc_parser_samples_range.
+ *
+ * Backends with a native samples_range implementation record a checkpoint
+ * with the byte offset and the decoder state at the start of a sample,
+ * during their first complete walk over the profile. Once the index is
+ * complete, they resume decoding from the last checkpoint before the
+ * start of the range, and stop after the end of the range. The callback
+ * passed to the backend already discards the samples outside the range.
+ *
+ * The index has a fixed size. When it is full, every other checkpoint is
+ * dropped and the interval between the checkpoints is doubled.
+ */
+
+#define DC_SAMPLE_INDEX_SIZE 64
+#define DC_SAMPLE_INDEX_INTERVAL 60
+
+typedef struct dc_sample_checkpoint_t {
+	unsigned int time;     /* Time of the previous sample */
+	unsigned int offset;   /* Byte offset of the next sample */
+	unsigned int state[4]; /* Backend specific decoder state */
+} dc_sample_checkpoint_t;
+
+typedef struct dc_sample_index_t {
+	unsigned int complete;
+	unsigned int interval;
+	unsigned int count;
+	dc_sample_checkpoint_t checkpoint[DC_SAMPLE_INDEX_SIZE];
+} dc_sample_index_t;
+
+void
+dc_sample_index_reset (dc_sample_index_t *index);
+
+void
+dc_sample_index_add (dc_sample_index_t *index, const dc_sample_checkpoint_t *checkpoint);
+
+const dc_sample_checkpoint_t *
+dc_sample_index_find (const dc_sample_index_t *index, unsigned int time);
+
+/*
+ * Push mode state, used by dc_parser_feed.
+ *
+ * Backends with a native samples_feed implementation are called after
+ * each chunk, with the parser data pointing to all data received so far.
+ * They report all complete samples, and store the decoder state at the
+ * start of the first incomplete sample in the resume checkpoint (a zero
+ * offset means the walk has not started yet). Once the final flag is
+ * set, all data has been received, and the remainder of the profile is
+ * processed with the normal error checking. Because the backend set_data
+ * function is not called for each chunk, it must not do more than reset
+ * the cached state.
+ */
+
+struct dc_sample_feed_t {
+	dc_buffer_t *buffer;
+	dc_sample_callback_t callback;
+	void *userdata;
+	unsigned int final;
+	dc_sample_checkpoint_t resume;
+};
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
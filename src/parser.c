@@ -20,8 +20,12 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <assert.h>
 
+#include <libdivecomputer/buffer.h>
+
 #include "suunto_d9.h"
 #include "suunto_eon.h"
 #include "suunto_eonsteel.h"
@@ -65,6 +69,48 @@
 
 #define REACTPROWHITE 0x4354
 
+#define C_ARRAY_SIZE(array) (sizeof (array) / sizeof *(array))
+
+typedef struct dc_sample_row_t {
+	unsigned int time;
+	double depth;
+	double temperature;
+} dc_sample_row_t;
+
+typedef struct dc_sample_pressure_t {
+	unsigned int index;
+	unsigned int tank;
+	double value;
+} dc_sample_pressure_t;
+
+struct dc_sample_table_t {
+	dc_status_t status;
+	unsigned int complete;
+	// Decoded samples.
+	dc_buffer_t *rows;
+	dc_buffer_t *pressures;
+	dc_buffer_t *events;
+	// Read position.
+	unsigned int row;
+	unsigned int pressure;
+	unsigned int event;
+};
+
+typedef struct dc_parser_pool_entry_t {
+	struct dc_parser_pool_entry_t *next;
+	dc_family_t family;
+	unsigned int model;
+	dc_parser_t *parser;
+} dc_parser_pool_entry_t;
+
+struct dc_parser_pool_t {
+	dc_context_t *context;
+	dc_parser_pool_entry_t *entries;
+};
+
+static void dc_sample_table_free (dc_sample_table_t *table);
+static void dc_sample_feed_free (dc_sample_feed_t *feed);
+
 static dc_status_t
 dc_parser_new_internal (dc_parser_t **out, dc_context_t *context, dc_family_t family, unsigned int model, unsigned int devtime, dc_ticks_t systime)
 {
@@ -224,6 +270,9 @@ dc_parser_allocate (dc_context_t *context, const dc_parser_vtable_t *vtable)
 	parser->context = context;
 	parser->data = NULL;
 	parser->size = 0;
+	parser->table = NULL;
+	parser->feed = NULL;
+	parser->headeronly = 0;
 
 	return parser;
 }
@@ -231,6 +280,12 @@ dc_parser_allocate (dc_context_t *context, const dc_parser_vtable_t *vtable)
 void
 dc_parser_deallocate (dc_parser_t *parser)
 {
+	if (parser == NULL)
+		return;
+
+	dc_sample_table_free (parser->table);
+	dc_sample_feed_free (parser->feed);
+
 	free (parser);
 }
 
@@ -254,6 +309,30 @@ dc_parser_get_type (dc_parser_t *parser)
 }
 
 
+dc_status_t
+dc_parser_reset (dc_parser_t *parser, unsigned int devtime, dc_ticks_t systime)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (parser == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	// Discard the previous dive. Backends keep their per-device state.
+	status = dc_parser_set_data (parser, NULL, 0);
+	if (status != DC_STATUS_SUCCESS && status != DC_STATUS_UNSUPPORTED)
+		return status;
+
+	// Update the clock of the new device.
+	if (parser->vtable->set_clock) {
+		status = parser->vtable->set_clock (parser, devtime, systime);
+		if (status != DC_STATUS_SUCCESS)
+			return status;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+
 dc_status_t
 dc_parser_set_data (dc_parser_t *parser, const unsigned char *data, unsigned int size)
 {
@@ -266,10 +345,125 @@ dc_parser_set_data (dc_parser_t *parser, const unsigned char *data, unsigned int
 	parser->data = data;
 	parser->size = size;
 
+	// Discard the samples of the previous dive.
+	dc_sample_table_free (parser->table);
+	parser->table = NULL;
+	dc_sample_feed_free (parser->feed);
+	parser->feed = NULL;
+
 	return parser->vtable->set_data (parser, data, size);
 }
 
 
+static void
+dc_sample_feed_free (dc_sample_feed_t *feed)
+{
+	if (feed == NULL)
+		return;
+
+	dc_buffer_free (feed->buffer);
+	free (feed);
+}
+
+dc_status_t
+dc_parser_feed_begin (dc_parser_t *parser, dc_sample_callback_t callback, void *userdata)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_sample_feed_t *feed = NULL;
+
+	if (parser == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	// Discard the previous dive.
+	status = dc_parser_set_data (parser, NULL, 0);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
+	feed = (dc_sample_feed_t *) malloc (sizeof (dc_sample_feed_t));
+	if (feed == NULL) {
+		ERROR (parser->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	feed->buffer = dc_buffer_new (0);
+	if (feed->buffer == NULL) {
+		ERROR (parser->context, "Failed to allocate memory.");
+		free (feed);
+		return DC_STATUS_NOMEMORY;
+	}
+
+	feed->callback = callback;
+	feed->userdata = userdata;
+	feed->final = 0;
+	feed->resume.time = 0;
+	feed->resume.offset = 0;
+	for (unsigned int i = 0; i < C_ARRAY_SIZE (feed->resume.state); ++i) {
+		feed->resume.state[i] = 0;
+	}
+
+	parser->feed = feed;
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_parser_feed (dc_parser_t *parser, const unsigned char data[], unsigned int size)
+{
+	if (parser == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	dc_sample_feed_t *feed = parser->feed;
+	if (feed == NULL || feed->final)
+		return DC_STATUS_INVALIDARGS;
+
+	if (!dc_buffer_append (feed->buffer, data, size)) {
+		ERROR (parser->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	// Without a native implementation, the samples are only
+	// processed once all data has been received.
+	if (parser->vtable->samples_feed == NULL)
+		return DC_STATUS_SUCCESS;
+
+	// The buffer may have been reallocated.
+	parser->data = dc_buffer_get_data (feed->buffer);
+	parser->size = dc_buffer_get_size (feed->buffer);
+
+	return parser->vtable->samples_feed (parser, feed);
+}
+
+dc_status_t
+dc_parser_feed_end (dc_parser_t *parser)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (parser == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	dc_sample_feed_t *feed = parser->feed;
+	if (feed == NULL || feed->final)
+		return DC_STATUS_INVALIDARGS;
+
+	feed->final = 1;
+
+	parser->data = dc_buffer_get_data (feed->buffer);
+	parser->size = dc_buffer_get_size (feed->buffer);
+
+	if (parser->vtable->samples_feed)
+		return parser->vtable->samples_feed (parser, feed);
+
+	status = parser->vtable->set_data (parser, parser->data, parser->size);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
+	if (parser->vtable->samples_foreach == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	return parser->vtable->samples_foreach (parser, feed->callback, feed->userdata);
+}
+
+
 dc_status_t
 dc_parser_get_datetime (dc_parser_t *parser, dc_datetime_t *datetime)
 {
@@ -295,6 +489,143 @@ dc_parser_get_field (dc_parser_t *parser, dc_field_type_t type, unsigned int fla
 }
 
 
+static dc_status_t
+dc_parser_get_summary_field (dc_parser_t *parser, dc_summary_t *summary, dc_field_type_t type, unsigned int flags, void *value)
+{
+	dc_status_t status = parser->vtable->field (parser, type, flags, value);
+	if (status == DC_STATUS_UNSUPPORTED)
+		return DC_STATUS_SUCCESS;
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
+	summary->fields |= 1u << type;
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_parser_get_summary (dc_parser_t *parser, dc_summary_t *summary)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (parser == NULL || summary == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	summary->fields = 0;
+	summary->divetime = 0;
+	summary->maxdepth = 0.0;
+	summary->avgdepth = 0.0;
+	summary->gasmix_count = 0;
+	summary->salinity.type = DC_WATER_FRESH;
+	summary->salinity.density = 0.0;
+	summary->atmospheric = 0.0;
+	summary->temperature_surface = 0.0;
+	summary->temperature_minimum = 0.0;
+	summary->temperature_maximum = 0.0;
+	summary->tank_count = 0;
+	summary->divemode = DC_DIVEMODE_OC;
+
+	if (parser->vtable->field == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	// The first field triggers the backend to parse and cache the
+	// header (and the profile if necessary). All other fields are
+	// served from that cache.
+	const struct {
+		dc_field_type_t type;
+		void *value;
+	} fields[] = {
+		{DC_FIELD_DIVETIME,            &summary->divetime},
+		{DC_FIELD_MAXDEPTH,            &summary->maxdepth},
+		{DC_FIELD_AVGDEPTH,            &summary->avgdepth},
+		{DC_FIELD_GASMIX_COUNT,        &summary->gasmix_count},
+		{DC_FIELD_SALINITY,            &summary->salinity},
+		{DC_FIELD_ATMOSPHERIC,         &summary->atmospheric},
+		{DC_FIELD_TEMPERATURE_SURFACE, &summary->temperature_surface},
+		{DC_FIELD_TEMPERATURE_MINIMUM, &summary->temperature_minimum},
+		{DC_FIELD_TEMPERATURE_MAXIMUM, &summary->temperature_maximum},
+		{DC_FIELD_TANK_COUNT,          &summary->tank_count},
+		{DC_FIELD_DIVEMODE,            &summary->divemode},
+	};
+
+	for (unsigned int i = 0; i < C_ARRAY_SIZE (fields); ++i) {
+		status = dc_parser_get_summary_field (parser, summary, fields[i].type, 0, fields[i].value);
+		if (status != DC_STATUS_SUCCESS)
+			return status;
+	}
+
+	// Gas mixes.
+	if (summary->gasmixes && DC_SUMMARY_HAS (summary, DC_FIELD_GASMIX_COUNT)) {
+		unsigned int n = summary->gasmix_count < summary->maxgasmixes ?
+			summary->gasmix_count : summary->maxgasmixes;
+		for (unsigned int i = 0; i < n; ++i) {
+			status = dc_parser_get_summary_field (parser, summary, DC_FIELD_GASMIX, i, summary->gasmixes + i);
+			if (status != DC_STATUS_SUCCESS)
+				return status;
+		}
+	}
+
+	// Tanks.
+	if (summary->tanks && DC_SUMMARY_HAS (summary, DC_FIELD_TANK_COUNT)) {
+		unsigned int n = summary->tank_count < summary->maxtanks ?
+			summary->tank_count : summary->maxtanks;
+		for (unsigned int i = 0; i < n; ++i) {
+			status = dc_parser_get_summary_field (parser, summary, DC_FIELD_TANK, i, summary->tanks + i);
+			if (status != DC_STATUS_SUCCESS)
+				return status;
+		}
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+
+dc_status_t
+dc_parser_probe (dc_parser_t *parser, dc_probe_t *probe)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (parser == NULL || probe == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	probe->fields = 0;
+	memset (&probe->datetime, 0, sizeof (probe->datetime));
+	probe->divetime = 0;
+	probe->maxdepth = 0.0;
+
+	// While the flag is set, the backends only look at the header and
+	// report fields that require a walk over the profile as unsupported.
+	parser->headeronly = 1;
+
+	if (parser->vtable->datetime) {
+		status = parser->vtable->datetime (parser, &probe->datetime);
+		if (status == DC_STATUS_SUCCESS)
+			probe->fields |= DC_PROBE_DATETIME;
+		else if (status != DC_STATUS_UNSUPPORTED)
+			goto error_exit;
+	}
+
+	if (parser->vtable->field) {
+		status = parser->vtable->field (parser, DC_FIELD_DIVETIME, 0, &probe->divetime);
+		if (status == DC_STATUS_SUCCESS)
+			probe->fields |= DC_PROBE_DIVETIME;
+		else if (status != DC_STATUS_UNSUPPORTED)
+			goto error_exit;
+
+		status = parser->vtable->field (parser, DC_FIELD_MAXDEPTH, 0, &probe->maxdepth);
+		if (status == DC_STATUS_SUCCESS)
+			probe->fields |= DC_PROBE_MAXDEPTH;
+		else if (status != DC_STATUS_UNSUPPORTED)
+			goto error_exit;
+	}
+
+	status = DC_STATUS_SUCCESS;
+
+error_exit:
+	parser->headeronly = 0;
+	return status;
+}
+
 dc_status_t
 dc_parser_samples_foreach (dc_parser_t *parser, dc_sample_callback_t callback, void *userdata)
 {
@@ -308,6 +639,368 @@ dc_parser_samples_foreach (dc_parser_t *parser, dc_sample_callback_t callback, v
 }
 
 
+typedef struct dc_sample_range_t {
+	unsigned int begin;
+	unsigned int end;
+	unsigned int time;
+	dc_sample_callback_t callback;
+	void *userdata;
+} dc_sample_range_t;
+
+static void
+dc_sample_range_cb (dc_sample_type_t type, dc_sample_value_t value, void *userdata)
+{
+	dc_sample_range_t *range = (dc_sample_range_t *) userdata;
+
+	// A time sample starts a new row.
+	if (type == DC_SAMPLE_TIME)
+		range->time = value.time;
+
+	if (range->time < range->begin || range->time > range->end)
+		return;
+
+	range->callback (type, value, range->userdata);
+}
+
+dc_status_t
+dc_parser_samples_range (dc_parser_t *parser, unsigned int begin, unsigned int end, dc_sample_callback_t callback, void *userdata)
+{
+	if (parser == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (begin > end)
+		return DC_STATUS_INVALIDARGS;
+
+	if (callback == NULL)
+		return DC_STATUS_SUCCESS;
+
+	dc_sample_range_t range = {begin, end, 0, callback, userdata};
+
+	// Without a native implementation, walk the entire profile.
+	if (parser->vtable->samples_range == NULL) {
+		if (parser->vtable->samples_foreach == NULL)
+			return DC_STATUS_UNSUPPORTED;
+
+		return parser->vtable->samples_foreach (parser, dc_sample_range_cb, &range);
+	}
+
+	return parser->vtable->samples_range (parser, begin, end, dc_sample_range_cb, &range);
+}
+
+
+void
+dc_sample_index_reset (dc_sample_index_t *index)
+{
+	index->complete = 0;
+	index->interval = DC_SAMPLE_INDEX_INTERVAL;
+	index->count = 0;
+}
+
+void
+dc_sample_index_add (dc_sample_index_t *index, const dc_sample_checkpoint_t *checkpoint)
+{
+	unsigned int previous = index->count ? index->checkpoint[index->count - 1].time : 0;
+	if (checkpoint->time < previous + index->interval)
+		return;
+
+	if (index->count == DC_SAMPLE_INDEX_SIZE) {
+		// Drop every other checkpoint.
+		for (unsigned int i = 1; i < DC_SAMPLE_INDEX_SIZE / 2; ++i) {
+			index->checkpoint[i] = index->checkpoint[2 * i];
+		}
+		index->count = DC_SAMPLE_INDEX_SIZE / 2;
+		index->interval *= 2;
+
+		previous = index->checkpoint[index->count - 1].time;
+		if (checkpoint->time < previous + index->interval)
+			return;
+	}
+
+	index->checkpoint[index->count++] = *checkpoint;
+}
+
+const dc_sample_checkpoint_t *
+dc_sample_index_find (const dc_sample_index_t *index, unsigned int time)
+{
+	unsigned int lo = 0, hi = index->count;
+
+	if (!index->complete)
+		return NULL;
+
+	// Find the last checkpoint before the requested time.
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+		if (index->checkpoint[mid].time < time)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo == 0)
+		return NULL;
+
+	return index->checkpoint + lo - 1;
+}
+
+static dc_sample_table_t *
+dc_sample_table_new (void)
+{
+	dc_sample_table_t *table = (dc_sample_table_t *) malloc (sizeof (dc_sample_table_t));
+	if (table == NULL)
+		return NULL;
+
+	table->status = DC_STATUS_SUCCESS;
+	table->complete = 0;
+	table->rows = dc_buffer_new (0);
+	table->pressures = dc_buffer_new (0);
+	table->events = dc_buffer_new (0);
+	table->row = 0;
+	table->pressure = 0;
+	table->event = 0;
+
+	if (table->rows == NULL || table->pressures == NULL || table->events == NULL) {
+		dc_sample_table_free (table);
+		return NULL;
+	}
+
+	return table;
+}
+
+static void
+dc_sample_table_free (dc_sample_table_t *table)
+{
+	if (table == NULL)
+		return;
+
+	dc_buffer_free (table->rows);
+	dc_buffer_free (table->pressures);
+	dc_buffer_free (table->events);
+	free (table);
+}
+
+static unsigned int
+dc_sample_table_count (dc_buffer_t *buffer, size_t size)
+{
+	return dc_buffer_get_size (buffer) / size;
+}
+
+static dc_sample_row_t *
+dc_sample_table_last (dc_sample_table_t *table)
+{
+	unsigned int count = dc_sample_table_count (table->rows, sizeof (dc_sample_row_t));
+	if (count == 0) {
+		// Samples without a preceding time sample belong to time zero.
+		dc_sample_table_time (table, 0);
+		count = dc_sample_table_count (table->rows, sizeof (dc_sample_row_t));
+		if (count == 0)
+			return NULL;
+	}
+
+	return (dc_sample_row_t *) dc_buffer_get_data (table->rows) + count - 1;
+}
+
+void
+dc_sample_table_time (dc_sample_table_t *table, unsigned int time)
+{
+	dc_sample_row_t row = {time, NAN, NAN};
+
+	if (!dc_buffer_append (table->rows, (const unsigned char *) &row, sizeof (row)))
+		table->status = DC_STATUS_NOMEMORY;
+}
+
+void
+dc_sample_table_depth (dc_sample_table_t *table, double depth)
+{
+	dc_sample_row_t *row = dc_sample_table_last (table);
+	if (row)
+		row->depth = depth;
+}
+
+void
+dc_sample_table_temperature (dc_sample_table_t *table, double temperature)
+{
+	dc_sample_row_t *row = dc_sample_table_last (table);
+	if (row)
+		row->temperature = temperature;
+}
+
+void
+dc_sample_table_pressure (dc_sample_table_t *table, unsigned int tank, double value)
+{
+	if (dc_sample_table_last (table) == NULL)
+		return;
+
+	dc_sample_pressure_t pressure = {0};
+	pressure.index = dc_sample_table_count (table->rows, sizeof (dc_sample_row_t)) - 1;
+	pressure.tank = tank;
+	pressure.value = value;
+
+	if (!dc_buffer_append (table->pressures, (const unsigned char *) &pressure, sizeof (pressure)))
+		table->status = DC_STATUS_NOMEMORY;
+}
+
+static void
+dc_sample_table_event (dc_sample_table_t *table, dc_sample_type_t type, const dc_sample_value_t *value)
+{
+	if (dc_sample_table_last (table) == NULL)
+		return;
+
+	dc_sample_batch_event_t event;
+	memset (&event, 0, sizeof (event));
+	event.index = dc_sample_table_count (table->rows, sizeof (dc_sample_row_t)) - 1;
+	event.type = type;
+	event.value = *value;
+
+	if (!dc_buffer_append (table->events, (const unsigned char *) &event, sizeof (event)))
+		table->status = DC_STATUS_NOMEMORY;
+}
+
+void
+dc_sample_table_cb (dc_sample_type_t type, dc_sample_value_t value, void *userdata)
+{
+	dc_sample_table_t *table = (dc_sample_table_t *) userdata;
+
+	switch (type) {
+	case DC_SAMPLE_TIME:
+		dc_sample_table_time (table, value.time);
+		break;
+	case DC_SAMPLE_DEPTH:
+		dc_sample_table_depth (table, value.depth);
+		break;
+	case DC_SAMPLE_TEMPERATURE:
+		dc_sample_table_temperature (table, value.temperature);
+		break;
+	case DC_SAMPLE_PRESSURE:
+		dc_sample_table_pressure (table, value.pressure.tank, value.pressure.value);
+		break;
+	default:
+		dc_sample_table_event (table, type, &value);
+		break;
+	}
+}
+
+static dc_status_t
+dc_sample_table_build (dc_parser_t *parser, dc_sample_table_t *table)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (parser->vtable->samples_batch) {
+		status = parser->vtable->samples_batch (parser, table);
+	} else if (parser->vtable->samples_foreach) {
+		status = parser->vtable->samples_foreach (parser, dc_sample_table_cb, table);
+	} else {
+		status = DC_STATUS_UNSUPPORTED;
+	}
+
+	if (status == DC_STATUS_SUCCESS)
+		status = table->status;
+
+	return status;
+}
+
+dc_status_t
+dc_parser_samples_batch (dc_parser_t *parser, dc_sample_batch_t *batch)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (parser == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (batch == NULL || batch->capacity == 0 ||
+		(batch->pressure == NULL && batch->ntanks != 0))
+		return DC_STATUS_INVALIDARGS;
+
+	batch->count = 0;
+	batch->nevents = 0;
+
+	// Decode all samples on the first call.
+	if (parser->table == NULL) {
+		parser->table = dc_sample_table_new ();
+		if (parser->table == NULL) {
+			ERROR (parser->context, "Failed to allocate memory.");
+			return DC_STATUS_NOMEMORY;
+		}
+	}
+
+	dc_sample_table_t *table = parser->table;
+	if (!table->complete) {
+		status = dc_sample_table_build (parser, table);
+		if (status != DC_STATUS_SUCCESS) {
+			dc_sample_table_free (table);
+			parser->table = NULL;
+			return status;
+		}
+		table->complete = 1;
+	}
+
+	const dc_sample_row_t *rows = (const dc_sample_row_t *) dc_buffer_get_data (table->rows);
+	const dc_sample_pressure_t *pressures = (const dc_sample_pressure_t *) dc_buffer_get_data (table->pressures);
+	const dc_sample_batch_event_t *events = (const dc_sample_batch_event_t *) dc_buffer_get_data (table->events);
+	unsigned int nrows = dc_sample_table_count (table->rows, sizeof (dc_sample_row_t));
+	unsigned int npressures = dc_sample_table_count (table->pressures, sizeof (dc_sample_pressure_t));
+	unsigned int nevents = dc_sample_table_count (table->events, sizeof (dc_sample_batch_event_t));
+
+	while (table->row < nrows && batch->count < batch->capacity) {
+		unsigned int index = table->row;
+		unsigned int i = batch->count;
+
+		// Count the events of this row, including the pressure samples
+		// that have no column, to check whether the row still fits.
+		unsigned int n = 0;
+		for (unsigned int j = table->event; j < nevents && events[j].index == index; ++j)
+			n++;
+		for (unsigned int j = table->pressure; j < npressures && pressures[j].index == index; ++j) {
+			if (pressures[j].tank >= batch->ntanks)
+				n++;
+		}
+		if (batch->events && batch->nevents + n > batch->maxevents) {
+			if (batch->count == 0) {
+				ERROR (parser->context, "Not enough space for the events of a single sample.");
+				return DC_STATUS_NOMEMORY;
+			}
+			break;
+		}
+
+		if (batch->time)
+			batch->time[i] = rows[index].time;
+		if (batch->depth)
+			batch->depth[i] = rows[index].depth;
+		if (batch->temperature)
+			batch->temperature[i] = rows[index].temperature;
+		for (unsigned int t = 0; t < batch->ntanks; ++t)
+			batch->pressure[t * batch->capacity + i] = NAN;
+
+		while (table->event < nevents && events[table->event].index == index) {
+			if (batch->events) {
+				dc_sample_batch_event_t *event = batch->events + batch->nevents++;
+				*event = events[table->event];
+				event->index = i;
+			}
+			table->event++;
+		}
+
+		while (table->pressure < npressures && pressures[table->pressure].index == index) {
+			const dc_sample_pressure_t *p = pressures + table->pressure;
+			if (p->tank < batch->ntanks) {
+				batch->pressure[p->tank * batch->capacity + i] = p->value;
+			} else if (batch->events) {
+				dc_sample_batch_event_t *event = batch->events + batch->nevents++;
+				memset (event, 0, sizeof (*event));
+				event->index = i;
+				event->type = DC_SAMPLE_PRESSURE;
+				event->value.pressure.tank = p->tank;
+				event->value.pressure.value = p->value;
+			}
+			table->pressure++;
+		}
+
+		table->row++;
+		batch->count++;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
 dc_status_t
 dc_parser_destroy (dc_parser_t *parser)
 {
@@ -343,3 +1036,94 @@ sample_statistics_cb (dc_sample_type_t type, dc_sample_value_t value, void *user
 		break;
 	}
 }
+
+
+dc_status_t
+dc_parser_pool_new (dc_parser_pool_t **out, dc_context_t *context)
+{
+	dc_parser_pool_t *pool = NULL;
+
+	if (out == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	// Allocate memory.
+	pool = (dc_parser_pool_t *) malloc (sizeof (dc_parser_pool_t));
+	if (pool == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	pool->context = context;
+	pool->entries = NULL;
+
+	*out = pool;
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_parser_pool_get (dc_parser_pool_t *pool, dc_parser_t **out, dc_descriptor_t *descriptor, unsigned int devtime, dc_ticks_t systime)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_parser_pool_entry_t *entry = NULL;
+
+	if (pool == NULL || out == NULL || descriptor == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_family_t family = dc_descriptor_get_type (descriptor);
+	unsigned int model = dc_descriptor_get_model (descriptor);
+
+	// Re-use the existing parser, if available.
+	for (entry = pool->entries; entry != NULL; entry = entry->next) {
+		if (entry->family == family && entry->model == model) {
+			status = dc_parser_reset (entry->parser, devtime, systime);
+			if (status != DC_STATUS_SUCCESS)
+				return status;
+
+			*out = entry->parser;
+
+			return DC_STATUS_SUCCESS;
+		}
+	}
+
+	// Allocate memory.
+	entry = (dc_parser_pool_entry_t *) malloc (sizeof (dc_parser_pool_entry_t));
+	if (entry == NULL) {
+		ERROR (pool->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	status = dc_parser_new_internal (&entry->parser, pool->context, family, model, devtime, systime);
+	if (status != DC_STATUS_SUCCESS) {
+		free (entry);
+		return status;
+	}
+
+	entry->family = family;
+	entry->model = model;
+	entry->next = pool->entries;
+	pool->entries = entry;
+
+	*out = entry->parser;
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_parser_pool_free (dc_parser_pool_t *pool)
+{
+	if (pool == NULL)
+		return DC_STATUS_SUCCESS;
+
+	dc_parser_pool_entry_t *entry = pool->entries;
+	while (entry) {
+		dc_parser_pool_entry_t *next = entry->next;
+		dc_parser_destroy (entry->parser);
+		free (entry);
+		entry = next;
+	}
+
+	free (pool);
+
+	return DC_STATUS_SUCCESS;
+}
@@ -0,0 +1,356 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#include <stdlib.h>
+
+#include <libdivecomputer/parser.h>
+
+#include "context-private.h"
+#include "thread.h"
+#include "timer.h"
+
+typedef struct dc_parse_engine_t dc_parse_engine_t;
+
+typedef struct dc_parse_worker_t {
+	dc_parse_engine_t *engine;
+	dc_thread_t *thread;
+	dc_mutex_t *mutex;
+	unsigned int begin, end;
+	dc_parser_pool_t *pool;
+	dc_timer_t *timer;
+	dc_parse_stats_t *stats;
+	unsigned int nstats;
+} dc_parse_worker_t;
+
+struct dc_parse_engine_t {
+	dc_context_t *context;
+	const dc_parse_job_t *jobs;
+	unsigned int njobs;
+	dc_parse_func_t func;
+	void *userdata;
+	dc_parse_worker_t *workers;
+	unsigned int nworkers;
+	dc_mutex_t *mutex;
+	dc_cond_t *cond;
+	dc_status_t *status;
+	unsigned char *done;
+	unsigned int next;
+	int cancelled;
+};
+
+static dc_status_t
+dc_parse_default (dc_parser_t *parser, const dc_parse_job_t *job, void *userdata)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_datetime_t datetime;
+
+	status = dc_parser_get_datetime (parser, &datetime);
+	if (status != DC_STATUS_SUCCESS && status != DC_STATUS_UNSUPPORTED)
+		return status;
+
+	return dc_parser_samples_foreach (parser, NULL, NULL);
+}
+
+static dc_parse_stats_t *
+dc_parse_worker_stats (dc_parse_worker_t *worker, dc_family_t family)
+{
+	dc_parse_stats_t *stats = NULL;
+
+	for (unsigned int i = 0; i < worker->nstats; ++i) {
+		if (worker->stats[i].family == family)
+			return worker->stats + i;
+	}
+
+	stats = (dc_parse_stats_t *) realloc (worker->stats, (worker->nstats + 1) * sizeof (dc_parse_stats_t));
+	if (stats == NULL)
+		return NULL;
+
+	worker->stats = stats;
+	stats += worker->nstats++;
+	stats->family = family;
+	stats->count = 0;
+	stats->errors = 0;
+	stats->bytes = 0;
+	stats->usecs = 0;
+
+	return stats;
+}
+
+static dc_status_t
+dc_parse_worker_run (dc_parse_worker_t *worker, const dc_parse_job_t *job)
+{
+	dc_parse_engine_t *engine = worker->engine;
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_parser_t *parser = NULL;
+	dc_usecs_t begin = 0, end = 0;
+
+	dc_timer_now (worker->timer, &begin);
+
+	status = dc_parser_pool_get (worker->pool, &parser, job->descriptor, job->devtime, job->systime);
+	if (status == DC_STATUS_SUCCESS) {
+		status = dc_parser_set_data (parser, job->data, job->size);
+	}
+	if (status == DC_STATUS_SUCCESS) {
+		if (engine->func) {
+			status = engine->func (parser, job, engine->userdata);
+		} else {
+			status = dc_parse_default (parser, job, engine->userdata);
+		}
+	}
+
+	dc_timer_now (worker->timer, &end);
+
+	dc_parse_stats_t *stats = dc_parse_worker_stats (worker, dc_descriptor_get_type (job->descriptor));
+	if (stats) {
+		stats->count++;
+		if (status != DC_STATUS_SUCCESS)
+			stats->errors++;
+		stats->bytes += job->size;
+		stats->usecs += end - begin;
+	}
+
+	return status;
+}
+
+static int
+dc_parse_worker_take (dc_parse_worker_t *worker, unsigned int *index)
+{
+	dc_parse_engine_t *engine = worker->engine;
+	int found = 0;
+
+	// Take the next job from the front of our own range.
+	dc_mutex_lock (worker->mutex);
+	if (worker->begin < worker->end) {
+		*index = worker->begin++;
+		found = 1;
+	}
+	dc_mutex_unlock (worker->mutex);
+
+	if (found)
+		return 1;
+
+	// Steal a job from the back of the range of the other workers.
+	unsigned int n = worker - engine->workers;
+	for (unsigned int i = 1; i < engine->nworkers; ++i) {
+		dc_parse_worker_t *victim = engine->workers + (n + i) % engine->nworkers;
+
+		dc_mutex_lock (victim->mutex);
+		if (victim->begin < victim->end) {
+			*index = --victim->end;
+			found = 1;
+		}
+		dc_mutex_unlock (victim->mutex);
+
+		if (found)
+			return 1;
+	}
+
+	return 0;
+}
+
+static void
+dc_parse_worker_main (void *userdata)
+{
+	dc_parse_worker_t *worker = (dc_parse_worker_t *) userdata;
+	dc_parse_engine_t *engine = worker->engine;
+	unsigned int index = 0;
+
+	while (dc_parse_worker_take (worker, &index)) {
+		dc_mutex_lock (engine->mutex);
+		int cancelled = engine->cancelled;
+		dc_mutex_unlock (engine->mutex);
+
+		if (cancelled)
+			break;
+
+		dc_status_t status = dc_parse_worker_run (worker, engine->jobs + index);
+
+		dc_mutex_lock (engine->mutex);
+		engine->status[index] = status;
+		engine->done[index] = 1;
+		if (index == engine->next)
+			dc_cond_signal (engine->cond);
+		dc_mutex_unlock (engine->mutex);
+	}
+}
+
+dc_status_t
+dc_parse_batch (dc_context_t *context, const dc_parse_job_t jobs[], unsigned int njobs, unsigned int nthreads, dc_parse_func_t func, dc_parse_sink_t sink, void *userdata, dc_parse_stats_t stats[], unsigned int *nstats)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_parse_engine_t engine;
+	unsigned int nworkers = 0, nrunning = 0;
+
+	if (jobs == NULL && njobs != 0)
+		return DC_STATUS_INVALIDARGS;
+
+	if (stats == NULL && nstats != NULL && *nstats != 0)
+		return DC_STATUS_INVALIDARGS;
+
+	for (unsigned int i = 0; i < njobs; ++i) {
+		if (jobs[i].descriptor == NULL)
+			return DC_STATUS_INVALIDARGS;
+	}
+
+	// Never start more threads than there are jobs.
+	nworkers = nthreads < njobs ? nthreads : njobs;
+	if (nworkers == 0)
+		nworkers = 1;
+
+	engine.context = context;
+	engine.jobs = jobs;
+	engine.njobs = njobs;
+	engine.func = func;
+	engine.userdata = userdata;
+	engine.nworkers = nworkers;
+	engine.mutex = NULL;
+	engine.cond = NULL;
+	engine.next = 0;
+	engine.cancelled = 0;
+	engine.status = (dc_status_t *) malloc ((njobs ? njobs : 1) * sizeof (dc_status_t));
+	engine.done = (unsigned char *) calloc (njobs ? njobs : 1, sizeof (unsigned char));
+	engine.workers = (dc_parse_worker_t *) calloc (nworkers, sizeof (dc_parse_worker_t));
+	if (engine.status == NULL || engine.done == NULL || engine.workers == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		status = DC_STATUS_NOMEMORY;
+		goto error_free;
+	}
+
+	status = dc_mutex_new (&engine.mutex);
+	if (status == DC_STATUS_SUCCESS) {
+		status = dc_cond_new (&engine.cond);
+	}
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (context, "Failed to create the synchronization objects.");
+		goto error_free;
+	}
+
+	// Split the jobs into contiguous ranges, one per worker.
+	for (unsigned int i = 0; i < nworkers; ++i) {
+		dc_parse_worker_t *worker = engine.workers + i;
+		worker->engine = &engine;
+		worker->begin = (unsigned long long) njobs * i / nworkers;
+		worker->end = (unsigned long long) njobs * (i + 1) / nworkers;
+
+		status = dc_mutex_new (&worker->mutex);
+		if (status == DC_STATUS_SUCCESS) {
+			status = dc_parser_pool_new (&worker->pool, context);
+		}
+		if (status == DC_STATUS_SUCCESS) {
+			status = dc_timer_new (&worker->timer);
+		}
+		if (status != DC_STATUS_SUCCESS) {
+			ERROR (context, "Failed to create the worker.");
+			goto error_free;
+		}
+	}
+
+	// Start the worker threads. Because idle workers steal from all
+	// ranges, the batch also completes if not all threads could be
+	// started.
+	if (nthreads) {
+		for (unsigned int i = 0; i < nworkers; ++i) {
+			status = dc_thread_new (&engine.workers[i].thread, dc_parse_worker_main, engine.workers + i);
+			if (status != DC_STATUS_SUCCESS) {
+				if (status != DC_STATUS_UNSUPPORTED)
+					WARNING (context, "Failed to start worker thread %u.", i);
+				break;
+			}
+			nrunning++;
+		}
+		status = DC_STATUS_SUCCESS;
+	}
+
+	if (nrunning == 0) {
+		// Parse all jobs on the calling thread.
+		for (unsigned int i = 0; i < njobs; ++i) {
+			dc_status_t rc = dc_parse_worker_run (engine.workers, jobs + i);
+			if (sink && !sink (jobs + i, rc, userdata))
+				break;
+		}
+	} else {
+		// Deliver the results in input order.
+		dc_mutex_lock (engine.mutex);
+		while (engine.next < njobs) {
+			unsigned int index = engine.next;
+			while (!engine.done[index])
+				dc_cond_wait (engine.cond, engine.mutex);
+			dc_mutex_unlock (engine.mutex);
+
+			int proceed = sink ? sink (jobs + index, engine.status[index], userdata) : 1;
+
+			dc_mutex_lock (engine.mutex);
+			engine.next++;
+			if (!proceed) {
+				engine.cancelled = 1;
+				break;
+			}
+		}
+		dc_mutex_unlock (engine.mutex);
+
+		for (unsigned int i = 0; i < nrunning; ++i) {
+			dc_thread_join (engine.workers[i].thread);
+		}
+	}
+
+	// Merge the per worker statistics.
+	if (nstats) {
+		unsigned int count = 0;
+		for (unsigned int i = 0; i < nworkers; ++i) {
+			dc_parse_worker_t *worker = engine.workers + i;
+			for (unsigned int j = 0; j < worker->nstats; ++j) {
+				const dc_parse_stats_t *src = worker->stats + j;
+				unsigned int k = 0;
+				while (k < count && stats[k].family != src->family)
+					k++;
+				if (k == count) {
+					if (count >= *nstats)
+						continue;
+					stats[k] = *src;
+					count++;
+				} else {
+					stats[k].count += src->count;
+					stats[k].errors += src->errors;
+					stats[k].bytes += src->bytes;
+					stats[k].usecs += src->usecs;
+				}
+			}
+		}
+		*nstats = count;
+	}
+
+error_free:
+	if (engine.workers) {
+		for (unsigned int i = 0; i < nworkers; ++i) {
+			dc_parse_worker_t *worker = engine.workers + i;
+			free (worker->stats);
+			dc_timer_free (worker->timer);
+			dc_parser_pool_free (worker->pool);
+			dc_mutex_free (worker->mutex);
+		}
+	}
+	dc_cond_free (engine.cond);
+	dc_mutex_free (engine.mutex);
+	free (engine.workers);
+	free (engine.done);
+	free (engine.status);
+	return status;
+}
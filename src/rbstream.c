@@ -35,7 +35,10 @@ struct dc_rbstream_t {
 	unsigned int address;
 	unsigned int available;
 	unsigned int skip;
-	unsigned char cache[];
+	unsigned int window;
+	unsigned int cachesize;
+	unsigned char *cache;
+	dc_rbstream_stats_t stats;
 };
 
 static unsigned int
@@ -85,12 +88,19 @@ dc_rbstream_new (dc_rbstream_t **out, dc_device_t *device, unsigned int pagesize
 	}
 
 	// Allocate memory.
-	rbstream = (dc_rbstream_t *) malloc (sizeof(*rbstream) + packetsize);
+	rbstream = (dc_rbstream_t *) malloc (sizeof(*rbstream));
 	if (rbstream == NULL) {
 		ERROR (device->context, "Failed to allocate memory.");
 		return DC_STATUS_NOMEMORY;
 	}
 
+	rbstream->cache = (unsigned char *) malloc (packetsize);
+	if (rbstream->cache == NULL) {
+		ERROR (device->context, "Failed to allocate memory.");
+		free (rbstream);
+		return DC_STATUS_NOMEMORY;
+	}
+
 	rbstream->device = device;
 	rbstream->pagesize = pagesize;
 	rbstream->packetsize = packetsize;
@@ -99,12 +109,40 @@ dc_rbstream_new (dc_rbstream_t **out, dc_device_t *device, unsigned int pagesize
 	rbstream->address = iceil(address, pagesize);
 	rbstream->available = 0;
 	rbstream->skip = rbstream->address - address;
+	rbstream->window = packetsize;
+	rbstream->cachesize = packetsize;
+	memset (&rbstream->stats, 0, sizeof (rbstream->stats));
 
 	*out = rbstream;
 
 	return DC_STATUS_SUCCESS;
 }
 
+dc_status_t
+dc_rbstream_set_readahead (dc_rbstream_t *rbstream, unsigned int npackets)
+{
+	if (rbstream == NULL || npackets == 0)
+		return DC_STATUS_INVALIDARGS;
+
+	unsigned int window = npackets * rbstream->packetsize;
+
+	// The cache never shrinks, to preserve any data that is still
+	// available in it.
+	if (window > rbstream->cachesize) {
+		unsigned char *cache = (unsigned char *) realloc (rbstream->cache, window);
+		if (cache == NULL) {
+			ERROR (rbstream->device->context, "Failed to allocate memory.");
+			return DC_STATUS_NOMEMORY;
+		}
+		rbstream->cache = cache;
+		rbstream->cachesize = window;
+	}
+
+	rbstream->window = window;
+
+	return DC_STATUS_SUCCESS;
+}
+
 dc_status_t
 dc_rbstream_read (dc_rbstream_t *rbstream, dc_event_progress_t *progress, unsigned char data[], unsigned int size)
 {
@@ -127,17 +165,32 @@ dc_rbstream_read (dc_rbstream_t *rbstream, dc_event_progress_t *progress, unsign
 
 			// Calculate the packet size.
 			unsigned int len = rbstream->packetsize;
-			if (rbstream->begin + len > address)
+			unsigned int count = rbstream->packetsize;
+			if (rbstream->begin + len > address) {
 				len = address - rbstream->begin;
+			} else {
+				// Coalesce the packets needed for the remainder of the
+				// request into a single read. Reading any further ahead
+				// would be wasted when the caller stops at the fingerprint.
+				unsigned int needed = iceil (size - nbytes + skip, rbstream->packetsize);
+				if (needed > rbstream->window)
+					needed = rbstream->window;
+				if (needed > ifloor (address - rbstream->begin, rbstream->packetsize))
+					needed = ifloor (address - rbstream->begin, rbstream->packetsize);
+				len = count = needed;
+			}
 
 			// Move to the begin of the current packet.
 			address -= len;
 
 			// Read the packet into the cache.
-			rc = dc_device_read (rbstream->device, address, rbstream->cache, rbstream->packetsize);
+			rc = dc_device_read (rbstream->device, address, rbstream->cache, count);
 			if (rc != DC_STATUS_SUCCESS)
 				return rc;
 
+			rbstream->stats.requests++;
+			rbstream->stats.bytes += count;
+
 			available = len - skip;
 			skip = 0;
 		}
@@ -151,6 +204,8 @@ dc_rbstream_read (dc_rbstream_t *rbstream, dc_event_progress_t *progress, unsign
 
 		memcpy (data + offset, rbstream->cache + available, length);
 
+		rbstream->stats.used += length;
+
 		// Update and emit a progress event.
 		if (progress) {
 			progress->current += length;
@@ -167,9 +222,28 @@ dc_rbstream_read (dc_rbstream_t *rbstream, dc_event_progress_t *progress, unsign
 	return rc;
 }
 
+dc_status_t
+dc_rbstream_get_stats (dc_rbstream_t *rbstream, dc_rbstream_stats_t *stats)
+{
+	if (rbstream == NULL || stats == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	*stats = rbstream->stats;
+
+	return DC_STATUS_SUCCESS;
+}
+
 dc_status_t
 dc_rbstream_free (dc_rbstream_t *rbstream)
 {
+	if (rbstream == NULL)
+		return DC_STATUS_SUCCESS;
+
+	DEBUG (rbstream->device->context, "Ringbuffer stream: %u requests, %u bytes read, %u bytes wasted.",
+		rbstream->stats.requests, rbstream->stats.bytes,
+		rbstream->stats.bytes - rbstream->stats.used);
+
+	free (rbstream->cache);
 	free (rbstream);
 
 	return DC_STATUS_SUCCESS;
@@ -33,6 +33,15 @@ extern "C" {
  */
 typedef struct dc_rbstream_t dc_rbstream_t;
 
+/**
+ * Statistics of a ringbuffer stream.
+ */
+typedef struct dc_rbstream_stats_t {
+	unsigned int requests; /* Number of reads sent to the device */
+	unsigned int bytes;    /* Number of bytes read from the device */
+	unsigned int used;     /* Number of bytes returned to the caller */
+} dc_rbstream_stats_t;
+
 /**
  * Create a new ringbuffer stream.
  *
@@ -49,6 +58,23 @@ typedef struct dc_rbstream_t dc_rbstream_t;
 dc_status_t
 dc_rbstream_new (dc_rbstream_t **rbstream, dc_device_t *device, unsigned int pagesize, unsigned int packetsize, unsigned int begin, unsigned int end, unsigned int address);
 
+/**
+ * Set the maximum number of packets to read at once.
+ *
+ * When a read spans several packets, the packets are combined into a
+ * single read of the device, up to the given number of packets. Only
+ * the packets that are needed for the current read are fetched, so a
+ * download that stops early (e.g. at the fingerprint) reads exactly the
+ * same data as with single packets. The default is a single packet.
+ *
+ * @param[in]  rbstream  A valid ringbuffer stream.
+ * @param[in]  npackets  The maximum number of packets.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_rbstream_set_readahead (dc_rbstream_t *rbstream, unsigned int npackets);
+
 /**
  * Read data from the ringbuffer stream.
  *
@@ -62,6 +88,19 @@ dc_rbstream_new (dc_rbstream_t **rbstream, dc_device_t *device, unsigned int pag
 dc_status_t
 dc_rbstream_read (dc_rbstream_t *rbstream, dc_event_progress_t *progress, unsigned char data[], unsigned int size);
 
+/**
+ * Get the statistics of the ringbuffer stream. The difference between
+ * the number of bytes read and the number of bytes used is the amount
+ * of data that was read in vain, so far.
+ *
+ * @param[in]  rbstream  A valid ringbuffer stream.
+ * @param[out] stats     A location to store the statistics.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_rbstream_get_stats (dc_rbstream_t *rbstream, dc_rbstream_stats_t *stats);
+
 /**
  * Destroy the ringbuffer stream.
  *
@@ -49,6 +49,7 @@ struct reefnet_sensus_parser_t {
 };
 
 static dc_status_t reefnet_sensus_parser_set_data (dc_parser_t *abstract, const unsigned char *data, unsigned int size);
+static dc_status_t reefnet_sensus_parser_set_clock (dc_parser_t *abstract, unsigned int devtime, dc_ticks_t systime);
 static dc_status_t reefnet_sensus_parser_get_datetime (dc_parser_t *abstract, dc_datetime_t *datetime);
 static dc_status_t reefnet_sensus_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsigned int flags, void *value);
 static dc_status_t reefnet_sensus_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata);
@@ -57,9 +58,13 @@ static const dc_parser_vtable_t reefnet_sensus_parser_vtable = {
 	sizeof(reefnet_sensus_parser_t),
 	DC_FAMILY_REEFNET_SENSUS,
 	reefnet_sensus_parser_set_data, /* set_data */
+	reefnet_sensus_parser_set_clock, /* set_clock */
 	reefnet_sensus_parser_get_datetime, /* datetime */
 	reefnet_sensus_parser_get_field, /* fields */
 	reefnet_sensus_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -108,6 +113,18 @@ reefnet_sensus_parser_set_data (dc_parser_t *abstract, const unsigned char *data
 }
 
 
+static dc_status_t
+reefnet_sensus_parser_set_clock (dc_parser_t *abstract, unsigned int devtime, dc_ticks_t systime)
+{
+	reefnet_sensus_parser_t *parser = (reefnet_sensus_parser_t *) abstract;
+
+	parser->devtime = devtime;
+	parser->systime = systime;
+
+	return DC_STATUS_SUCCESS;
+}
+
+
 dc_status_t
 reefnet_sensus_parser_set_calibration (dc_parser_t *abstract, double atmospheric, double hydrostatic)
 {
@@ -151,6 +168,9 @@ reefnet_sensus_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, un
 		return DC_STATUS_DATAFORMAT;
 
 	if (!parser->cached) {
+		if (abstract->headeronly)
+			return DC_STATUS_UNSUPPORTED;
+
 		const unsigned char *data = abstract->data;
 		unsigned int size = abstract->size;
 
@@ -30,6 +30,7 @@
 #include <fcntl.h>	// fcntl
 #include <termios.h>	// tcgetattr, tcsetattr, cfsetispeed, cfsetospeed, tcflush, tcsendbreak
 #include <sys/ioctl.h>	// ioctl
+#include <poll.h>	// poll
 #include <time.h>	// nanosleep
 #ifdef HAVE_LINUX_SERIAL_H
 #include <linux/serial.h>
@@ -74,8 +75,11 @@ static dc_status_t dc_serial_get_lines (dc_iostream_t *iostream, unsigned int *v
 static dc_status_t dc_serial_get_available (dc_iostream_t *iostream, size_t *value);
 static dc_status_t dc_serial_configure (dc_iostream_t *iostream, unsigned int baudrate, unsigned int databits, dc_parity_t parity, dc_stopbits_t stopbits, dc_flowcontrol_t flowcontrol);
 static dc_status_t dc_serial_poll (dc_iostream_t *iostream, int timeout);
+static dc_status_t dc_serial_get_fd (dc_iostream_t *iostream, int *fd);
 static dc_status_t dc_serial_read (dc_iostream_t *iostream, void *data, size_t size, size_t *actual);
 static dc_status_t dc_serial_write (dc_iostream_t *iostream, const void *data, size_t size, size_t *actual);
+static dc_status_t dc_serial_read_nonblock (dc_iostream_t *iostream, void *data, size_t size, size_t *actual);
+static dc_status_t dc_serial_write_nonblock (dc_iostream_t *iostream, const void *data, size_t size, size_t *actual);
 static dc_status_t dc_serial_ioctl (dc_iostream_t *iostream, unsigned int request, void *data, size_t size);
 static dc_status_t dc_serial_flush (dc_iostream_t *iostream);
 static dc_status_t dc_serial_purge (dc_iostream_t *iostream, dc_direction_t direction);
@@ -100,6 +104,14 @@ typedef struct dc_serial_t {
 	int fd;
 	int timeout;
 	dc_timer_t *timer;
+	/*
+	 * With deferred draining, waiting until the output has been
+	 * transmitted is postponed until it really matters (e.g. before
+	 * changing the modem lines or sleeping), instead of after every
+	 * single write.
+	 */
+	unsigned int deferred;
+	unsigned int pending;
 	/*
 	 * Serial port settings are saved into this variable immediately
 	 * after the port is opened. These settings are restored when the
@@ -124,8 +136,11 @@ static const dc_iostream_vtable_t dc_serial_vtable = {
 	dc_serial_get_available, /* get_available */
 	dc_serial_configure, /* configure */
 	dc_serial_poll, /* poll */
+	dc_serial_get_fd, /* get_fd */
 	dc_serial_read, /* read */
 	dc_serial_write, /* write */
+	dc_serial_read_nonblock, /* read_nonblock */
+	dc_serial_write_nonblock, /* write_nonblock */
 	dc_serial_ioctl, /* ioctl */
 	dc_serial_flush, /* flush */
 	dc_serial_purge, /* purge */
@@ -282,6 +297,10 @@ dc_serial_open (dc_iostream_t **out, dc_context_t *context, const char *name)
 	// Default to blocking reads.
 	device->timeout = -1;
 
+	// Default to draining after every write.
+	device->deferred = 0;
+	device->pending = 0;
+
 	// Create a high resolution timer.
 	status = dc_timer_new (&device->timer);
 	if (status != DC_STATUS_SUCCESS) {
@@ -333,12 +352,40 @@ error_free:
 	return status;
 }
 
+static dc_status_t
+dc_serial_drain (dc_serial_t *device)
+{
+	if (!device->pending)
+		return DC_STATUS_SUCCESS;
+
+	// Wait until all data has been transmitted.
+#ifdef __ANDROID__
+	/* Android is missing tcdrain, so use ioctl version instead */
+	while (ioctl (device->fd, TCSBRK, 1) != 0) {
+#else
+	while (tcdrain (device->fd) != 0) {
+#endif
+		int errcode = errno;
+		if (errcode != EINTR ) {
+			SYSERROR (device->base.context, errcode);
+			return syserror (errcode);
+		}
+	}
+
+	device->pending = 0;
+
+	return DC_STATUS_SUCCESS;
+}
+
 static dc_status_t
 dc_serial_close (dc_iostream_t *abstract)
 {
 	dc_status_t status = DC_STATUS_SUCCESS;
 	dc_serial_t *device = (dc_serial_t *) abstract;
 
+	// Transmit any remaining data.
+	dc_status_set_error(&status, dc_serial_drain (device));
+
 	// Restore the initial terminal attributes.
 	if (tcsetattr (device->fd, TCSANOW, &device->tty) != 0) {
 		int errcode = errno;
@@ -372,6 +419,12 @@ dc_serial_configure (dc_iostream_t *abstract, unsigned int baudrate, unsigned in
 {
 	dc_serial_t *device = (dc_serial_t *) abstract;
 
+	// Changing the settings while data is still being transmitted
+	// corrupts the pending output.
+	dc_status_t status = dc_serial_drain (device);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
 	// Retrieve the current settings.
 	struct termios tty;
 	memset (&tty, 0, sizeof (tty));
@@ -666,33 +719,39 @@ dc_serial_set_latency (dc_iostream_t *abstract, unsigned int milliseconds)
 }
 
 static dc_status_t
-dc_serial_poll (dc_iostream_t *abstract, int timeout)
+dc_serial_set_deferred_drain (dc_iostream_t *abstract, unsigned int value)
 {
 	dc_serial_t *device = (dc_serial_t *) abstract;
-	int rc = 0;
 
-	do {
-		fd_set fds;
-		FD_ZERO (&fds);
-		FD_SET (device->fd, &fds);
+	// Returning to the draining after every write, so anything that is
+	// still pending must be drained now.
+	if (!value) {
+		dc_status_t status = dc_serial_drain (device);
+		if (status != DC_STATUS_SUCCESS)
+			return status;
+	}
 
-		struct timeval tv, *ptv = NULL;
-		if (timeout > 0) {
-			tv.tv_sec  = (timeout / 1000);
-			tv.tv_usec = (timeout % 1000) * 1000;
-			ptv = &tv;
-		} else if (timeout == 0) {
-			tv.tv_sec  = 0;
-			tv.tv_usec = 0;
-			ptv = &tv;
-		}
+	device->deferred = (value != 0);
+
+	return DC_STATUS_SUCCESS;
+}
 
-		rc = select (device->fd + 1, &fds, NULL, NULL, ptv);
+static dc_status_t
+dc_serial_wait (dc_serial_t *device, short events, int timeout)
+{
+	struct pollfd pfd;
+	pfd.fd = device->fd;
+	pfd.events = events;
+	pfd.revents = 0;
+
+	int rc = 0;
+	do {
+		rc = poll (&pfd, 1, timeout);
 	} while (rc < 0 && errno == EINTR);
 
 	if (rc < 0) {
 		int errcode = errno;
-		SYSERROR (abstract->context, errcode);
+		SYSERROR (device->base.context, errcode);
 		return syserror (errcode);
 	} else if (rc == 0) {
 		return DC_STATUS_TIMEOUT;
@@ -702,7 +761,25 @@ dc_serial_poll (dc_iostream_t *abstract, int timeout)
 }
 
 static dc_status_t
-dc_serial_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual)
+dc_serial_poll (dc_iostream_t *abstract, int timeout)
+{
+	dc_serial_t *device = (dc_serial_t *) abstract;
+
+	return dc_serial_wait (device, POLLIN, timeout < 0 ? -1 : timeout);
+}
+
+static dc_status_t
+dc_serial_get_fd (dc_iostream_t *abstract, int *fd)
+{
+	dc_serial_t *device = (dc_serial_t *) abstract;
+
+	*fd = device->fd;
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+dc_serial_read_internal (dc_iostream_t *abstract, void *data, size_t size, int timeout, size_t *actual)
 {
 	dc_status_t status = DC_STATUS_SUCCESS;
 	dc_serial_t *device = (dc_serial_t *) abstract;
@@ -713,13 +790,30 @@ dc_serial_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual
 
 	int init = 1;
 	while (nbytes < size) {
-		fd_set fds;
-		FD_ZERO (&fds);
-		FD_SET (device->fd, &fds);
+		// The file descriptor is in non-blocking mode, so try to read
+		// first. Data that has already arrived is returned without
+		// waiting, which saves a system call for every chunk.
+		ssize_t n = read (device->fd, (char *) data + nbytes, size - nbytes);
+		if (n > 0) {
+			nbytes += n;
+			continue;
+		} else if (n == 0) {
+			break; // EOF.
+		}
 
-		struct timeval tv, *ptv = NULL;
-		if (device->timeout > 0) {
-			dc_usecs_t timeout = 0;
+		int errcode = errno;
+		if (errcode == EINTR)
+			continue; // Retry.
+		if (errcode != EAGAIN) {
+			SYSERROR (abstract->context, errcode);
+			status = syserror (errcode);
+			goto out;
+		}
+
+		// Wait for more data to arrive.
+		int ms = -1;
+		if (timeout > 0) {
+			dc_usecs_t remaining = 0;
 
 			dc_usecs_t now = 0;
 			status = dc_timer_now (device->timer, &now);
@@ -729,52 +823,31 @@ dc_serial_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual
 
 			if (init) {
 				// Calculate the initial timeout.
-				timeout = (dc_usecs_t) device->timeout * 1000;
+				remaining = (dc_usecs_t) timeout * 1000;
 				// Calculate the target time.
-				target = now + timeout;
+				target = now + remaining;
 				init = 0;
 			} else {
 				// Calculate the remaining timeout.
 				if (now < target) {
-					timeout = target - now;
+					remaining = target - now;
 				} else {
-					timeout = 0;
+					remaining = 0;
 				}
 			}
-			tv.tv_sec  = timeout / 1000000;
-			tv.tv_usec = timeout % 1000000;
-			ptv = &tv;
-		} else if (device->timeout == 0) {
-			tv.tv_sec  = 0;
-			tv.tv_usec = 0;
-			ptv = &tv;
+			// Round up to avoid busy looping on the last millisecond.
+			ms = (int) ((remaining + 999) / 1000);
+		} else if (timeout == 0) {
+			ms = 0;
 		}
 
-		int rc = select (device->fd + 1, &fds, NULL, NULL, ptv);
-		if (rc < 0) {
-			int errcode = errno;
-			if (errcode == EINTR)
-				continue; // Retry.
-			SYSERROR (abstract->context, errcode);
-			status = syserror (errcode);
-			goto out;
-		} else if (rc == 0) {
+		status = dc_serial_wait (device, POLLIN, ms);
+		if (status == DC_STATUS_TIMEOUT) {
+			status = DC_STATUS_SUCCESS;
 			break; // Timeout.
-		}
-
-		ssize_t n = read (device->fd, (char *) data + nbytes, size - nbytes);
-		if (n < 0) {
-			int errcode = errno;
-			if (errcode == EINTR || errcode == EAGAIN)
-				continue; // Retry.
-			SYSERROR (abstract->context, errcode);
-			status = syserror (errcode);
+		} else if (status != DC_STATUS_SUCCESS) {
 			goto out;
-		} else if (n == 0) {
-			 break; // EOF.
 		}
-
-		nbytes += n;
 	}
 
 	if (nbytes != size) {
@@ -789,57 +862,66 @@ out:
 }
 
 static dc_status_t
-dc_serial_write (dc_iostream_t *abstract, const void *data, size_t size, size_t *actual)
+dc_serial_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual)
+{
+	dc_serial_t *device = (dc_serial_t *) abstract;
+
+	return dc_serial_read_internal (abstract, data, size, device->timeout, actual);
+}
+
+static dc_status_t
+dc_serial_read_nonblock (dc_iostream_t *abstract, void *data, size_t size, size_t *actual)
+{
+	return dc_serial_read_internal (abstract, data, size, 0, actual);
+}
+
+static dc_status_t
+dc_serial_write_internal (dc_iostream_t *abstract, const void *data, size_t size, int blocking, size_t *actual)
 {
 	dc_status_t status = DC_STATUS_SUCCESS;
 	dc_serial_t *device = (dc_serial_t *) abstract;
 	size_t nbytes = 0;
 
 	while (nbytes < size) {
-		fd_set fds;
-		FD_ZERO (&fds);
-		FD_SET (device->fd, &fds);
+		ssize_t n = write (device->fd, (const char *) data + nbytes, size - nbytes);
+		if (n > 0) {
+			nbytes += n;
+			device->pending = 1;
+			continue;
+		} else if (n == 0) {
+			break; // EOF.
+		}
 
-		int rc = select (device->fd + 1, NULL, &fds, NULL, NULL);
-		if (rc < 0) {
-			int errcode = errno;
-			if (errcode == EINTR)
-				continue; // Retry.
+		int errcode = errno;
+		if (errcode == EINTR)
+			continue; // Retry.
+		if (errcode != EAGAIN) {
 			SYSERROR (abstract->context, errcode);
 			status = syserror (errcode);
 			goto out;
-		} else if (rc == 0) {
-			break; // Timeout.
 		}
 
-		ssize_t n = write (device->fd, (const char *) data + nbytes, size - nbytes);
-		if (n < 0) {
-			int errcode = errno;
-			if (errcode == EINTR || errcode == EAGAIN)
-				continue; // Retry.
-			SYSERROR (abstract->context, errcode);
-			status = syserror (errcode);
+		// Wait until there is room in the output buffer.
+		status = dc_serial_wait (device, POLLOUT, blocking ? -1 : 0);
+		if (status == DC_STATUS_TIMEOUT) {
+			status = DC_STATUS_SUCCESS;
+			break; // Output buffer full.
+		} else if (status != DC_STATUS_SUCCESS) {
 			goto out;
-		} else if (n == 0) {
-			 break; // EOF.
 		}
-
-		nbytes += n;
 	}
 
-	// Wait until all data has been transmitted.
-#ifdef __ANDROID__
-	/* Android is missing tcdrain, so use ioctl version instead */
-	while (ioctl (device->fd, TCSBRK, 1) != 0) {
-#else
-	while (tcdrain (device->fd) != 0) {
-#endif
-		int errcode = errno;
-		if (errcode != EINTR ) {
-			SYSERROR (abstract->context, errcode);
-			status = syserror (errcode);
-			goto out;
+	if (!blocking) {
+		if (nbytes != size) {
+			status = DC_STATUS_TIMEOUT;
 		}
+		goto out;
+	}
+
+	// Wait until all data has been transmitted, unless that has been
+	// postponed with the deferred draining.
+	if (!device->deferred) {
+		status = dc_serial_drain (device);
 	}
 
 out:
@@ -849,12 +931,26 @@ out:
 	return status;
 }
 
+static dc_status_t
+dc_serial_write (dc_iostream_t *abstract, const void *data, size_t size, size_t *actual)
+{
+	return dc_serial_write_internal (abstract, data, size, 1, actual);
+}
+
+static dc_status_t
+dc_serial_write_nonblock (dc_iostream_t *abstract, const void *data, size_t size, size_t *actual)
+{
+	return dc_serial_write_internal (abstract, data, size, 0, actual);
+}
+
 static dc_status_t
 dc_serial_ioctl (dc_iostream_t *abstract, unsigned int request, void *data, size_t size)
 {
 	switch (request) {
 	case DC_IOCTL_SERIAL_SET_LATENCY:
 		return dc_serial_set_latency (abstract, *(unsigned int *) data);
+	case DC_IOCTL_SERIAL_SET_DEFERRED_DRAIN:
+		return dc_serial_set_deferred_drain (abstract, *(unsigned int *) data);
 	default:
 		return DC_STATUS_UNSUPPORTED;
 	}
@@ -887,13 +983,19 @@ dc_serial_purge (dc_iostream_t *abstract, dc_direction_t direction)
 		return syserror (errcode);
 	}
 
+	if (direction & DC_DIRECTION_OUTPUT) {
+		device->pending = 0;
+	}
+
 	return DC_STATUS_SUCCESS;
 }
 
 static dc_status_t
 dc_serial_flush (dc_iostream_t *abstract)
 {
-	return DC_STATUS_SUCCESS;
+	dc_serial_t *device = (dc_serial_t *) abstract;
+
+	return dc_serial_drain (device);
 }
 
 static dc_status_t
@@ -901,6 +1003,10 @@ dc_serial_set_break (dc_iostream_t *abstract, unsigned int level)
 {
 	dc_serial_t *device = (dc_serial_t *) abstract;
 
+	dc_status_t status = dc_serial_drain (device);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
 	unsigned long action = (level ? TIOCSBRK : TIOCCBRK);
 
 	if (ioctl (device->fd, action, NULL) != 0 && NOPTY) {
@@ -917,6 +1023,10 @@ dc_serial_set_dtr (dc_iostream_t *abstract, unsigned int level)
 {
 	dc_serial_t *device = (dc_serial_t *) abstract;
 
+	dc_status_t status = dc_serial_drain (device);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
 	unsigned long action = (level ? TIOCMBIS : TIOCMBIC);
 
 	int value = TIOCM_DTR;
@@ -934,6 +1044,10 @@ dc_serial_set_rts (dc_iostream_t *abstract, unsigned int level)
 {
 	dc_serial_t *device = (dc_serial_t *) abstract;
 
+	dc_status_t status = dc_serial_drain (device);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
 	unsigned long action = (level ? TIOCMBIS : TIOCMBIC);
 
 	int value = TIOCM_RTS;
@@ -995,6 +1109,14 @@ dc_serial_get_lines (dc_iostream_t *abstract, unsigned int *value)
 static dc_status_t
 dc_serial_sleep (dc_iostream_t *abstract, unsigned int timeout)
 {
+	dc_serial_t *device = (dc_serial_t *) abstract;
+
+	// Drivers sleep to respect the protocol timing, which is relative to
+	// the end of the transmission.
+	dc_status_t status = dc_serial_drain (device);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
 	struct timespec ts;
 	ts.tv_sec  = (timeout / 1000);
 	ts.tv_nsec = (timeout % 1000) * 1000000;
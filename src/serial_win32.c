@@ -99,8 +99,11 @@ static const dc_iostream_vtable_t dc_serial_vtable = {
 	dc_serial_get_available, /* get_available */
 	dc_serial_configure, /* configure */
 	dc_serial_poll, /* poll */
+	NULL, /* get_fd */
 	dc_serial_read, /* read */
 	dc_serial_write, /* write */
+	NULL, /* read_nonblock */
+	NULL, /* write_nonblock */
 	dc_serial_ioctl, /* ioctl */
 	dc_serial_flush, /* flush */
 	dc_serial_purge, /* purge */
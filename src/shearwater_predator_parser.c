@@ -20,6 +20,7 @@
  */
 
 #include <stdlib.h>
+#include <limits.h>
 
 #include <libdivecomputer/units.h>
 
@@ -114,22 +115,30 @@ struct shearwater_predator_parser_t {
 	unsigned int units;
 	unsigned int atmospheric;
 	unsigned int density;
+	dc_sample_index_t index;
 };
 
 static dc_status_t shearwater_predator_parser_set_data (dc_parser_t *abstract, const unsigned char *data, unsigned int size);
 static dc_status_t shearwater_predator_parser_get_datetime (dc_parser_t *abstract, dc_datetime_t *datetime);
 static dc_status_t shearwater_predator_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsigned int flags, void *value);
 static dc_status_t shearwater_predator_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata);
+static dc_status_t shearwater_predator_parser_samples_batch (dc_parser_t *abstract, dc_sample_table_t *table);
+static dc_status_t shearwater_predator_parser_samples_range (dc_parser_t *abstract, unsigned int begin, unsigned int end, dc_sample_callback_t callback, void *userdata);
 
 static dc_status_t shearwater_predator_parser_cache (shearwater_predator_parser_t *parser);
+static dc_status_t shearwater_predator_parser_cache_header (shearwater_predator_parser_t *parser);
 
 static const dc_parser_vtable_t shearwater_predator_parser_vtable = {
 	sizeof(shearwater_predator_parser_t),
 	DC_FAMILY_SHEARWATER_PREDATOR,
 	shearwater_predator_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	shearwater_predator_parser_get_datetime, /* datetime */
 	shearwater_predator_parser_get_field, /* fields */
 	shearwater_predator_parser_samples_foreach, /* samples_foreach */
+	shearwater_predator_parser_samples_batch, /* samples_batch */
+	shearwater_predator_parser_samples_range, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -137,9 +146,13 @@ static const dc_parser_vtable_t shearwater_petrel_parser_vtable = {
 	sizeof(shearwater_predator_parser_t),
 	DC_FAMILY_SHEARWATER_PETREL,
 	shearwater_predator_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	shearwater_predator_parser_get_datetime, /* datetime */
 	shearwater_predator_parser_get_field, /* fields */
 	shearwater_predator_parser_samples_foreach, /* samples_foreach */
+	shearwater_predator_parser_samples_batch, /* samples_batch */
+	shearwater_predator_parser_samples_range, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -217,6 +230,7 @@ shearwater_common_parser_create (dc_parser_t **out, dc_context_t *context, unsig
 	parser->units = METRIC;
 	parser->density = 1025;
 	parser->atmospheric = ATM / (BAR / 1000);
+	dc_sample_index_reset (&parser->index);
 
 	*out = (dc_parser_t *) parser;
 
@@ -274,6 +288,7 @@ shearwater_predator_parser_set_data (dc_parser_t *abstract, const unsigned char
 	parser->units = METRIC;
 	parser->density = 1025;
 	parser->atmospheric = ATM / (BAR / 1000);
+	dc_sample_index_reset (&parser->index);
 
 	return DC_STATUS_SUCCESS;
 }
@@ -286,7 +301,9 @@ shearwater_predator_parser_get_datetime (dc_parser_t *abstract, dc_datetime_t *d
 	const unsigned char *data = abstract->data;
 
 	// Cache the parser data.
-	dc_status_t rc = shearwater_predator_parser_cache (parser);
+	dc_status_t rc = abstract->headeronly ?
+		shearwater_predator_parser_cache_header (parser) :
+		shearwater_predator_parser_cache (parser);
 	if (rc != DC_STATUS_SUCCESS)
 		return rc;
 
@@ -532,6 +549,82 @@ shearwater_predator_parser_cache (shearwater_predator_parser_t *parser)
 	return DC_STATUS_SUCCESS;
 }
 
+static dc_status_t
+shearwater_predator_parser_cache_header (shearwater_predator_parser_t *parser)
+{
+	dc_parser_t *abstract = (dc_parser_t *) parser;
+	const unsigned char *data = parser->base.data;
+	unsigned int size = parser->base.size;
+
+	if (parser->cached) {
+		return DC_STATUS_SUCCESS;
+	}
+
+	// Verify the minimum length.
+	if (size < 2) {
+		ERROR (abstract->context, "Invalid data length.");
+		return DC_STATUS_DATAFORMAT;
+	}
+
+	// Locate the first opening and closing record, without walking over
+	// all the samples. Only these two records are stored in the cache,
+	// and the cached flag remains cleared.
+	unsigned int pnf = parser->petrel ? array_uint16_be (data) != 0xFFFF : 0;
+	unsigned int opening = UNDEFINED, closing = UNDEFINED;
+	if (!pnf) {
+		unsigned int footersize = SZ_BLOCK;
+		if (size < SZ_BLOCK + footersize) {
+			ERROR (abstract->context, "Invalid data length.");
+			return DC_STATUS_DATAFORMAT;
+		}
+
+		if (parser->petrel || array_uint16_be (data + size - footersize) == 0xFFFD) {
+			footersize += SZ_BLOCK;
+			if (size < SZ_BLOCK + footersize) {
+				ERROR (abstract->context, "Invalid data length.");
+				return DC_STATUS_DATAFORMAT;
+			}
+		}
+
+		opening = 0;
+		closing = size - footersize;
+	} else {
+		// The opening records are stored before the first sample, and
+		// the closing records after the last sample.
+		unsigned int count = size / parser->samplesize;
+		for (unsigned int i = 0; i < count; ++i) {
+			unsigned int type = data[i * parser->samplesize];
+			if (type == LOG_RECORD_OPENING_0) {
+				opening = i * parser->samplesize;
+				break;
+			}
+			if (type == LOG_RECORD_DIVE_SAMPLE || type == LOG_RECORD_FREEDIVE_SAMPLE)
+				break;
+		}
+		for (unsigned int i = count; i > 0; --i) {
+			unsigned int type = data[(i - 1) * parser->samplesize];
+			if (type == LOG_RECORD_CLOSING_0) {
+				closing = (i - 1) * parser->samplesize;
+				break;
+			}
+			if (type == LOG_RECORD_DIVE_SAMPLE || type == LOG_RECORD_FREEDIVE_SAMPLE)
+				break;
+		}
+	}
+
+	if (opening == UNDEFINED || closing == UNDEFINED) {
+		ERROR (abstract->context, "Opening or closing record not found.");
+		return DC_STATUS_DATAFORMAT;
+	}
+
+	parser->pnf = pnf;
+	parser->opening[0] = opening;
+	parser->closing[0] = closing;
+	parser->units = data[opening + 8];
+
+	return DC_STATUS_SUCCESS;
+}
+
 static dc_status_t
 shearwater_predator_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsigned int flags, void *value)
 {
@@ -540,10 +633,17 @@ shearwater_predator_parser_get_field (dc_parser_t *abstract, dc_field_type_t typ
 	const unsigned char *data = abstract->data;
 
 	// Cache the parser data.
-	dc_status_t rc = shearwater_predator_parser_cache (parser);
+	dc_status_t rc = abstract->headeronly ?
+		shearwater_predator_parser_cache_header (parser) :
+		shearwater_predator_parser_cache (parser);
 	if (rc != DC_STATUS_SUCCESS)
 		return rc;
 
+	// Without the full cache, only the fields from the first opening
+	// and closing record are available.
+	if (!parser->cached && type != DC_FIELD_DIVETIME && type != DC_FIELD_MAXDEPTH)
+		return DC_STATUS_UNSUPPORTED;
+
 	dc_gasmix_t *gasmix = (dc_gasmix_t *) value;
 	dc_tank_t *tank = (dc_tank_t *) value;
 	dc_salinity_t *water = (dc_salinity_t *) value;
@@ -606,7 +706,7 @@ shearwater_predator_parser_get_field (dc_parser_t *abstract, dc_field_type_t typ
 
 
 static dc_status_t
-shearwater_predator_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata)
+shearwater_predator_parser_samples (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata, dc_sample_table_t *table, unsigned int begin, unsigned int end)
 {
 	shearwater_predator_parser_t *parser = (shearwater_predator_parser_t *) abstract;
 
@@ -636,9 +736,28 @@ shearwater_predator_parser_samples_foreach (dc_parser_t *abstract, dc_sample_cal
 	unsigned int pnf = parser->pnf;
 	unsigned int offset = parser->headersize;
 	unsigned int length = size - parser->footersize;
+
+	// Resume from the last checkpoint before the start of the range.
+	const dc_sample_checkpoint_t *checkpoint = dc_sample_index_find (&parser->index, begin);
+	if (checkpoint) {
+		time = checkpoint->time;
+		offset = checkpoint->offset;
+		o2_previous = checkpoint->state[0];
+		he_previous = checkpoint->state[1];
+	}
+
 	while (offset + parser->samplesize <= length) {
 		dc_sample_value_t sample = {0};
 
+		if (parser->index.complete) {
+			// Stop after the end of the range.
+			if (time + interval > end)
+				return DC_STATUS_SUCCESS;
+		} else {
+			dc_sample_checkpoint_t cp = {time, offset, {o2_previous, he_previous, 0, 0}};
+			dc_sample_index_add (&parser->index, &cp);
+		}
+
 		// Ignore empty samples.
 		if (array_isequal (data + offset, parser->samplesize, 0x00)) {
 			offset += parser->samplesize;
@@ -652,7 +771,10 @@ shearwater_predator_parser_samples_foreach (dc_parser_t *abstract, dc_sample_cal
 			// Time (seconds).
 			time += interval;
 			sample.time = time;
-			if (callback) callback (DC_SAMPLE_TIME, sample, userdata);
+			if (table)
+				dc_sample_table_time (table, sample.time);
+			else if (callback)
+				callback (DC_SAMPLE_TIME, sample, userdata);
 
 			// Depth (1/10 m or ft).
 			unsigned int depth = array_uint16_be (data + pnf + offset);
@@ -660,7 +782,10 @@ shearwater_predator_parser_samples_foreach (dc_parser_t *abstract, dc_sample_cal
 				sample.depth = depth * FEET / 10.0;
 			else
 				sample.depth = depth / 10.0;
-			if (callback) callback (DC_SAMPLE_DEPTH, sample, userdata);
+			if (table)
+				dc_sample_table_depth (table, sample.depth);
+			else if (callback)
+				callback (DC_SAMPLE_DEPTH, sample, userdata);
 
 			// Temperature (°C or °F).
 			int temperature = (signed char) data[offset + pnf + 13];
@@ -675,7 +800,10 @@ shearwater_predator_parser_samples_foreach (dc_parser_t *abstract, dc_sample_cal
 				sample.temperature = (temperature - 32.0) * (5.0 / 9.0);
 			else
 				sample.temperature = temperature;
-			if (callback) callback (DC_SAMPLE_TEMPERATURE, sample, userdata);
+			if (table)
+				dc_sample_table_temperature (table, sample.temperature);
+			else if (callback)
+				callback (DC_SAMPLE_TEMPERATURE, sample, userdata);
 
 			// Status flags.
 			unsigned int status = data[offset + pnf + 11];
@@ -768,7 +896,10 @@ shearwater_predator_parser_samples_foreach (dc_parser_t *abstract, dc_sample_cal
 						pressure &= 0x0FFF;
 						sample.pressure.tank = parser->tankidx[i];
 						sample.pressure.value = pressure * 2 * PSI / BAR;
-						if (callback) callback (DC_SAMPLE_PRESSURE, sample, userdata);
+						if (table)
+							dc_sample_table_pressure (table, sample.pressure.tank, sample.pressure.value);
+						else if (callback)
+							callback (DC_SAMPLE_PRESSURE, sample, userdata);
 					}
 				}
 
@@ -799,22 +930,51 @@ shearwater_predator_parser_samples_foreach (dc_parser_t *abstract, dc_sample_cal
 				// Time (seconds).
 				time += interval;
 				sample.time = time;
-				if (callback) callback (DC_SAMPLE_TIME, sample, userdata);
+				if (table)
+					dc_sample_table_time (table, sample.time);
+				else if (callback)
+					callback (DC_SAMPLE_TIME, sample, userdata);
 
 				// Depth (absolute pressure in millibar)
 				unsigned int depth = array_uint16_be (data + idx + 1);
 				sample.depth = (depth - parser->atmospheric) * (BAR / 1000.0) / (parser->density * GRAVITY);
-				if (callback) callback (DC_SAMPLE_DEPTH, sample, userdata);
+				if (table)
+					dc_sample_table_depth (table, sample.depth);
+				else if (callback)
+					callback (DC_SAMPLE_DEPTH, sample, userdata);
 
 				// Temperature (1/10 °C).
 				int temperature = (signed short) array_uint16_be (data + idx + 3);
 				sample.temperature = temperature / 10.0;
-				if (callback) callback (DC_SAMPLE_TEMPERATURE, sample, userdata);
+				if (table)
+					dc_sample_table_temperature (table, sample.temperature);
+				else if (callback)
+					callback (DC_SAMPLE_TEMPERATURE, sample, userdata);
 			}
 		}
 
 		offset += parser->samplesize;
 	}
 
+	parser->index.complete = 1;
+
 	return DC_STATUS_SUCCESS;
 }
+
+static dc_status_t
+shearwater_predator_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata)
+{
+	return shearwater_predator_parser_samples (abstract, callback, userdata, NULL, 0, UINT_MAX);
+}
+
+static dc_status_t
+shearwater_predator_parser_samples_batch (dc_parser_t *abstract, dc_sample_table_t *table)
+{
+	return shearwater_predator_parser_samples (abstract, dc_sample_table_cb, table, table, 0, UINT_MAX);
+}
+
+static dc_status_t
+shearwater_predator_parser_samples_range (dc_parser_t *abstract, unsigned int begin, unsigned int end, dc_sample_callback_t callback, void *userdata)
+{
+	return shearwater_predator_parser_samples (abstract, callback, userdata, NULL, begin, end);
+}
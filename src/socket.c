@@ -223,7 +223,21 @@ dc_socket_poll (dc_iostream_t *abstract, int timeout)
 }
 
 dc_status_t
-dc_socket_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual)
+dc_socket_get_fd (dc_iostream_t *abstract, int *fd)
+{
+#ifdef _WIN32
+	return DC_STATUS_UNSUPPORTED;
+#else
+	dc_socket_t *socket = (dc_socket_t *) abstract;
+
+	*fd = socket->fd;
+
+	return DC_STATUS_SUCCESS;
+#endif
+}
+
+static dc_status_t
+dc_socket_read_internal (dc_iostream_t *abstract, void *data, size_t size, int timeout, size_t *actual)
 {
 	dc_status_t status = DC_STATUS_SUCCESS;
 	dc_socket_t *socket = (dc_socket_t *) abstract;
@@ -235,14 +249,14 @@ dc_socket_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual
 		FD_SET (socket->fd, &fds);
 
 		struct timeval tvt;
-		if (socket->timeout > 0) {
-			tvt.tv_sec  = (socket->timeout / 1000);
-			tvt.tv_usec = (socket->timeout % 1000) * 1000;
-		} else if (socket->timeout == 0) {
+		if (timeout > 0) {
+			tvt.tv_sec  = (timeout / 1000);
+			tvt.tv_usec = (timeout % 1000) * 1000;
+		} else if (timeout == 0) {
 			timerclear (&tvt);
 		}
 
-		int rc = select (socket->fd + 1, &fds, NULL, NULL, socket->timeout >= 0 ? &tvt : NULL);
+		int rc = select (socket->fd + 1, &fds, NULL, NULL, timeout >= 0 ? &tvt : NULL);
 		if (rc < 0) {
 			s_errcode_t errcode = S_ERRNO;
 			if (errcode == S_EINTR)
@@ -281,18 +295,42 @@ out:
 }
 
 dc_status_t
-dc_socket_write (dc_iostream_t *abstract, const void *data, size_t size, size_t *actual)
+dc_socket_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual)
+{
+	dc_socket_t *socket = (dc_socket_t *) abstract;
+
+	return dc_socket_read_internal (abstract, data, size, socket->timeout, actual);
+}
+
+dc_status_t
+dc_socket_read_nonblock (dc_iostream_t *abstract, void *data, size_t size, size_t *actual)
+{
+	return dc_socket_read_internal (abstract, data, size, 0, actual);
+}
+
+static dc_status_t
+dc_socket_write_internal (dc_iostream_t *abstract, const void *data, size_t size, int blocking, size_t *actual)
 {
 	dc_status_t status = DC_STATUS_SUCCESS;
 	dc_socket_t *socket = (dc_socket_t *) abstract;
 	size_t nbytes = 0;
+	int flags = 0;
+
+#ifdef MSG_DONTWAIT
+	if (!blocking) {
+		flags |= MSG_DONTWAIT;
+	}
+#endif
 
 	while (nbytes < size) {
 		fd_set fds;
 		FD_ZERO (&fds);
 		FD_SET (socket->fd, &fds);
 
-		int rc = select (socket->fd + 1, NULL, &fds, NULL, NULL);
+		struct timeval tvt;
+		timerclear (&tvt);
+
+		int rc = select (socket->fd + 1, NULL, &fds, NULL, blocking ? NULL : &tvt);
 		if (rc < 0) {
 			s_errcode_t errcode = S_ERRNO;
 			if (errcode == S_EINTR)
@@ -304,9 +342,11 @@ dc_socket_write (dc_iostream_t *abstract, const void *data, size_t size, size_t
 			break; // Timeout.
 		}
 
-		s_ssize_t n = send (socket->fd, (const char *) data + nbytes, size - nbytes, 0);
+		s_ssize_t n = send (socket->fd, (const char *) data + nbytes, size - nbytes, flags);
 		if (n < 0) {
 			s_errcode_t errcode = S_ERRNO;
+			if (errcode == S_EAGAIN && !blocking)
+				break; // Output buffer full.
 			if (errcode == S_EINTR || errcode == S_EAGAIN)
 				continue; // Retry.
 			SYSERROR (abstract->context, errcode);
@@ -330,6 +370,18 @@ out:
 	return status;
 }
 
+dc_status_t
+dc_socket_write (dc_iostream_t *abstract, const void *data, size_t size, size_t *actual)
+{
+	return dc_socket_write_internal (abstract, data, size, 1, actual);
+}
+
+dc_status_t
+dc_socket_write_nonblock (dc_iostream_t *abstract, const void *data, size_t size, size_t *actual)
+{
+	return dc_socket_write_internal (abstract, data, size, 0, actual);
+}
+
 dc_status_t
 dc_socket_ioctl (dc_iostream_t *abstract, unsigned int request, void *data, size_t size)
 {
@@ -111,12 +111,21 @@ dc_socket_get_available (dc_iostream_t *iostream, size_t *value);
 dc_status_t
 dc_socket_poll (dc_iostream_t *iostream, int timeout);
 
+dc_status_t
+dc_socket_get_fd (dc_iostream_t *iostream, int *fd);
+
 dc_status_t
 dc_socket_read (dc_iostream_t *iostream, void *data, size_t size, size_t *actual);
 
 dc_status_t
 dc_socket_write (dc_iostream_t *iostream, const void *data, size_t size, size_t *actual);
 
+dc_status_t
+dc_socket_read_nonblock (dc_iostream_t *iostream, void *data, size_t size, size_t *actual);
+
+dc_status_t
+dc_socket_write_nonblock (dc_iostream_t *iostream, const void *data, size_t size, size_t *actual);
+
 dc_status_t
 dc_socket_ioctl (dc_iostream_t *iostream, unsigned int request, void *data, size_t size);
 
@@ -52,9 +52,13 @@ static const dc_parser_vtable_t suunto_eon_parser_vtable = {
 	sizeof(suunto_eon_parser_t),
 	DC_FAMILY_SUUNTO_EON,
 	suunto_eon_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	suunto_eon_parser_get_datetime, /* datetime */
 	suunto_eon_parser_get_field, /* fields */
 	suunto_eon_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -192,6 +196,10 @@ suunto_eon_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsign
 
 	const unsigned char *data = abstract->data;
 
+	// The marker is only found by walking the samples.
+	if (!parser->cached && abstract->headeronly)
+		return DC_STATUS_UNSUPPORTED;
+
 	// Cache the data.
 	dc_status_t rc = suunto_eon_parser_cache (parser);
 	if (rc != DC_STATUS_SUCCESS)
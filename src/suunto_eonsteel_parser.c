@@ -63,18 +63,29 @@ enum eon_sample {
 
 #define EON_MAX_GROUP 16
 
+#define EON_MAX_ENUM 100
+
 struct type_desc {
+	char *text;
+	// Described by the current dive
+	unsigned int active;
 	char *desc, *format, *mod;
 	unsigned int size;
 	enum eon_sample type[EON_MAX_GROUP];
+	// Enumeration strings, split once from the format
+	char *enumtext;
+	const char **enums;
 };
 
 #define MAXTYPE 512
 #define MAXGASES 16
+#define TYPEHASH 64
 
 typedef struct suunto_eonsteel_parser_t {
 	dc_parser_t base;
 	struct type_desc type_desc[MAXTYPE];
+	// type_translation index (plus one) by name hash
+	unsigned char typehash[TYPEHASH];
 	// field cache
 	struct {
 		unsigned int initialized;
@@ -135,9 +146,38 @@ static const struct {
 	{ "Events.DiveTimer.Time",		ES_none },
 };
 
+static unsigned int hash_type_name(const char *name)
+{
+	unsigned int hash = 2166136261u;
+
+	while (*name) {
+		hash ^= (unsigned char) *name++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/*
+ * Build the open addressing hash table over the type_translation
+ * names, so the descriptor lookup costs a single string compare.
+ */
+static void init_type_hash(suunto_eonsteel_parser_t *eon)
+{
+	unsigned int i;
+
+	memset(eon->typehash, 0, sizeof(eon->typehash));
+	for (i = 0; i < C_ARRAY_SIZE(type_translation); i++) {
+		unsigned int slot = hash_type_name(type_translation[i].name) % TYPEHASH;
+
+		while (eon->typehash[slot])
+			slot = (slot + 1) % TYPEHASH;
+		eon->typehash[slot] = i + 1;
+	}
+}
+
 static enum eon_sample lookup_descriptor_type(suunto_eonsteel_parser_t *eon, struct type_desc *desc)
 {
-	int i;
+	unsigned int slot;
 	const char *name = desc->desc;
 
 	// Not a sample type? Skip it
@@ -160,15 +200,21 @@ static enum eon_sample lookup_descriptor_type(suunto_eonsteel_parser_t *eon, str
 	name += 8;
 
 	// .. and look it up in the table of sample type strings
-	for (i = 0; i < C_ARRAY_SIZE(type_translation); i++) {
+	slot = hash_type_name(name) % TYPEHASH;
+	while (eon->typehash[slot]) {
+		unsigned int i = eon->typehash[slot] - 1;
 		if (!strcmp(name, type_translation[i].name))
 			return type_translation[i].type;
+		slot = (slot + 1) % TYPEHASH;
 	}
 	return ES_none;
 }
 
 static parser_sample_event_t lookup_event(const char *name, const eon_event_t events[], size_t n)
 {
+	if (!name)
+		return SAMPLE_EVENT_NONE;
+
 	for (size_t i = 0; i < n; ++i) {
 		if (!strcasecmp(name, events[i].name))
 			return events[i].type;
@@ -227,7 +273,7 @@ static int fill_in_group_details(suunto_eonsteel_parser_t *eon, struct type_desc
 			break;
 		}
 		base = eon->type_desc + index;
-		if (!base->desc) {
+		if (!base->active || !base->desc) {
 			ERROR(eon->base.context, "Group type descriptor '%s' has undescribed index %ld", desc->desc, index);
 			break;
 		}
@@ -263,6 +309,68 @@ static int fill_in_group_details(suunto_eonsteel_parser_t *eon, struct type_desc
 	return -1;
 }
 
+/*
+ * Split the strings of an enumeration once per descriptor (see
+ * lookup_enum for the format), so that looking up a value when
+ * an event fires is just an array access.
+ */
+static int split_enum(suunto_eonsteel_parser_t *eon, struct type_desc *desc)
+{
+	char *str;
+	unsigned char c;
+
+	if (!desc->format || strncmp(desc->format, "enum:", 5))
+		return 0;
+
+	desc->enumtext = strdup(desc->format + 5);
+	desc->enums = (const char **) calloc(EON_MAX_ENUM, sizeof(*desc->enums));
+	if (!desc->enumtext || !desc->enums) {
+		ERROR(eon->base.context, "out of memory");
+		free(desc->enumtext);
+		free(desc->enums);
+		desc->enumtext = NULL;
+		desc->enums = NULL;
+		return -1;
+	}
+
+	str = desc->enumtext;
+	while ((c = *str) != 0) {
+		unsigned char n;
+		char *begin, *end;
+
+		str++;
+		if (!isdigit(c))
+			continue;
+		n = c - '0';
+
+		// We only handle one or two digits
+		if (isdigit(*str)) {
+			n = n*10 + *str - '0';
+			str++;
+		}
+
+		begin = end = str;
+		while ((c = *str) != 0) {
+			str++;
+			if (c == ',')
+				break;
+			end = str;
+		}
+
+		// Verify that it has the 'n=string' format and skip the equals sign
+		if (*begin != '=')
+			continue;
+		begin++;
+
+		// The scan is already past the separator, so the
+		// string can be terminated in place.
+		*end = 0;
+		if (!desc->enums[n])
+			desc->enums[n] = begin;
+	}
+	return 0;
+}
+
 /*
  * Here we cache descriptor data so that we don't have
  * to re-parse the string all the time. That way we can
@@ -283,16 +391,19 @@ static int fill_in_desc_details(suunto_eonsteel_parser_t *eon, struct type_desc
 
 	desc->size = lookup_descriptor_size(eon, desc);
 	desc->type[0] = lookup_descriptor_type(eon, desc);
-	return 0;
+	return split_enum(eon, desc);
 }
 
 static void
 desc_free (struct type_desc desc[], unsigned int count)
 {
 	for (unsigned int i = 0; i < count; ++i) {
+		free(desc[i].text);
 		free(desc[i].desc);
 		free(desc[i].format);
 		free(desc[i].mod);
+		free(desc[i].enumtext);
+		free(desc[i].enums);
 	}
 }
 
@@ -300,8 +411,27 @@ static int record_type(suunto_eonsteel_parser_t *eon, unsigned short type, const
 {
 	struct type_desc desc;
 	const char *next;
+	size_t textlen = strlen(name);
+
+	// The descriptors are identical for all dives of the same device,
+	// so they only need to be parsed again if the text has changed.
+	// Group descriptors depend on other descriptors, and are always
+	// parsed again.
+	if (type < MAXTYPE && eon->type_desc[type].text &&
+		eon->type_desc[type].desc && !isdigit(eon->type_desc[type].desc[0]) &&
+		!strcmp(eon->type_desc[type].text, name)) {
+		eon->type_desc[type].active = 1;
+		return 0;
+	}
 
 	memset(&desc, 0, sizeof(desc));
+	desc.text = (char *) malloc(textlen + 1);
+	if (!desc.text) {
+		ERROR(eon->base.context, "out of memory");
+		return -1;
+	}
+	memcpy(desc.text, name, textlen + 1);
+
 	do {
 		int len;
 		char *p;
@@ -318,6 +448,7 @@ static int record_type(suunto_eonsteel_parser_t *eon, unsigned short type, const
 
 		if (len < 5 || name[0] != '<' || name[4] != '>') {
 			ERROR(eon->base.context, "Unexpected type description: %.*s", len, name);
+			desc_free(&desc, 1);
 			return -1;
 		}
 		p = (char *) malloc(len-4);
@@ -360,6 +491,7 @@ static int record_type(suunto_eonsteel_parser_t *eon, unsigned short type, const
 	}
 
 	fill_in_desc_details(eon, &desc);
+	desc.active = 1;
 
 	desc_free(eon->type_desc + type, 1);
 	eon->type_desc[type] = desc;
@@ -418,7 +550,7 @@ static int traverse_entry(suunto_eonsteel_parser_t *eon, const unsigned char *p,
 			end += 4;
 		}
 
-		if (type >= MAXTYPE || !eon->type_desc[type].desc) {
+		if (type >= MAXTYPE || !eon->type_desc[type].active || !eon->type_desc[type].desc) {
 			HEXDUMP(eon->base.context, DC_LOGLEVEL_DEBUG, "last", last, 16);
 			HEXDUMP(eon->base.context, DC_LOGLEVEL_DEBUG, "this", begin, 16);
 		} else {
@@ -462,9 +594,10 @@ struct sample_data {
 	suunto_eonsteel_parser_t *eon;
 	dc_sample_callback_t callback;
 	void *userdata;
+	dc_sample_table_t *table;
 	unsigned int time;
-	char *state_type, *notify_type;
-	char *warning_type, *alarm_type;
+	parser_sample_event_t state_type, notify_type;
+	parser_sample_event_t warning_type, alarm_type;
 
 	/* We gather up deco and cylinder pressure information */
 	int gasnr;
@@ -478,7 +611,10 @@ static void sample_time(struct sample_data *info, unsigned short time_delta)
 
 	info->time += time_delta;
 	sample.time = info->time / 1000;
-	if (info->callback) info->callback(DC_SAMPLE_TIME, sample, info->userdata);
+	if (info->table)
+		dc_sample_table_time(info->table, sample.time);
+	else if (info->callback)
+		info->callback(DC_SAMPLE_TIME, sample, info->userdata);
 }
 
 static void sample_depth(struct sample_data *info, unsigned short depth)
@@ -489,7 +625,10 @@ static void sample_depth(struct sample_data *info, unsigned short depth)
 		return;
 
 	sample.depth = depth / 100.0;
-	if (info->callback) info->callback(DC_SAMPLE_DEPTH, sample, info->userdata);
+	if (info->table)
+		dc_sample_table_depth(info->table, sample.depth);
+	else if (info->callback)
+		info->callback(DC_SAMPLE_DEPTH, sample, info->userdata);
 }
 
 static void sample_temp(struct sample_data *info, short temp)
@@ -500,7 +639,10 @@ static void sample_temp(struct sample_data *info, short temp)
 		return;
 
 	sample.temperature = temp / 10.0;
-	if (info->callback) info->callback(DC_SAMPLE_TEMPERATURE, sample, info->userdata);
+	if (info->table)
+		dc_sample_table_temperature(info->table, sample.temperature);
+	else if (info->callback)
+		info->callback(DC_SAMPLE_TEMPERATURE, sample, info->userdata);
 }
 
 static void sample_ndl(struct sample_data *info, short ndl)
@@ -579,7 +721,10 @@ static void sample_pressure(struct sample_data *info, unsigned short pressure)
 
 	sample.pressure.tank = info->gasnr-1;
 	sample.pressure.value = pressure / 100.0;
-	if (info->callback) info->callback(DC_SAMPLE_PRESSURE, sample, info->userdata);
+	if (info->table)
+		dc_sample_table_pressure(info->table, sample.pressure.tank, sample.pressure.value);
+	else if (info->callback)
+		info->callback(DC_SAMPLE_PRESSURE, sample, info->userdata);
 }
 
 static void sample_bookmark_event(struct sample_data *info, unsigned short idx)
@@ -613,90 +758,87 @@ static void sample_gas_switch_event(struct sample_data *info, unsigned short idx
  *
  * "enum:0=NoFly Time,1=Depth,2=Surface Time,3=..."
  */
-static char *lookup_enum(const struct type_desc *desc, unsigned char value)
+static const char *lookup_enum(const struct type_desc *desc, unsigned char value)
 {
-	const char *str = desc->format;
-	unsigned char c;
-
-	if (!str)
+	if (!desc->enums || value >= EON_MAX_ENUM)
 		return NULL;
-	if (strncmp(str, "enum:", 5))
-		return NULL;
-	str += 5;
-
-	while ((c = *str) != 0) {
-		unsigned char n;
-		const char *begin, *end;
-		char *ret;
-
-		str++;
-		if (!isdigit(c))
-			continue;
-		n = c - '0';
 
-		// We only handle one or two digits
-		if (isdigit(*str)) {
-			n = n*10 + *str - '0';
-			str++;
-		}
-
-		begin = end = str;
-		while ((c = *str) != 0) {
-			str++;
-			if (c == ',')
-				break;
-			end = str;
-		}
-
-		// Verify that it has the 'n=string' format and skip the equals sign
-		if (*begin != '=')
-			continue;
-		begin++;
-
-		// Is it the value we're looking for?
-		if (n != value)
-			continue;
-
-		ret = (char *)malloc(end - begin + 1);
-		if (!ret)
-			break;
-
-		memcpy(ret, begin, end-begin);
-		ret[end-begin] = 0;
-		return ret;
-	}
-	return NULL;
+	return desc->enums[value];
 }
 
 /*
  * The EON Steel has four different sample events: "state", "notification",
  * "warning" and "alarm". All end up having two fields: type and a boolean value.
+ * The type is resolved to the event when it arrives, and reported with the
+ * next value.
  */
+static const eon_event_t states[] = {
+	{"Wet Outside",                SAMPLE_EVENT_NONE},
+	{"Below Wet Activation Depth", SAMPLE_EVENT_NONE},
+	{"Below Surface",              SAMPLE_EVENT_NONE},
+	{"Dive Active",                SAMPLE_EVENT_NONE},
+	{"Surface Calculation",        SAMPLE_EVENT_NONE},
+	{"Tank pressure available",    SAMPLE_EVENT_NONE},
+	{"Closed Circuit Mode",        SAMPLE_EVENT_NONE},
+};
+
+static const eon_event_t notifications[] = {
+	{"NoFly Time",         SAMPLE_EVENT_NONE},
+	{"Depth",              SAMPLE_EVENT_NONE},
+	{"Surface Time",       SAMPLE_EVENT_NONE},
+	{"Tissue Level",       SAMPLE_EVENT_TISSUELEVEL},
+	{"Deco",               SAMPLE_EVENT_NONE},
+	{"Deco Window",        SAMPLE_EVENT_NONE},
+	{"Safety Stop Ahead",  SAMPLE_EVENT_NONE},
+	{"Safety Stop",        SAMPLE_EVENT_SAFETYSTOP},
+	{"Safety Stop Broken", SAMPLE_EVENT_CEILING_SAFETYSTOP},
+	{"Deep Stop Ahead",    SAMPLE_EVENT_NONE},
+	{"Deep Stop",          SAMPLE_EVENT_DEEPSTOP},
+	{"Dive Time",          SAMPLE_EVENT_DIVETIME},
+	{"Gas Available",      SAMPLE_EVENT_NONE},
+	{"SetPoint Switch",    SAMPLE_EVENT_NONE},
+	{"Diluent Hypoxia",    SAMPLE_EVENT_NONE},
+	{"Air Time",           SAMPLE_EVENT_NONE},
+	{"Tank Pressure",      SAMPLE_EVENT_NONE},
+};
+
+static const eon_event_t warnings[] = {
+	{"ICD Penalty",           SAMPLE_EVENT_NONE},
+	{"Deep Stop Penalty",     SAMPLE_EVENT_VIOLATION},
+	{"Mandatory Safety Stop", SAMPLE_EVENT_SAFETYSTOP_MANDATORY},
+	{"OTU250",                SAMPLE_EVENT_NONE},
+	{"OTU300",                SAMPLE_EVENT_NONE},
+	{"CNS80%",                SAMPLE_EVENT_NONE},
+	{"CNS100%",               SAMPLE_EVENT_NONE},
+	{"Max.Depth",             SAMPLE_EVENT_MAXDEPTH},
+	{"Air Time",              SAMPLE_EVENT_AIRTIME},
+	{"Tank Pressure",         SAMPLE_EVENT_NONE},
+	{"Safety Stop Broken",    SAMPLE_EVENT_CEILING_SAFETYSTOP},
+	{"Deep Stop Broken",      SAMPLE_EVENT_CEILING_SAFETYSTOP},
+	{"Ceiling Broken",        SAMPLE_EVENT_CEILING},
+	{"PO2 High",              SAMPLE_EVENT_PO2},
+};
+
+static const eon_event_t alarms[] = {
+	{"Mandatory Safety Stop Broken", SAMPLE_EVENT_CEILING_SAFETYSTOP},
+	{"Ascent Speed",                 SAMPLE_EVENT_ASCENT},
+	{"Diluent Hyperoxia",            SAMPLE_EVENT_NONE},
+	{"Violated Deep Stop",           SAMPLE_EVENT_VIOLATION},
+	{"Ceiling Broken",               SAMPLE_EVENT_CEILING},
+	{"PO2 High",                     SAMPLE_EVENT_PO2},
+	{"PO2 Low",                      SAMPLE_EVENT_PO2},
+};
+
 static void sample_event_state_type(const struct type_desc *desc, struct sample_data *info, unsigned char type)
 {
-	free(info->state_type);
-	info->state_type = lookup_enum(desc, type);
+	info->state_type = lookup_event(lookup_enum(desc, type), states, C_ARRAY_SIZE(states));
 }
 
 static void sample_event_state_value(const struct type_desc *desc, struct sample_data *info, unsigned char value)
 {
 	dc_sample_value_t sample = {0};
-	static const eon_event_t states[] = {
-		{"Wet Outside",                SAMPLE_EVENT_NONE},
-		{"Below Wet Activation Depth", SAMPLE_EVENT_NONE},
-		{"Below Surface",              SAMPLE_EVENT_NONE},
-		{"Dive Active",                SAMPLE_EVENT_NONE},
-		{"Surface Calculation",        SAMPLE_EVENT_NONE},
-		{"Tank pressure available",    SAMPLE_EVENT_NONE},
-		{"Closed Circuit Mode",        SAMPLE_EVENT_NONE},
-	};
-	const char *name;
 
-	name = info->state_type;
-	if (!name)
-		return;
-
-	sample.event.type = lookup_event(name, states, C_ARRAY_SIZE(states));
+	sample.event.type = info->state_type;
 	if (sample.event.type == SAMPLE_EVENT_NONE)
 		return;
 
@@ -706,39 +848,14 @@ static void sample_event_state_value(const struct type_desc *desc, struct sample
 
 static void sample_event_notify_type(const struct type_desc *desc, struct sample_data *info, unsigned char type)
 {
-	free(info->notify_type);
-	info->notify_type = lookup_enum(desc, type);
+	info->notify_type = lookup_event(lookup_enum(desc, type), notifications, C_ARRAY_SIZE(notifications));
 }
 
 static void sample_event_notify_value(const struct type_desc *desc, struct sample_data *info, unsigned char value)
 {
-	static const eon_event_t notifications[] = {
-		{"NoFly Time",         SAMPLE_EVENT_NONE},
-		{"Depth",              SAMPLE_EVENT_NONE},
-		{"Surface Time",       SAMPLE_EVENT_NONE},
-		{"Tissue Level",       SAMPLE_EVENT_TISSUELEVEL},
-		{"Deco",               SAMPLE_EVENT_NONE},
-		{"Deco Window",        SAMPLE_EVENT_NONE},
-		{"Safety Stop Ahead",  SAMPLE_EVENT_NONE},
-		{"Safety Stop",        SAMPLE_EVENT_SAFETYSTOP},
-		{"Safety Stop Broken", SAMPLE_EVENT_CEILING_SAFETYSTOP},
-		{"Deep Stop Ahead",    SAMPLE_EVENT_NONE},
-		{"Deep Stop",          SAMPLE_EVENT_DEEPSTOP},
-		{"Dive Time",          SAMPLE_EVENT_DIVETIME},
-		{"Gas Available",      SAMPLE_EVENT_NONE},
-		{"SetPoint Switch",    SAMPLE_EVENT_NONE},
-		{"Diluent Hypoxia",    SAMPLE_EVENT_NONE},
-		{"Air Time",           SAMPLE_EVENT_NONE},
-		{"Tank Pressure",      SAMPLE_EVENT_NONE},
-	};
 	dc_sample_value_t sample = {0};
-	const char *name;
 
-	name = info->notify_type;
-	if (!name)
-		return;
-
-	sample.event.type = lookup_event(name, notifications, C_ARRAY_SIZE(notifications));
+	sample.event.type = info->notify_type;
 	if (sample.event.type == SAMPLE_EVENT_NONE)
 		return;
 
@@ -749,36 +866,14 @@ static void sample_event_notify_value(const struct type_desc *desc, struct sampl
 
 static void sample_event_warning_type(const struct type_desc *desc, struct sample_data *info, unsigned char type)
 {
-	free(info->warning_type);
-	info->warning_type = lookup_enum(desc, type);
+	info->warning_type = lookup_event(lookup_enum(desc, type), warnings, C_ARRAY_SIZE(warnings));
 }
 
 static void sample_event_warning_value(const struct type_desc *desc, struct sample_data *info, unsigned char value)
 {
-	static const eon_event_t warnings[] = {
-		{"ICD Penalty",           SAMPLE_EVENT_NONE},
-		{"Deep Stop Penalty",     SAMPLE_EVENT_VIOLATION},
-		{"Mandatory Safety Stop", SAMPLE_EVENT_SAFETYSTOP_MANDATORY},
-		{"OTU250",                SAMPLE_EVENT_NONE},
-		{"OTU300",                SAMPLE_EVENT_NONE},
-		{"CNS80%",                SAMPLE_EVENT_NONE},
-		{"CNS100%",               SAMPLE_EVENT_NONE},
-		{"Max.Depth",             SAMPLE_EVENT_MAXDEPTH},
-		{"Air Time",              SAMPLE_EVENT_AIRTIME},
-		{"Tank Pressure",         SAMPLE_EVENT_NONE},
-		{"Safety Stop Broken",    SAMPLE_EVENT_CEILING_SAFETYSTOP},
-		{"Deep Stop Broken",      SAMPLE_EVENT_CEILING_SAFETYSTOP},
-		{"Ceiling Broken",        SAMPLE_EVENT_CEILING},
-		{"PO2 High",              SAMPLE_EVENT_PO2},
-	};
 	dc_sample_value_t sample = {0};
-	const char *name;
-
-	name = info->warning_type;
-	if (!name)
-		return;
 
-	sample.event.type = lookup_event(name, warnings, C_ARRAY_SIZE(warnings));
+	sample.event.type = info->warning_type;
 	if (sample.event.type == SAMPLE_EVENT_NONE)
 		return;
 
@@ -788,30 +883,15 @@ static void sample_event_warning_value(const struct type_desc *desc, struct samp
 
 static void sample_event_alarm_type(const struct type_desc *desc, struct sample_data *info, unsigned char type)
 {
-	free(info->alarm_type);
-	info->alarm_type = lookup_enum(desc, type);
+	info->alarm_type = lookup_event(lookup_enum(desc, type), alarms, C_ARRAY_SIZE(alarms));
 }
 
 
 static void sample_event_alarm_value(const struct type_desc *desc, struct sample_data *info, unsigned char value)
 {
-	static const eon_event_t alarms[] = {
-		{"Mandatory Safety Stop Broken", SAMPLE_EVENT_CEILING_SAFETYSTOP},
-		{"Ascent Speed",                 SAMPLE_EVENT_ASCENT},
-		{"Diluent Hyperoxia",            SAMPLE_EVENT_NONE},
-		{"Violated Deep Stop",           SAMPLE_EVENT_VIOLATION},
-		{"Ceiling Broken",               SAMPLE_EVENT_CEILING},
-		{"PO2 High",                     SAMPLE_EVENT_PO2},
-		{"PO2 Low",                      SAMPLE_EVENT_PO2},
-	};
 	dc_sample_value_t sample = {0};
-	const char *name;
 
-	name = info->alarm_type;
-	if (!name)
-		return;
-
-	sample.event.type = lookup_event(name, alarms, C_ARRAY_SIZE(alarms));
+	sample.event.type = info->alarm_type;
 	if (sample.event.type == SAMPLE_EVENT_NONE)
 		return;
 
@@ -823,7 +903,7 @@ static void sample_event_alarm_value(const struct type_desc *desc, struct sample
 static void sample_setpoint_type(const struct type_desc *desc, struct sample_data *info, unsigned char value)
 {
 	dc_sample_value_t sample = {0};
-	char *type = lookup_enum(desc, value);
+	const char *type = lookup_enum(desc, value);
 
 	if (!type) {
 		DEBUG(info->eon->base.context, "sample_setpoint_type(%u) did not match anything in %s", value, desc->format);
@@ -838,12 +918,10 @@ static void sample_setpoint_type(const struct type_desc *desc, struct sample_dat
 		sample.ppo2 = info->eon->cache.customsetpoint;
 	else {
 		DEBUG(info->eon->base.context, "sample_setpoint_type(%u) unknown type '%s'", value, type);
-		free(type);
 		return;
 	}
 
 	if (info->callback) info->callback(DC_SAMPLE_SETPOINT, sample, info->userdata);
-	free(type);
 }
 
 // uint32
@@ -1010,22 +1088,35 @@ static int traverse_samples(unsigned short type, const struct type_desc *desc, c
 	return 0;
 }
 
+static void suunto_eonsteel_parser_cache(suunto_eonsteel_parser_t *eon);
+
 static dc_status_t
-suunto_eonsteel_parser_samples_foreach(dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata)
+suunto_eonsteel_parser_samples(dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata, dc_sample_table_t *table)
 {
 	suunto_eonsteel_parser_t *eon = (suunto_eonsteel_parser_t *) abstract;
-	struct sample_data data = { eon, callback, userdata, 0 };
+	struct sample_data data = { eon, callback, userdata, table, 0 };
+
+	// The samples depend on the gas mixes and setpoints in the cache.
+	suunto_eonsteel_parser_cache(eon);
 
 	traverse_data(eon, traverse_samples, &data);
 
-	free(data.state_type);
-	free(data.notify_type);
-	free(data.warning_type);
-	free(data.alarm_type);
 
 	return DC_STATUS_SUCCESS;
 }
 
+static dc_status_t
+suunto_eonsteel_parser_samples_foreach(dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata)
+{
+	return suunto_eonsteel_parser_samples(abstract, callback, userdata, NULL);
+}
+
+static dc_status_t
+suunto_eonsteel_parser_samples_batch(dc_parser_t *abstract, dc_sample_table_t *table)
+{
+	return suunto_eonsteel_parser_samples(abstract, dc_sample_table_cb, table, table);
+}
+
 // Ugly define thing makes the code much easier to read
 // I'd love to use __typeof__, but that's a gcc'ism
 #define field_value(p, set) \
@@ -1038,6 +1129,12 @@ suunto_eonsteel_parser_get_field(dc_parser_t *parser, dc_field_type_t type, unsi
 
 	suunto_eonsteel_parser_t *eon = (suunto_eonsteel_parser_t *)parser;
 
+	// All fields require a full traversal of the dive.
+	if (parser->headeronly && !eon->cache.initialized)
+		return DC_STATUS_UNSUPPORTED;
+
+	suunto_eonsteel_parser_cache(eon);
+
 	if (!(eon->cache.initialized & (1 << type)))
 		return DC_STATUS_UNSUPPORTED;
 
@@ -1158,7 +1255,7 @@ static int add_gas_type(suunto_eonsteel_parser_t *eon, const struct type_desc *d
 {
 	int idx = eon->cache.ngases;
 	dc_tankvolume_t tankinfo = DC_TANKVOLUME_METRIC;
-	char *name;
+	const char *name;
 
 	if (idx >= MAXGASES)
 		return 0;
@@ -1180,7 +1277,6 @@ static int add_gas_type(suunto_eonsteel_parser_t *eon, const struct type_desc *d
 
 	eon->cache.initialized |= 1 << DC_FIELD_GASMIX_COUNT;
 	eon->cache.initialized |= 1 << DC_FIELD_TANK_COUNT;
-	free(name);
 	return 0;
 }
 
@@ -1464,7 +1560,7 @@ static void show_descriptor(suunto_eonsteel_parser_t *eon, int nr, struct type_d
 {
 	int i;
 
-	if (!desc->desc)
+	if (!desc->active || !desc->desc)
 		return;
 	DEBUG(eon->base.context, "Descriptor %d: '%s', size %d bytes", nr, desc->desc, desc->size);
 	if (desc->format)
@@ -1485,15 +1581,28 @@ static void show_all_descriptors(suunto_eonsteel_parser_t *eon)
 		show_descriptor(eon, i, eon->type_desc+i);
 }
 
+// The field cache is filled on first use, so that setting the data
+// (and retrieving the date/time from the filename) stays cheap.
+static void suunto_eonsteel_parser_cache(suunto_eonsteel_parser_t *eon)
+{
+	if (eon->cache.initialized)
+		return;
+
+	initialize_field_caches(eon);
+	show_all_descriptors(eon);
+}
+
 static dc_status_t
 suunto_eonsteel_parser_set_data(dc_parser_t *parser, const unsigned char *data, unsigned int size)
 {
 	suunto_eonsteel_parser_t *eon = (suunto_eonsteel_parser_t *) parser;
 
-	desc_free(eon->type_desc, MAXTYPE);
-	memset(eon->type_desc, 0, sizeof(eon->type_desc));
-	initialize_field_caches(eon);
-	show_all_descriptors(eon);
+	// The parsed type descriptors are kept, because they are usually the
+	// same for all dives of the same device, but only the descriptors
+	// that are present in the new dive are used again.
+	for (unsigned int i = 0; i < MAXTYPE; ++i)
+		eon->type_desc[i].active = 0;
+	memset(&eon->cache, 0, sizeof(eon->cache));
 	return DC_STATUS_SUCCESS;
 }
 
@@ -1511,9 +1620,13 @@ static const dc_parser_vtable_t suunto_eonsteel_parser_vtable = {
 	sizeof(suunto_eonsteel_parser_t),
 	DC_FAMILY_SUUNTO_EONSTEEL,
 	suunto_eonsteel_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	suunto_eonsteel_parser_get_datetime, /* datetime */
 	suunto_eonsteel_parser_get_field, /* fields */
 	suunto_eonsteel_parser_samples_foreach, /* samples_foreach */
+	suunto_eonsteel_parser_samples_batch, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	suunto_eonsteel_parser_destroy /* destroy */
 };
 
@@ -1533,6 +1646,7 @@ suunto_eonsteel_parser_create(dc_parser_t **out, dc_context_t *context, unsigned
 
 	memset(&parser->type_desc, 0, sizeof(parser->type_desc));
 	memset(&parser->cache, 0, sizeof(parser->cache));
+	init_type_hash(parser);
 
 	*out = (dc_parser_t *) parser;
 
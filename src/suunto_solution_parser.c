@@ -47,9 +47,13 @@ static const dc_parser_vtable_t suunto_solution_parser_vtable = {
 	sizeof(suunto_solution_parser_t),
 	DC_FAMILY_SUUNTO_SOLUTION,
 	suunto_solution_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	NULL, /* datetime */
 	suunto_solution_parser_get_field, /* fields */
 	suunto_solution_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -106,6 +110,9 @@ suunto_solution_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, u
 		return DC_STATUS_DATAFORMAT;
 
 	if (!parser->cached) {
+		if (abstract->headeronly)
+			return DC_STATUS_UNSUPPORTED;
+
 		unsigned int nsamples = 0;
 		unsigned int depth = 0, maxdepth = 0;
 		unsigned int offset = 3;
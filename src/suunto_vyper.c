@@ -38,6 +38,10 @@
 #define SZ_MEMORY 0x2000
 #define SZ_PACKET 32
 
+#define DELAY    500
+#define MINDELAY 100
+#define MAXDELAY 1000
+
 #define HDR_DEVINFO_VYPER   0x24
 #define HDR_DEVINFO_SPYDER  0x16
 #define HDR_DEVINFO_BEGIN   (HDR_DEVINFO_SPYDER)
@@ -101,6 +105,12 @@ suunto_vyper_device_open (dc_device_t **out, dc_context_t *context, dc_iostream_
 	// Initialize the base class.
 	suunto_common_device_init (&device->base);
 
+	// The delay before every command starts at the value that has always
+	// been used. Lower delays are only probed after a long run of
+	// successful packets, and the application can restore the last
+	// known-good delay in the next session.
+	dc_pacing_init (&device->base.base.pacing, DELAY, MINDELAY, MAXDELAY);
+
 	// Set the default values.
 	device->iostream = iostream;
 
@@ -147,7 +157,7 @@ suunto_vyper_send (suunto_vyper_device_t *device, const unsigned char command[],
 	dc_status_t status = DC_STATUS_SUCCESS;
 	dc_device_t *abstract = (dc_device_t *) device;
 
-	dc_iostream_sleep (device->iostream, 500);
+	dc_iostream_sleep (device->iostream, dc_pacing_delay (&abstract->pacing));
 
 	// Set RTS to send the command.
 	status = dc_iostream_set_rts (device->iostream, 1);
@@ -210,12 +220,15 @@ suunto_vyper_transfer (suunto_vyper_device_t *device, const unsigned char comman
 	status = dc_iostream_read (device->iostream, answer, asize, NULL);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (abstract->context, "Failed to receive the answer.");
+		if (status == DC_STATUS_TIMEOUT)
+			dc_pacing_failure (&abstract->pacing);
 		return status;
 	}
 
 	// Verify the header of the package.
 	if (memcmp (command, answer, asize - size - 1) != 0) {
 		ERROR (abstract->context, "Unexpected answer start byte(s).");
+		dc_pacing_failure (&abstract->pacing);
 		return DC_STATUS_PROTOCOL;
 	}
 
@@ -224,9 +237,12 @@ suunto_vyper_transfer (suunto_vyper_device_t *device, const unsigned char comman
 	unsigned char ccrc = checksum_xor_uint8 (answer, asize - 1, 0x00);
 	if (crc != ccrc) {
 		ERROR (abstract->context, "Unexpected answer checksum.");
+		dc_pacing_failure (&abstract->pacing);
 		return DC_STATUS_PROTOCOL;
 	}
 
+	dc_pacing_success (&abstract->pacing);
+
 	return DC_STATUS_SUCCESS;
 }
 
@@ -345,6 +361,8 @@ suunto_vyper_read_dive (dc_device_t *abstract, dc_buffer_t *buffer, int init, dc
 			if (n == 0 && npackages != 0)
 				break;
 			ERROR (abstract->context, "Failed to receive the answer.");
+			if (status == DC_STATUS_TIMEOUT && npackages == 0)
+				dc_pacing_failure (&abstract->pacing);
 			return status;
 		}
 
@@ -352,6 +370,7 @@ suunto_vyper_read_dive (dc_device_t *abstract, dc_buffer_t *buffer, int init, dc
 		if (answer[0] != command[0] ||
 			answer[1] > SZ_PACKET) {
 			ERROR (abstract->context, "Unexpected answer start byte(s).");
+			dc_pacing_failure (&abstract->pacing);
 			return DC_STATUS_PROTOCOL;
 		}
 
@@ -368,9 +387,13 @@ suunto_vyper_read_dive (dc_device_t *abstract, dc_buffer_t *buffer, int init, dc
 		unsigned char ccrc = checksum_xor_uint8 (answer, len + 2, 0x00);
 		if (crc != ccrc) {
 			ERROR (abstract->context, "Unexpected answer checksum.");
+			dc_pacing_failure (&abstract->pacing);
 			return DC_STATUS_PROTOCOL;
 		}
 
+		if (npackages == 0)
+			dc_pacing_success (&abstract->pacing);
+
 		// The DC sends a null package (a package with length zero) when it
 		// has reached the end of its internal ring buffer. From this point on,
 		// the current dive has been overwritten with newer data. Therefore,
@@ -53,9 +53,13 @@ static const dc_parser_vtable_t suunto_vyper_parser_vtable = {
 	sizeof(suunto_vyper_parser_t),
 	DC_FAMILY_SUUNTO_VYPER,
 	suunto_vyper_parser_set_data, /* set_data */
+	NULL, /* set_clock */
 	suunto_vyper_parser_get_datetime, /* datetime */
 	suunto_vyper_parser_get_field, /* fields */
 	suunto_vyper_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -241,6 +245,10 @@ suunto_vyper_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsi
 	dc_gasmix_t *gas = (dc_gasmix_t *) value;
 	dc_tank_t *tank = (dc_tank_t *) value;
 
+	// The end of the profile is only found by walking the samples.
+	if (!parser->cached && abstract->headeronly)
+		return DC_STATUS_UNSUPPORTED;
+
 	// Cache the data.
 	dc_status_t rc = suunto_vyper_parser_cache (parser);
 	if (rc != DC_STATUS_SUCCESS)
@@ -26,6 +26,7 @@
 #include "context-private.h"
 #include "device-private.h"
 #include "array.h"
+#include "buffered.h"
 
 #define ISINSTANCE(device) dc_device_isinstance((device), &tecdiving_divecomputereu_device_vtable)
 
@@ -359,21 +360,28 @@ tecdiving_divecomputereu_device_open (dc_device_t **out, dc_context_t *context,
 	}
 
 	// Set the default values.
-	device->iostream = iostream;
 	memset (device->fingerprint, 0, sizeof (device->fingerprint));
 
+	// Read ahead, because the packet header is searched for one byte
+	// at a time.
+	status = dc_buffered_open (&device->iostream, context, iostream, 1024);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (context, "Failed to create the buffered stream.");
+		goto error_free;
+	}
+
 	// Set the serial communication protocol (115200 8N1).
 	status = dc_iostream_configure (device->iostream, 115200, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the terminal attributes.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Set the timeout for receiving data (1000ms).
 	status = dc_iostream_set_timeout (device->iostream, 1000);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the timeout.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Make sure everything is in a sane state.
@@ -384,20 +392,22 @@ tecdiving_divecomputereu_device_open (dc_device_t **out, dc_context_t *context,
 	status = tecdiving_divecomputereu_send (device, CMD_INIT, NULL, 0);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to send the init command.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Read the device info.
 	status = tecdiving_divecomputereu_receive (device, RSP_INIT, device->version, sizeof(device->version), NULL);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to receive the device info.");
-		goto error_free;
+		goto error_close;
 	}
 
 	*out = (dc_device_t *) device;
 
 	return DC_STATUS_SUCCESS;
 
+error_close:
+	dc_iostream_close (device->iostream);
 error_free:
 	dc_device_deallocate ((dc_device_t *) device);
 	return status;
@@ -408,14 +418,21 @@ tecdiving_divecomputereu_device_close (dc_device_t *abstract)
 {
 	dc_status_t status = DC_STATUS_SUCCESS;
 	tecdiving_divecomputereu_device_t *device = (tecdiving_divecomputereu_device_t *) abstract;
+	dc_status_t rc = DC_STATUS_SUCCESS;
 
-	status = tecdiving_divecomputereu_send (device, CMD_EXIT, NULL, 0);
-	if (status != DC_STATUS_SUCCESS) {
+	rc = tecdiving_divecomputereu_send (device, CMD_EXIT, NULL, 0);
+	if (rc != DC_STATUS_SUCCESS) {
 		ERROR (abstract->context, "Failed to send the exit command.");
-		return status;
+		dc_status_set_error(&status, rc);
 	}
 
-	return DC_STATUS_SUCCESS;
+	// Close the buffered stream.
+	rc = dc_iostream_close (device->iostream);
+	if (rc != DC_STATUS_SUCCESS) {
+		dc_status_set_error(&status, rc);
+	}
+
+	return status;
 }
 
 static dc_status_t
@@ -50,6 +50,10 @@
 #include <hidapi.h>
 #endif
 
+#if defined(USE_LIBUSB) && defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000102)
+#define USBHID_HOTPLUG
+#endif
+
 #include <libdivecomputer/usbhid.h>
 
 #include "common-private.h"
@@ -58,17 +62,21 @@
 #include "descriptor-private.h"
 #include "iterator-private.h"
 #include "platform.h"
+#include "timer.h"
+#include "thread.h"
 
 #ifdef _WIN32
-typedef LONG dc_mutex_t;
-#define DC_MUTEX_INIT 0
+typedef LONG dc_usbhid_lock_t;
+#define DC_USBHID_LOCK_INIT 0
 #else
-typedef pthread_mutex_t dc_mutex_t;
-#define DC_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+typedef pthread_mutex_t dc_usbhid_lock_t;
+#define DC_USBHID_LOCK_INIT PTHREAD_MUTEX_INITIALIZER
 #endif
 
 #define ISINSTANCE(device) dc_iostream_isinstance((device), &dc_usbhid_vtable)
 
+#define MAXTRANSFERS 16
+
 typedef struct dc_usbhid_session_t {
 	size_t refcount;
 #if defined(USE_LIBUSB)
@@ -97,6 +105,7 @@ static dc_status_t dc_usbhid_set_timeout (dc_iostream_t *iostream, int timeout);
 static dc_status_t dc_usbhid_poll (dc_iostream_t *iostream, int timeout);
 static dc_status_t dc_usbhid_read (dc_iostream_t *iostream, void *data, size_t size, size_t *actual);
 static dc_status_t dc_usbhid_write (dc_iostream_t *iostream, const void *data, size_t size, size_t *actual);
+static dc_status_t dc_usbhid_read_nonblock (dc_iostream_t *iostream, void *data, size_t size, size_t *actual);
 static dc_status_t dc_usbhid_ioctl (dc_iostream_t *iostream, unsigned int request, void *data, size_t size);
 static dc_status_t dc_usbhid_close (dc_iostream_t *iostream);
 
@@ -124,12 +133,61 @@ typedef struct dc_usbhid_t {
 	unsigned char endpoint_in;
 	unsigned char endpoint_out;
 	unsigned int timeout;
+	dc_timer_t *timer;
+	/*
+	 * In asynchronous mode, a number of transfers is kept in flight on
+	 * the input endpoint at all times. The completed reports are
+	 * appended to the receive ring, which has a free slot reserved for
+	 * every transfer in flight. Transfers that can't be resubmitted
+	 * because the ring is full are parked until the next read.
+	 */
+	dc_mutex_t *mutex;
+	dc_status_t error;
+	unsigned int ntransfers, nactive, nidle;
+	struct libusb_transfer *transfers[MAXTRANSFERS];
+	struct libusb_transfer *idle[MAXTRANSFERS];
+	unsigned char *buffers;
+	unsigned int packetsize;
+	unsigned int capacity, head, count;
+	unsigned int *lengths;
+	unsigned char *ring;
 #elif defined(USE_HIDAPI)
 	hid_device *handle;
 	int timeout;
 #endif
 } dc_usbhid_t;
 
+#ifdef USBHID_HOTPLUG
+typedef struct dc_usbhid_event_t {
+	struct dc_usbhid_event_t *next;
+	struct libusb_device *device;
+	unsigned int arrived;
+} dc_usbhid_event_t;
+
+typedef struct dc_usbhid_entry_t {
+	struct dc_usbhid_entry_t *next;
+	dc_usbhid_device_t *device;
+} dc_usbhid_entry_t;
+
+struct dc_usbhid_watcher_t {
+	dc_context_t *context;
+	dc_usbhid_session_t *session;
+	dc_filter_t filter;
+	dc_usbhid_watcher_callback_t callback;
+	void *userdata;
+	libusb_hotplug_callback_handle hotplug;
+	/*
+	 * The libusb hotplug callback runs in whichever thread is handling
+	 * the libusb events, and only queues the events. They are processed
+	 * and delivered to the application from dc_usbhid_watcher_poll.
+	 */
+	dc_mutex_t *mutex;
+	dc_usbhid_event_t *events, **tail;
+	/* The devices that are currently plugged in. */
+	dc_usbhid_entry_t *devices;
+};
+#endif
+
 static const dc_iterator_vtable_t dc_usbhid_iterator_vtable = {
 	sizeof(dc_usbhid_iterator_t),
 	dc_usbhid_iterator_next,
@@ -146,8 +204,11 @@ static const dc_iostream_vtable_t dc_usbhid_vtable = {
 	NULL, /* get_available */
 	NULL, /* configure */
 	dc_usbhid_poll, /* poll */
+	NULL, /* get_fd */
 	dc_usbhid_read, /* read */
 	dc_usbhid_write, /* write */
+	dc_usbhid_read_nonblock, /* read_nonblock */
+	NULL, /* write_nonblock */
 	dc_usbhid_ioctl, /* ioctl */
 	NULL, /* flush */
 	NULL, /* purge */
@@ -156,7 +217,7 @@ static const dc_iostream_vtable_t dc_usbhid_vtable = {
 };
 
 #ifdef USE_HIDAPI
-static dc_mutex_t g_usbhid_mutex = DC_MUTEX_INIT;
+static dc_usbhid_lock_t g_usbhid_mutex = DC_USBHID_LOCK_INIT;
 static dc_usbhid_session_t *g_usbhid_session = NULL;
 #endif
 
@@ -185,7 +246,7 @@ syserror(int errcode)
 
 #ifdef USE_HIDAPI
 static void
-dc_mutex_lock (dc_mutex_t *mutex)
+dc_usbhid_lock (dc_usbhid_lock_t *mutex)
 {
 #ifdef _WIN32
 	while (InterlockedCompareExchange (mutex, 1, 0) == 1) {
@@ -197,7 +258,7 @@ dc_mutex_lock (dc_mutex_t *mutex)
 }
 
 static void
-dc_mutex_unlock (dc_mutex_t *mutex)
+dc_usbhid_unlock (dc_usbhid_lock_t *mutex)
 {
 #ifdef _WIN32
 	InterlockedExchange (mutex, 0);
@@ -217,12 +278,12 @@ dc_usbhid_session_new (dc_usbhid_session_t **out, dc_context_t *context)
 		return DC_STATUS_INVALIDARGS;
 
 #ifdef USE_HIDAPI
-	dc_mutex_lock (&g_usbhid_mutex);
+	dc_usbhid_lock (&g_usbhid_mutex);
 
 	if (g_usbhid_session) {
 		g_usbhid_session->refcount++;
 		*out = g_usbhid_session;
-		dc_mutex_unlock (&g_usbhid_mutex);
+		dc_usbhid_unlock (&g_usbhid_mutex);
 		return DC_STATUS_SUCCESS;
 	}
 #endif
@@ -254,7 +315,7 @@ dc_usbhid_session_new (dc_usbhid_session_t **out, dc_context_t *context)
 
 	g_usbhid_session = session;
 
-	dc_mutex_unlock (&g_usbhid_mutex);
+	dc_usbhid_unlock (&g_usbhid_mutex);
 #endif
 
 	*out = session;
@@ -265,7 +326,7 @@ error_free:
 	free (session);
 error_unlock:
 #ifdef USE_HIDAPI
-	dc_mutex_unlock (&g_usbhid_mutex);
+	dc_usbhid_unlock (&g_usbhid_mutex);
 #endif
 	return status;
 }
@@ -277,13 +338,13 @@ dc_usbhid_session_ref (dc_usbhid_session_t *session)
 		return NULL;
 
 #ifdef USE_HIDAPI
-	dc_mutex_lock (&g_usbhid_mutex);
+	dc_usbhid_lock (&g_usbhid_mutex);
 #endif
 
 	session->refcount++;
 
 #ifdef USE_HIDAPI
-	dc_mutex_unlock (&g_usbhid_mutex);
+	dc_usbhid_unlock (&g_usbhid_mutex);
 #endif
 
 	return session;
@@ -296,7 +357,7 @@ dc_usbhid_session_unref (dc_usbhid_session_t *session)
 		return DC_STATUS_SUCCESS;
 
 #ifdef USE_HIDAPI
-	dc_mutex_lock (&g_usbhid_mutex);
+	dc_usbhid_lock (&g_usbhid_mutex);
 #endif
 
 	if (--session->refcount == 0) {
@@ -310,7 +371,7 @@ dc_usbhid_session_unref (dc_usbhid_session_t *session)
 	}
 
 #ifdef USE_HIDAPI
-	dc_mutex_unlock (&g_usbhid_mutex);
+	dc_usbhid_unlock (&g_usbhid_mutex);
 #endif
 
 	return DC_STATUS_SUCCESS;
@@ -415,100 +476,125 @@ error_free:
 }
 
 #ifdef USBHID
+#if defined(USE_LIBUSB)
+/*
+ * Create a new device for a USB device with a HID interface that passes
+ * the filter. For all other USB devices, no device is returned.
+ */
 static dc_status_t
-dc_usbhid_iterator_next (dc_iterator_t *abstract, void *out)
+dc_usbhid_device_new (dc_usbhid_device_t **out, dc_context_t *context, dc_usbhid_session_t *session, dc_filter_t filter, struct libusb_device *current)
 {
-	dc_usbhid_iterator_t *iterator = (dc_usbhid_iterator_t *) abstract;
 	dc_usbhid_device_t *device = NULL;
 
-#if defined(USE_LIBUSB)
-	while (iterator->current < iterator->count) {
-		struct libusb_device *current = iterator->devices[iterator->current++];
+	*out = NULL;
 
-		// Get the device descriptor.
-		struct libusb_device_descriptor dev;
-		int rc = libusb_get_device_descriptor (current, &dev);
-		if (rc < 0) {
-			ERROR (abstract->context, "Failed to get the device descriptor (%s).",
-				libusb_error_name (rc));
-			return syserror (rc);
+	// Get the device descriptor.
+	struct libusb_device_descriptor dev;
+	int rc = libusb_get_device_descriptor (current, &dev);
+	if (rc < 0) {
+		ERROR (context, "Failed to get the device descriptor (%s).",
+			libusb_error_name (rc));
+		return syserror (rc);
+	}
+
+	dc_usb_desc_t usb = {dev.idVendor, dev.idProduct};
+	if (filter && !filter (DC_TRANSPORT_USBHID, &usb)) {
+		return DC_STATUS_SUCCESS;
+	}
+
+	// Get the active configuration descriptor.
+	struct libusb_config_descriptor *config = NULL;
+	rc = libusb_get_active_config_descriptor (current, &config);
+	if (rc != LIBUSB_SUCCESS) {
+		ERROR (context, "Failed to get the configuration descriptor (%s).",
+			libusb_error_name (rc));
+		return syserror (rc);
+	}
+
+	// Find the first HID interface.
+	const struct libusb_interface_descriptor *interface = NULL;
+	for (unsigned int i = 0; i < config->bNumInterfaces; i++) {
+		const struct libusb_interface *iface = &config->interface[i];
+		for (int j = 0; j < iface->num_altsetting; j++) {
+			const struct libusb_interface_descriptor *desc = &iface->altsetting[j];
+			if (desc->bInterfaceClass == LIBUSB_CLASS_HID && interface == NULL) {
+				interface = desc;
+			}
 		}
+	}
 
-		dc_usb_desc_t usb = {dev.idVendor, dev.idProduct};
-		if (iterator->filter && !iterator->filter (DC_TRANSPORT_USBHID, &usb)) {
+	if (interface == NULL) {
+		libusb_free_config_descriptor (config);
+		return DC_STATUS_SUCCESS;
+	}
+
+	// Find the first input and output interrupt endpoints.
+	const struct libusb_endpoint_descriptor *ep_in = NULL, *ep_out = NULL;
+	for (unsigned int i = 0; i < interface->bNumEndpoints; i++) {
+		const struct libusb_endpoint_descriptor *desc = &interface->endpoint[i];
+
+		unsigned int type = desc->bmAttributes & LIBUSB_TRANSFER_TYPE_MASK;
+		unsigned int direction = desc->bEndpointAddress & LIBUSB_ENDPOINT_DIR_MASK;
+
+		if (type != LIBUSB_TRANSFER_TYPE_INTERRUPT) {
 			continue;
 		}
 
-		// Get the active configuration descriptor.
-		struct libusb_config_descriptor *config = NULL;
-		rc = libusb_get_active_config_descriptor (current, &config);
-		if (rc != LIBUSB_SUCCESS) {
-			ERROR (abstract->context, "Failed to get the configuration descriptor (%s).",
-				libusb_error_name (rc));
-			return syserror (rc);
+		if (direction == LIBUSB_ENDPOINT_IN && ep_in == NULL) {
+			ep_in = desc;
 		}
 
-		// Find the first HID interface.
-		const struct libusb_interface_descriptor *interface = NULL;
-		for (unsigned int i = 0; i < config->bNumInterfaces; i++) {
-			const struct libusb_interface *iface = &config->interface[i];
-			for (int j = 0; j < iface->num_altsetting; j++) {
-				const struct libusb_interface_descriptor *desc = &iface->altsetting[j];
-				if (desc->bInterfaceClass == LIBUSB_CLASS_HID && interface == NULL) {
-					interface = desc;
-				}
-			}
+		if (direction == LIBUSB_ENDPOINT_OUT && ep_out == NULL) {
+			ep_out = desc;
 		}
+	}
 
-		if (interface == NULL) {
-			libusb_free_config_descriptor (config);
-			continue;
-		}
+	if (ep_in == NULL || ep_out == NULL) {
+		libusb_free_config_descriptor (config);
+		return DC_STATUS_SUCCESS;
+	}
 
-		// Find the first input and output interrupt endpoints.
-		const struct libusb_endpoint_descriptor *ep_in = NULL, *ep_out = NULL;
-		for (unsigned int i = 0; i < interface->bNumEndpoints; i++) {
-			const struct libusb_endpoint_descriptor *desc = &interface->endpoint[i];
+	device = (dc_usbhid_device_t *) malloc (sizeof(dc_usbhid_device_t));
+	if (device == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		libusb_free_config_descriptor (config);
+		return DC_STATUS_NOMEMORY;
+	}
 
-			unsigned int type = desc->bmAttributes & LIBUSB_TRANSFER_TYPE_MASK;
-			unsigned int direction = desc->bEndpointAddress & LIBUSB_ENDPOINT_DIR_MASK;
+	device->session = dc_usbhid_session_ref (session);
+	device->vid = dev.idVendor;
+	device->pid = dev.idProduct;
+	device->handle = libusb_ref_device (current);
+	device->interface = interface->bInterfaceNumber;
+	device->endpoint_in = ep_in->bEndpointAddress;
+	device->endpoint_out = ep_out->bEndpointAddress;
 
-			if (type != LIBUSB_TRANSFER_TYPE_INTERRUPT) {
-				continue;
-			}
+	*out = device;
 
-			if (direction == LIBUSB_ENDPOINT_IN && ep_in == NULL) {
-				ep_in = desc;
-			}
+	libusb_free_config_descriptor (config);
 
-			if (direction == LIBUSB_ENDPOINT_OUT && ep_out == NULL) {
-				ep_out = desc;
-			}
-		}
+	return DC_STATUS_SUCCESS;
+}
+#endif
 
-		if (ep_in == NULL || ep_out == NULL) {
-			libusb_free_config_descriptor (config);
-			continue;
-		}
+static dc_status_t
+dc_usbhid_iterator_next (dc_iterator_t *abstract, void *out)
+{
+	dc_usbhid_iterator_t *iterator = (dc_usbhid_iterator_t *) abstract;
+	dc_usbhid_device_t *device = NULL;
 
-		device = (dc_usbhid_device_t *) malloc (sizeof(dc_usbhid_device_t));
-		if (device == NULL) {
-			ERROR (abstract->context, "Failed to allocate memory.");
-			libusb_free_config_descriptor (config);
-			return DC_STATUS_NOMEMORY;
-		}
+#if defined(USE_LIBUSB)
+	while (iterator->current < iterator->count) {
+		struct libusb_device *current = iterator->devices[iterator->current++];
 
-		device->session = dc_usbhid_session_ref (iterator->session);
-		device->vid = dev.idVendor;
-		device->pid = dev.idProduct;
-		device->handle = libusb_ref_device (current);
-		device->interface = interface->bInterfaceNumber;
-		device->endpoint_in = ep_in->bEndpointAddress;
-		device->endpoint_out = ep_out->bEndpointAddress;
+		dc_status_t status = dc_usbhid_device_new (&device, abstract->context, iterator->session, iterator->filter, current);
+		if (status != DC_STATUS_SUCCESS)
+			return status;
 
-		*(dc_usbhid_device_t **) out = device;
+		if (device == NULL)
+			continue;
 
-		libusb_free_config_descriptor (config);
+		*(dc_usbhid_device_t **) out = device;
 
 		return DC_STATUS_SUCCESS;
 	}
@@ -558,6 +644,554 @@ dc_usbhid_iterator_free (dc_iterator_t *abstract)
 }
 #endif
 
+#ifdef USBHID_HOTPLUG
+static int LIBUSB_CALL
+dc_usbhid_watcher_hotplug (libusb_context *ctx, libusb_device *device, libusb_hotplug_event event, void *userdata)
+{
+	dc_usbhid_watcher_t *watcher = (dc_usbhid_watcher_t *) userdata;
+
+	dc_usbhid_event_t *item = (dc_usbhid_event_t *) malloc (sizeof(dc_usbhid_event_t));
+	if (item == NULL) {
+		ERROR (watcher->context, "Failed to allocate memory.");
+		return 0;
+	}
+
+	item->next = NULL;
+	item->device = libusb_ref_device (device);
+	item->arrived = (event == LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED);
+
+	dc_mutex_lock (watcher->mutex);
+	*watcher->tail = item;
+	watcher->tail = &item->next;
+	dc_mutex_unlock (watcher->mutex);
+
+	return 0;
+}
+
+static dc_usbhid_event_t *
+dc_usbhid_watcher_events (dc_usbhid_watcher_t *watcher)
+{
+	dc_mutex_lock (watcher->mutex);
+	dc_usbhid_event_t *events = watcher->events;
+	watcher->events = NULL;
+	watcher->tail = &watcher->events;
+	dc_mutex_unlock (watcher->mutex);
+
+	return events;
+}
+
+static unsigned int
+dc_usbhid_watcher_dispatch (dc_usbhid_watcher_t *watcher)
+{
+	unsigned int count = 0;
+
+	dc_usbhid_event_t *events = dc_usbhid_watcher_events (watcher);
+	while (events) {
+		dc_usbhid_event_t *item = events;
+		events = item->next;
+
+		// Look up the device in the set of known devices.
+		dc_usbhid_entry_t **entry = &watcher->devices;
+		while (*entry && (*entry)->device->handle != item->device) {
+			entry = &(*entry)->next;
+		}
+
+		if (item->arrived && *entry == NULL) {
+			dc_usbhid_device_t *device = NULL;
+			dc_status_t status = dc_usbhid_device_new (&device, watcher->context, watcher->session, watcher->filter, item->device);
+			if (status != DC_STATUS_SUCCESS) {
+				WARNING (watcher->context, "Failed to probe the usb device.");
+			}
+
+			if (device) {
+				dc_usbhid_entry_t *node = (dc_usbhid_entry_t *) malloc (sizeof(dc_usbhid_entry_t));
+				if (node == NULL) {
+					ERROR (watcher->context, "Failed to allocate memory.");
+					dc_usbhid_device_free (device);
+				} else {
+					node->device = device;
+					node->next = NULL;
+					*entry = node;
+
+					watcher->callback (device, 1, watcher->userdata);
+					count++;
+				}
+			}
+		} else if (!item->arrived && *entry != NULL) {
+			dc_usbhid_entry_t *node = *entry;
+			*entry = node->next;
+
+			watcher->callback (node->device, 0, watcher->userdata);
+			count++;
+
+			dc_usbhid_device_free (node->device);
+			free (node);
+		}
+
+		libusb_unref_device (item->device);
+		free (item);
+	}
+
+	return count;
+}
+
+static void
+dc_usbhid_watcher_discard (dc_usbhid_watcher_t *watcher)
+{
+	dc_usbhid_event_t *events = dc_usbhid_watcher_events (watcher);
+	while (events) {
+		dc_usbhid_event_t *item = events;
+		events = item->next;
+
+		libusb_unref_device (item->device);
+		free (item);
+	}
+}
+#endif
+
+dc_status_t
+dc_usbhid_watcher_new (dc_usbhid_watcher_t **out, dc_context_t *context, dc_descriptor_t *descriptor, dc_usbhid_watcher_callback_t callback, void *userdata)
+{
+#ifdef USBHID_HOTPLUG
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_usbhid_watcher_t *watcher = NULL;
+
+	if (out == NULL || callback == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	watcher = (dc_usbhid_watcher_t *) malloc (sizeof(dc_usbhid_watcher_t));
+	if (watcher == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	watcher->context = context;
+	watcher->filter = dc_descriptor_get_filter (descriptor);
+	watcher->callback = callback;
+	watcher->userdata = userdata;
+	watcher->events = NULL;
+	watcher->tail = &watcher->events;
+	watcher->devices = NULL;
+
+	// Initialize the usb library.
+	status = dc_usbhid_session_new (&watcher->session, context);
+	if (status != DC_STATUS_SUCCESS) {
+		goto error_free;
+	}
+
+	if (!libusb_has_capability (LIBUSB_CAP_HAS_HOTPLUG)) {
+		ERROR (context, "Usb hotplug events are not supported on this platform.");
+		status = DC_STATUS_UNSUPPORTED;
+		goto error_session_unref;
+	}
+
+	status = dc_mutex_new (&watcher->mutex);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (context, "Failed to create a mutex.");
+		goto error_session_unref;
+	}
+
+	// Register for the hotplug events. The devices that are already
+	// plugged in are reported as arrived immediately.
+	int rc = libusb_hotplug_register_callback (watcher->session->handle,
+		LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT,
+		LIBUSB_HOTPLUG_ENUMERATE,
+		LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY,
+		dc_usbhid_watcher_hotplug, watcher, &watcher->hotplug);
+	if (rc != LIBUSB_SUCCESS) {
+		ERROR (context, "Failed to register the usb hotplug callback (%s).",
+			libusb_error_name (rc));
+		status = syserror (rc);
+		goto error_mutex_destroy;
+	}
+
+	*out = watcher;
+
+	return DC_STATUS_SUCCESS;
+
+error_mutex_destroy:
+	dc_usbhid_watcher_discard (watcher);
+	dc_mutex_free (watcher->mutex);
+error_session_unref:
+	dc_usbhid_session_unref (watcher->session);
+error_free:
+	free (watcher);
+	return status;
+#else
+	return DC_STATUS_UNSUPPORTED;
+#endif
+}
+
+dc_status_t
+dc_usbhid_watcher_poll (dc_usbhid_watcher_t *watcher, int timeout)
+{
+#ifdef USBHID_HOTPLUG
+	int rc = LIBUSB_SUCCESS;
+
+	if (watcher == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	// Deliver the events that are already queued without waiting.
+	if (dc_usbhid_watcher_dispatch (watcher))
+		return DC_STATUS_SUCCESS;
+
+	if (timeout < 0) {
+		rc = libusb_handle_events_completed (watcher->session->handle, NULL);
+	} else {
+		struct timeval tv;
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = (timeout % 1000) * 1000;
+		rc = libusb_handle_events_timeout_completed (watcher->session->handle, &tv, NULL);
+	}
+
+	if (rc != LIBUSB_SUCCESS && rc != LIBUSB_ERROR_INTERRUPTED) {
+		ERROR (watcher->context, "Failed to handle the usb events (%s).",
+			libusb_error_name (rc));
+		return syserror (rc);
+	}
+
+	if (dc_usbhid_watcher_dispatch (watcher))
+		return DC_STATUS_SUCCESS;
+
+	return DC_STATUS_TIMEOUT;
+#else
+	return DC_STATUS_UNSUPPORTED;
+#endif
+}
+
+dc_status_t
+dc_usbhid_watcher_free (dc_usbhid_watcher_t *watcher)
+{
+#ifdef USBHID_HOTPLUG
+	if (watcher == NULL)
+		return DC_STATUS_SUCCESS;
+
+	libusb_hotplug_deregister_callback (watcher->session->handle, watcher->hotplug);
+
+	dc_usbhid_watcher_discard (watcher);
+
+	while (watcher->devices) {
+		dc_usbhid_entry_t *node = watcher->devices;
+		watcher->devices = node->next;
+
+		dc_usbhid_device_free (node->device);
+		free (node);
+	}
+
+	dc_mutex_free (watcher->mutex);
+	dc_usbhid_session_unref (watcher->session);
+	free (watcher);
+
+	return DC_STATUS_SUCCESS;
+#else
+	return DC_STATUS_UNSUPPORTED;
+#endif
+}
+
+#if defined(USE_LIBUSB)
+static void
+dc_usbhid_async_submit (dc_usbhid_t *usbhid, struct libusb_transfer *transfer)
+{
+	if (usbhid->error != DC_STATUS_SUCCESS)
+		return;
+
+	// Never have more transfers in flight than there are free slots in
+	// the receive ring. Otherwise a completed report would be lost.
+	if (usbhid->count + usbhid->nactive >= usbhid->capacity) {
+		usbhid->idle[usbhid->nidle++] = transfer;
+		return;
+	}
+
+	int rc = libusb_submit_transfer (transfer);
+	if (rc != LIBUSB_SUCCESS) {
+		ERROR (usbhid->base.context, "Failed to submit the usb transfer (%s).",
+			libusb_error_name (rc));
+		usbhid->error = syserror (rc);
+		return;
+	}
+
+	usbhid->nactive++;
+}
+
+static void LIBUSB_CALL
+dc_usbhid_async_callback (struct libusb_transfer *transfer)
+{
+	dc_usbhid_t *usbhid = (dc_usbhid_t *) transfer->user_data;
+
+	dc_mutex_lock (usbhid->mutex);
+
+	usbhid->nactive--;
+
+	switch (transfer->status) {
+	case LIBUSB_TRANSFER_COMPLETED:
+		if (usbhid->error == DC_STATUS_SUCCESS) {
+			unsigned int idx = (usbhid->head + usbhid->count) % usbhid->capacity;
+			memcpy (usbhid->ring + idx * usbhid->packetsize, transfer->buffer, transfer->actual_length);
+			usbhid->lengths[idx] = transfer->actual_length;
+			usbhid->count++;
+		}
+		dc_usbhid_async_submit (usbhid, transfer);
+		break;
+	case LIBUSB_TRANSFER_TIMED_OUT:
+		dc_usbhid_async_submit (usbhid, transfer);
+		break;
+	case LIBUSB_TRANSFER_CANCELLED:
+		break;
+	default:
+		if (usbhid->error == DC_STATUS_SUCCESS) {
+			ERROR (usbhid->base.context, "Usb read interrupt transfer failed (%u).",
+				transfer->status);
+			if (transfer->status == LIBUSB_TRANSFER_NO_DEVICE) {
+				usbhid->error = DC_STATUS_NODEVICE;
+			} else {
+				usbhid->error = DC_STATUS_IO;
+			}
+		}
+		break;
+	}
+
+	dc_mutex_unlock (usbhid->mutex);
+}
+
+static dc_status_t
+dc_usbhid_async_events (dc_usbhid_t *usbhid, int timeout)
+{
+	int rc = LIBUSB_SUCCESS;
+
+	if (timeout < 0) {
+		rc = libusb_handle_events_completed (usbhid->session->handle, NULL);
+	} else {
+		struct timeval tv;
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = (timeout % 1000) * 1000;
+		rc = libusb_handle_events_timeout_completed (usbhid->session->handle, &tv, NULL);
+	}
+
+	if (rc != LIBUSB_SUCCESS && rc != LIBUSB_ERROR_INTERRUPTED) {
+		ERROR (usbhid->base.context, "Failed to handle the usb events (%s).",
+			libusb_error_name (rc));
+		return syserror (rc);
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+dc_usbhid_async_poll (dc_usbhid_t *usbhid, int timeout)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_usecs_t target = 0;
+	unsigned int nevents = 0;
+
+	if (timeout > 0) {
+		status = dc_timer_now (usbhid->timer, &target);
+		if (status != DC_STATUS_SUCCESS) {
+			return status;
+		}
+
+		target += (dc_usecs_t) timeout * 1000;
+	}
+
+	while (1) {
+		dc_mutex_lock (usbhid->mutex);
+		unsigned int count = usbhid->count;
+		dc_status_t error = usbhid->error;
+		dc_mutex_unlock (usbhid->mutex);
+
+		if (count)
+			return DC_STATUS_SUCCESS;
+
+		if (error != DC_STATUS_SUCCESS)
+			return error;
+
+		// Calculate the remaining timeout.
+		int remaining = timeout;
+		if (timeout > 0) {
+			dc_usecs_t now = 0;
+			status = dc_timer_now (usbhid->timer, &now);
+			if (status != DC_STATUS_SUCCESS) {
+				return status;
+			}
+
+			if (now >= target)
+				return DC_STATUS_TIMEOUT;
+
+			remaining = (target - now + 999) / 1000;
+		} else if (timeout == 0 && nevents) {
+			return DC_STATUS_TIMEOUT;
+		}
+
+		status = dc_usbhid_async_events (usbhid, remaining);
+		if (status != DC_STATUS_SUCCESS) {
+			return status;
+		}
+
+		nevents++;
+	}
+}
+
+static dc_status_t
+dc_usbhid_async_pop (dc_usbhid_t *usbhid, void *data, size_t size, int *actual)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	dc_mutex_lock (usbhid->mutex);
+
+	if (usbhid->count == 0) {
+		status = usbhid->error;
+		if (status == DC_STATUS_SUCCESS)
+			status = DC_STATUS_TIMEOUT;
+		goto out_unlock;
+	}
+
+	// Copy the oldest report. Just like hidapi, the part of the report
+	// that doesn't fit into the buffer is discarded.
+	unsigned int length = usbhid->lengths[usbhid->head];
+	if (length > size)
+		length = size;
+	memcpy (data, usbhid->ring + usbhid->head * usbhid->packetsize, length);
+	usbhid->head = (usbhid->head + 1) % usbhid->capacity;
+	usbhid->count--;
+
+	*actual = length;
+
+	// Resubmit the transfers that were parked while the ring was full.
+	while (usbhid->nidle && usbhid->count + usbhid->nactive < usbhid->capacity) {
+		dc_usbhid_async_submit (usbhid, usbhid->idle[--usbhid->nidle]);
+	}
+
+out_unlock:
+	dc_mutex_unlock (usbhid->mutex);
+
+	return status;
+}
+
+static void
+dc_usbhid_async_stop (dc_usbhid_t *usbhid)
+{
+	if (usbhid->ntransfers == 0)
+		return;
+
+	// Cancel all transfers that are still in flight. Setting the error
+	// prevents the callback from resubmitting a transfer that completed
+	// in the meantime.
+	dc_mutex_lock (usbhid->mutex);
+	usbhid->error = DC_STATUS_CANCELLED;
+	for (unsigned int i = 0; i < usbhid->ntransfers; ++i) {
+		libusb_cancel_transfer (usbhid->transfers[i]);
+	}
+	dc_mutex_unlock (usbhid->mutex);
+
+	// Wait until all cancellations have been delivered. A transfer that
+	// is still owned by libusb can't be freed, and its callback still
+	// refers to this object, so there is no way out before that.
+	unsigned int warned = 0;
+	while (1) {
+		dc_mutex_lock (usbhid->mutex);
+		unsigned int nactive = usbhid->nactive;
+		dc_mutex_unlock (usbhid->mutex);
+
+		if (nactive == 0)
+			break;
+
+		if (dc_usbhid_async_events (usbhid, 100) != DC_STATUS_SUCCESS && !warned) {
+			WARNING (usbhid->base.context, "Waiting for %u usb transfers.", nactive);
+			warned = 1;
+		}
+	}
+
+	for (unsigned int i = 0; i < usbhid->ntransfers; ++i) {
+		libusb_free_transfer (usbhid->transfers[i]);
+	}
+
+	free (usbhid->buffers);
+	free (usbhid->lengths);
+	free (usbhid->ring);
+
+	usbhid->ntransfers = 0;
+	usbhid->nidle = 0;
+	usbhid->count = 0;
+	usbhid->buffers = NULL;
+	usbhid->lengths = NULL;
+	usbhid->ring = NULL;
+}
+
+static dc_status_t
+dc_usbhid_async_start (dc_usbhid_t *usbhid, unsigned int ntransfers)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_context_t *context = usbhid->base.context;
+
+	if (ntransfers == 0 || ntransfers > MAXTRANSFERS)
+		return DC_STATUS_INVALIDARGS;
+
+	int packetsize = libusb_get_max_packet_size (libusb_get_device (usbhid->handle), usbhid->endpoint_in);
+	if (packetsize <= 0) {
+		ERROR (context, "Failed to get the maximum packet size (%s).",
+			libusb_error_name (packetsize));
+		return packetsize ? syserror (packetsize) : DC_STATUS_IO;
+	}
+
+	usbhid->error = DC_STATUS_SUCCESS;
+	usbhid->nactive = 0;
+	usbhid->nidle = 0;
+	usbhid->packetsize = packetsize;
+	usbhid->capacity = 2 * ntransfers;
+	usbhid->head = 0;
+	usbhid->count = 0;
+
+	usbhid->buffers = (unsigned char *) malloc (ntransfers * packetsize);
+	usbhid->lengths = (unsigned int *) malloc (usbhid->capacity * sizeof (unsigned int));
+	usbhid->ring = (unsigned char *) malloc (usbhid->capacity * packetsize);
+	if (usbhid->buffers == NULL || usbhid->lengths == NULL || usbhid->ring == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		status = DC_STATUS_NOMEMORY;
+		goto error_free;
+	}
+
+	for (usbhid->ntransfers = 0; usbhid->ntransfers < ntransfers; usbhid->ntransfers++) {
+		struct libusb_transfer *transfer = libusb_alloc_transfer (0);
+		if (transfer == NULL) {
+			ERROR (context, "Failed to allocate memory.");
+			status = DC_STATUS_NOMEMORY;
+			goto error_stop;
+		}
+
+		libusb_fill_interrupt_transfer (transfer, usbhid->handle, usbhid->endpoint_in,
+			usbhid->buffers + usbhid->ntransfers * packetsize, packetsize,
+			dc_usbhid_async_callback, usbhid, 0);
+
+		usbhid->transfers[usbhid->ntransfers] = transfer;
+	}
+
+	dc_mutex_lock (usbhid->mutex);
+	for (unsigned int i = 0; i < ntransfers; ++i) {
+		dc_usbhid_async_submit (usbhid, usbhid->transfers[i]);
+	}
+	status = usbhid->error;
+	dc_mutex_unlock (usbhid->mutex);
+	if (status != DC_STATUS_SUCCESS) {
+		goto error_stop;
+	}
+
+	return DC_STATUS_SUCCESS;
+
+error_stop:
+	if (usbhid->ntransfers) {
+		dc_usbhid_async_stop (usbhid);
+		return status;
+	}
+error_free:
+	free (usbhid->buffers);
+	free (usbhid->lengths);
+	free (usbhid->ring);
+	usbhid->buffers = NULL;
+	usbhid->lengths = NULL;
+	usbhid->ring = NULL;
+	return status;
+}
+#endif
+
 dc_status_t
 dc_usbhid_open (dc_iostream_t **out, dc_context_t *context, dc_usbhid_device_t *device)
 {
@@ -613,6 +1247,23 @@ dc_usbhid_open (dc_iostream_t **out, dc_context_t *context, dc_usbhid_device_t *
 	usbhid->endpoint_in = device->endpoint_in;
 	usbhid->endpoint_out = device->endpoint_out;
 	usbhid->timeout = 0;
+	usbhid->ntransfers = 0;
+	usbhid->buffers = NULL;
+	usbhid->lengths = NULL;
+	usbhid->ring = NULL;
+
+	// Create a high resolution timer.
+	status = dc_timer_new (&usbhid->timer);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (context, "Failed to create a high resolution timer.");
+		goto error_usb_release;
+	}
+
+	status = dc_mutex_new (&usbhid->mutex);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (context, "Failed to create a mutex.");
+		goto error_timer_free;
+	}
 
 #elif defined(USE_HIDAPI)
 	INFO (context, "Open: path=%s", device->path);
@@ -633,6 +1284,10 @@ dc_usbhid_open (dc_iostream_t **out, dc_context_t *context, dc_usbhid_device_t *
 	return DC_STATUS_SUCCESS;
 
 #if defined(USE_LIBUSB)
+error_timer_free:
+	dc_timer_free (usbhid->timer);
+error_usb_release:
+	libusb_release_interface (usbhid->handle, usbhid->interface);
 error_usb_close:
 	libusb_close (usbhid->handle);
 #endif
@@ -654,6 +1309,9 @@ dc_usbhid_close (dc_iostream_t *abstract)
 	dc_usbhid_t *usbhid = (dc_usbhid_t *) abstract;
 
 #if defined(USE_LIBUSB)
+	dc_usbhid_async_stop (usbhid);
+	dc_mutex_free (usbhid->mutex);
+	dc_timer_free (usbhid->timer);
 	libusb_release_interface (usbhid->handle, usbhid->interface);
 	libusb_close (usbhid->handle);
 #elif defined(USE_HIDAPI)
@@ -691,6 +1349,14 @@ dc_usbhid_set_timeout (dc_iostream_t *abstract, int timeout)
 static dc_status_t
 dc_usbhid_poll (dc_iostream_t *abstract, int timeout)
 {
+#if defined(USE_LIBUSB)
+	dc_usbhid_t *usbhid = (dc_usbhid_t *) abstract;
+
+	if (usbhid->ntransfers) {
+		return dc_usbhid_async_poll (usbhid, timeout);
+	}
+#endif
+
 	return DC_STATUS_UNSUPPORTED;
 }
 
@@ -702,6 +1368,14 @@ dc_usbhid_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual
 	int nbytes = 0;
 
 #if defined(USE_LIBUSB)
+	if (usbhid->ntransfers) {
+		status = dc_usbhid_async_poll (usbhid, usbhid->timeout ? (int) usbhid->timeout : -1);
+		if (status == DC_STATUS_SUCCESS) {
+			status = dc_usbhid_async_pop (usbhid, data, size, &nbytes);
+		}
+		goto out;
+	}
+
 	int rc = libusb_interrupt_transfer (usbhid->handle, usbhid->endpoint_in, data, size, &nbytes, usbhid->timeout);
 	if (rc != LIBUSB_SUCCESS) {
 		ERROR (abstract->context, "Usb read interrupt transfer failed (%s).",
@@ -726,6 +1400,55 @@ out:
 	return status;
 }
 
+static dc_status_t
+dc_usbhid_read_nonblock (dc_iostream_t *abstract, void *data, size_t size, size_t *actual)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_usbhid_t *usbhid = (dc_usbhid_t *) abstract;
+	int nbytes = 0;
+
+#if defined(USE_LIBUSB)
+	if (usbhid->ntransfers) {
+		status = dc_usbhid_async_poll (usbhid, 0);
+		if (status == DC_STATUS_SUCCESS) {
+			status = dc_usbhid_async_pop (usbhid, data, size, &nbytes);
+		}
+		goto out;
+	}
+
+	// A synchronous transfer can't return without waiting (a zero
+	// timeout means infinite for libusb), so use the shortest possible
+	// timeout instead.
+	int rc = libusb_interrupt_transfer (usbhid->handle, usbhid->endpoint_in, data, size, &nbytes, 1);
+	if (rc != LIBUSB_SUCCESS) {
+		if (rc != LIBUSB_ERROR_TIMEOUT) {
+			ERROR (abstract->context, "Usb read interrupt transfer failed (%s).",
+				libusb_error_name (rc));
+		}
+		status = syserror (rc);
+		goto out;
+	}
+#elif defined(USE_HIDAPI)
+	nbytes = hid_read_timeout(usbhid->handle, data, size, 0);
+	if (nbytes < 0) {
+		ERROR (abstract->context, "Usb read interrupt transfer failed.");
+		status = DC_STATUS_IO;
+		nbytes = 0;
+		goto out;
+	}
+#endif
+
+	if (nbytes == 0) {
+		status = DC_STATUS_TIMEOUT;
+	}
+
+out:
+	if (actual)
+		*actual = nbytes;
+
+	return status;
+}
+
 static dc_status_t
 dc_usbhid_write (dc_iostream_t *abstract, const void *data, size_t size, size_t *actual)
 {
@@ -786,6 +1509,20 @@ out:
 static dc_status_t
 dc_usbhid_ioctl (dc_iostream_t *abstract, unsigned int request, void *data, size_t size)
 {
+#if defined(USE_LIBUSB)
+	dc_usbhid_t *usbhid = (dc_usbhid_t *) abstract;
+
+	switch (request) {
+	case DC_IOCTL_USBHID_SET_ASYNC:
+		dc_usbhid_async_stop (usbhid);
+		if (*(unsigned int *) data == 0)
+			return DC_STATUS_SUCCESS;
+		return dc_usbhid_async_start (usbhid, *(unsigned int *) data);
+	default:
+		break;
+	}
+#endif
+
 	return DC_STATUS_UNSUPPORTED;
 }
 #endif
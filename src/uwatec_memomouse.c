@@ -28,6 +28,7 @@
 #include "device-private.h"
 #include "checksum.h"
 #include "array.h"
+#include "buffered.h"
 
 #define ISINSTANCE(device) dc_device_isinstance((device), &uwatec_memomouse_device_vtable)
 
@@ -47,6 +48,7 @@ typedef struct uwatec_memomouse_device_t {
 static dc_status_t uwatec_memomouse_device_set_fingerprint (dc_device_t *device, const unsigned char data[], unsigned int size);
 static dc_status_t uwatec_memomouse_device_dump (dc_device_t *abstract, dc_buffer_t *buffer);
 static dc_status_t uwatec_memomouse_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata);
+static dc_status_t uwatec_memomouse_device_close (dc_device_t *abstract);
 
 static const dc_device_vtable_t uwatec_memomouse_device_vtable = {
 	sizeof(uwatec_memomouse_device_t),
@@ -57,7 +59,7 @@ static const dc_device_vtable_t uwatec_memomouse_device_vtable = {
 	uwatec_memomouse_device_dump, /* dump */
 	uwatec_memomouse_device_foreach, /* foreach */
 	NULL, /* timesync */
-	NULL /* close */
+	uwatec_memomouse_device_close /* close */
 };
 
 static dc_status_t
@@ -80,37 +82,44 @@ uwatec_memomouse_device_open (dc_device_t **out, dc_context_t *context, dc_iostr
 	}
 
 	// Set the default values.
-	device->iostream = iostream;
 	device->timestamp = 0;
 	device->systime = (dc_ticks_t) -1;
 	device->devtime = 0;
 
+	// Read ahead, because every packet is received with a separate read
+	// for its length byte, while the device keeps sending.
+	status = dc_buffered_open (&device->iostream, context, iostream, 1024);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (context, "Failed to create the buffered stream.");
+		goto error_free;
+	}
+
 	// Set the serial communication protocol (9600 8N1).
 	status = dc_iostream_configure (device->iostream, 9600, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the terminal attributes.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Set the timeout for receiving data (1000 ms).
 	status = dc_iostream_set_timeout (device->iostream, 1000);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to set the timeout.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Clear the DTR line.
 	status = dc_iostream_set_dtr (device->iostream, 0);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to clear the DTR line.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Clear the RTS line.
 	status = dc_iostream_set_rts (device->iostream, 0);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to clear the RTS line.");
-		goto error_free;
+		goto error_close;
 	}
 
 	// Make sure everything is in a sane state.
@@ -120,12 +129,23 @@ uwatec_memomouse_device_open (dc_device_t **out, dc_context_t *context, dc_iostr
 
 	return DC_STATUS_SUCCESS;
 
+error_close:
+	dc_iostream_close (device->iostream);
 error_free:
 	dc_device_deallocate ((dc_device_t *) device);
 	return status;
 }
 
 
+static dc_status_t
+uwatec_memomouse_device_close (dc_device_t *abstract)
+{
+	uwatec_memomouse_device_t *device = (uwatec_memomouse_device_t *) abstract;
+
+	return dc_iostream_close (device->iostream);
+}
+
+
 static dc_status_t
 uwatec_memomouse_device_set_fingerprint (dc_device_t *abstract, const unsigned char data[], unsigned int size)
 {
@@ -55,6 +55,10 @@
 
 #define UNSUPPORTED 0xFFFFFFFF
 
+#define NTYPES       256
+#define TYPE_INVALID 0xFE
+#define TYPE_NEXT    0xFF
+
 #define NEVENTS   3
 #define NGASMIXES 10
 
@@ -146,6 +150,8 @@ struct uwatec_smart_parser_t {
 	const uwatec_smart_header_info_t *header;
 	unsigned int headersize;
 	unsigned int nsamples;
+	unsigned int galileo;
+	unsigned char types[NTYPES];
 	const uwatec_smart_event_info_t *events[NEVENTS];
 	unsigned int nevents[NEVENTS];
 	unsigned int trimix;
@@ -160,19 +166,26 @@ struct uwatec_smart_parser_t {
 };
 
 static dc_status_t uwatec_smart_parser_set_data (dc_parser_t *abstract, const unsigned char *data, unsigned int size);
+static dc_status_t uwatec_smart_parser_set_clock (dc_parser_t *abstract, unsigned int devtime, dc_ticks_t systime);
 static dc_status_t uwatec_smart_parser_get_datetime (dc_parser_t *abstract, dc_datetime_t *datetime);
 static dc_status_t uwatec_smart_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsigned int flags, void *value);
 static dc_status_t uwatec_smart_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata);
+static dc_status_t uwatec_smart_parser_samples_batch (dc_parser_t *abstract, dc_sample_table_t *table);
 
-static dc_status_t uwatec_smart_parse (uwatec_smart_parser_t *parser, dc_sample_callback_t callback, void *userdata);
+static dc_status_t uwatec_smart_parse (uwatec_smart_parser_t *parser, dc_sample_callback_t callback, void *userdata, dc_sample_table_t *output);
+static void uwatec_smart_init_types (uwatec_smart_parser_t *parser);
 
 static const dc_parser_vtable_t uwatec_smart_parser_vtable = {
 	sizeof(uwatec_smart_parser_t),
 	DC_FAMILY_UWATEC_SMART,
 	uwatec_smart_parser_set_data, /* set_data */
+	uwatec_smart_parser_set_clock, /* set_clock */
 	uwatec_smart_parser_get_datetime, /* datetime */
 	uwatec_smart_parser_get_field, /* fields */
 	uwatec_smart_parser_samples_foreach, /* samples_foreach */
+	uwatec_smart_parser_samples_batch, /* samples_batch */
+	NULL, /* samples_range */
+	NULL, /* samples_feed */
 	NULL /* destroy */
 };
 
@@ -591,6 +604,7 @@ uwatec_smart_parser_create (dc_parser_t **out, dc_context_t *context, unsigned i
 	parser->devtime = devtime;
 	parser->systime = systime;
 	parser->trimix = 0;
+	parser->galileo = 0;
 	for (unsigned int i = 0; i < NEVENTS; ++i) {
 		parser->events[i] = NULL;
 		parser->nevents[i] = 0;
@@ -615,6 +629,7 @@ uwatec_smart_parser_create (dc_parser_t **out, dc_context_t *context, unsigned i
 		parser->header = &uwatec_smart_galileo_header;
 		parser->samples = uwatec_smart_galileo_samples;
 		parser->nsamples = C_ARRAY_SIZE (uwatec_smart_galileo_samples);
+		parser->galileo = 1;
 		parser->events[0] = uwatec_smart_galileo_events_0;
 		parser->events[1] = uwatec_smart_galileo_events_1;
 		parser->events[2] = uwatec_smart_galileo_events_2;
@@ -630,6 +645,7 @@ uwatec_smart_parser_create (dc_parser_t **out, dc_context_t *context, unsigned i
 		parser->header = &uwatec_smart_trimix_header;
 		parser->samples = uwatec_smart_galileo_samples;
 		parser->nsamples = C_ARRAY_SIZE (uwatec_smart_galileo_samples);
+		parser->galileo = 1;
 		parser->events[0] = uwatec_smart_galileo_events_0;
 		parser->events[1] = uwatec_smart_galileo_events_1;
 		parser->events[2] = uwatec_smart_trimix_events_2;
@@ -680,6 +696,8 @@ uwatec_smart_parser_create (dc_parser_t **out, dc_context_t *context, unsigned i
 		goto error_free;
 	}
 
+	uwatec_smart_init_types (parser);
+
 	parser->cached = 0;
 	parser->ngasmixes = 0;
 	parser->ntanks = 0;
@@ -730,6 +748,18 @@ uwatec_smart_parser_set_data (dc_parser_t *abstract, const unsigned char *data,
 }
 
 
+static dc_status_t
+uwatec_smart_parser_set_clock (dc_parser_t *abstract, unsigned int devtime, dc_ticks_t systime)
+{
+	uwatec_smart_parser_t *parser = (uwatec_smart_parser_t *) abstract;
+
+	parser->devtime = devtime;
+	parser->systime = systime;
+
+	return DC_STATUS_SUCCESS;
+}
+
+
 static dc_status_t
 uwatec_smart_parser_get_datetime (dc_parser_t *abstract, dc_datetime_t *datetime)
 {
@@ -777,9 +807,9 @@ uwatec_smart_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsi
 	if (rc != DC_STATUS_SUCCESS)
 		return rc;
 
-	// Cache the profile data.
-	if (parser->cached < PROFILE) {
-		rc = uwatec_smart_parse (parser, NULL, NULL);
+	// Cache the profile data, unless only the header is requested.
+	if (parser->cached < PROFILE && !abstract->headeronly) {
+		rc = uwatec_smart_parse (parser, NULL, NULL, NULL);
 		if (rc != DC_STATUS_SUCCESS)
 			return rc;
 	}
@@ -802,17 +832,25 @@ uwatec_smart_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsi
 			*((double *) value) = array_uint16_le (data + table->maxdepth) / 100.0 / salinity;
 			break;
 		case DC_FIELD_GASMIX_COUNT:
+			if (parser->cached < PROFILE)
+				return DC_STATUS_UNSUPPORTED;
 			*((unsigned int *) value) = parser->ngasmixes;
 			break;
 		case DC_FIELD_GASMIX:
+			if (parser->cached < PROFILE)
+				return DC_STATUS_UNSUPPORTED;
 			gasmix->helium = parser->gasmix[flags].helium / 100.0;
 			gasmix->oxygen = parser->gasmix[flags].oxygen / 100.0;
 			gasmix->nitrogen = 1.0 - gasmix->oxygen - gasmix->helium;
 			break;
 		case DC_FIELD_TANK_COUNT:
+			if (parser->cached < PROFILE)
+				return DC_STATUS_UNSUPPORTED;
 			*((unsigned int *) value) = parser->ntanks;
 			break;
 		case DC_FIELD_TANK:
+			if (parser->cached < PROFILE)
+				return DC_STATUS_UNSUPPORTED;
 			tank->type = DC_TANKVOLUME_NONE;
 			tank->volume = 0.0;
 			tank->workpressure = 0.0;
@@ -891,6 +929,35 @@ uwatec_galileo_identify (unsigned char value)
 }
 
 
+static void
+uwatec_smart_init_types (uwatec_smart_parser_t *parser)
+{
+	// Precompute the sample type for every possible value of the first
+	// byte, such that the type bits don't have to be processed one by
+	// one for each sample. The Smart type bits are a unary prefix, which
+	// continues in the next byte if all bits of the first byte are set.
+	// Because the count of the second byte is always smaller than the
+	// total count, the same table can be used for the second byte.
+	for (unsigned int i = 0; i < NTYPES; ++i) {
+		unsigned char value = i;
+		unsigned int id = 0;
+		if (parser->galileo) {
+			id = uwatec_galileo_identify (value);
+		} else {
+			id = uwatec_smart_identify (&value, 1);
+		}
+
+		if (id < parser->nsamples) {
+			parser->types[i] = id;
+		} else if (!parser->galileo && value == 0xFF && parser->nsamples > NBITS) {
+			parser->types[i] = TYPE_NEXT;
+		} else {
+			parser->types[i] = TYPE_INVALID;
+		}
+	}
+}
+
+
 static unsigned int
 uwatec_smart_fixsignbit (unsigned int x, unsigned int n)
 {
@@ -910,8 +977,22 @@ uwatec_smart_fixsignbit (unsigned int x, unsigned int n)
 }
 
 
+static unsigned int
+uwatec_smart_sample_id (uwatec_smart_parser_t *parser, const unsigned char data[], unsigned int size)
+{
+	unsigned int id = parser->types[data[0]];
+	if (id == TYPE_NEXT) {
+		id = TYPE_INVALID;
+		if (size > 1 && parser->types[data[1]] < TYPE_INVALID)
+			id = NBITS + parser->types[data[1]];
+	}
+
+	return id;
+}
+
+
 static dc_status_t
-uwatec_smart_parse (uwatec_smart_parser_t *parser, dc_sample_callback_t callback, void *userdata)
+uwatec_smart_parse (uwatec_smart_parser_t *parser, dc_sample_callback_t callback, void *userdata, dc_sample_table_t *output)
 {
 	dc_parser_t *abstract = (dc_parser_t *) parser;
 
@@ -963,19 +1044,7 @@ uwatec_smart_parse (uwatec_smart_parser_t *parser, dc_sample_callback_t callback
 		dc_sample_value_t sample = {0};
 
 		// Process the type bits in the bitstream.
-		unsigned int id = 0;
-		if (parser->model == GALILEO || parser->model == GALILEOTRIMIX ||
-			parser->model == ALADIN2G || parser->model == MERIDIAN ||
-			parser->model == CHROMIS || parser->model == MANTIS2 ||
-			parser->model == G2 || parser->model == ALADINSPORTMATRIX ||
-			parser->model == ALADINSQUARE || parser->model == G2HUD ||
-			parser->model == ALADINA1) {
-			// Uwatec Galileo
-			id = uwatec_galileo_identify (data[offset]);
-		} else {
-			// Uwatec Smart
-			id = uwatec_smart_identify (data + offset, size - offset);
-		}
+		unsigned int id = uwatec_smart_sample_id (parser, data + offset, size - offset);
 		if (id >= entries) {
 			ERROR (abstract->context, "Invalid type bits.");
 			return DC_STATUS_DATAFORMAT;
@@ -1179,7 +1248,10 @@ uwatec_smart_parse (uwatec_smart_parser_t *parser, dc_sample_callback_t callback
 
 		while (complete) {
 			sample.time = time;
-			if (callback) callback (DC_SAMPLE_TIME, sample, userdata);
+			if (output)
+				dc_sample_table_time (output, sample.time);
+			else if (callback)
+				callback (DC_SAMPLE_TIME, sample, userdata);
 
 			if (parser->ngasmixes && gasmix != gasmix_previous) {
 				idx = uwatec_smart_find_gasmix (parser, gasmix);
@@ -1194,7 +1266,10 @@ uwatec_smart_parse (uwatec_smart_parser_t *parser, dc_sample_callback_t callback
 
 			if (have_temperature) {
 				sample.temperature = temperature;
-				if (callback) callback (DC_SAMPLE_TEMPERATURE, sample, userdata);
+				if (output)
+					dc_sample_table_temperature (output, sample.temperature);
+				else if (callback)
+					callback (DC_SAMPLE_TEMPERATURE, sample, userdata);
 			}
 
 			if (bookmark) {
@@ -1215,7 +1290,10 @@ uwatec_smart_parse (uwatec_smart_parser_t *parser, dc_sample_callback_t callback
 				if (idx < parser->ntanks) {
 					sample.pressure.tank = idx;
 					sample.pressure.value = pressure;
-					if (callback) callback (DC_SAMPLE_PRESSURE, sample, userdata);
+					if (output)
+						dc_sample_table_pressure (output, sample.pressure.tank, sample.pressure.value);
+					else if (callback)
+						callback (DC_SAMPLE_PRESSURE, sample, userdata);
 				}
 			}
 
@@ -1232,7 +1310,10 @@ uwatec_smart_parse (uwatec_smart_parser_t *parser, dc_sample_callback_t callback
 
 			if (have_depth) {
 				sample.depth = (depth - depth_calibration) / salinity;
-				if (callback) callback (DC_SAMPLE_DEPTH, sample, userdata);
+				if (output)
+					dc_sample_table_depth (output, sample.depth);
+				else if (callback)
+					callback (DC_SAMPLE_DEPTH, sample, userdata);
 			}
 
 			time += interval;
@@ -1258,10 +1339,31 @@ uwatec_smart_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t
 
 	// Cache the profile data.
 	if (parser->cached < PROFILE) {
-		rc = uwatec_smart_parse (parser, NULL, NULL);
+		rc = uwatec_smart_parse (parser, NULL, NULL, NULL);
+		if (rc != DC_STATUS_SUCCESS)
+			return rc;
+	}
+
+	return uwatec_smart_parse (parser, callback, userdata, NULL);
+}
+
+
+static dc_status_t
+uwatec_smart_parser_samples_batch (dc_parser_t *abstract, dc_sample_table_t *table)
+{
+	uwatec_smart_parser_t *parser = (uwatec_smart_parser_t *) abstract;
+
+	// Cache the parser data.
+	dc_status_t rc = uwatec_smart_parser_cache (parser);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	// Cache the profile data.
+	if (parser->cached < PROFILE) {
+		rc = uwatec_smart_parse (parser, NULL, NULL, NULL);
 		if (rc != DC_STATUS_SUCCESS)
 			return rc;
 	}
 
-	return uwatec_smart_parse (parser, callback, userdata);
+	return uwatec_smart_parse (parser, dc_sample_table_cb, table, table);
 }
@@ -0,0 +1,171 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+/*
+ * Loading and saving the bluetooth cache. The cache entries are only
+ * observable through the serialized form, so every check compares the
+ * saved text.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <libdivecomputer/bluetooth.h>
+#include <libdivecomputer/buffer.h>
+
+#include "common.h"
+
+#define MAX_NAME 248
+
+static dc_bluetooth_cache_t *
+cache_new (dc_context_t *context, const char *text)
+{
+	dc_bluetooth_cache_t *cache = NULL;
+	CHECK (dc_bluetooth_cache_new (&cache, context) == DC_STATUS_SUCCESS);
+	CHECK (dc_bluetooth_cache_load (cache, (const unsigned char *) text, strlen (text)) == DC_STATUS_SUCCESS);
+	return cache;
+}
+
+static int
+cache_equal (dc_bluetooth_cache_t *cache, const char *expected)
+{
+	dc_buffer_t *buffer = dc_buffer_new (0);
+	CHECK (dc_bluetooth_cache_save (cache, buffer) == DC_STATUS_SUCCESS);
+
+	size_t size = dc_buffer_get_size (buffer);
+	int equal = size == strlen (expected) &&
+		memcmp (dc_buffer_get_data (buffer), expected, size) == 0;
+
+	dc_buffer_free (buffer);
+
+	return equal;
+}
+
+/*
+ * An entry with a name of the given length, followed by more text.
+ */
+static void
+line_long (char *text, size_t size, unsigned int length, const char *more)
+{
+	char name[2 * MAX_NAME + 1];
+	memset (name, 'x', length);
+	name[length] = '\0';
+	snprintf (text, size, "A0:B1:C2:D3:E4:F5\t1\t%s\n%s", name, more);
+}
+
+/*
+ * Loading the saved form into a new cache gives the same cache again.
+ */
+static void
+test_roundtrip (dc_context_t *context, const char *text, const char *expected)
+{
+	dc_bluetooth_cache_t *cache = cache_new (context, text);
+	CHECK (cache_equal (cache, expected));
+	dc_bluetooth_cache_free (cache);
+
+	cache = cache_new (context, expected);
+	CHECK (cache_equal (cache, expected));
+	dc_bluetooth_cache_free (cache);
+}
+
+int
+main (void)
+{
+	dc_context_t *context = test_context ();
+
+	// Empty caches.
+	test_roundtrip (context, "", "");
+	test_roundtrip (context, "\n\n", "");
+
+	// The entries keep their order, and the address is normalized.
+	test_roundtrip (context,
+		"00:13:43:0e:2a:01\t5\tOSTC 3\n"
+		"A0:B1:C2:D3:E4:F5\t1\tPetrel\n"
+		"00:00:00:00:00:01\t0\t\n",
+		"00:13:43:0E:2A:01\t5\tOSTC 3\n"
+		"A0:B1:C2:D3:E4:F5\t1\tPetrel\n"
+		"00:00:00:00:00:01\t0\t\n");
+
+	// The last line does not need a newline.
+	test_roundtrip (context,
+		"00:13:43:0E:2A:01\t5\tOSTC 3",
+		"00:13:43:0E:2A:01\t5\tOSTC 3\n");
+
+	// A known address is updated in place.
+	test_roundtrip (context,
+		"00:13:43:0E:2A:01\t5\tOSTC 3\n"
+		"A0:B1:C2:D3:E4:F5\t1\tPetrel\n"
+		"00:13:43:0e:2a:01\t7\tOSTC 4\n",
+		"00:13:43:0E:2A:01\t7\tOSTC 4\n"
+		"A0:B1:C2:D3:E4:F5\t1\tPetrel\n");
+
+	// Invalid entries are ignored.
+	test_roundtrip (context,
+		"garbage\n"
+		"00:13:43:0E:2A:01 5 OSTC 3\n"
+		"00:13:43:0E:2A:01\t5\n"
+		"00:00:00:00:00:00\t5\tZero\n"
+		"00:13:43:0G:2A:01\t5\tHex\n"
+		"A0:B1:C2:D3:E4:F5\t1\tPetrel\n",
+		"A0:B1:C2:D3:E4:F5\t1\tPetrel\n");
+
+	// The carriage returns of CRLF line endings are not part of the name.
+	test_roundtrip (context,
+		"00:13:43:0E:2A:01\t5\tOSTC 3\r\n"
+		"A0:B1:C2:D3:E4:F5\t1\tPetrel\r\n"
+		"00:00:00:00:00:01\t0\t\r",
+		"00:13:43:0E:2A:01\t5\tOSTC 3\n"
+		"A0:B1:C2:D3:E4:F5\t1\tPetrel\n"
+		"00:00:00:00:00:01\t0\t\n");
+
+	// Tabs in the name are replaced on saving.
+	test_roundtrip (context,
+		"A0:B1:C2:D3:E4:F5\t1\tPetrel\t2\n",
+		"A0:B1:C2:D3:E4:F5\t1\tPetrel 2\n");
+
+	// Long names are truncated, and overlong lines are ignored.
+	char text[2 * MAX_NAME + 64], expected[2 * MAX_NAME + 64];
+	line_long (text, sizeof (text), MAX_NAME - 1, "");
+	test_roundtrip (context, text, text);
+	line_long (text, sizeof (text), MAX_NAME + 2, "");
+	line_long (expected, sizeof (expected), MAX_NAME - 1, "");
+	test_roundtrip (context, text, expected);
+	line_long (text, sizeof (text), 2 * MAX_NAME, "00:13:43:0E:2A:01\t5\tOSTC 3\n");
+	test_roundtrip (context, text, "00:13:43:0E:2A:01\t5\tOSTC 3\n");
+
+	// Loading adds to the existing entries.
+	dc_bluetooth_cache_t *cache = cache_new (context, "00:13:43:0E:2A:01\t5\tOSTC 3\n");
+	const char *more = "A0:B1:C2:D3:E4:F5\t1\tPetrel\n";
+	CHECK (dc_bluetooth_cache_load (cache, (const unsigned char *) more, strlen (more)) == DC_STATUS_SUCCESS);
+	CHECK (cache_equal (cache, "00:13:43:0E:2A:01\t5\tOSTC 3\nA0:B1:C2:D3:E4:F5\t1\tPetrel\n"));
+
+	// Invalid arguments.
+	CHECK (dc_bluetooth_cache_load (cache, NULL, 0) == DC_STATUS_SUCCESS);
+	CHECK (dc_bluetooth_cache_load (cache, NULL, 1) == DC_STATUS_INVALIDARGS);
+	CHECK (dc_bluetooth_cache_load (NULL, (const unsigned char *) more, strlen (more)) == DC_STATUS_INVALIDARGS);
+	CHECK (dc_bluetooth_cache_save (cache, NULL) == DC_STATUS_INVALIDARGS);
+	CHECK (dc_bluetooth_cache_new (NULL, context) == DC_STATUS_INVALIDARGS);
+	dc_bluetooth_cache_free (cache);
+
+	dc_context_free (context);
+
+	return test_result ();
+}
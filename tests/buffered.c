@@ -0,0 +1,343 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+/*
+ * The buffered I/O stream on top of a fake stream, which records the
+ * reads that reach it. Only the bytes that have already arrived are
+ * reported as available, but a read can wait for more.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libdivecomputer/custom.h>
+
+#include "common.h"
+#include "buffered.h"
+
+#define CAPACITY 64
+#define SIZE 4096
+
+typedef struct fake_t {
+	unsigned char data[SIZE];
+	size_t position;
+	size_t arrived;
+	unsigned int nreads;
+	size_t lastread;
+} fake_t;
+
+static dc_status_t
+fake_get_available (void *userdata, size_t *value)
+{
+	fake_t *fake = (fake_t *) userdata;
+
+	*value = fake->arrived - fake->position;
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+fake_poll (void *userdata, int timeout)
+{
+	fake_t *fake = (fake_t *) userdata;
+
+	return fake->arrived > fake->position ? DC_STATUS_SUCCESS : DC_STATUS_TIMEOUT;
+}
+
+static dc_status_t
+fake_read (void *userdata, void *data, size_t size, size_t *actual)
+{
+	fake_t *fake = (fake_t *) userdata;
+
+	size_t n = SIZE - fake->position;
+	if (n > size)
+		n = size;
+
+	memcpy (data, fake->data + fake->position, n);
+	fake->position += n;
+	if (fake->arrived < fake->position)
+		fake->arrived = fake->position;
+	fake->nreads++;
+	fake->lastread = size;
+
+	*actual = n;
+
+	return n == size ? DC_STATUS_SUCCESS : DC_STATUS_TIMEOUT;
+}
+
+static dc_status_t
+fake_purge (void *userdata, dc_direction_t direction)
+{
+	return DC_STATUS_SUCCESS;
+}
+
+static const dc_custom_cbs_t g_callbacks = {
+	NULL, /* set_timeout */
+	NULL, /* set_break */
+	NULL, /* set_dtr */
+	NULL, /* set_rts */
+	NULL, /* get_lines */
+	fake_get_available, /* get_available */
+	NULL, /* configure */
+	fake_poll, /* poll */
+	fake_read, /* read */
+	NULL, /* write */
+	NULL, /* ioctl */
+	NULL, /* flush */
+	fake_purge, /* purge */
+	NULL, /* sleep */
+	NULL, /* close */
+};
+
+static void
+fake_reset (fake_t *fake)
+{
+	for (unsigned int i = 0; i < SIZE; ++i)
+		fake->data[i] = (i * 7 + i / 256) & 0xFF;
+	fake->position = 0;
+	fake->arrived = 0;
+	fake->nreads = 0;
+	fake->lastread = 0;
+}
+
+static dc_iostream_t *
+buffered_open (dc_context_t *context, dc_iostream_t *base)
+{
+	dc_iostream_t *iostream = NULL;
+	if (!CHECK (dc_buffered_open (&iostream, context, base, CAPACITY) == DC_STATUS_SUCCESS))
+		exit (EXIT_FAILURE);
+	return iostream;
+}
+
+static void
+test_readahead (dc_context_t *context, dc_iostream_t *base, fake_t *fake)
+{
+	dc_iostream_t *iostream = buffered_open (context, base);
+	unsigned char byte = 0;
+	size_t actual = 0;
+
+	// Everything that has arrived is read along with the first byte.
+	fake_reset (fake);
+	fake->arrived = 100;
+	CHECK (dc_iostream_read (iostream, &byte, 1, &actual) == DC_STATUS_SUCCESS);
+	CHECK (actual == 1 && byte == fake->data[0]);
+	CHECK (fake->nreads == 1 && fake->lastread == CAPACITY);
+
+	// The remaining bytes come from the buffer.
+	for (unsigned int i = 1; i < CAPACITY; ++i) {
+		CHECK (dc_iostream_read (iostream, &byte, 1, &actual) == DC_STATUS_SUCCESS);
+		CHECK (actual == 1 && byte == fake->data[i]);
+	}
+	CHECK (fake->nreads == 1);
+
+	// Without any data available, a read never waits for more than the
+	// missing bytes.
+	fake->arrived = fake->position;
+	unsigned char data[8];
+	CHECK (dc_iostream_read (iostream, data, 5, &actual) == DC_STATUS_SUCCESS);
+	CHECK (actual == 5 && memcmp (data, fake->data + CAPACITY, 5) == 0);
+	CHECK (fake->nreads == 2 && fake->lastread == 5);
+	CHECK (dc_iostream_get_available (iostream, &actual) == DC_STATUS_SUCCESS && actual == 0);
+
+	dc_iostream_close (iostream);
+}
+
+static void
+test_sequence (dc_context_t *context, dc_iostream_t *base, fake_t *fake)
+{
+	dc_iostream_t *iostream = buffered_open (context, base);
+	unsigned char data[3 * CAPACITY];
+	unsigned int seed = 1;
+	size_t position = 0;
+
+	// Random read sizes and arrivals return the data in order.
+	fake_reset (fake);
+	while (position < SIZE - sizeof (data)) {
+		size_t size = 1 + test_random (&seed) % sizeof (data);
+		fake->arrived += test_random (&seed) % (2 * CAPACITY);
+		if (fake->arrived > SIZE)
+			fake->arrived = SIZE;
+
+		size_t actual = 0;
+		CHECK (dc_iostream_read (iostream, data, size, &actual) == DC_STATUS_SUCCESS);
+		if (!CHECK (actual == size && memcmp (data, fake->data + position, size) == 0))
+			break;
+		position += size;
+	}
+
+	// A read beyond the end times out, with the remaining data.
+	size_t actual = 0;
+	size_t remaining = SIZE - position;
+	CHECK (dc_iostream_read (iostream, data, sizeof (data), &actual) == DC_STATUS_TIMEOUT);
+	CHECK (actual == remaining && memcmp (data, fake->data + position, remaining) == 0);
+
+	dc_iostream_close (iostream);
+}
+
+static void
+test_peek (dc_context_t *context, dc_iostream_t *base, fake_t *fake)
+{
+	dc_iostream_t *iostream = buffered_open (context, base);
+	unsigned char data[CAPACITY + 1], peek[CAPACITY + 1];
+	size_t actual = 0;
+
+	fake_reset (fake);
+	fake->arrived = 10;
+
+	CHECK (dc_buffered_peek (iostream, peek, 4, &actual) == DC_STATUS_SUCCESS);
+	CHECK (actual == 4 && memcmp (peek, fake->data, 4) == 0);
+	CHECK (dc_buffered_peek (iostream, peek, 8, &actual) == DC_STATUS_SUCCESS);
+	CHECK (actual == 8 && memcmp (peek, fake->data, 8) == 0);
+	CHECK (fake->nreads == 1);
+
+	// A read returns the same bytes again.
+	CHECK (dc_iostream_read (iostream, data, 6, &actual) == DC_STATUS_SUCCESS);
+	CHECK (actual == 6 && memcmp (data, fake->data, 6) == 0);
+
+	// Peeking more than is buffered waits for the missing bytes.
+	CHECK (dc_buffered_peek (iostream, peek, CAPACITY, &actual) == DC_STATUS_SUCCESS);
+	CHECK (actual == CAPACITY && memcmp (peek, fake->data + 6, CAPACITY) == 0);
+	CHECK (dc_iostream_read (iostream, data, CAPACITY, &actual) == DC_STATUS_SUCCESS);
+	CHECK (actual == CAPACITY && memcmp (data, fake->data + 6, CAPACITY) == 0);
+
+	// The peek size is limited to the buffer size.
+	CHECK (dc_buffered_peek (iostream, peek, CAPACITY + 1, &actual) == DC_STATUS_INVALIDARGS);
+	CHECK (actual == 0);
+
+	// Peeking beyond the end times out, with the remaining data.
+	fake->position = fake->arrived = SIZE - 3;
+	CHECK (dc_buffered_peek (iostream, peek, 8, &actual) == DC_STATUS_TIMEOUT);
+	CHECK (actual == 3 && memcmp (peek, fake->data + SIZE - 3, 3) == 0);
+	CHECK (dc_iostream_read (iostream, data, 3, &actual) == DC_STATUS_SUCCESS);
+	CHECK (actual == 3 && memcmp (data, fake->data + SIZE - 3, 3) == 0);
+
+	dc_iostream_close (iostream);
+}
+
+static void
+test_unread (dc_context_t *context, dc_iostream_t *base, fake_t *fake)
+{
+	dc_iostream_t *iostream = buffered_open (context, base);
+	unsigned char data[4 * CAPACITY], pushed[3 * CAPACITY];
+	size_t actual = 0;
+
+	for (unsigned int i = 0; i < sizeof (pushed); ++i)
+		pushed[i] = ~i & 0xFF;
+
+	fake_reset (fake);
+	fake->arrived = 32;
+
+	// Push back in front of buffered data.
+	CHECK (dc_iostream_read (iostream, data, 8, &actual) == DC_STATUS_SUCCESS);
+	CHECK (dc_buffered_unread (iostream, data + 4, 4) == DC_STATUS_SUCCESS);
+	CHECK (dc_buffered_unread (iostream, pushed, 3) == DC_STATUS_SUCCESS);
+	CHECK (dc_iostream_read (iostream, data, 11, &actual) == DC_STATUS_SUCCESS);
+	CHECK (actual == 11);
+	CHECK (memcmp (data, pushed, 3) == 0);
+	CHECK (memcmp (data + 3, fake->data + 4, 8) == 0);
+
+	// Pushing back more than fits grows the buffer.
+	CHECK (dc_buffered_unread (iostream, pushed, sizeof (pushed)) == DC_STATUS_SUCCESS);
+	CHECK (dc_iostream_read (iostream, data, sizeof (pushed) + 4, &actual) == DC_STATUS_SUCCESS);
+	CHECK (actual == sizeof (pushed) + 4);
+	CHECK (memcmp (data, pushed, sizeof (pushed)) == 0);
+	CHECK (memcmp (data + sizeof (pushed), fake->data + 12, 4) == 0);
+
+	// Pushed back data is returned by a peek too.
+	CHECK (dc_buffered_unread (iostream, pushed, 2) == DC_STATUS_SUCCESS);
+	CHECK (dc_buffered_peek (iostream, data, 4, &actual) == DC_STATUS_SUCCESS);
+	CHECK (actual == 4 && memcmp (data, pushed, 2) == 0 && memcmp (data + 2, fake->data + 16, 2) == 0);
+
+	// Purging the input discards all buffered data.
+	CHECK (dc_iostream_purge (iostream, DC_DIRECTION_INPUT) == DC_STATUS_SUCCESS);
+	size_t position = fake->position;
+	CHECK (dc_iostream_read (iostream, data, 1, &actual) == DC_STATUS_SUCCESS);
+	CHECK (actual == 1 && data[0] == fake->data[position]);
+
+	CHECK (dc_buffered_unread (iostream, pushed, 0) == DC_STATUS_SUCCESS);
+
+	dc_iostream_close (iostream);
+}
+
+static void
+test_bypass (dc_context_t *context, dc_iostream_t *base, fake_t *fake)
+{
+	dc_iostream_t *iostream = buffered_open (context, base);
+	unsigned char data[4 * CAPACITY];
+	size_t actual = 0;
+
+	fake_reset (fake);
+	fake->arrived = SIZE;
+
+	// A large read on an empty buffer goes straight to the stream.
+	CHECK (dc_iostream_read (iostream, data, 2 * CAPACITY, &actual) == DC_STATUS_SUCCESS);
+	CHECK (actual == 2 * CAPACITY && memcmp (data, fake->data, actual) == 0);
+	CHECK (fake->nreads == 1 && fake->lastread == 2 * CAPACITY);
+
+	// With buffered data, only the remainder bypasses the buffer.
+	CHECK (dc_iostream_read (iostream, data, 1, &actual) == DC_STATUS_SUCCESS);
+	CHECK (fake->nreads == 2 && fake->lastread == CAPACITY);
+	CHECK (dc_iostream_read (iostream, data, 3 * CAPACITY, &actual) == DC_STATUS_SUCCESS);
+	CHECK (actual == 3 * CAPACITY && memcmp (data, fake->data + 2 * CAPACITY + 1, actual) == 0);
+	CHECK (fake->nreads == 3 && fake->lastread == 2 * CAPACITY + 1);
+
+	// Buffered data is reported as available, and satisfies a poll.
+	fake->arrived = fake->position;
+	CHECK (dc_iostream_poll (iostream, 0) == DC_STATUS_TIMEOUT);
+	CHECK (dc_buffered_unread (iostream, data, 5) == DC_STATUS_SUCCESS);
+	CHECK (dc_iostream_poll (iostream, 0) == DC_STATUS_SUCCESS);
+	CHECK (dc_iostream_get_available (iostream, &actual) == DC_STATUS_SUCCESS && actual == 5);
+	fake->arrived += 7;
+	CHECK (dc_iostream_get_available (iostream, &actual) == DC_STATUS_SUCCESS && actual == 12);
+
+	dc_iostream_close (iostream);
+}
+
+int
+main (void)
+{
+	static fake_t fake;
+	dc_iostream_t *base = NULL, *iostream = NULL;
+
+	dc_context_t *context = test_context ();
+
+	CHECK (dc_custom_open (&base, context, DC_TRANSPORT_SERIAL, &g_callbacks, &fake) == DC_STATUS_SUCCESS);
+	CHECK (dc_buffered_open (&iostream, context, base, 0) == DC_STATUS_INVALIDARGS);
+	CHECK (dc_buffered_open (&iostream, context, base, CAPACITY) == DC_STATUS_SUCCESS);
+	CHECK (dc_iostream_get_transport (iostream) == DC_TRANSPORT_SERIAL);
+
+	// The extra functions only accept a buffered stream.
+	unsigned char byte = 0;
+	CHECK (dc_buffered_peek (base, &byte, 1, NULL) == DC_STATUS_INVALIDARGS);
+	CHECK (dc_buffered_unread (base, &byte, 1) == DC_STATUS_INVALIDARGS);
+
+	test_readahead (context, base, &fake);
+	test_sequence (context, base, &fake);
+	test_peek (context, base, &fake);
+	test_unread (context, base, &fake);
+	test_bypass (context, base, &fake);
+
+	dc_iostream_close (iostream);
+	dc_iostream_close (base);
+	dc_context_free (context);
+
+	return test_result ();
+}
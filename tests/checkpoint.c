@@ -0,0 +1,308 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+/*
+ * Resuming an interrupted memory dump from a checkpoint. A fake device
+ * dumps its memory with device_dump_read, and fails after a number of
+ * reads to simulate a lost connection. The resumed dump must read the
+ * first and the last restored block again, skip the blocks in between,
+ * and restart from zero when the checkpoint does not match.
+ */
+
+#include <string.h>
+
+#include "common.h"
+#include "device-private.h"
+
+#define SIZE      1000
+#define BLOCKSIZE 64
+#define NBLOCKS   ((SIZE + BLOCKSIZE - 1) / BLOCKSIZE)
+#define MAXREADS  64
+#define SERIAL    1234
+
+#define CHECKPOINT_HEADER 24
+
+typedef struct fake_device_t {
+	dc_device_t base;
+	unsigned char memory[SIZE];
+	unsigned int limit;
+	unsigned int nreads;
+	unsigned int addresses[MAXREADS];
+} fake_device_t;
+
+static dc_status_t
+fake_device_read (dc_device_t *abstract, unsigned int address, unsigned char data[], unsigned int size)
+{
+	fake_device_t *device = (fake_device_t *) abstract;
+
+	if (device->limit && device->nreads >= device->limit)
+		return DC_STATUS_IO;
+
+	if (device->nreads < MAXREADS)
+		device->addresses[device->nreads] = address;
+	device->nreads++;
+
+	memcpy (data, device->memory + address, size);
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+fake_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
+{
+	if (!dc_buffer_clear (buffer) || !dc_buffer_resize (buffer, SIZE))
+		return DC_STATUS_NOMEMORY;
+
+	return device_dump_read (abstract, dc_buffer_get_data (buffer),
+		dc_buffer_get_size (buffer), BLOCKSIZE);
+}
+
+static const dc_device_vtable_t fake_device_vtable = {
+	sizeof (fake_device_t),
+	DC_FAMILY_NULL,
+	NULL, /* set_fingerprint */
+	fake_device_read, /* read */
+	NULL, /* write */
+	fake_device_dump, /* dump */
+	NULL, /* foreach */
+	NULL, /* timesync */
+	NULL, /* close */
+};
+
+static unsigned char g_memory[SIZE];
+
+/*
+ * Dump the memory of a device, failing after the given number of reads.
+ */
+static fake_device_t *
+session (dc_context_t *context, dc_buffer_t *checkpoint, unsigned int serial, unsigned int limit, dc_status_t expected)
+{
+	static fake_device_t result;
+
+	fake_device_t *device = (fake_device_t *) dc_device_allocate (context, &fake_device_vtable);
+	CHECK (device != NULL);
+	memcpy (device->memory, g_memory, sizeof (g_memory));
+	device->limit = limit;
+	device->nreads = 0;
+	device->base.devinfo.serial = serial;
+
+	dc_buffer_t *buffer = dc_buffer_new (0);
+	CHECK (dc_device_set_checkpoint ((dc_device_t *) device, checkpoint) == DC_STATUS_SUCCESS);
+	CHECK (dc_device_dump ((dc_device_t *) device, buffer) == expected);
+	if (expected == DC_STATUS_SUCCESS) {
+		CHECK (dc_buffer_get_size (buffer) == SIZE);
+		CHECK (memcmp (dc_buffer_get_data (buffer), g_memory, SIZE) == 0);
+	}
+	dc_buffer_free (buffer);
+
+	result = *device;
+	dc_device_close ((dc_device_t *) device);
+
+	return &result;
+}
+
+/*
+ * The checkpoint holds the given number of blocks of the memory.
+ */
+static int
+checkpoint_equal (dc_buffer_t *checkpoint, unsigned int nblocks)
+{
+	if (dc_buffer_get_size (checkpoint) != CHECKPOINT_HEADER + nblocks * BLOCKSIZE)
+		return 0;
+
+	return memcmp (dc_buffer_get_data (checkpoint) + CHECKPOINT_HEADER, g_memory, nblocks * BLOCKSIZE) == 0;
+}
+
+/*
+ * The device was read at the given addresses, and then sequentially from
+ * the given block to the end.
+ */
+static int
+reads_equal (const fake_device_t *device, const unsigned int prefix[], unsigned int nprefix, unsigned int block)
+{
+	if (device->nreads != nprefix + NBLOCKS - block)
+		return 0;
+
+	for (unsigned int i = 0; i < nprefix; ++i) {
+		if (device->addresses[i] != prefix[i])
+			return 0;
+	}
+
+	for (unsigned int i = nprefix; i < device->nreads; ++i) {
+		if (device->addresses[i] != (block + i - nprefix) * BLOCKSIZE)
+			return 0;
+	}
+
+	return 1;
+}
+
+static void
+test_complete (dc_context_t *context)
+{
+	dc_buffer_t *checkpoint = dc_buffer_new (0);
+
+	// A complete dump leaves an empty checkpoint.
+	fake_device_t *device = session (context, checkpoint, SERIAL, 0, DC_STATUS_SUCCESS);
+	CHECK (reads_equal (device, NULL, 0, 0));
+	CHECK (dc_buffer_get_size (checkpoint) == 0);
+
+	// Without a checkpoint nothing changes.
+	device = session (context, NULL, SERIAL, 0, DC_STATUS_SUCCESS);
+	CHECK (reads_equal (device, NULL, 0, 0));
+
+	dc_buffer_free (checkpoint);
+}
+
+static void
+test_resume (dc_context_t *context, unsigned int nblocks)
+{
+	dc_buffer_t *checkpoint = dc_buffer_new (0);
+
+	// The interrupted dump stores the blocks received so far.
+	session (context, checkpoint, SERIAL, nblocks, DC_STATUS_IO);
+	CHECK (checkpoint_equal (checkpoint, nblocks));
+
+	// The resumed dump reads the first block, and continues with the
+	// last restored block.
+	unsigned int last = nblocks - 1;
+	const unsigned int prefix[] = {0};
+	fake_device_t *device = session (context, checkpoint, SERIAL, 0, DC_STATUS_SUCCESS);
+	CHECK (reads_equal (device, prefix, 1, last ? last : 1));
+	CHECK (dc_buffer_get_size (checkpoint) == 0);
+
+	dc_buffer_free (checkpoint);
+}
+
+static void
+test_resume_twice (dc_context_t *context)
+{
+	dc_buffer_t *checkpoint = dc_buffer_new (0);
+
+	session (context, checkpoint, SERIAL, 4, DC_STATUS_IO);
+	CHECK (checkpoint_equal (checkpoint, 4));
+
+	// An interrupted resumed dump keeps the restored blocks.
+	fake_device_t *device = session (context, checkpoint, SERIAL, 6, DC_STATUS_IO);
+	CHECK (device->addresses[0] == 0 && device->addresses[1] == 3 * BLOCKSIZE);
+	CHECK (checkpoint_equal (checkpoint, 8));
+
+	const unsigned int prefix[] = {0};
+	device = session (context, checkpoint, SERIAL, 0, DC_STATUS_SUCCESS);
+	CHECK (reads_equal (device, prefix, 1, 7));
+	CHECK (dc_buffer_get_size (checkpoint) == 0);
+
+	dc_buffer_free (checkpoint);
+}
+
+/*
+ * The memory changed between the two sessions, in the first or in the
+ * last restored block. The dump restarts from zero once the change is
+ * noticed.
+ */
+static void
+test_mismatch (dc_context_t *context, unsigned int offset, const unsigned int prefix[], unsigned int nprefix)
+{
+	dc_buffer_t *checkpoint = dc_buffer_new (0);
+
+	session (context, checkpoint, SERIAL, 8, DC_STATUS_IO);
+	CHECK (checkpoint_equal (checkpoint, 8));
+
+	g_memory[offset] ^= 0xFF;
+	fake_device_t *device = session (context, checkpoint, SERIAL, 0, DC_STATUS_SUCCESS);
+	CHECK (reads_equal (device, prefix, nprefix, 0));
+	CHECK (dc_buffer_get_size (checkpoint) == 0);
+	g_memory[offset] ^= 0xFF;
+
+	dc_buffer_free (checkpoint);
+}
+
+/*
+ * A checkpoint that does not belong to this dump is discarded. The header
+ * byte at the given offset is changed, or the checkpoint is truncated to
+ * the given length.
+ */
+static void
+test_restart (dc_context_t *context, unsigned int offset, unsigned int length, unsigned int serial)
+{
+	dc_buffer_t *checkpoint = dc_buffer_new (0);
+
+	session (context, checkpoint, SERIAL, 8, DC_STATUS_IO);
+	CHECK (checkpoint_equal (checkpoint, 8));
+
+	if (offset < CHECKPOINT_HEADER)
+		dc_buffer_get_data (checkpoint)[offset] ^= 0xFF;
+	if (length)
+		dc_buffer_resize (checkpoint, length);
+
+	// The dump is interrupted again, to check that the checkpoint was
+	// replaced with a fresh one.
+	fake_device_t *device = session (context, checkpoint, serial, 4, DC_STATUS_IO);
+	CHECK (device->addresses[0] == 0 && device->addresses[1] == BLOCKSIZE);
+	CHECK (checkpoint_equal (checkpoint, 4));
+
+	dc_buffer_free (checkpoint);
+}
+
+int
+main (void)
+{
+	unsigned int seed = 1;
+	for (unsigned int i = 0; i < SIZE; ++i)
+		g_memory[i] = test_random (&seed) & 0xFF;
+
+	dc_context_t *context = test_context ();
+
+	test_complete (context);
+
+	for (unsigned int nblocks = 1; nblocks < NBLOCKS; ++nblocks)
+		test_resume (context, nblocks);
+	test_resume_twice (context);
+
+	// The first or the last restored block was changed.
+	const unsigned int first[] = {0};
+	const unsigned int last[] = {0, 7 * BLOCKSIZE};
+	test_mismatch (context, 10, first, 1);
+	test_mismatch (context, 7 * BLOCKSIZE + 10, last, 2);
+
+	// The magic, the family, the size and the device identity.
+	test_restart (context, 0, 0, SERIAL);
+	test_restart (context, 4, 0, SERIAL);
+	test_restart (context, 8, 0, SERIAL);
+	test_restart (context, 12, 0, SERIAL);
+	test_restart (context, 20, 0, SERIAL);
+	test_restart (context, CHECKPOINT_HEADER, 0, SERIAL + 1);
+
+	// Truncated checkpoints, and one without a complete block.
+	test_restart (context, CHECKPOINT_HEADER, 10, SERIAL);
+	test_restart (context, CHECKPOINT_HEADER, CHECKPOINT_HEADER + BLOCKSIZE - 1, SERIAL);
+
+	// A device that does not report its identity is never resumed.
+	test_restart (context, CHECKPOINT_HEADER, 0, 0);
+	dc_buffer_t *checkpoint = dc_buffer_new (0);
+	session (context, checkpoint, 0, 8, DC_STATUS_IO);
+	fake_device_t *device = session (context, checkpoint, 0, 4, DC_STATUS_IO);
+	CHECK (device->addresses[0] == 0 && device->addresses[1] == BLOCKSIZE);
+	dc_buffer_free (checkpoint);
+
+	dc_context_free (context);
+
+	return test_result ();
+}
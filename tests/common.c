@@ -0,0 +1,341 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <libdivecomputer/iterator.h>
+
+#include "common.h"
+
+#define OSTC3_LOGBOOK 256
+#define OSTC3_INTERVAL 10
+
+#define D9_CONFIG   0x3A
+#define D9_INTERVAL 10
+
+static unsigned int g_failures = 0;
+
+int
+test_check (int ok, const char *expr, const char *file, unsigned int line)
+{
+	if (!ok) {
+		fprintf (stderr, "%s:%u: check failed: %s\n", file, line, expr);
+		g_failures++;
+	}
+
+	return ok;
+}
+
+int
+test_result (void)
+{
+	if (g_failures) {
+		fprintf (stderr, "%u check(s) failed.\n", g_failures);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+unsigned int
+test_random (unsigned int *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return (*seed >> 16) & 0x7FFF;
+}
+
+dc_context_t *
+test_context (void)
+{
+	dc_context_t *context = NULL;
+	if (dc_context_new (&context) != DC_STATUS_SUCCESS) {
+		fprintf (stderr, "Failed to create the context.\n");
+		exit (EXIT_FAILURE);
+	}
+
+	dc_context_set_loglevel (context, DC_LOGLEVEL_NONE);
+
+	return context;
+}
+
+dc_descriptor_t *
+test_descriptor (dc_family_t family, unsigned int model)
+{
+	dc_iterator_t *iterator = NULL;
+	if (dc_descriptor_iterator (&iterator) != DC_STATUS_SUCCESS) {
+		fprintf (stderr, "Failed to create the descriptor iterator.\n");
+		exit (EXIT_FAILURE);
+	}
+
+	dc_descriptor_t *descriptor = NULL;
+	while (dc_iterator_next (iterator, &descriptor) == DC_STATUS_SUCCESS) {
+		if (dc_descriptor_get_type (descriptor) == family &&
+			dc_descriptor_get_model (descriptor) == model)
+			break;
+		dc_descriptor_free (descriptor);
+		descriptor = NULL;
+	}
+
+	dc_iterator_free (iterator);
+
+	if (descriptor == NULL) {
+		fprintf (stderr, "No descriptor for family %08x and model %02x.\n", family, model);
+		exit (EXIT_FAILURE);
+	}
+
+	return descriptor;
+}
+
+static void
+put_u16_le (unsigned char data[], unsigned int value)
+{
+	data[0] = value & 0xFF;
+	data[1] = (value >> 8) & 0xFF;
+}
+
+static void
+put_u24_le (unsigned char data[], unsigned int value)
+{
+	data[0] = value & 0xFF;
+	data[1] = (value >> 8) & 0xFF;
+	data[2] = (value >> 16) & 0xFF;
+}
+
+/*
+ * A simple dive profile (in centimeter), descending to the maximum depth
+ * during the first third of the dive, and ascending during the rest.
+ */
+static unsigned int
+test_depth (unsigned int i, unsigned int nsamples)
+{
+	unsigned int bottom = nsamples / 3 + 1;
+	if (i < bottom)
+		return 200 + 3000 * i / bottom + (i % 5) * 7;
+	else
+		return 200 + 3000 * (nsamples - i) / (nsamples - bottom + 1);
+}
+
+static unsigned int
+test_maxdepth (unsigned int nsamples)
+{
+	unsigned int maxdepth = 0;
+	for (unsigned int i = 0; i < nsamples; ++i) {
+		unsigned int depth = test_depth (i, nsamples);
+		if (depth > maxdepth)
+			maxdepth = depth;
+	}
+	return maxdepth;
+}
+
+unsigned int
+test_dive_ostc3 (unsigned char data[], unsigned int size, unsigned int nsamples)
+{
+	// Every sample has a temperature, and every seventh sample also a
+	// bookmark event.
+	unsigned int nevents = (nsamples + 6) / 7;
+	unsigned int length = 5 + 3 + nsamples * 5 + nevents + 2;
+	unsigned int maxdepth = test_maxdepth (nsamples);
+	unsigned int divetime = nsamples * OSTC3_INTERVAL;
+
+	if (size < OSTC3_LOGBOOK + length)
+		return 0;
+
+	memset (data, 0, OSTC3_LOGBOOK + length);
+
+	// Dive header.
+	data[0] = data[1] = 0xFA;
+	data[8] = 0x23;
+	put_u24_le (data + 9, length + 3);
+	data[12] = 24;
+	data[13] = 6;
+	data[14] = 15;
+	data[15] = 10;
+	data[16] = 30;
+	put_u16_le (data + 17, maxdepth);
+	put_u16_le (data + 19, divetime / 60);
+	data[21] = divetime % 60;
+	put_u16_le (data + 22, 200);
+	put_u16_le (data + 24, 1013);
+	data[28] = 21;
+	data[31] = 1;
+	data[48] = 10;
+	data[49] = 30;
+	data[70] = 100;
+	put_u16_le (data + 73, maxdepth * 2 / 3);
+	put_u16_le (data + 75, divetime);
+	put_u16_le (data + 80, 1);
+	data[OSTC3_LOGBOOK - 2] = data[OSTC3_LOGBOOK - 1] = 0xFB;
+
+	// Profile header with the temperature in every sample.
+	unsigned char *profile = data + OSTC3_LOGBOOK;
+	put_u24_le (profile, length + 3);
+	profile[3] = OSTC3_INTERVAL;
+	profile[4] = 1;
+	profile[5] = 0; // Temperature
+	profile[6] = 2;
+	profile[7] = 1;
+
+	unsigned int offset = 8;
+	for (unsigned int i = 0; i < nsamples; ++i) {
+		put_u16_le (profile + offset, test_depth (i, nsamples));
+		if (i % 7 == 0) {
+			profile[offset + 2] = 0x80 | 3;
+			profile[offset + 3] = 0x06; // Manual marker
+			offset += 4;
+		} else {
+			profile[offset + 2] = 2;
+			offset += 3;
+		}
+		put_u16_le (profile + offset, 250 - i % 40);
+		offset += 2;
+	}
+	profile[offset + 0] = profile[offset + 1] = 0xFD;
+
+	return OSTC3_LOGBOOK + length;
+}
+
+unsigned int
+test_dive_d9 (unsigned char data[], unsigned int size, unsigned int nsamples)
+{
+	unsigned int maxdepth = test_maxdepth (nsamples);
+	unsigned int divetime = nsamples * D9_INTERVAL;
+	unsigned int length = D9_CONFIG + 5 + 5 + nsamples * 2;
+
+	if (size < length)
+		return 0;
+
+	memset (data, 0, length);
+
+	put_u16_le (data + 0x09, maxdepth);
+	put_u16_le (data + 0x0B, divetime / 60);
+
+	// Date and time.
+	data[0x11] = 10;
+	data[0x12] = 30;
+	data[0x13] = 0;
+	put_u16_le (data + 0x14, 2024);
+	data[0x16] = 6;
+	data[0x17] = 15;
+
+	// Sample interval and air mode.
+	data[0x18] = D9_INTERVAL;
+	data[0x19] = 0;
+
+	// A single depth parameter (1/100 m), recorded with every sample.
+	data[D9_CONFIG + 0] = 1;
+	data[D9_CONFIG + 2] = 0x64;
+	data[D9_CONFIG + 3] = 1;
+	data[D9_CONFIG + 4] = 0x18;
+
+	// The profile starts without any event markers.
+	unsigned char *profile = data + D9_CONFIG + 5;
+	profile[0] = 0x01;
+
+	for (unsigned int i = 0; i < nsamples; ++i) {
+		put_u16_le (profile + 5 + 2 * i, test_depth (i, nsamples));
+	}
+
+	return length;
+}
+
+void
+test_samples_cb (dc_sample_type_t type, dc_sample_value_t value, void *userdata)
+{
+	test_samples_t *samples = (test_samples_t *) userdata;
+
+	if (samples->count == samples->capacity) {
+		unsigned int capacity = samples->capacity ? samples->capacity * 2 : 64;
+		test_sample_t *items = (test_sample_t *) realloc (samples->samples, capacity * sizeof (test_sample_t));
+		if (items == NULL) {
+			fprintf (stderr, "Failed to allocate memory.\n");
+			exit (EXIT_FAILURE);
+		}
+		samples->samples = items;
+		samples->capacity = capacity;
+	}
+
+	samples->samples[samples->count].type = type;
+	samples->samples[samples->count].value = value;
+	samples->count++;
+}
+
+void
+test_samples_free (test_samples_t *samples)
+{
+	free (samples->samples);
+	samples->samples = NULL;
+	samples->count = 0;
+	samples->capacity = 0;
+}
+
+static int
+test_double_equal (double a, double b)
+{
+	return a == b || (isnan (a) && isnan (b));
+}
+
+int
+test_sample_equal (dc_sample_type_t type, const dc_sample_value_t *a, const dc_sample_value_t *b)
+{
+	switch (type) {
+	case DC_SAMPLE_TIME:
+		return a->time == b->time;
+	case DC_SAMPLE_DEPTH:
+		return test_double_equal (a->depth, b->depth);
+	case DC_SAMPLE_PRESSURE:
+		return a->pressure.tank == b->pressure.tank &&
+			test_double_equal (a->pressure.value, b->pressure.value);
+	case DC_SAMPLE_TEMPERATURE:
+		return test_double_equal (a->temperature, b->temperature);
+	case DC_SAMPLE_EVENT:
+		return a->event.type == b->event.type &&
+			a->event.time == b->event.time &&
+			a->event.flags == b->event.flags &&
+			a->event.value == b->event.value;
+	case DC_SAMPLE_RBT:
+		return a->rbt == b->rbt;
+	case DC_SAMPLE_HEARTBEAT:
+		return a->heartbeat == b->heartbeat;
+	case DC_SAMPLE_BEARING:
+		return a->bearing == b->bearing;
+	case DC_SAMPLE_VENDOR:
+		return a->vendor.type == b->vendor.type &&
+			a->vendor.size == b->vendor.size &&
+			memcmp (a->vendor.data, b->vendor.data, a->vendor.size) == 0;
+	case DC_SAMPLE_SETPOINT:
+		return test_double_equal (a->setpoint, b->setpoint);
+	case DC_SAMPLE_PPO2:
+		return test_double_equal (a->ppo2, b->ppo2);
+	case DC_SAMPLE_CNS:
+		return test_double_equal (a->cns, b->cns);
+	case DC_SAMPLE_DECO:
+		return a->deco.type == b->deco.type &&
+			a->deco.time == b->deco.time &&
+			test_double_equal (a->deco.depth, b->deco.depth);
+	case DC_SAMPLE_GASMIX:
+		return a->gasmix == b->gasmix;
+	default:
+		return 0;
+	}
+}
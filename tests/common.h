@@ -0,0 +1,100 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifndef TESTS_COMMON_H
+#define TESTS_COMMON_H
+
+#include <libdivecomputer/context.h>
+#include <libdivecomputer/descriptor.h>
+#include <libdivecomputer/parser.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Record a failure (with the expression and its location) when the
+ * expression is false. The test keeps running, and test_result returns
+ * the exit code of the test program.
+ */
+#define CHECK(expr) test_check ((expr) != 0, #expr, __FILE__, __LINE__)
+
+int
+test_check (int ok, const char *expr, const char *file, unsigned int line);
+
+int
+test_result (void);
+
+/*
+ * Deterministic pseudo random numbers, independent of the C library.
+ */
+unsigned int
+test_random (unsigned int *seed);
+
+dc_context_t *
+test_context (void);
+
+dc_descriptor_t *
+test_descriptor (dc_family_t family, unsigned int model);
+
+/*
+ * Synthetic dives in the native format of a device. The return value
+ * is the size of the dive, or zero if the buffer is too small.
+ */
+#define TEST_OSTC3  0x0A
+#define TEST_D9     0x0E
+
+unsigned int
+test_dive_ostc3 (unsigned char data[], unsigned int size, unsigned int nsamples);
+
+unsigned int
+test_dive_d9 (unsigned char data[], unsigned int size, unsigned int nsamples);
+
+/*
+ * All the samples reported by a parser, in the order of the callbacks.
+ */
+typedef struct test_sample_t {
+	dc_sample_type_t type;
+	dc_sample_value_t value;
+} test_sample_t;
+
+typedef struct test_samples_t {
+	test_sample_t *samples;
+	unsigned int count;
+	unsigned int capacity;
+} test_samples_t;
+
+void
+test_samples_cb (dc_sample_type_t type, dc_sample_value_t value, void *userdata);
+
+void
+test_samples_free (test_samples_t *samples);
+
+/*
+ * Compare two sample values of the given type, field by field.
+ */
+int
+test_sample_equal (dc_sample_type_t type, const dc_sample_value_t *a, const dc_sample_value_t *b);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* TESTS_COMMON_H */
@@ -0,0 +1,196 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+/*
+ * The adaptive inter packet delay: the back off after failures, the
+ * probing of lower delays and the limits.
+ */
+
+#include "common.h"
+#include "pacing.h"
+
+#define INTERVAL_MIN 32
+#define INTERVAL_MAX 1024
+
+static void
+succeed (dc_pacing_t *pacing, unsigned int n)
+{
+	for (unsigned int i = 0; i < n; ++i)
+		dc_pacing_success (pacing);
+}
+
+static void
+test_limits (void)
+{
+	dc_pacing_t pacing;
+
+	// The initial delay is clamped to the limits.
+	dc_pacing_init (&pacing, 5, 10, 100);
+	CHECK (dc_pacing_enabled (&pacing));
+	CHECK (dc_pacing_delay (&pacing) == 10 && dc_pacing_get (&pacing) == 10);
+	dc_pacing_init (&pacing, 500, 10, 100);
+	CHECK (dc_pacing_delay (&pacing) == 100 && dc_pacing_get (&pacing) == 100);
+
+	// Pacing is disabled without a maximum.
+	dc_pacing_init (&pacing, 0, 0, 0);
+	CHECK (!dc_pacing_enabled (&pacing));
+	CHECK (dc_pacing_delay (&pacing) == 0);
+	dc_pacing_failure (&pacing);
+	CHECK (dc_pacing_delay (&pacing) == 0);
+
+	// The delay never drops below the minimum.
+	dc_pacing_init (&pacing, 10, 10, 100);
+	succeed (&pacing, 100 * INTERVAL_MIN);
+	CHECK (dc_pacing_delay (&pacing) == 10 && dc_pacing_get (&pacing) == 10);
+
+	// The delay never exceeds the maximum.
+	for (unsigned int i = 0; i < 20; ++i)
+		dc_pacing_failure (&pacing);
+	CHECK (dc_pacing_delay (&pacing) == 100 && dc_pacing_get (&pacing) == 10);
+	dc_pacing_success (&pacing);
+	CHECK (dc_pacing_delay (&pacing) == 100 && dc_pacing_get (&pacing) == 100);
+
+	// Setting a delay is clamped too, and makes it the known-good one.
+	dc_pacing_set (&pacing, 1000);
+	CHECK (dc_pacing_delay (&pacing) == 100 && dc_pacing_get (&pacing) == 100);
+	dc_pacing_set (&pacing, 42);
+	CHECK (dc_pacing_delay (&pacing) == 42 && dc_pacing_get (&pacing) == 42);
+}
+
+static void
+test_backoff (void)
+{
+	dc_pacing_t pacing;
+
+	// Back off by half the current delay, at least by one.
+	dc_pacing_init (&pacing, 0, 0, 1000);
+	dc_pacing_failure (&pacing);
+	CHECK (dc_pacing_delay (&pacing) == 1);
+	dc_pacing_failure (&pacing);
+	CHECK (dc_pacing_delay (&pacing) == 2);
+	dc_pacing_failure (&pacing);
+	CHECK (dc_pacing_delay (&pacing) == 3);
+	dc_pacing_failure (&pacing);
+	CHECK (dc_pacing_delay (&pacing) == 4);
+	dc_pacing_failure (&pacing);
+	CHECK (dc_pacing_delay (&pacing) == 6);
+
+	// The backed off delay only becomes the known-good one once a packet
+	// succeeds with it.
+	dc_pacing_set (&pacing, 100);
+	dc_pacing_failure (&pacing);
+	CHECK (dc_pacing_delay (&pacing) == 150 && dc_pacing_get (&pacing) == 100);
+	dc_pacing_failure (&pacing);
+	CHECK (dc_pacing_delay (&pacing) == 225 && dc_pacing_get (&pacing) == 100);
+	dc_pacing_success (&pacing);
+	CHECK (dc_pacing_delay (&pacing) == 225 && dc_pacing_get (&pacing) == 225);
+}
+
+static void
+test_probe (void)
+{
+	dc_pacing_t pacing;
+
+	dc_pacing_init (&pacing, 50, 10, 100);
+
+	// A lower delay is probed after a run of successful packets.
+	succeed (&pacing, INTERVAL_MIN - 1);
+	CHECK (dc_pacing_delay (&pacing) == 50);
+	dc_pacing_success (&pacing);
+	CHECK (dc_pacing_delay (&pacing) == 49 && dc_pacing_get (&pacing) == 50);
+
+	// A successful probe becomes the known-good delay at the next step.
+	succeed (&pacing, INTERVAL_MIN);
+	CHECK (dc_pacing_delay (&pacing) == 48 && dc_pacing_get (&pacing) == 49);
+
+	// A failed probe returns to the known-good delay, and the next
+	// probe takes twice as long.
+	dc_pacing_failure (&pacing);
+	CHECK (dc_pacing_delay (&pacing) == 49 && dc_pacing_get (&pacing) == 49);
+	succeed (&pacing, 2 * INTERVAL_MIN - 1);
+	CHECK (dc_pacing_delay (&pacing) == 49);
+	dc_pacing_success (&pacing);
+	CHECK (dc_pacing_delay (&pacing) == 48);
+
+	// A failure resets the run of successful packets.
+	dc_pacing_set (&pacing, 30);
+	succeed (&pacing, 2 * INTERVAL_MIN - 1);
+	dc_pacing_failure (&pacing);
+	CHECK (dc_pacing_delay (&pacing) == 45);
+	succeed (&pacing, 2 * INTERVAL_MIN - 1);
+	CHECK (dc_pacing_delay (&pacing) == 45);
+
+	// The probe interval is limited.
+	dc_pacing_init (&pacing, 50, 10, 100);
+	for (unsigned int i = 0; i < 20; ++i) {
+		while (dc_pacing_delay (&pacing) == 50)
+			dc_pacing_success (&pacing);
+		dc_pacing_failure (&pacing);
+	}
+	succeed (&pacing, INTERVAL_MAX - 1);
+	CHECK (dc_pacing_delay (&pacing) == 50);
+	dc_pacing_success (&pacing);
+	CHECK (dc_pacing_delay (&pacing) == 49);
+}
+
+/*
+ * A link that fails every packet sent with less than the required delay
+ * settles just above that delay, with only a few failed probes.
+ */
+static void
+test_link (unsigned int initial, unsigned int required)
+{
+	dc_pacing_t pacing;
+	unsigned int failures = 0;
+	unsigned int npackets = 100000;
+
+	dc_pacing_init (&pacing, initial, 0, 1000);
+
+	for (unsigned int i = 0; i < npackets; ++i) {
+		if (dc_pacing_delay (&pacing) < required) {
+			dc_pacing_failure (&pacing);
+			failures++;
+		} else {
+			dc_pacing_success (&pacing);
+		}
+
+		if (i > npackets / 2) {
+			CHECK (dc_pacing_get (&pacing) >= required);
+			CHECK (dc_pacing_delay (&pacing) + 1 >= required);
+		}
+	}
+
+	CHECK (dc_pacing_get (&pacing) <= required + required / 2 + 1);
+	CHECK (failures < 200);
+}
+
+int
+main (void)
+{
+	test_limits ();
+	test_backoff ();
+	test_probe ();
+	test_link (0, 20);
+	test_link (500, 20);
+	test_link (100, 100);
+
+	return test_result ();
+}
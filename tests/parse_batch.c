@@ -0,0 +1,215 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+/*
+ * The results of dc_parse_batch must not depend on the number of worker
+ * threads: every job is parsed exactly as with its own parser, and the
+ * sink sees every job exactly once, in input order.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+#define NJOBS 48
+#define MAXSIZE 8192
+
+typedef struct result_t {
+	dc_status_t status;
+	unsigned int divetime;
+	double maxdepth;
+	unsigned int nsamples;
+	double depths;
+} result_t;
+
+/*
+ * The parse function and the sink share the same userdata.
+ */
+typedef struct batch_t {
+	const dc_parse_job_t *jobs;
+	const result_t *expected;
+	result_t *results;
+	unsigned int count;
+	unsigned int stop;
+} batch_t;
+
+static void
+result_cb (dc_sample_type_t type, dc_sample_value_t value, void *userdata)
+{
+	result_t *result = (result_t *) userdata;
+
+	result->nsamples++;
+	if (type == DC_SAMPLE_DEPTH)
+		result->depths += value.depth;
+}
+
+static dc_status_t
+parse (dc_parser_t *parser, result_t *result)
+{
+	memset (result, 0, sizeof (*result));
+
+	dc_status_t rc = dc_parser_get_field (parser, DC_FIELD_DIVETIME, 0, &result->divetime);
+	if (rc == DC_STATUS_SUCCESS)
+		rc = dc_parser_get_field (parser, DC_FIELD_MAXDEPTH, 0, &result->maxdepth);
+	if (rc == DC_STATUS_SUCCESS)
+		rc = dc_parser_samples_foreach (parser, result_cb, result);
+
+	return rc;
+}
+
+static dc_status_t
+parse_func (dc_parser_t *parser, const dc_parse_job_t *job, void *userdata)
+{
+	batch_t *batch = (batch_t *) userdata;
+
+	return parse (parser, batch->results + (job - batch->jobs));
+}
+
+static int
+sink_func (const dc_parse_job_t *job, dc_status_t status, void *userdata)
+{
+	batch_t *batch = (batch_t *) userdata;
+
+	CHECK (job == batch->jobs + batch->count);
+	CHECK (status == batch->expected[batch->count].status);
+	batch->count++;
+
+	return batch->count != batch->stop;
+}
+
+static void
+test_threads (dc_context_t *context, const dc_parse_job_t jobs[], const result_t expected[], unsigned int nthreads)
+{
+	result_t results[NJOBS];
+	memset (results, 0, sizeof (results));
+
+	batch_t batch = {jobs, expected, results, 0, 0};
+	dc_parse_stats_t stats[4];
+	unsigned int nstats = 4;
+	CHECK (dc_parse_batch (context, jobs, NJOBS, nthreads, parse_func, sink_func, &batch, stats, &nstats) == DC_STATUS_SUCCESS);
+	CHECK (batch.count == NJOBS);
+
+	for (unsigned int i = 0; i < NJOBS; ++i) {
+		if (expected[i].status != DC_STATUS_SUCCESS)
+			continue;
+		CHECK (results[i].divetime == expected[i].divetime);
+		CHECK (results[i].maxdepth == expected[i].maxdepth);
+		CHECK (results[i].nsamples == expected[i].nsamples);
+		CHECK (results[i].depths == expected[i].depths);
+	}
+
+	// One entry per family, with the totals of its jobs.
+	CHECK (nstats == 2);
+	for (unsigned int i = 0; i < nstats; ++i) {
+		unsigned int count = 0, errors = 0;
+		unsigned long long bytes = 0;
+		for (unsigned int j = 0; j < NJOBS; ++j) {
+			if (dc_descriptor_get_type (jobs[j].descriptor) != stats[i].family)
+				continue;
+			count++;
+			bytes += jobs[j].size;
+			if (expected[j].status != DC_STATUS_SUCCESS)
+				errors++;
+		}
+		CHECK (stats[i].count == count);
+		CHECK (stats[i].errors == errors);
+		CHECK (stats[i].bytes == bytes);
+	}
+
+	// Stop after a few jobs.
+	batch.count = 0;
+	batch.stop = 5;
+	CHECK (dc_parse_batch (context, jobs, NJOBS, nthreads, parse_func, sink_func, &batch, NULL, NULL) == DC_STATUS_SUCCESS);
+	CHECK (batch.count == 5);
+
+	// Fewer statistics than families.
+	nstats = 1;
+	CHECK (dc_parse_batch (context, jobs, NJOBS, nthreads, parse_func, NULL, &batch, stats, &nstats) == DC_STATUS_SUCCESS);
+	CHECK (nstats == 1);
+}
+
+int
+main (void)
+{
+	static unsigned char data[NJOBS][MAXSIZE];
+	dc_parse_job_t jobs[NJOBS];
+	result_t expected[NJOBS];
+
+	dc_context_t *context = test_context ();
+	dc_descriptor_t *ostc3 = test_descriptor (DC_FAMILY_HW_OSTC3, TEST_OSTC3);
+	dc_descriptor_t *d9 = test_descriptor (DC_FAMILY_SUUNTO_D9, TEST_D9);
+
+	// Dives of both families, with a few corrupt ones.
+	unsigned int seed = 1;
+	unsigned int nerrors = 0;
+	for (unsigned int i = 0; i < NJOBS; ++i) {
+		unsigned int nsamples = 1 + test_random (&seed) % 500;
+		memset (jobs + i, 0, sizeof (jobs[i]));
+		if (i % 3 == 0) {
+			jobs[i].descriptor = d9;
+			jobs[i].size = test_dive_d9 (data[i], MAXSIZE, nsamples);
+		} else {
+			jobs[i].descriptor = ostc3;
+			jobs[i].size = test_dive_ostc3 (data[i], MAXSIZE, nsamples);
+		}
+		if (i % 11 == 5)
+			jobs[i].size /= 2;
+		jobs[i].data = data[i];
+
+		dc_parser_t *parser = NULL;
+		CHECK (dc_parser_new2 (&parser, context, jobs[i].descriptor, 0, 0) == DC_STATUS_SUCCESS);
+		CHECK (dc_parser_set_data (parser, jobs[i].data, jobs[i].size) == DC_STATUS_SUCCESS);
+		expected[i].status = parse (parser, expected + i);
+		dc_parser_destroy (parser);
+
+		if (expected[i].status != DC_STATUS_SUCCESS)
+			nerrors++;
+	}
+	CHECK (nerrors > 0 && nerrors < NJOBS);
+
+	test_threads (context, jobs, expected, 0);
+	test_threads (context, jobs, expected, 1);
+	test_threads (context, jobs, expected, 4);
+	test_threads (context, jobs, expected, 2 * NJOBS);
+
+	// Without a parse function, the jobs are still decoded.
+	unsigned int count = 0;
+	dc_parse_stats_t stats[2];
+	unsigned int nstats = 2;
+	CHECK (dc_parse_batch (context, jobs, NJOBS, 4, NULL, NULL, NULL, stats, &nstats) == DC_STATUS_SUCCESS);
+	for (unsigned int i = 0; i < nstats; ++i)
+		count += stats[i].count;
+	CHECK (count == NJOBS);
+
+	// Invalid arguments.
+	nstats = 1;
+	CHECK (dc_parse_batch (context, NULL, 1, 0, NULL, NULL, NULL, NULL, NULL) == DC_STATUS_INVALIDARGS);
+	CHECK (dc_parse_batch (context, jobs, NJOBS, 0, NULL, NULL, NULL, NULL, &nstats) == DC_STATUS_INVALIDARGS);
+	jobs[0].descriptor = NULL;
+	CHECK (dc_parse_batch (context, jobs, NJOBS, 0, NULL, NULL, NULL, NULL, NULL) == DC_STATUS_INVALIDARGS);
+
+	dc_descriptor_free (ostc3);
+	dc_descriptor_free (d9);
+	dc_context_free (context);
+
+	return test_result ();
+}
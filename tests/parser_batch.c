@@ -0,0 +1,275 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+/*
+ * The columnar samples returned by dc_parser_samples_batch must contain
+ * exactly the samples reported by dc_parser_samples_foreach, for every
+ * chunk size. The OSTC3 uses a native implementation, and the D9 the
+ * generic one on top of samples_foreach.
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "common.h"
+
+#define NTANKS 1
+#define MAXSIZE 8192
+
+typedef struct expected_t {
+	test_samples_t samples;
+	unsigned int *rows;   // Index of the first sample of each row
+	unsigned int nrows;
+	unsigned int maxevents;
+} expected_t;
+
+static int
+is_column (const test_sample_t *sample)
+{
+	switch (sample->type) {
+	case DC_SAMPLE_TIME:
+	case DC_SAMPLE_DEPTH:
+	case DC_SAMPLE_TEMPERATURE:
+		return 1;
+	case DC_SAMPLE_PRESSURE:
+		return sample->value.pressure.tank < NTANKS;
+	default:
+		return 0;
+	}
+}
+
+static void
+expected_build (expected_t *expected, dc_parser_t *parser)
+{
+	expected->samples.samples = NULL;
+	expected->samples.count = expected->samples.capacity = 0;
+	CHECK (dc_parser_samples_foreach (parser, test_samples_cb, &expected->samples) == DC_STATUS_SUCCESS);
+
+	const test_sample_t *samples = expected->samples.samples;
+	unsigned int count = expected->samples.count;
+
+	expected->rows = (unsigned int *) malloc ((count + 1) * sizeof (unsigned int));
+	expected->nrows = 0;
+	expected->maxevents = 0;
+
+	// Samples before the first time sample belong to time zero.
+	unsigned int nevents = 0;
+	for (unsigned int i = 0; i < count; ++i) {
+		if (samples[i].type == DC_SAMPLE_TIME || i == 0) {
+			expected->rows[expected->nrows++] = i;
+			nevents = 0;
+		}
+		if (!is_column (samples + i)) {
+			nevents++;
+			if (nevents > expected->maxevents)
+				expected->maxevents = nevents;
+		}
+	}
+	expected->rows[expected->nrows] = count;
+}
+
+static void
+expected_free (expected_t *expected)
+{
+	test_samples_free (&expected->samples);
+	free (expected->rows);
+}
+
+/*
+ * Compare one row of a chunk with the samples of the expected row. The
+ * batch returns the events before the pressures without a column.
+ */
+static void
+compare_row (const expected_t *expected, unsigned int row, const dc_sample_batch_t *batch, unsigned int i, unsigned int *event)
+{
+	const test_sample_t *samples = expected->samples.samples;
+	unsigned int begin = expected->rows[row], end = expected->rows[row + 1];
+
+	unsigned int time = 0;
+	double depth = NAN, temperature = NAN, pressure = NAN;
+	for (unsigned int j = begin; j < end; ++j) {
+		switch (samples[j].type) {
+		case DC_SAMPLE_TIME:
+			time = samples[j].value.time;
+			break;
+		case DC_SAMPLE_DEPTH:
+			depth = samples[j].value.depth;
+			break;
+		case DC_SAMPLE_TEMPERATURE:
+			temperature = samples[j].value.temperature;
+			break;
+		case DC_SAMPLE_PRESSURE:
+			if (samples[j].value.pressure.tank < NTANKS)
+				pressure = samples[j].value.pressure.value;
+			break;
+		default:
+			break;
+		}
+	}
+
+	CHECK (batch->time[i] == time);
+	CHECK (batch->depth[i] == depth || (isnan (batch->depth[i]) && isnan (depth)));
+	CHECK (batch->temperature[i] == temperature || (isnan (batch->temperature[i]) && isnan (temperature)));
+	CHECK (batch->pressure[i] == pressure || (isnan (batch->pressure[i]) && isnan (pressure)));
+
+	for (unsigned int pass = 0; pass < 2; ++pass) {
+		for (unsigned int j = begin; j < end; ++j) {
+			if (is_column (samples + j) || (samples[j].type == DC_SAMPLE_PRESSURE) != pass)
+				continue;
+			if (!CHECK (*event < batch->nevents))
+				return;
+			const dc_sample_batch_event_t *e = batch->events + *event;
+			CHECK (e->index == i);
+			CHECK (e->type == samples[j].type);
+			CHECK (test_sample_equal (e->type, &e->value, &samples[j].value));
+			(*event)++;
+		}
+	}
+}
+
+static void
+test_batch (dc_parser_t *parser, const expected_t *expected, unsigned int capacity, unsigned int maxevents)
+{
+	unsigned int *time = (unsigned int *) malloc (capacity * sizeof (unsigned int));
+	double *depth = (double *) malloc (capacity * sizeof (double));
+	double *temperature = (double *) malloc (capacity * sizeof (double));
+	double *pressure = (double *) malloc (NTANKS * capacity * sizeof (double));
+	dc_sample_batch_event_t *events = (dc_sample_batch_event_t *) malloc (maxevents * sizeof (dc_sample_batch_event_t));
+
+	dc_sample_batch_t batch = {0};
+	batch.capacity = capacity;
+	batch.ntanks = NTANKS;
+	batch.time = time;
+	batch.depth = depth;
+	batch.temperature = temperature;
+	batch.pressure = pressure;
+	batch.maxevents = maxevents;
+	batch.events = events;
+
+	unsigned int row = 0;
+	while (1) {
+		if (!CHECK (dc_parser_samples_batch (parser, &batch) == DC_STATUS_SUCCESS))
+			break;
+		if (batch.count == 0)
+			break;
+
+		CHECK (batch.count <= capacity);
+		CHECK (batch.nevents <= maxevents);
+
+		unsigned int event = 0;
+		for (unsigned int i = 0; i < batch.count && row < expected->nrows; ++i, ++row) {
+			compare_row (expected, row, &batch, i, &event);
+		}
+		CHECK (event == batch.nevents);
+	}
+
+	CHECK (row == expected->nrows);
+
+	free (time);
+	free (depth);
+	free (temperature);
+	free (pressure);
+	free (events);
+}
+
+static void
+test_dive (dc_context_t *context, dc_descriptor_t *descriptor, const unsigned char data[], unsigned int size)
+{
+	static const unsigned int capacities[] = {1, 3, 16, 1000};
+
+	dc_parser_t *parser = NULL;
+	if (!CHECK (dc_parser_new2 (&parser, context, descriptor, 0, 0) == DC_STATUS_SUCCESS))
+		return;
+	CHECK (dc_parser_set_data (parser, data, size) == DC_STATUS_SUCCESS);
+
+	expected_t expected;
+	expected_build (&expected, parser);
+	CHECK (expected.nrows > 0);
+
+	for (unsigned int i = 0; i < sizeof (capacities) / sizeof (capacities[0]); ++i) {
+		// Setting the data again rewinds to the first row.
+		CHECK (dc_parser_set_data (parser, data, size) == DC_STATUS_SUCCESS);
+		test_batch (parser, &expected, capacities[i], expected.maxevents ? expected.maxevents : 1);
+
+		CHECK (dc_parser_set_data (parser, data, size) == DC_STATUS_SUCCESS);
+		test_batch (parser, &expected, capacities[i], 1000);
+	}
+
+	// A row is never split, so the events of a single row must fit.
+	if (expected.maxevents > 1) {
+		dc_sample_batch_event_t events[1];
+		unsigned int time[1];
+		dc_sample_batch_t batch = {0};
+		batch.capacity = 1;
+		batch.time = time;
+		batch.maxevents = 1;
+		batch.events = events;
+
+		dc_status_t status = DC_STATUS_SUCCESS;
+		CHECK (dc_parser_set_data (parser, data, size) == DC_STATUS_SUCCESS);
+		do {
+			status = dc_parser_samples_batch (parser, &batch);
+		} while (status == DC_STATUS_SUCCESS && batch.count);
+		CHECK (status == DC_STATUS_NOMEMORY);
+	}
+
+	expected_free (&expected);
+	dc_parser_destroy (parser);
+}
+
+int
+main (void)
+{
+	static const unsigned int nsamples[] = {1, 2, 7, 50, 600};
+	unsigned char data[MAXSIZE];
+
+	dc_context_t *context = test_context ();
+	dc_descriptor_t *ostc3 = test_descriptor (DC_FAMILY_HW_OSTC3, TEST_OSTC3);
+	dc_descriptor_t *d9 = test_descriptor (DC_FAMILY_SUUNTO_D9, TEST_D9);
+
+	for (unsigned int i = 0; i < sizeof (nsamples) / sizeof (nsamples[0]); ++i) {
+		unsigned int size = test_dive_ostc3 (data, sizeof (data), nsamples[i]);
+		CHECK (size != 0);
+		test_dive (context, ostc3, data, size);
+
+		size = test_dive_d9 (data, sizeof (data), nsamples[i]);
+		CHECK (size != 0);
+		test_dive (context, d9, data, size);
+	}
+
+	// Invalid arguments.
+	dc_sample_batch_t batch = {0};
+	dc_parser_t *parser = NULL;
+	unsigned int size = test_dive_d9 (data, sizeof (data), 10);
+	CHECK (dc_parser_new2 (&parser, context, d9, 0, 0) == DC_STATUS_SUCCESS);
+	CHECK (dc_parser_set_data (parser, data, size) == DC_STATUS_SUCCESS);
+	CHECK (dc_parser_samples_batch (parser, &batch) == DC_STATUS_INVALIDARGS);
+	batch.capacity = 1;
+	batch.ntanks = 1;
+	CHECK (dc_parser_samples_batch (parser, &batch) == DC_STATUS_INVALIDARGS);
+	dc_parser_destroy (parser);
+
+	dc_descriptor_free (ostc3);
+	dc_descriptor_free (d9);
+	dc_context_free (context);
+
+	return test_result ();
+}
@@ -0,0 +1,138 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+/*
+ * The samples reported by dc_parser_samples_range must be exactly the
+ * samples of dc_parser_samples_foreach with a time inside the range,
+ * both before and after the index is built. The OSTC3 uses a native
+ * implementation with an index, and the D9 the generic filter.
+ */
+
+#include <stdlib.h>
+
+#include "common.h"
+
+#define MAXSIZE 16384
+
+static void
+test_range (dc_parser_t *parser, const test_samples_t *all, unsigned int begin, unsigned int end)
+{
+	test_samples_t samples = {NULL, 0, 0};
+	CHECK (dc_parser_samples_range (parser, begin, end, test_samples_cb, &samples) == DC_STATUS_SUCCESS);
+
+	// Samples before the first time sample belong to time zero.
+	unsigned int n = 0, time = 0;
+	for (unsigned int i = 0; i < all->count; ++i) {
+		const test_sample_t *sample = all->samples + i;
+		if (sample->type == DC_SAMPLE_TIME)
+			time = sample->value.time;
+		if (time < begin || time > end)
+			continue;
+
+		if (!CHECK (n < samples.count))
+			break;
+		CHECK (samples.samples[n].type == sample->type);
+		CHECK (test_sample_equal (sample->type, &samples.samples[n].value, &sample->value));
+		n++;
+	}
+	CHECK (n == samples.count);
+
+	test_samples_free (&samples);
+}
+
+static void
+test_dive (dc_context_t *context, dc_descriptor_t *descriptor, const unsigned char data[], unsigned int size, unsigned int *seed)
+{
+	dc_parser_t *parser = NULL;
+	test_samples_t all = {NULL, 0, 0};
+
+	CHECK (dc_parser_new2 (&parser, context, descriptor, 0, 0) == DC_STATUS_SUCCESS);
+	CHECK (dc_parser_set_data (parser, data, size) == DC_STATUS_SUCCESS);
+	CHECK (dc_parser_samples_foreach (parser, test_samples_cb, &all) == DC_STATUS_SUCCESS);
+
+	unsigned int divetime = 0;
+	for (unsigned int i = 0; i < all.count; ++i) {
+		if (all.samples[i].type == DC_SAMPLE_TIME)
+			divetime = all.samples[i].value.time;
+	}
+
+	// A range on a fresh parser, before the index is built.
+	CHECK (dc_parser_set_data (parser, data, size) == DC_STATUS_SUCCESS);
+	test_range (parser, &all, divetime / 2, divetime / 2 + 100);
+
+	// Random ranges, including empty ones and ranges beyond the end.
+	for (unsigned int i = 0; i < 200; ++i) {
+		unsigned int begin = test_random (seed) % (divetime + 100);
+		unsigned int end = begin + test_random (seed) % (divetime / 4 + 20);
+		test_range (parser, &all, begin, end);
+	}
+
+	// An inverted range is rejected.
+	CHECK (dc_parser_samples_range (parser, 20, 10, test_samples_cb, &all) == DC_STATUS_INVALIDARGS);
+
+	// Boundaries of the dive and of the samples.
+	test_range (parser, &all, 0, 0);
+	test_range (parser, &all, 0, divetime);
+	test_range (parser, &all, divetime, divetime);
+	test_range (parser, &all, 10, 10);
+	test_range (parser, &all, 11, 19);
+	test_range (parser, &all, 0, 0xFFFFFFFF);
+
+	// The full profile is still reported correctly afterwards.
+	test_samples_t again = {NULL, 0, 0};
+	CHECK (dc_parser_samples_foreach (parser, test_samples_cb, &again) == DC_STATUS_SUCCESS);
+	CHECK (again.count == all.count);
+	for (unsigned int i = 0; i < again.count && i < all.count; ++i) {
+		CHECK (test_sample_equal (all.samples[i].type, &again.samples[i].value, &all.samples[i].value));
+	}
+	test_samples_free (&again);
+
+	test_samples_free (&all);
+	dc_parser_destroy (parser);
+}
+
+int
+main (void)
+{
+	static const unsigned int nsamples[] = {1, 5, 100, 2000};
+	static unsigned char data[MAXSIZE];
+	unsigned int seed = 1;
+
+	dc_context_t *context = test_context ();
+	dc_descriptor_t *ostc3 = test_descriptor (DC_FAMILY_HW_OSTC3, TEST_OSTC3);
+	dc_descriptor_t *d9 = test_descriptor (DC_FAMILY_SUUNTO_D9, TEST_D9);
+
+	for (unsigned int i = 0; i < sizeof (nsamples) / sizeof (nsamples[0]); ++i) {
+		unsigned int size = test_dive_ostc3 (data, sizeof (data), nsamples[i]);
+		CHECK (size != 0);
+		test_dive (context, ostc3, data, size, &seed);
+
+		size = test_dive_d9 (data, sizeof (data), nsamples[i]);
+		CHECK (size != 0);
+		test_dive (context, d9, data, size, &seed);
+	}
+
+	dc_descriptor_free (ostc3);
+	dc_descriptor_free (d9);
+	dc_context_free (context);
+
+	return test_result ();
+}
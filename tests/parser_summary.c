@@ -0,0 +1,284 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+/*
+ * The fields returned by dc_parser_get_summary must be exactly the
+ * fields returned by dc_parser_get_field. The Oceanic and Cressi Goa
+ * backends compute their header fields from the profile, and are fed
+ * with random data to cover both the valid and the error paths. The
+ * synthetic OSTC3 and D9 dives must always succeed.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libdivecomputer/iterator.h>
+
+#include "common.h"
+
+#define MAXGASMIXES 8
+#define MAXTANKS 8
+#define MAXSIZE 8192
+#define NITERATIONS 100
+
+typedef struct counters_t {
+	unsigned int success;
+	unsigned int failure;
+} counters_t;
+
+static const struct {
+	dc_field_type_t type;
+	size_t size;
+} g_fields[] = {
+	{DC_FIELD_DIVETIME,            sizeof (unsigned int)},
+	{DC_FIELD_MAXDEPTH,            sizeof (double)},
+	{DC_FIELD_AVGDEPTH,            sizeof (double)},
+	{DC_FIELD_GASMIX_COUNT,        sizeof (unsigned int)},
+	{DC_FIELD_SALINITY,            sizeof (dc_salinity_t)},
+	{DC_FIELD_ATMOSPHERIC,         sizeof (double)},
+	{DC_FIELD_TEMPERATURE_SURFACE, sizeof (double)},
+	{DC_FIELD_TEMPERATURE_MINIMUM, sizeof (double)},
+	{DC_FIELD_TEMPERATURE_MAXIMUM, sizeof (double)},
+	{DC_FIELD_TANK_COUNT,          sizeof (unsigned int)},
+	{DC_FIELD_DIVEMODE,            sizeof (dc_divemode_t)},
+};
+
+static const void *
+summary_value (const dc_summary_t *summary, dc_field_type_t type)
+{
+	switch (type) {
+	case DC_FIELD_DIVETIME:
+		return &summary->divetime;
+	case DC_FIELD_MAXDEPTH:
+		return &summary->maxdepth;
+	case DC_FIELD_AVGDEPTH:
+		return &summary->avgdepth;
+	case DC_FIELD_GASMIX_COUNT:
+		return &summary->gasmix_count;
+	case DC_FIELD_SALINITY:
+		return &summary->salinity;
+	case DC_FIELD_ATMOSPHERIC:
+		return &summary->atmospheric;
+	case DC_FIELD_TEMPERATURE_SURFACE:
+		return &summary->temperature_surface;
+	case DC_FIELD_TEMPERATURE_MINIMUM:
+		return &summary->temperature_minimum;
+	case DC_FIELD_TEMPERATURE_MAXIMUM:
+		return &summary->temperature_maximum;
+	case DC_FIELD_TANK_COUNT:
+		return &summary->tank_count;
+	case DC_FIELD_DIVEMODE:
+		return &summary->divemode;
+	default:
+		return NULL;
+	}
+}
+
+static int
+value_equal (dc_field_type_t type, const void *a, const void *b)
+{
+	if (type == DC_FIELD_SALINITY) {
+		const dc_salinity_t *x = (const dc_salinity_t *) a, *y = (const dc_salinity_t *) b;
+		return x->type == y->type && x->density == y->density;
+	}
+
+	for (unsigned int i = 0; i < sizeof (g_fields) / sizeof (g_fields[0]); ++i) {
+		if (g_fields[i].type == type)
+			return memcmp (a, b, g_fields[i].size) == 0;
+	}
+
+	return 0;
+}
+
+static int
+gasmix_equal (const dc_gasmix_t *a, const dc_gasmix_t *b)
+{
+	return a->helium == b->helium && a->oxygen == b->oxygen && a->nitrogen == b->nitrogen;
+}
+
+static int
+tank_equal (const dc_tank_t *a, const dc_tank_t *b)
+{
+	return a->gasmix == b->gasmix && a->type == b->type &&
+		a->volume == b->volume && a->workpressure == b->workpressure &&
+		a->beginpressure == b->beginpressure && a->endpressure == b->endpressure;
+}
+
+static void
+test_data (dc_context_t *context, dc_descriptor_t *descriptor, const unsigned char data[], unsigned int size, counters_t *counters)
+{
+	dc_parser_t *parser = NULL;
+	dc_gasmix_t gasmixes[MAXGASMIXES];
+	dc_tank_t tanks[MAXTANKS];
+	dc_summary_t summary;
+
+	// Summary.
+	if (dc_parser_new2 (&parser, context, descriptor, 0, 0) != DC_STATUS_SUCCESS)
+		return;
+	if (dc_parser_set_data (parser, data, size) != DC_STATUS_SUCCESS) {
+		dc_parser_destroy (parser);
+		return;
+	}
+
+	memset (&summary, 0, sizeof (summary));
+	summary.maxgasmixes = MAXGASMIXES;
+	summary.gasmixes = gasmixes;
+	summary.maxtanks = MAXTANKS;
+	summary.tanks = tanks;
+	dc_status_t status = dc_parser_get_summary (parser, &summary);
+
+	// Only the counts, or fewer elements than available.
+	dc_summary_t counts;
+	dc_gasmix_t gasmix;
+	dc_tank_t tank;
+	memset (&counts, 0, sizeof (counts));
+	counts.maxgasmixes = 1;
+	counts.gasmixes = &gasmix;
+	CHECK (dc_parser_get_summary (parser, &counts) == status);
+	if (status == DC_STATUS_SUCCESS) {
+		CHECK (counts.gasmix_count == summary.gasmix_count);
+		if (summary.gasmix_count && DC_SUMMARY_HAS (&summary, DC_FIELD_GASMIX))
+			CHECK (gasmix_equal (&gasmix, gasmixes));
+	}
+	memset (&counts, 0, sizeof (counts));
+	counts.maxtanks = 1;
+	counts.tanks = &tank;
+	CHECK (dc_parser_get_summary (parser, &counts) == status);
+	if (status == DC_STATUS_SUCCESS) {
+		CHECK (counts.tank_count == summary.tank_count);
+		if (summary.tank_count && DC_SUMMARY_HAS (&summary, DC_FIELD_TANK))
+			CHECK (tank_equal (&tank, tanks));
+	}
+
+	dc_parser_destroy (parser);
+
+	// Individual fields, with a fresh parser.
+	CHECK (dc_parser_new2 (&parser, context, descriptor, 0, 0) == DC_STATUS_SUCCESS);
+	CHECK (dc_parser_set_data (parser, data, size) == DC_STATUS_SUCCESS);
+
+	unsigned int failed = 0;
+	for (unsigned int i = 0; i < sizeof (g_fields) / sizeof (g_fields[0]); ++i) {
+		dc_field_type_t type = g_fields[i].type;
+		union {
+			unsigned int u;
+			double d;
+			dc_salinity_t salinity;
+			dc_divemode_t divemode;
+		} value;
+		memset (&value, 0, sizeof (value));
+
+		dc_status_t rc = dc_parser_get_field (parser, type, 0, &value);
+		if (rc != DC_STATUS_SUCCESS && rc != DC_STATUS_UNSUPPORTED)
+			failed++;
+
+		if (status != DC_STATUS_SUCCESS)
+			continue;
+
+		CHECK (rc == DC_STATUS_SUCCESS || rc == DC_STATUS_UNSUPPORTED);
+		CHECK ((rc == DC_STATUS_SUCCESS) == DC_SUMMARY_HAS (&summary, type));
+		if (rc == DC_STATUS_SUCCESS)
+			CHECK (value_equal (type, &value, summary_value (&summary, type)));
+	}
+
+	if (status == DC_STATUS_SUCCESS) {
+		unsigned int ngasmixes = summary.gasmix_count < MAXGASMIXES ? summary.gasmix_count : MAXGASMIXES;
+		for (unsigned int i = 0; DC_SUMMARY_HAS (&summary, DC_FIELD_GASMIX_COUNT) && i < ngasmixes; ++i) {
+			dc_status_t rc = dc_parser_get_field (parser, DC_FIELD_GASMIX, i, &gasmix);
+			CHECK ((rc == DC_STATUS_SUCCESS) == DC_SUMMARY_HAS (&summary, DC_FIELD_GASMIX));
+			if (rc == DC_STATUS_SUCCESS)
+				CHECK (gasmix_equal (&gasmix, gasmixes + i));
+		}
+
+		unsigned int ntanks = summary.tank_count < MAXTANKS ? summary.tank_count : MAXTANKS;
+		for (unsigned int i = 0; DC_SUMMARY_HAS (&summary, DC_FIELD_TANK_COUNT) && i < ntanks; ++i) {
+			dc_status_t rc = dc_parser_get_field (parser, DC_FIELD_TANK, i, &tank);
+			CHECK ((rc == DC_STATUS_SUCCESS) == DC_SUMMARY_HAS (&summary, DC_FIELD_TANK));
+			if (rc == DC_STATUS_SUCCESS)
+				CHECK (tank_equal (&tank, tanks + i));
+		}
+
+		counters->success++;
+	} else {
+		// A failing summary implies that at least one field fails too.
+		CHECK (failed > 0);
+		counters->failure++;
+	}
+
+	dc_parser_destroy (parser);
+}
+
+static void
+test_family (dc_context_t *context, dc_family_t family)
+{
+	unsigned char data[MAXSIZE];
+	counters_t counters = {0, 0};
+	unsigned int seed = family;
+
+	dc_iterator_t *iterator = NULL;
+	dc_descriptor_t *descriptor = NULL;
+	CHECK (dc_descriptor_iterator (&iterator) == DC_STATUS_SUCCESS);
+	while (dc_iterator_next (iterator, &descriptor) == DC_STATUS_SUCCESS) {
+		if (dc_descriptor_get_type (descriptor) == family) {
+			for (unsigned int i = 0; i < NITERATIONS; ++i) {
+				unsigned int size = 16 + test_random (&seed) % 1024;
+				for (unsigned int j = 0; j < size; ++j)
+					data[j] = test_random (&seed) & 0xFF;
+				test_data (context, descriptor, data, size, &counters);
+			}
+		}
+		dc_descriptor_free (descriptor);
+	}
+	dc_iterator_free (iterator);
+
+	// Both paths must have been exercised.
+	CHECK (counters.success > 0);
+	CHECK (counters.failure > 0);
+}
+
+int
+main (void)
+{
+	unsigned char data[MAXSIZE];
+	counters_t counters = {0, 0};
+
+	dc_context_t *context = test_context ();
+
+	test_family (context, DC_FAMILY_OCEANIC_ATOM2);
+	test_family (context, DC_FAMILY_OCEANIC_VEO250);
+	test_family (context, DC_FAMILY_OCEANIC_VTPRO);
+	test_family (context, DC_FAMILY_CRESSI_GOA);
+
+	dc_descriptor_t *ostc3 = test_descriptor (DC_FAMILY_HW_OSTC3, TEST_OSTC3);
+	dc_descriptor_t *d9 = test_descriptor (DC_FAMILY_SUUNTO_D9, TEST_D9);
+	for (unsigned int nsamples = 1; nsamples < 400; nsamples += 37) {
+		unsigned int size = test_dive_ostc3 (data, sizeof (data), nsamples);
+		test_data (context, ostc3, data, size, &counters);
+		size = test_dive_d9 (data, sizeof (data), nsamples);
+		test_data (context, d9, data, size, &counters);
+	}
+	CHECK (counters.failure == 0);
+	dc_descriptor_free (ostc3);
+	dc_descriptor_free (d9);
+
+	dc_context_free (context);
+
+	return test_result ();
+}
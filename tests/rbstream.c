@@ -0,0 +1,258 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+/*
+ * Reading a ringbuffer backwards, with packets coalesced into larger
+ * reads. The data must be the same for every readahead, also across the
+ * wrap point and when the start address is not aligned to a page. The
+ * coalesced reads must not fetch more data than single packets.
+ */
+
+#include <string.h>
+
+#include "common.h"
+#include "device-private.h"
+#include "rbstream.h"
+
+#define MEMSIZE    0x1000
+#define PAGESIZE   0x10
+#define PACKETSIZE 0x40
+#define BEGIN      0x100
+#define END        0xF00
+#define MAXREADS   4096
+#define MAXSIZE    0x2000
+
+typedef struct fake_read_t {
+	unsigned int address;
+	unsigned int size;
+} fake_read_t;
+
+typedef struct fake_device_t {
+	dc_device_t base;
+	unsigned int nreads;
+	fake_read_t reads[MAXREADS];
+} fake_device_t;
+
+static unsigned char g_memory[MEMSIZE];
+
+static dc_status_t
+fake_device_read (dc_device_t *abstract, unsigned int address, unsigned char data[], unsigned int size)
+{
+	fake_device_t *device = (fake_device_t *) abstract;
+
+	if (address + size > MEMSIZE)
+		return DC_STATUS_INVALIDARGS;
+
+	if (device->nreads < MAXREADS) {
+		device->reads[device->nreads].address = address;
+		device->reads[device->nreads].size = size;
+	}
+	device->nreads++;
+
+	memcpy (data, g_memory + address, size);
+
+	return DC_STATUS_SUCCESS;
+}
+
+static const dc_device_vtable_t fake_device_vtable = {
+	sizeof (fake_device_t),
+	DC_FAMILY_NULL,
+	NULL, /* set_fingerprint */
+	fake_device_read, /* read */
+	NULL, /* write */
+	NULL, /* dump */
+	NULL, /* foreach */
+	NULL, /* timesync */
+	NULL, /* close */
+};
+
+static fake_device_t *
+fake_device_new (dc_context_t *context)
+{
+	fake_device_t *device = (fake_device_t *) dc_device_allocate (context, &fake_device_vtable);
+	CHECK (device != NULL);
+	device->nreads = 0;
+	return device;
+}
+
+/*
+ * The data preceding the given address, wrapping from the begin of the
+ * ringbuffer to the end.
+ */
+static unsigned int
+reference (unsigned int address, unsigned char data[], unsigned int size)
+{
+	for (unsigned int i = size; i > 0; --i) {
+		if (address == BEGIN)
+			address = END;
+		address--;
+		data[i - 1] = g_memory[address];
+	}
+
+	return address;
+}
+
+/*
+ * Read a random sequence of sizes from the given address. The readahead
+ * is either fixed, or changed randomly between the reads when zero.
+ */
+static dc_rbstream_stats_t
+test_stream (dc_context_t *context, unsigned int address, unsigned int npackets, unsigned int seed)
+{
+	static unsigned char data[MAXSIZE], expected[MAXSIZE];
+	dc_rbstream_stats_t stats = {0, 0, 0};
+	dc_rbstream_t *rbstream = NULL;
+
+	fake_device_t *device = fake_device_new (context);
+	CHECK (dc_rbstream_new (&rbstream, (dc_device_t *) device, PAGESIZE, PACKETSIZE, BEGIN, END, address) == DC_STATUS_SUCCESS);
+	if (npackets)
+		CHECK (dc_rbstream_set_readahead (rbstream, npackets) == DC_STATUS_SUCCESS);
+
+	// The sizes do not depend on the readahead.
+	unsigned int other = ~seed;
+
+	unsigned int total = 0;
+	for (unsigned int i = 0; i < 64; ++i) {
+		unsigned int size = 1 + test_random (&seed) % (i % 8 == 0 ? MAXSIZE : 3 * PACKETSIZE);
+		if (npackets == 0)
+			CHECK (dc_rbstream_set_readahead (rbstream, 1 + test_random (&other) % 8) == DC_STATUS_SUCCESS);
+
+		CHECK (dc_rbstream_read (rbstream, NULL, data, size) == DC_STATUS_SUCCESS);
+		address = reference (address, expected, size);
+		CHECK (memcmp (data, expected, size) == 0);
+		total += size;
+	}
+
+	// Every read stays inside the ringbuffer, and within the readahead.
+	for (unsigned int i = 0; i < device->nreads && i < MAXREADS; ++i) {
+		const fake_read_t *read = device->reads + i;
+		CHECK (read->address >= BEGIN && read->address + read->size <= END);
+		CHECK (read->size % PACKETSIZE == 0);
+		CHECK (npackets == 0 || read->size <= npackets * PACKETSIZE);
+	}
+
+	CHECK (dc_rbstream_get_stats (rbstream, &stats) == DC_STATUS_SUCCESS);
+	CHECK (stats.requests == device->nreads);
+	CHECK (stats.used == total);
+	CHECK (stats.bytes >= stats.used);
+
+	dc_rbstream_free (rbstream);
+	dc_device_close ((dc_device_t *) device);
+
+	return stats;
+}
+
+/*
+ * A single read across the wrap point, starting at an unaligned address.
+ */
+static void
+test_wrap (dc_context_t *context)
+{
+	static const fake_read_t expected[] = {
+		{0x110, 0x80},
+		{0x100, 0x40},
+		{0xE80, 0x80},
+	};
+	unsigned char data[0x100], reference_data[0x100];
+	dc_rbstream_t *rbstream = NULL;
+
+	fake_device_t *device = fake_device_new (context);
+	CHECK (dc_rbstream_new (&rbstream, (dc_device_t *) device, PAGESIZE, PACKETSIZE, BEGIN, END, 0x188) == DC_STATUS_SUCCESS);
+	CHECK (dc_rbstream_set_readahead (rbstream, 8) == DC_STATUS_SUCCESS);
+	CHECK (dc_rbstream_read (rbstream, NULL, data, sizeof (data)) == DC_STATUS_SUCCESS);
+
+	reference (0x188, reference_data, sizeof (reference_data));
+	CHECK (memcmp (data, reference_data, sizeof (data)) == 0);
+
+	// The packets are coalesced up to the partial packet at the begin of
+	// the ringbuffer, and again after the wrap point.
+	CHECK (device->nreads == sizeof (expected) / sizeof (expected[0]));
+	for (unsigned int i = 0; i < device->nreads && i < sizeof (expected) / sizeof (expected[0]); ++i) {
+		CHECK (device->reads[i].address == expected[i].address);
+		CHECK (device->reads[i].size == expected[i].size);
+	}
+
+	dc_rbstream_free (rbstream);
+	dc_device_close ((dc_device_t *) device);
+}
+
+static void
+test_invalid (dc_context_t *context)
+{
+	dc_rbstream_t *rbstream = NULL;
+	dc_device_t *device = (dc_device_t *) fake_device_new (context);
+
+	CHECK (dc_rbstream_new (NULL, device, PAGESIZE, PACKETSIZE, BEGIN, END, BEGIN) == DC_STATUS_INVALIDARGS);
+	CHECK (dc_rbstream_new (&rbstream, NULL, PAGESIZE, PACKETSIZE, BEGIN, END, BEGIN) == DC_STATUS_INVALIDARGS);
+	CHECK (dc_rbstream_new (&rbstream, device, 0, PACKETSIZE, BEGIN, END, BEGIN) == DC_STATUS_INVALIDARGS);
+	CHECK (dc_rbstream_new (&rbstream, device, PAGESIZE, PAGESIZE + 1, BEGIN, END, BEGIN) == DC_STATUS_INVALIDARGS);
+	CHECK (dc_rbstream_new (&rbstream, device, PAGESIZE, PACKETSIZE, BEGIN + 1, END, BEGIN + 1) == DC_STATUS_INVALIDARGS);
+	CHECK (dc_rbstream_new (&rbstream, device, PAGESIZE, PACKETSIZE, BEGIN, END, END + 1) == DC_STATUS_INVALIDARGS);
+
+	CHECK (dc_rbstream_new (&rbstream, device, PAGESIZE, PACKETSIZE, BEGIN, END, END) == DC_STATUS_SUCCESS);
+	CHECK (dc_rbstream_set_readahead (rbstream, 0) == DC_STATUS_INVALIDARGS);
+	CHECK (dc_rbstream_set_readahead (NULL, 1) == DC_STATUS_INVALIDARGS);
+	CHECK (dc_rbstream_get_stats (rbstream, NULL) == DC_STATUS_INVALIDARGS);
+	dc_rbstream_free (rbstream);
+
+	dc_device_close (device);
+}
+
+int
+main (void)
+{
+	static const unsigned int npackets[] = {2, 3, 8, 64};
+	unsigned int seed = 1;
+
+	for (unsigned int i = 0; i < MEMSIZE; ++i)
+		g_memory[i] = test_random (&seed) & 0xFF;
+
+	dc_context_t *context = test_context ();
+
+	test_wrap (context);
+	test_invalid (context);
+
+	// Start at the begin, at the end, and at random addresses.
+	for (unsigned int i = 0; i < 100; ++i) {
+		unsigned int address = BEGIN + test_random (&seed) % (END - BEGIN + 1);
+		if (i == 0)
+			address = BEGIN;
+		else if (i == 1)
+			address = END;
+
+		// A larger readahead reads the same amount of data, with fewer
+		// requests.
+		dc_rbstream_stats_t single = test_stream (context, address, 1, i);
+		for (unsigned int j = 0; j < sizeof (npackets) / sizeof (npackets[0]); ++j) {
+			dc_rbstream_stats_t stats = test_stream (context, address, npackets[j], i);
+			CHECK (stats.bytes == single.bytes);
+			CHECK (stats.requests <= single.requests);
+		}
+
+		dc_rbstream_stats_t stats = test_stream (context, address, 0, i);
+		CHECK (stats.bytes == single.bytes);
+		CHECK (stats.requests <= single.requests);
+	}
+
+	dc_context_free (context);
+
+	return test_result ();
+}
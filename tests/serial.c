@@ -0,0 +1,206 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+/*
+ * Reading and writing a serial port, with and without the deferred
+ * draining. The port is the slave side of a pseudo terminal, and the test
+ * plays the dive computer on the master side. The test is skipped when no
+ * pseudo terminal is available.
+ */
+
+#ifndef _XOPEN_SOURCE
+#define _XOPEN_SOURCE 600
+#endif
+
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+#include <libdivecomputer/serial.h>
+
+#include "common.h"
+
+#define SKIP 77
+
+#ifndef _WIN32
+
+#define TIMEOUT 100
+
+/*
+ * Read exactly the given number of bytes from the master side.
+ */
+static int
+master_read (int fd, unsigned char data[], size_t size)
+{
+	size_t nbytes = 0;
+	while (nbytes < size) {
+		struct pollfd pfd = {fd, POLLIN, 0};
+		if (poll (&pfd, 1, 1000) != 1)
+			return 0;
+
+		ssize_t n = read (fd, data + nbytes, size - nbytes);
+		if (n <= 0)
+			return 0;
+		nbytes += n;
+	}
+
+	return 1;
+}
+
+static int
+master_write (int fd, const unsigned char data[], size_t size)
+{
+	return write (fd, data, size) == (ssize_t) size;
+}
+
+/*
+ * The data written to the port arrives on the master side unchanged, and
+ * the other way around.
+ */
+static void
+test_roundtrip (dc_iostream_t *iostream, int fd, unsigned int seed)
+{
+	unsigned char command[256], answer[256], data[256];
+
+	for (unsigned int i = 0; i < 16; ++i) {
+		size_t size = 1 + test_random (&seed) % sizeof (command);
+		for (size_t j = 0; j < size; ++j) {
+			command[j] = test_random (&seed) & 0xFF;
+			answer[j] = test_random (&seed) & 0xFF;
+		}
+
+		size_t nbytes = 0;
+		CHECK (dc_iostream_write (iostream, command, size, &nbytes) == DC_STATUS_SUCCESS);
+		CHECK (nbytes == size);
+		CHECK (master_read (fd, data, size));
+		CHECK (memcmp (data, command, size) == 0);
+
+		CHECK (master_write (fd, answer, size));
+		CHECK (dc_iostream_read (iostream, data, size, &nbytes) == DC_STATUS_SUCCESS);
+		CHECK (nbytes == size);
+		CHECK (memcmp (data, answer, size) == 0);
+	}
+}
+
+/*
+ * A read returns the data that arrived before the timeout, and a non
+ * blocking read only the data that is already there.
+ */
+static void
+test_timeout (dc_iostream_t *iostream, int fd)
+{
+	static const unsigned char answer[] = {0x01, 0x02, 0x03};
+	unsigned char data[8] = {0};
+	size_t nbytes = 0;
+
+	CHECK (master_write (fd, answer, sizeof (answer)));
+	CHECK (dc_iostream_read (iostream, data, sizeof (data), &nbytes) == DC_STATUS_TIMEOUT);
+	CHECK (nbytes == sizeof (answer));
+	CHECK (memcmp (data, answer, sizeof (answer)) == 0);
+
+	CHECK (dc_iostream_read_nonblock (iostream, data, sizeof (data), &nbytes) == DC_STATUS_TIMEOUT);
+	CHECK (nbytes == 0);
+
+	CHECK (master_write (fd, answer, sizeof (answer)));
+	CHECK (dc_iostream_poll (iostream, TIMEOUT) == DC_STATUS_SUCCESS);
+	CHECK (dc_iostream_read_nonblock (iostream, data, 1, &nbytes) == DC_STATUS_SUCCESS);
+	CHECK (nbytes == 1 && data[0] == answer[0]);
+	CHECK (dc_iostream_read (iostream, data, 2, &nbytes) == DC_STATUS_SUCCESS);
+	CHECK (nbytes == 2 && data[0] == answer[1] && data[1] == answer[2]);
+}
+
+/*
+ * With the deferred draining, the output is still transmitted in order,
+ * and every operation that drains the pending output succeeds.
+ */
+static void
+test_deferred (dc_iostream_t *iostream, int fd)
+{
+	static const unsigned char command[] = {0xAA, 0x55, 0x00, 0xFF};
+	unsigned char data[4 * sizeof (command)];
+	unsigned int value = 1;
+
+	CHECK (dc_iostream_ioctl (iostream, DC_IOCTL_SERIAL_SET_DEFERRED_DRAIN, &value, sizeof (value)) == DC_STATUS_SUCCESS);
+	test_roundtrip (iostream, fd, 2);
+
+	CHECK (dc_iostream_write (iostream, command, sizeof (command), NULL) == DC_STATUS_SUCCESS);
+	CHECK (dc_iostream_flush (iostream) == DC_STATUS_SUCCESS);
+	CHECK (dc_iostream_write (iostream, command, sizeof (command), NULL) == DC_STATUS_SUCCESS);
+	CHECK (dc_iostream_sleep (iostream, 1) == DC_STATUS_SUCCESS);
+	CHECK (dc_iostream_write (iostream, command, sizeof (command), NULL) == DC_STATUS_SUCCESS);
+	CHECK (dc_iostream_configure (iostream, 9600, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE) == DC_STATUS_SUCCESS);
+	CHECK (dc_iostream_write (iostream, command, sizeof (command), NULL) == DC_STATUS_SUCCESS);
+
+	// Disabling the deferred draining drains the pending output first.
+	value = 0;
+	CHECK (dc_iostream_ioctl (iostream, DC_IOCTL_SERIAL_SET_DEFERRED_DRAIN, &value, sizeof (value)) == DC_STATUS_SUCCESS);
+
+	CHECK (master_read (fd, data, sizeof (data)));
+	for (unsigned int i = 0; i < 4; ++i)
+		CHECK (memcmp (data + i * sizeof (command), command, sizeof (command)) == 0);
+
+	test_roundtrip (iostream, fd, 3);
+
+	// The request has a fixed size.
+	CHECK (dc_iostream_ioctl (iostream, DC_IOCTL_SERIAL_SET_DEFERRED_DRAIN, &value, 1) == DC_STATUS_INVALIDARGS);
+}
+
+#endif
+
+int
+main (void)
+{
+#ifdef _WIN32
+	return SKIP;
+#else
+	int fd = posix_openpt (O_RDWR | O_NOCTTY);
+	if (fd == -1)
+		return SKIP;
+
+	if (grantpt (fd) != 0 || unlockpt (fd) != 0 || ptsname (fd) == NULL) {
+		close (fd);
+		return SKIP;
+	}
+
+	dc_context_t *context = test_context ();
+
+	dc_iostream_t *iostream = NULL;
+	CHECK (dc_serial_open (&iostream, context, ptsname (fd)) == DC_STATUS_SUCCESS);
+	CHECK (dc_iostream_configure (iostream, 9600, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE) == DC_STATUS_SUCCESS);
+	CHECK (dc_iostream_set_timeout (iostream, TIMEOUT) == DC_STATUS_SUCCESS);
+
+	test_roundtrip (iostream, fd, 1);
+	test_timeout (iostream, fd);
+	test_deferred (iostream, fd);
+
+	CHECK (dc_iostream_close (iostream) == DC_STATUS_SUCCESS);
+	close (fd);
+
+	dc_context_free (context);
+
+	return test_result ();
+#endif
+}